@@ -0,0 +1,1118 @@
+/*--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+*/
+/* daq_balance.c - a wrapper module that steers new flows from the instance
+ * that received them to the least loaded instance of the process; flows stay
+ * with the instance they were given to until they go idle */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <daq_dlt.h>
+#include <daq_module_api.h>
+
+#include "daq_balance.h"
+
+#define DAQ_MOD_VERSION 0
+#define DAQ_NAME "balance"
+#define DAQ_TYPE (DAQ_TYPE_WRAPPER|DAQ_TYPE_INLINE_CAPABLE|DAQ_TYPE_MULTI_INSTANCE)
+
+/* the table stores owners + 1 in 16 bits */
+#define BALANCE_MAX_INSTANCES 0xfffe
+#define BALANCE_DEFAULT_BUCKETS 65536
+#define BALANCE_MAX_BUCKETS (1u << 30)
+/* at least the longest default stream session timeout (tcp) so that a
+   quiet session isn't moved to a thread that doesn't know it */
+#define BALANCE_DEFAULT_IDLE 180
+
+/* how long stop keeps returning handoffs and waits for its own to come back */
+#define BALANCE_STOP_GRACE_MS 100
+#define BALANCE_STOP_WAIT_MS 1000
+
+#define ETH_HDR_LEN 14
+#define VLAN_TAG_LEN 4
+#define IP4_HDR_LEN 20
+#define IP6_HDR_LEN 40
+#define IP6_SRC_OFF 8
+#define IP6_DST_OFF 24
+
+#define SET_ERROR(modinst, ...)    daq_base_api.set_errbuf(modinst, __VA_ARGS__)
+
+#define CHECK_SUBAPI(ctxt, fname) (ctxt->subapi.fname.func != NULL)
+
+#define CALL_SUBAPI_NOARGS(ctxt, fname) \
+    ctxt->subapi.fname.func(ctxt->subapi.fname.context)
+
+#define CALL_SUBAPI(ctxt, fname, ...) \
+    ctxt->subapi.fname.func(ctxt->subapi.fname.context, __VA_ARGS__)
+
+typedef struct
+{
+    const DAQ_Msg_t* msg;
+    DAQ_Verdict verdict;
+} BalanceSlot;
+
+/* single producer and single consumer; the indices only ever increase and
+   are masked to index the slots */
+typedef struct
+{
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t tail __attribute__((aligned(64)));
+    uint32_t mask __attribute__((aligned(64)));
+    BalanceSlot* slots;
+} BalanceRing;
+
+/* the part of an instance read and written by other instances; it outlives
+   the instance so that others never touch freed memory */
+typedef struct
+{
+    bool running;
+    bool waiting;
+    uint64_t pending;   /* handed to this instance and not yet received */
+    uint64_t held;      /* received and not yet finalized */
+    uint64_t backlog;   /* the size of the latest local receive */
+    int (*interrupt)(void*);
+    void* interrupt_context;
+} __attribute__((aligned(64))) BalanceShare;
+
+typedef struct
+{
+    unsigned refs;
+    unsigned num;
+    uint32_t idle;
+    uint32_t mask;
+    uint64_t* table;    /* owner + 1 in the low 16 bits, last seen seconds in the high 32 */
+    BalanceShare* shares;
+    BalanceRing* fwd;   /* [from * num + to], packets handed from one instance to another */
+    BalanceRing* ret;   /* [from * num + to], verdicts on handoffs going back to their origin */
+} BalanceShared;
+
+/* a handoff held by this instance */
+typedef struct
+{
+    const DAQ_Msg_t* msg;
+    unsigned origin;
+} BalanceHeld;
+
+typedef struct
+{
+    /* Configuration */
+    unsigned buckets;
+    unsigned idle;
+
+    /* State */
+    DAQ_ModuleInstance_h modinst;
+    DAQ_InstanceAPI_t subapi;
+    BalanceShare* share;    /* null when there is no one to balance with */
+    unsigned id;
+    unsigned num;
+    unsigned next_peer;
+    int dlt;
+    volatile bool interrupted;
+
+    /* this instance's packets held by others */
+    uint64_t outstanding;
+
+    BalanceHeld* held;
+    uint32_t held_mask;
+
+    const DAQ_Msg_t** local;
+    unsigned local_size;
+    bool local_turn;
+
+    DIOCTL_GetBalanceStats stats;
+} BalanceContext;
+
+static DAQ_VariableDesc_t balance_variable_descriptions[] = {
+    { "buckets", "Number of flow buckets shared by the instances, rounded up to a power of 2 (default 65536)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "idle", "Seconds without packets before a bucket can be given to another instance (default 180)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+};
+
+static DAQ_BaseAPI_t daq_base_api;
+
+/* instances are instantiated and destroyed by the main thread but the lock
+   makes no assumption about that */
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static BalanceShared* shared = NULL;
+
+//-------------------------------------------------------------------------
+// utility functions
+//-------------------------------------------------------------------------
+
+static uint32_t pow2_at_least(uint32_t n)
+{
+    uint32_t p = 1;
+
+    while (p < n)
+        p <<= 1;
+
+    return p;
+}
+
+static uint16_t get16be(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t coarse_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint32_t)ts.tv_sec;
+}
+
+static uint64_t elapsed_ms(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000 +
+        (uint64_t)(now.tv_nsec / 1000000) - (uint64_t)(start->tv_nsec / 1000000);
+}
+
+//-------------------------------------------------------------------------
+// rings
+//-------------------------------------------------------------------------
+
+static bool ring_init(BalanceRing* ring, uint32_t size)
+{
+    uint32_t cap = pow2_at_least(size);
+
+    free(ring->slots);
+    ring->slots = (BalanceSlot*)calloc(cap, sizeof(*ring->slots));
+
+    if (!ring->slots)
+        return false;
+
+    ring->mask = cap - 1;
+    ring->head = ring->tail = 0;
+    return true;
+}
+
+static bool ring_push(BalanceRing* ring, const DAQ_Msg_t* msg, DAQ_Verdict verdict)
+{
+    uint32_t tail = ring->tail;
+
+    if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) > ring->mask)
+        return false;
+
+    ring->slots[tail & ring->mask].msg = msg;
+    ring->slots[tail & ring->mask].verdict = verdict;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool ring_pop(BalanceRing* ring, BalanceSlot* slot)
+{
+    uint32_t head = ring->head;
+
+    if (head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+        return false;
+
+    *slot = ring->slots[head & ring->mask];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool ring_empty(BalanceRing* ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+//-------------------------------------------------------------------------
+// handoffs held here, keyed by address and never dereferenced
+//-------------------------------------------------------------------------
+
+static uint32_t held_home(const BalanceContext* bc, const DAQ_Msg_t* msg)
+{
+    return (uint32_t)(((uint64_t)(uintptr_t)msg * 0x9e3779b97f4a7c15ULL) >> 32) & bc->held_mask;
+}
+
+static void held_add(BalanceContext* bc, const DAQ_Msg_t* msg, unsigned origin)
+{
+    uint32_t i = held_home(bc, msg);
+
+    while (bc->held[i].msg)
+        i = (i + 1) & bc->held_mask;
+
+    bc->held[i].msg = msg;
+    bc->held[i].origin = origin;
+}
+
+static int held_find(const BalanceContext* bc, const DAQ_Msg_t* msg)
+{
+    uint32_t i = held_home(bc, msg);
+
+    while (bc->held[i].msg)
+    {
+        if (bc->held[i].msg == msg)
+            return (int)i;
+
+        i = (i + 1) & bc->held_mask;
+    }
+    return -1;
+}
+
+/* removal shifts later entries back so that lookups can stop at a gap */
+static void held_remove(BalanceContext* bc, uint32_t i)
+{
+    uint32_t j = i;
+
+    while (true)
+    {
+        j = (j + 1) & bc->held_mask;
+
+        if (!bc->held[j].msg)
+            break;
+
+        uint32_t home = held_home(bc, bc->held[j].msg);
+        bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+
+        if (!stays)
+        {
+            bc->held[i] = bc->held[j];
+            i = j;
+        }
+    }
+    bc->held[i].msg = NULL;
+}
+
+//-------------------------------------------------------------------------
+// flow steering
+//-------------------------------------------------------------------------
+
+static uint32_t balance_mix(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+/* both directions must land in the same bucket so the addresses are
+   combined with an operation that ignores their order */
+static uint32_t pair_hash(uint32_t a, uint32_t b)
+{
+    return balance_mix(balance_mix(a) + balance_mix(b));
+}
+
+static uint32_t fold_ip6(const uint8_t* p)
+{
+    return balance_mix(get32(p)) ^ balance_mix(get32(p + 4) + 1) ^
+        balance_mix(get32(p + 8) + 2) ^ balance_mix(get32(p + 12) + 3);
+}
+
+/* packets are pinned by their address pair alone.  ports would spread the
+   flows between two hosts over more instances but aren't in every fragment,
+   and a datagram's fragments must reach the instance that has its flow.
+   the cost is that one busy host pair is never spread: all of its traffic
+   is inspected by whichever instance owns its bucket. */
+static bool hash_ip4(const uint8_t* data, uint32_t len, uint32_t* hash)
+{
+    if (len < IP4_HDR_LEN || (data[0] >> 4) != 4)
+        return false;
+
+    *hash = pair_hash(get32(data + 12), get32(data + 16));
+    return true;
+}
+
+static bool hash_ip6(const uint8_t* data, uint32_t len, uint32_t* hash)
+{
+    if (len < IP6_HDR_LEN || (data[0] >> 4) != 6)
+        return false;
+
+    *hash = pair_hash(fold_ip6(data + IP6_SRC_OFF), fold_ip6(data + IP6_DST_OFF));
+    return true;
+}
+
+static bool hash_packet(const BalanceContext* bc, const DAQ_Msg_t* msg, uint32_t* hash)
+{
+    if (msg->type != DAQ_MSG_TYPE_PACKET)
+        return false;
+
+    const uint8_t* data = msg->data;
+    uint32_t len = msg->data_len;
+    uint16_t type;
+
+    if (bc->dlt == DLT_EN10MB)
+    {
+        if (len < ETH_HDR_LEN)
+            return false;
+
+        uint32_t off = ETH_HDR_LEN;
+        type = get16be(data + 12);
+
+        while ((type == 0x8100 || type == 0x88a8) && len >= off + VLAN_TAG_LEN)
+        {
+            type = get16be(data + off + 2);
+            off += VLAN_TAG_LEN;
+        }
+        data += off;
+        len -= off;
+    }
+    else if (bc->dlt == DLT_RAW && len)
+        type = ((data[0] >> 4) == 6) ? 0x86dd : 0x0800;
+
+    else
+        return false;
+
+    if (type == 0x0800)
+        return hash_ip4(data, len, hash);
+
+    if (type == 0x86dd)
+        return hash_ip6(data, len, hash);
+
+    return false;
+}
+
+/* work the instance has queued, in hand, and most recently received */
+static uint64_t share_load(BalanceShare* share)
+{
+    return __atomic_load_n(&share->pending, __ATOMIC_RELAXED) +
+        __atomic_load_n(&share->held, __ATOMIC_RELAXED) +
+        __atomic_load_n(&share->backlog, __ATOMIC_RELAXED);
+}
+
+static bool share_running(BalanceShare* share)
+{
+    return __atomic_load_n(&share->running, __ATOMIC_ACQUIRE);
+}
+
+static bool share_waiting(BalanceShare* share)
+{
+    return __atomic_load_n(&share->waiting, __ATOMIC_SEQ_CST);
+}
+
+/* ties go to the receiving instance so that balanced traffic isn't moved */
+static unsigned least_loaded(const BalanceContext* bc)
+{
+    BalanceShared* bs = shared;
+    unsigned best = bc->id;
+    uint64_t best_load = share_load(bc->share);
+
+    for (unsigned k = 0; k < bc->num; ++k)
+    {
+        if (k == bc->id || !share_running(&bs->shares[k]))
+            continue;
+
+        uint64_t load = share_load(&bs->shares[k]);
+
+        if (load < best_load)
+        {
+            best = k;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+/* returns the instance that owns the message's flow, giving its bucket an
+   owner first if it has none that is current */
+static unsigned steer(BalanceContext* bc, const DAQ_Msg_t* msg, uint32_t now)
+{
+    uint32_t hash;
+
+    if (!hash_packet(bc, msg, &hash))
+    {
+        bc->stats.unsteered++;
+        return bc->id;
+    }
+
+    BalanceShared* bs = shared;
+    uint64_t* bucket = &bs->table[hash & bs->mask];
+    uint64_t entry = __atomic_load_n(bucket, __ATOMIC_ACQUIRE);
+
+    while (true)
+    {
+        unsigned owner = (unsigned)(entry & 0xffff);
+        uint32_t seen = (uint32_t)(entry >> 32);
+
+        if (owner && now - seen <= bs->idle && share_running(&bs->shares[owner - 1]))
+        {
+            if (seen == now)
+                return owner - 1;
+
+            uint64_t update = ((uint64_t)now << 32) | (entry & 0xffffffff);
+
+            if (__atomic_compare_exchange_n(bucket, &entry, update, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                return owner - 1;
+
+            continue;
+        }
+
+        unsigned to = least_loaded(bc);
+        uint64_t update = ((uint64_t)now << 32) | (to + 1);
+
+        if (__atomic_compare_exchange_n(bucket, &entry, update, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            bc->stats.assigned++;
+
+            if (owner)
+                bc->stats.reassigned++;
+
+            if (to != bc->id)
+                bc->stats.moved++;
+
+            return to;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// handoffs
+//-------------------------------------------------------------------------
+
+/* finalize this instance's packets that others are done with */
+static void take_returns(BalanceContext* bc)
+{
+    BalanceShared* bs = shared;
+    BalanceSlot slot;
+
+    for (unsigned k = 0; k < bc->num && bc->outstanding; ++k)
+    {
+        BalanceRing* ring = &bs->ret[k * bc->num + bc->id];
+
+        while (ring_pop(ring, &slot))
+        {
+            CALL_SUBAPI(bc, msg_finalize, slot.msg, slot.verdict);
+            bc->outstanding--;
+        }
+    }
+}
+
+static unsigned adopt(BalanceContext* bc, unsigned max_recv, const DAQ_Msg_t* msgs[])
+{
+    BalanceShared* bs = shared;
+    BalanceSlot slot;
+    unsigned idx = 0;
+
+    /* rotate the first peer so that none is favored */
+    for (unsigned n = 0; n < bc->num && idx < max_recv; ++n)
+    {
+        unsigned k = (bc->next_peer + n) % bc->num;
+
+        if (k == bc->id)
+            continue;
+
+        BalanceRing* ring = &bs->fwd[k * bc->num + bc->id];
+
+        while (idx < max_recv && ring_pop(ring, &slot))
+        {
+            held_add(bc, slot.msg, k);
+            msgs[idx++] = slot.msg;
+        }
+    }
+    bc->next_peer = (bc->next_peer + 1) % bc->num;
+
+    if (idx)
+    {
+        __atomic_fetch_sub(&bc->share->pending, idx, __ATOMIC_RELAXED);
+        bc->stats.adopted += idx;
+    }
+    return idx;
+}
+
+/* interrupts the waiting instances this one has handed packets to and,
+   when it is about to wait itself, those that have handed packets to it so
+   that they come back here and interrupt it.  the callers' seq_cst fences
+   pair so that of two instances about to wait with handoffs between them at
+   least one sees the other waiting. */
+static void wake_peers(BalanceContext* bc, bool waiting)
+{
+    BalanceShared* bs = shared;
+
+    for (unsigned k = 0; k < bc->num; ++k)
+    {
+        if (k == bc->id)
+            continue;
+
+        BalanceShare* share = &bs->shares[k];
+
+        if (!share->interrupt || !share_waiting(share) || !share_running(share))
+            continue;
+
+        if (!ring_empty(&bs->fwd[bc->id * bc->num + k]) ||
+            (waiting && !ring_empty(&bs->fwd[k * bc->num + bc->id])))
+        {
+            share->interrupt(share->interrupt_context);
+        }
+    }
+}
+
+/* the receive from the base module can block until interrupted */
+static unsigned receive_local(BalanceContext* bc, unsigned max_recv, const DAQ_Msg_t* msgs[], DAQ_RecvStatus* rstat)
+{
+    BalanceShared* bs = shared;
+    unsigned want = (max_recv < bc->local_size) ? max_recv : bc->local_size;
+
+    __atomic_store_n(&bc->share->waiting, true, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    wake_peers(bc, true);
+
+    unsigned num_recv = CALL_SUBAPI(bc, msg_receive, want, bc->local, rstat);
+
+    __atomic_store_n(&bc->share->waiting, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&bc->share->backlog, num_recv, __ATOMIC_RELAXED);
+
+    if (!num_recv)
+        return 0;
+
+    uint32_t now = coarse_seconds();
+    unsigned idx = 0;
+    bool handed_off = false;
+
+    for (unsigned i = 0; i < num_recv; ++i)
+    {
+        const DAQ_Msg_t* msg = bc->local[i];
+        unsigned to = steer(bc, msg, now);
+
+        if (to != bc->id)
+        {
+            /* counted first so the receiver can never take it below zero */
+            __atomic_fetch_add(&bs->shares[to].pending, 1, __ATOMIC_RELAXED);
+
+            /* the ring holds all of this instance's messages so it can't fill */
+            if (ring_push(&bs->fwd[bc->id * bc->num + to], msg, DAQ_VERDICT_PASS))
+            {
+                bc->outstanding++;
+                bc->stats.forwarded++;
+                handed_off = true;
+                continue;
+            }
+            __atomic_fetch_sub(&bs->shares[to].pending, 1, __ATOMIC_RELAXED);
+        }
+        msgs[idx++] = msg;
+    }
+
+    if (handed_off)
+    {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        wake_peers(bc, false);
+    }
+    return idx;
+}
+
+/* at stop, handoffs that won't be inspected go back with a pass */
+static void return_handoffs(BalanceContext* bc)
+{
+    BalanceShared* bs = shared;
+    BalanceSlot slot;
+
+    for (unsigned k = 0; k < bc->num; ++k)
+    {
+        if (k == bc->id)
+            continue;
+
+        BalanceRing* ring = &bs->fwd[k * bc->num + bc->id];
+
+        while (ring_pop(ring, &slot))
+        {
+            ring_push(&bs->ret[bc->id * bc->num + k], slot.msg, DAQ_VERDICT_PASS);
+            __atomic_fetch_sub(&bc->share->pending, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// shared state
+//-------------------------------------------------------------------------
+
+static void free_shared(BalanceShared* bs)
+{
+    unsigned rings = bs->num * bs->num;
+
+    if (bs->fwd)
+    {
+        for (unsigned i = 0; i < rings; ++i)
+            free(bs->fwd[i].slots);
+        free(bs->fwd);
+    }
+    if (bs->ret)
+    {
+        for (unsigned i = 0; i < rings; ++i)
+            free(bs->ret[i].slots);
+        free(bs->ret);
+    }
+    free(bs->shares);
+    free(bs->table);
+    free(bs);
+}
+
+static void* alloc_aligned(size_t size)
+{
+    void* p;
+
+    if (posix_memalign(&p, 64, size))
+        return NULL;
+
+    memset(p, 0, size);
+    return p;
+}
+
+static BalanceShared* create_shared(const BalanceContext* bc)
+{
+    BalanceShared* bs = (BalanceShared*)calloc(1, sizeof(*bs));
+
+    if (!bs)
+        return NULL;
+
+    bs->num = bc->num;
+    bs->idle = bc->idle;
+
+    uint32_t buckets = pow2_at_least(bc->buckets);
+    bs->mask = buckets - 1;
+    bs->table = (uint64_t*)calloc(buckets, sizeof(*bs->table));
+
+    size_t rings = (size_t)bc->num * bc->num;
+    bs->shares = (BalanceShare*)alloc_aligned(bc->num * sizeof(*bs->shares));
+    bs->fwd = (BalanceRing*)alloc_aligned(rings * sizeof(*bs->fwd));
+    bs->ret = (BalanceRing*)alloc_aligned(rings * sizeof(*bs->ret));
+
+    if (!bs->table || !bs->shares || !bs->fwd || !bs->ret)
+    {
+        free_shared(bs);
+        return NULL;
+    }
+    return bs;
+}
+
+/* each instance sizes the rings its messages travel on by its own pool */
+static int join_shared(BalanceContext* bc, uint32_t pool_size)
+{
+    int rval = DAQ_SUCCESS;
+
+    pthread_mutex_lock(&shared_lock);
+
+    if (!shared && !(shared = create_shared(bc)))
+    {
+        SET_ERROR(bc->modinst, "%s: Couldn't allocate the shared state", DAQ_NAME);
+        rval = DAQ_ERROR_NOMEM;
+    }
+    else if (shared->num != bc->num)
+    {
+        SET_ERROR(bc->modinst, "%s: Instance count %u doesn't match %u", DAQ_NAME, bc->num, shared->num);
+        rval = DAQ_ERROR_INVAL;
+    }
+    else
+    {
+        shared->refs++;
+        bc->share = &shared->shares[bc->id];
+
+        for (unsigned k = 0; k < bc->num; ++k)
+        {
+            if (k == bc->id)
+                continue;
+
+            if (!ring_init(&shared->fwd[bc->id * bc->num + k], pool_size) ||
+                !ring_init(&shared->ret[k * bc->num + bc->id], pool_size))
+            {
+                SET_ERROR(bc->modinst, "%s: Couldn't allocate the handoff rings", DAQ_NAME);
+                rval = DAQ_ERROR_NOMEM;
+                break;
+            }
+        }
+
+        BalanceShare* share = bc->share;
+        share->running = share->waiting = false;
+        share->pending = share->held = share->backlog = 0;
+        share->interrupt = bc->subapi.interrupt.func;
+        share->interrupt_context = bc->subapi.interrupt.context;
+    }
+
+    pthread_mutex_unlock(&shared_lock);
+    return rval;
+}
+
+static void leave_shared(BalanceContext* bc)
+{
+    pthread_mutex_lock(&shared_lock);
+
+    if (!--shared->refs)
+    {
+        free_shared(shared);
+        shared = NULL;
+    }
+    bc->share = NULL;
+
+    pthread_mutex_unlock(&shared_lock);
+}
+
+//-------------------------------------------------------------------------
+// daq module functions
+//-------------------------------------------------------------------------
+
+static int balance_daq_module_load(const DAQ_BaseAPI_t* base_api)
+{
+    if (base_api->api_version != DAQ_BASE_API_VERSION || base_api->api_size != sizeof(DAQ_BaseAPI_t))
+        return DAQ_ERROR;
+
+    daq_base_api = *base_api;
+
+    return DAQ_SUCCESS;
+}
+
+static int balance_daq_get_variable_descs(const DAQ_VariableDesc_t** var_desc_table)
+{
+    *var_desc_table = balance_variable_descriptions;
+
+    return sizeof(balance_variable_descriptions) / sizeof(DAQ_VariableDesc_t);
+}
+
+static void balance_daq_destroy(void* handle);
+
+static int balance_daq_instantiate(const DAQ_ModuleConfig_h modcfg, DAQ_ModuleInstance_h modinst, void** ctxt_ptr)
+{
+    BalanceContext* bc;
+    int rval = DAQ_ERROR;
+    unsigned id;
+
+    bc = (BalanceContext*)calloc(1, sizeof(*bc));
+    if (!bc)
+    {
+        SET_ERROR(modinst, "%s: Couldn't allocate memory for the new Balance context!", DAQ_NAME);
+        return DAQ_ERROR_NOMEM;
+    }
+    bc->modinst = modinst;
+    bc->dlt = -1;
+    bc->buckets = BALANCE_DEFAULT_BUCKETS;
+    bc->idle = BALANCE_DEFAULT_IDLE;
+
+    const char* varKey, * varValue;
+    daq_base_api.config_first_variable(modcfg, &varKey, &varValue);
+    while (varKey)
+    {
+        if (!strcmp(varKey, "buckets"))
+        {
+            bc->buckets = strtoul(varValue, NULL, 10);
+
+            if (!bc->buckets || bc->buckets > BALANCE_MAX_BUCKETS)
+            {
+                SET_ERROR(modinst, "%s: Invalid bucket count: '%s'", DAQ_NAME, varValue);
+                rval = DAQ_ERROR_INVAL;
+                goto err;
+            }
+        }
+        else if (!strcmp(varKey, "idle"))
+            bc->idle = strtoul(varValue, NULL, 10);
+        else
+        {
+            SET_ERROR(modinst, "%s: Unknown variable name: '%s'", DAQ_NAME, varKey);
+            rval = DAQ_ERROR_INVAL;
+            goto err;
+        }
+
+        daq_base_api.config_next_variable(modcfg, &varKey, &varValue);
+    }
+
+    if (daq_base_api.resolve_subapi(modinst, &bc->subapi) != DAQ_SUCCESS)
+    {
+        SET_ERROR(modinst, "%s: Couldn't resolve subapi. No submodule?", DAQ_NAME);
+        rval = DAQ_ERROR_INVAL;
+        goto err;
+    }
+
+    /* a single instance just passes everything through */
+    bc->num = daq_base_api.config_get_total_instances(modcfg);
+    id = daq_base_api.config_get_instance_id(modcfg);
+
+    if (bc->num > 1)
+    {
+        if (bc->num > BALANCE_MAX_INSTANCES || !id || id > bc->num)
+        {
+            SET_ERROR(modinst, "%s: Unsupported instance %u of %u", DAQ_NAME, id, bc->num);
+            rval = DAQ_ERROR_INVAL;
+            goto err;
+        }
+        bc->id = id - 1;
+
+        DAQ_MsgPoolInfo_t info;
+        if ((rval = CALL_SUBAPI(bc, get_msg_pool_info, &info)) != DAQ_SUCCESS)
+        {
+            SET_ERROR(modinst, "%s: Couldn't get the submodule's message pool info", DAQ_NAME);
+            goto err;
+        }
+
+        /* the caller never holds more than the pool so neither can the table */
+        bc->local_size = info.size ? info.size : 1;
+        bc->held_mask = pow2_at_least(bc->local_size * 2) - 1;
+        bc->local = (const DAQ_Msg_t**)calloc(bc->local_size, sizeof(*bc->local));
+        bc->held = (BalanceHeld*)calloc(bc->held_mask + 1, sizeof(*bc->held));
+
+        if (!bc->local || !bc->held)
+        {
+            SET_ERROR(modinst, "%s: Couldn't allocate the message tables", DAQ_NAME);
+            rval = DAQ_ERROR_NOMEM;
+            goto err;
+        }
+
+        if ((rval = join_shared(bc, bc->local_size)) != DAQ_SUCCESS)
+            goto err;
+    }
+
+    *ctxt_ptr = bc;
+
+    return DAQ_SUCCESS;
+
+err:
+    balance_daq_destroy(bc);
+    return rval;
+}
+
+static void balance_daq_destroy(void* handle)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+
+    if (bc->share)
+        leave_shared(bc);
+
+    free(bc->local);
+    free(bc->held);
+    free(bc);
+}
+
+static int balance_daq_start(void* handle)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+    int rval = CALL_SUBAPI_NOARGS(bc, start);
+
+    if (rval != DAQ_SUCCESS)
+        return rval;
+
+    bc->dlt = CALL_SUBAPI_NOARGS(bc, get_datalink_type);
+
+    if (bc->share)
+        __atomic_store_n(&bc->share->running, true, __ATOMIC_RELEASE);
+
+    return DAQ_SUCCESS;
+}
+
+static int balance_daq_inject_relative(void* handle, const DAQ_Msg_t* msg, const uint8_t* data, uint32_t data_len, int reverse)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+
+    /* the submodule that could inject relative to a handoff belongs to another instance */
+    if (bc->share && held_find(bc, msg) >= 0)
+        return DAQ_ERROR_NOTSUP;
+
+    if (!CHECK_SUBAPI(bc, inject_relative))
+        return DAQ_ERROR_NOTSUP;
+
+    return CALL_SUBAPI(bc, inject_relative, msg, data, data_len, reverse);
+}
+
+static int balance_daq_interrupt(void* handle)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+
+    if (!CHECK_SUBAPI(bc, interrupt))
+        return DAQ_ERROR_NOTSUP;
+
+    bc->interrupted = true;
+
+    return CALL_SUBAPI_NOARGS(bc, interrupt);
+}
+
+static int balance_daq_stop(void* handle)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+
+    if (bc->share)
+    {
+        __atomic_store_n(&bc->share->running, false, __ATOMIC_SEQ_CST);
+
+        /* others may still be handing off until they see this one stopped */
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        while (true)
+        {
+            return_handoffs(bc);
+            take_returns(bc);
+
+            uint64_t ms = elapsed_ms(&start);
+
+            if ((ms >= BALANCE_STOP_GRACE_MS && !bc->outstanding) || ms >= BALANCE_STOP_WAIT_MS)
+                break;
+
+            usleep(1000);
+        }
+    }
+
+    return CALL_SUBAPI_NOARGS(bc, stop);
+}
+
+static int balance_daq_ioctl(void* handle, DAQ_IoctlCmd cmd, void* arg, size_t arglen)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+
+    if (cmd == DIOCTL_GET_BALANCE_STATS)
+    {
+        if (arglen != sizeof(DIOCTL_GetBalanceStats))
+            return DAQ_ERROR_INVAL;
+
+        DIOCTL_GetBalanceStats* gbs = (DIOCTL_GetBalanceStats*) arg;
+        *gbs = bc->stats;
+        gbs->load = bc->share ? share_load(bc->share) : 0;
+
+        return DAQ_SUCCESS;
+    }
+
+    /* the per message commands lead with the message */
+    if (bc->share && arg && arglen >= sizeof(DAQ_Msg_h))
+    {
+        DAQ_Msg_h msg;
+        memcpy(&msg, arg, sizeof(msg));
+
+        if (held_find(bc, msg) >= 0)
+            return DAQ_ERROR_NOTSUP;
+    }
+
+    if (!CHECK_SUBAPI(bc, ioctl))
+        return DAQ_ERROR_NOTSUP;
+
+    return CALL_SUBAPI(bc, ioctl, cmd, arg, arglen);
+}
+
+static unsigned balance_daq_msg_receive(void* handle, const unsigned max_recv, const DAQ_Msg_t* msgs[], DAQ_RecvStatus* rstat)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+
+    if (!bc->share)
+        return CALL_SUBAPI(bc, msg_receive, max_recv, msgs, rstat);
+
+    DAQ_RecvStatus status = DAQ_RSTAT_OK;
+    unsigned idx = 0;
+
+    take_returns(bc);
+
+    /* handoffs and the local queue take turns so that neither starves the
+       other; the local receive can block but instances with handoffs for
+       this one interrupt it */
+    if (!bc->local_turn)
+        idx = adopt(bc, max_recv, msgs);
+
+    if (idx)
+        bc->local_turn = true;
+
+    else if (max_recv)
+    {
+        idx = receive_local(bc, max_recv, msgs, &status);
+        idx += adopt(bc, max_recv - idx, msgs + idx);
+        bc->local_turn = false;
+
+        if (status == DAQ_RSTAT_INTERRUPTED)
+        {
+            if (bc->interrupted)
+                bc->interrupted = false;
+            else
+                status = DAQ_RSTAT_OK;
+        }
+        /* the pool is only empty until others return what they hold */
+        else if (status == DAQ_RSTAT_NOBUF && bc->outstanding)
+            status = DAQ_RSTAT_WOULD_BLOCK;
+    }
+
+    __atomic_fetch_add(&bc->share->held, idx, __ATOMIC_RELAXED);
+
+    *rstat = status;
+    return idx;
+}
+
+static int balance_daq_msg_finalize(void* handle, const DAQ_Msg_t* msg, DAQ_Verdict verdict)
+{
+    BalanceContext* bc = (BalanceContext*) handle;
+
+    if (!bc->share)
+        return CALL_SUBAPI(bc, msg_finalize, msg, verdict);
+
+    __atomic_fetch_sub(&bc->share->held, 1, __ATOMIC_RELAXED);
+
+    int i = held_find(bc, msg);
+
+    if (i < 0)
+        return CALL_SUBAPI(bc, msg_finalize, msg, verdict);
+
+    /* the origin finalizes it on its own thread */
+    unsigned origin = bc->held[i].origin;
+    held_remove(bc, (uint32_t)i);
+
+    /* sized for all of the origin's messages so this only waits on a bug */
+    BalanceRing* ring = &shared->ret[bc->id * bc->num + origin];
+
+    while (!ring_push(ring, msg, verdict))
+        sched_yield();
+
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+#ifdef BUILDING_SO
+DAQ_SO_PUBLIC const DAQ_ModuleAPI_t DAQ_MODULE_DATA =
+#else
+const DAQ_ModuleAPI_t balance_daq_module_data =
+#endif
+{
+    /* .api_version = */ DAQ_MODULE_API_VERSION,
+    /* .api_size = */ sizeof(DAQ_ModuleAPI_t),
+    /* .module_version = */ DAQ_MOD_VERSION,
+    /* .name = */ DAQ_NAME,
+    /* .type = */ DAQ_TYPE,
+    /* .load = */ balance_daq_module_load,
+    /* .unload = */ NULL,
+    /* .get_variable_descs = */ balance_daq_get_variable_descs,
+    /* .instantiate = */ balance_daq_instantiate,
+    /* .destroy = */ balance_daq_destroy,
+    /* .set_filter = */ NULL,
+    /* .start = */ balance_daq_start,
+    /* .inject = */ NULL,
+    /* .inject_relative = */ balance_daq_inject_relative,
+    /* .interrupt = */ balance_daq_interrupt,
+    /* .stop = */ balance_daq_stop,
+    /* .ioctl = */ balance_daq_ioctl,
+    /* .get_stats = */ NULL,
+    /* .reset_stats = */ NULL,
+    /* .get_snaplen = */ NULL,
+    /* .get_capabilities = */ NULL,
+    /* .get_datalink_type = */ NULL,
+    /* .config_load = */ NULL,
+    /* .config_swap = */ NULL,
+    /* .config_free = */ NULL,
+    /* .msg_receive = */ balance_daq_msg_receive,
+    /* .msg_finalize = */ balance_daq_msg_finalize,
+    /* .get_msg_pool_info = */ NULL,
+};
@@ -0,0 +1,41 @@
+/*--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+*/
+/* daq_balance.h - the statistics of the balance DAQ */
+/* this is a C include, not C++ */
+
+#ifndef DAQ_BALANCE_H
+#define DAQ_BALANCE_H
+
+#include <stdint.h>
+#include <daq_common.h>
+
+/* counts are since the instance was instantiated except for load */
+#define DIOCTL_GET_BALANCE_STATS    (DAQ_IoctlCmd) 2049
+typedef struct
+{
+    uint64_t load;          /* messages handed to or held by this instance */
+    uint64_t forwarded;     /* packets handed to other instances */
+    uint64_t adopted;       /* packets handed to this instance */
+    uint64_t assigned;      /* flow buckets given an owner by this instance */
+    uint64_t moved;         /* assigned to an instance other than this one */
+    uint64_t reassigned;    /* assigned after going idle or losing their owner */
+    uint64_t unsteered;     /* messages kept here because they couldn't be hashed */
+} DIOCTL_GetBalanceStats;
+
+#endif
@@ -30,6 +30,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -66,6 +68,7 @@ typedef struct
     /* Configuration */
     char* filename;
     unsigned snaplen;
+    bool mmap;
 
     /* State */
     DAQ_ModuleInstance_h modinst;
@@ -73,6 +76,11 @@ typedef struct
     int fid;
     volatile bool interrupted;
 
+    /* mmap mode, NULL if the input is read instead */
+    uint8_t* map;
+    size_t map_size;
+    size_t map_off;
+
     bool sof;
     bool eof;
 
@@ -80,6 +88,10 @@ typedef struct
     DAQ_Stats_t stats;
 } FileContext;
 
+static DAQ_VariableDesc_t file_variable_descriptions[] = {
+    { "mmap", "Map the input file and pass messages that point into it instead of reading copies", DAQ_VAR_DESC_FORBIDS_ARGUMENT },
+};
+
 static DAQ_BaseAPI_t daq_base_api;
 
 //-------------------------------------------------------------------------
@@ -92,7 +104,11 @@ static void destroy_message_pool(FileContext* fc)
     if (pool->pool)
     {
         while (pool->info.size > 0)
-            free(pool->pool[--pool->info.size].data);
+        {
+            FileMsgDesc* desc = &pool->pool[--pool->info.size];
+            if (!fc->mmap)
+                free(desc->data);
+        }
         free(pool->pool);
         pool->pool = NULL;
     }
@@ -104,7 +120,7 @@ static void destroy_message_pool(FileContext* fc)
 static int create_message_pool(FileContext* fc, unsigned size)
 {
     FileMsgPool* pool = &fc->pool;
-    pool->pool = calloc(sizeof(FileMsgDesc), size);
+    pool->pool = (FileMsgDesc*)calloc(sizeof(FileMsgDesc), size);
     if (!pool->pool)
     {
         SET_ERROR(fc->modinst, "%s: Could not allocate %zu bytes for a packet descriptor pool!",
@@ -116,14 +132,19 @@ static int create_message_pool(FileContext* fc, unsigned size)
     {
         /* Allocate packet data and set up descriptor */
         FileMsgDesc *desc = &pool->pool[pool->info.size];
-        desc->data = malloc(fc->snaplen);
-        if (!desc->data)
+
+        /* Mapped messages point into the file and need no buffer of their own. */
+        if (!fc->mmap)
         {
-            SET_ERROR(fc->modinst, "%s: Could not allocate %d bytes for a packet descriptor message buffer!",
-                    __func__, fc->snaplen);
-            return DAQ_ERROR_NOMEM;
+            desc->data = (uint8_t*)malloc(fc->snaplen);
+            if (!desc->data)
+            {
+                SET_ERROR(fc->modinst, "%s: Could not allocate %d bytes for a packet descriptor message buffer!",
+                        __func__, fc->snaplen);
+                return DAQ_ERROR_NOMEM;
+            }
+            pool->info.mem_size += fc->snaplen;
         }
-        pool->info.mem_size += fc->snaplen;
 
         /* Initialize non-zero invariant packet header fields. */
         DAQ_PktHdr_t *pkthdr = &desc->pkthdr;
@@ -151,6 +172,44 @@ static int create_message_pool(FileContext* fc, unsigned size)
 // file functions
 //-------------------------------------------------------------------------
 
+static int file_map(FileContext* fc)
+{
+    struct stat st;
+
+    if ( fc->fid == STDIN_FILENO || fstat(fc->fid, &st) || !S_ISREG(st.st_mode) )
+    {
+        SET_ERROR(fc->modinst, "%s: can't map %s, it is not a regular file", DAQ_NAME, fc->filename);
+        return -1;
+    }
+
+    fc->map_size = st.st_size;
+    fc->map_off = 0;
+
+    /* an empty file has nothing to map and goes straight to end of flow */
+    if ( !fc->map_size )
+        return 0;
+
+    /* private so that messages modified in place don't change the file */
+    void* map = mmap(NULL, fc->map_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fc->fid, 0);
+
+    if ( map == MAP_FAILED )
+    {
+        char error_msg[1024] = {0};
+        if (strerror_r(errno, error_msg, sizeof(error_msg)) == 0)
+            SET_ERROR(fc->modinst, "%s: can't map file (%s)", DAQ_NAME, error_msg);
+        else
+            SET_ERROR(fc->modinst, "%s: can't map file: %d", DAQ_NAME, errno);
+        fc->map_size = 0;
+        return -1;
+    }
+
+    /* a hint only, the file is read front to back exactly once */
+    madvise(map, fc->map_size, MADV_SEQUENTIAL);
+
+    fc->map = (uint8_t*)map;
+    return 0;
+}
+
 static int file_setup(FileContext* fc)
 {
     if ( !strcmp(fc->filename, "tty") )
@@ -170,11 +229,20 @@ static int file_setup(FileContext* fc)
     fc->sof = true;
     fc->eof = false;
 
+    if ( fc->mmap )
+        return file_map(fc);
+
     return 0;
 }
 
 static void file_cleanup(FileContext* fc)
 {
+    if ( fc->map )
+        munmap(fc->map, fc->map_size);
+
+    fc->map = NULL;
+    fc->map_size = fc->map_off = 0;
+
     if ( fc->fid > STDIN_FILENO )
         close(fc->fid);
 
@@ -212,7 +280,22 @@ static void init_packet_message(FileContext* fc, FileMsgDesc* desc)
 static DAQ_RecvStatus file_read_message(FileContext* fc, FileMsgDesc* desc)
 {
     desc->msg.data = NULL;
-    int n = read(fc->fid, desc->data, fc->snaplen);
+    int n;
+
+    if ( fc->mmap )
+    {
+        size_t left = fc->map_size - fc->map_off;
+        n = left < fc->snaplen ? left : fc->snaplen;
+
+        /* an empty file has no mapping to point into */
+        if ( n )
+        {
+            desc->data = fc->map + fc->map_off;
+            fc->map_off += n;
+        }
+    }
+    else
+        n = read(fc->fid, desc->data, fc->snaplen);
 
     if ( n )
     {
@@ -261,24 +344,48 @@ static int file_daq_module_load(const DAQ_BaseAPI_t* base_api)
     return DAQ_SUCCESS;
 }
 
+static int file_daq_get_variable_descs(const DAQ_VariableDesc_t** var_desc_table)
+{
+    *var_desc_table = file_variable_descriptions;
+
+    return sizeof(file_variable_descriptions) / sizeof(DAQ_VariableDesc_t);
+}
+
 static int file_daq_instantiate(const DAQ_ModuleConfig_h modcfg, DAQ_ModuleInstance_h modinst, void** ctxt_ptr)
 {
     FileContext* fc;
     int rval = DAQ_ERROR;
+    const char* filename;
+    uint32_t pool_size;
 
-    fc = calloc(1, sizeof(*fc));
+    fc = (FileContext*)calloc(1, sizeof(*fc));
     if (!fc)
     {
         SET_ERROR(modinst, "%s: Couldn't allocate memory for the new File context!", DAQ_NAME);
-        rval = DAQ_ERROR_NOMEM;
-        goto err;
+        return DAQ_ERROR_NOMEM;
     }
     fc->modinst = modinst;
 
     fc->snaplen = daq_base_api.config_get_snaplen(modcfg) ? daq_base_api.config_get_snaplen(modcfg) : FILE_BUF_SZ;
     fc->fid = -1;
 
-    const char* filename = daq_base_api.config_get_input(modcfg);
+    const char* varKey, * varValue;
+    daq_base_api.config_first_variable(modcfg, &varKey, &varValue);
+    while (varKey)
+    {
+        if (!strcmp(varKey, "mmap"))
+            fc->mmap = true;
+        else
+        {
+            SET_ERROR(modinst, "%s: Unknown variable name: '%s'", DAQ_NAME, varKey);
+            rval = DAQ_ERROR_INVAL;
+            goto err;
+        }
+
+        daq_base_api.config_next_variable(modcfg, &varKey, &varValue);
+    }
+
+    filename = daq_base_api.config_get_input(modcfg);
     if (filename)
     {
         if (!(fc->filename = strdup(filename)))
@@ -289,7 +396,7 @@ static int file_daq_instantiate(const DAQ_ModuleConfig_h modcfg, DAQ_ModuleInsta
         }
     }
 
-    uint32_t pool_size = daq_base_api.config_get_msg_pool_size(modcfg);
+    pool_size = daq_base_api.config_get_msg_pool_size(modcfg);
     rval = create_message_pool(fc, pool_size ? pool_size : FILE_DEFAULT_POOL_SIZE);
     if (rval != DAQ_SUCCESS)
         goto err;
@@ -478,7 +585,7 @@ const DAQ_ModuleAPI_t file_daq_module_data =
     /* .type = */ DAQ_TYPE,
     /* .load = */ file_daq_module_load,
     /* .unload = */ NULL,
-    /* .get_variable_descs = */ NULL,
+    /* .get_variable_descs = */ file_daq_get_variable_descs,
     /* .instantiate = */ file_daq_instantiate,
     /* .destroy = */ file_daq_destroy,
     /* .set_filter = */ NULL,
@@ -0,0 +1,1371 @@
+/*--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+*/
+/* daq_gen.c - generates synthetic traffic in memory and measures how fast
+ * the application consumes it */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GEN_HAVE_TSC
+#endif
+
+#include <daq_dlt.h>
+#include <daq_module_api.h>
+
+#define DAQ_MOD_VERSION 0
+#define DAQ_NAME "gen"
+#define DAQ_TYPE (DAQ_TYPE_INTF_CAPABLE|DAQ_TYPE_MULTI_INSTANCE)
+
+#define GEN_DEFAULT_POOL_SIZE 256
+#define GEN_DEFAULT_SNAPLEN 1518
+
+#define GEN_DEFAULT_FLOWS 1000
+#define GEN_DEFAULT_PACKETS 1000000
+#define GEN_DEFAULT_SIZE 16384
+#define GEN_DEFAULT_EXCHANGES 4
+#define GEN_DEFAULT_MIX "http:1,tls:1,dns:1,smb:1"
+
+#define ETH_HDR_LEN 14
+#define IP_HDR_LEN 20
+#define TCP_HDR_LEN 20
+#define UDP_HDR_LEN 8
+#define MAX_MSS 1460
+
+#define TH_FIN 0x01
+#define TH_SYN 0x02
+#define TH_PUSH 0x08
+#define TH_ACK 0x10
+
+/* latency histogram, 16 linear buckets per power of 2 */
+#define LAT_SUB_BITS 4
+#define LAT_SUB (1 << LAT_SUB_BITS)
+#define LAT_MAX_MSB 47
+#define LAT_BUCKETS ((LAT_MAX_MSB - LAT_SUB_BITS + 2) * LAT_SUB)
+
+#define SET_ERROR(modinst, ...)    daq_base_api.set_errbuf(modinst, __VA_ARGS__)
+
+typedef struct _gen_msg_desc
+{
+    DAQ_Msg_t msg;
+    DAQ_PktHdr_t pkthdr;
+    uint64_t recv_ns;
+    uint8_t* data;
+    struct _gen_msg_desc* next;
+} GenMsgDesc;
+
+typedef struct
+{
+    GenMsgDesc* pool;
+    GenMsgDesc* freelist;
+    DAQ_MsgPoolInfo_t info;
+} GenMsgPool;
+
+/* a payload template and the checksum of each segment it is cut into */
+typedef struct
+{
+    uint8_t* data;
+    unsigned len;
+    uint32_t* sums;
+} GenPayload;
+
+typedef enum { GEN_HTTP, GEN_TLS, GEN_DNS, GEN_SMB, GEN_MAX_PROTO } GenProtoId;
+
+/* the first exchange of a flow uses the first request and response and
+ * later exchanges use the second */
+typedef struct
+{
+    const char* name;
+    uint8_t ip_proto;
+    uint16_t port;
+    unsigned weight;
+    GenPayload req[2];
+    GenPayload rsp[2];
+} GenProto;
+
+typedef enum
+{
+    FLOW_SYN, FLOW_SYN_ACK, FLOW_ACK, FLOW_REQUEST, FLOW_RESPONSE, FLOW_CLIENT_ACK,
+    FLOW_CLIENT_FIN, FLOW_SERVER_FIN, FLOW_LAST_ACK, FLOW_DONE
+} GenFlowState;
+
+#define NO_HELD (~0u)
+
+typedef struct
+{
+    const GenProto* proto;
+    uint32_t cli_addr;
+    uint32_t srv_addr;
+    uint16_t cli_port;
+    uint16_t srv_port;
+
+    /* sequence numbers at the start of the current request and response */
+    uint32_t cli_seq;
+    uint32_t srv_seq;
+
+    GenFlowState state;
+    unsigned exchange;
+    unsigned off;       /* next payload offset to send */
+    unsigned held;      /* offset of a segment sent after its successor */
+    unsigned unacked;   /* server segments since the last client ack */
+} GenFlow;
+
+typedef struct
+{
+    /* Configuration */
+    unsigned snaplen;
+    unsigned mss;
+    unsigned num_flows;
+    uint64_t max_packets;
+    unsigned size;
+    unsigned exchanges;
+    unsigned ooo;
+    uint64_t seed;
+    char* report;
+
+    /* State */
+    DAQ_ModuleInstance_h modinst;
+    GenMsgPool pool;
+    volatile bool interrupted;
+    unsigned instance;
+
+    GenProto protos[GEN_MAX_PROTO];
+    unsigned total_weight;
+
+    GenFlow* flows;
+    unsigned next_flow;
+    uint64_t flow_count;
+    uint64_t rand;
+    uint16_t ip_id;
+    struct timeval ts;
+
+    /* Measurements */
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t flows_done;
+    uint64_t out_of_order;
+    uint64_t start_ns;
+    uint64_t last_ns;
+    uint64_t start_tsc;
+    uint64_t last_tsc;
+    uint64_t lat_max;
+    uint64_t lat[LAT_BUCKETS];
+
+    DAQ_Stats_t stats;
+} GenContext;
+
+static DAQ_VariableDesc_t gen_variable_descriptions[] = {
+    { "mix", "Weighted protocols to generate (default " GEN_DEFAULT_MIX ")", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "flows", "Number of concurrent flows (default 1000)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "packets", "Number of packets to generate, 0 for no limit (default 1000000)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "size", "Bytes in each TCP response (default 16384)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "exchanges", "Requests and responses per flow (default 4)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "ooo", "Percent of data segments sent after their successor (default 0)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "seed", "Seed for the random choices (default 0)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "report", "Append a JSON summary to this file instead of stdout when stopped", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+};
+
+static DAQ_BaseAPI_t daq_base_api;
+static unsigned gen_instances = 0;
+
+//-------------------------------------------------------------------------
+// utility functions
+//-------------------------------------------------------------------------
+
+static uint64_t get_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static uint64_t get_tsc(void)
+{
+#ifdef GEN_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static unsigned get_random(GenContext* gc, unsigned n)
+{
+    /* xorshift64 */
+    gc->rand ^= gc->rand << 13;
+    gc->rand ^= gc->rand >> 7;
+    gc->rand ^= gc->rand << 17;
+    return (unsigned)(gc->rand % n);
+}
+
+static uint32_t sum16(const uint8_t* p, unsigned n)
+{
+    uint32_t sum = 0;
+
+    for ( ; n > 1; p += 2, n -= 2 )
+        sum += (p[0] << 8) | p[1];
+
+    if ( n )
+        sum += p[0] << 8;
+
+    return sum;
+}
+
+static uint16_t fold16(uint32_t sum)
+{
+    while ( sum >> 16 )
+        sum = (sum & 0xffff) + (sum >> 16);
+
+    return (uint16_t)~sum;
+}
+
+static unsigned lat_bucket(uint64_t v)
+{
+    if ( v < LAT_SUB )
+        return (unsigned)v;
+
+    unsigned msb = 63 - __builtin_clzll(v);
+
+    if ( msb > LAT_MAX_MSB )
+        return LAT_BUCKETS - 1;
+
+    unsigned shift = msb - LAT_SUB_BITS;
+    return (msb - LAT_SUB_BITS + 1) * LAT_SUB + (unsigned)((v >> shift) & (LAT_SUB - 1));
+}
+
+/* lower bound of the bucket */
+static uint64_t lat_value(unsigned idx)
+{
+    if ( idx < LAT_SUB )
+        return idx;
+
+    unsigned msb = idx / LAT_SUB + LAT_SUB_BITS - 1;
+    uint64_t sub = idx % LAT_SUB;
+    return (LAT_SUB + sub) << (msb - LAT_SUB_BITS);
+}
+
+static uint64_t lat_percentile(GenContext* gc, double pct)
+{
+    uint64_t n = 0;
+
+    for ( unsigned i = 0; i < LAT_BUCKETS; ++i )
+        n += gc->lat[i];
+
+    if ( !n )
+        return 0;
+
+    uint64_t want = (uint64_t)(pct * n / 100.0);
+    uint64_t seen = 0;
+
+    if ( want >= n )
+        want = n - 1;
+
+    for ( unsigned i = 0; i < LAT_BUCKETS; ++i )
+    {
+        seen += gc->lat[i];
+
+        if ( seen > want )
+            return lat_value(i);
+    }
+    return gc->lat_max;
+}
+
+//-------------------------------------------------------------------------
+// payloads
+//-------------------------------------------------------------------------
+
+static void fill(uint8_t* p, unsigned n, GenContext* gc)
+{
+    static const char* text = "the quick brown fox jumps over the lazy dog 0123456789\n";
+    unsigned tlen = strlen(text);
+
+    for ( unsigned i = 0; i < n; ++i )
+        p[i] = text[(i + gc->seed) % tlen];
+}
+
+static uint8_t* put16(uint8_t* p, uint16_t v)
+{
+    *p++ = v >> 8;
+    *p++ = v & 0xff;
+    return p;
+}
+
+static uint8_t* put24(uint8_t* p, uint32_t v)
+{
+    *p++ = (v >> 16) & 0xff;
+    return put16(p, v & 0xffff);
+}
+
+static uint8_t* put32le(uint8_t* p, uint32_t v)
+{
+    for ( unsigned i = 0; i < 4; ++i )
+        *p++ = (v >> (8 * i)) & 0xff;
+    return p;
+}
+
+static int set_payload(GenContext* gc, GenPayload* pay, const uint8_t* data, unsigned len)
+{
+    unsigned nseg = len ? (len + gc->mss - 1) / gc->mss : 0;
+
+    pay->data = malloc(len ? len : 1);
+    pay->sums = calloc(nseg ? nseg : 1, sizeof(*pay->sums));
+
+    if ( !pay->data || !pay->sums )
+        return DAQ_ERROR_NOMEM;
+
+    memcpy(pay->data, data, len);
+    pay->len = len;
+
+    for ( unsigned i = 0; i < nseg; ++i )
+    {
+        unsigned off = i * gc->mss;
+        unsigned n = len - off < gc->mss ? len - off : gc->mss;
+        pay->sums[i] = sum16(pay->data + off, n);
+    }
+    return DAQ_SUCCESS;
+}
+
+static int make_http(GenContext* gc, GenProto* gp, uint8_t* buf)
+{
+    const char* req =
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: daq_gen\r\n"
+        "Accept: */*\r\n"
+        "\r\n";
+
+    int rval = set_payload(gc, &gp->req[0], (const uint8_t*)req, strlen(req));
+
+    if ( rval != DAQ_SUCCESS )
+        return rval;
+
+    int n = snprintf((char*)buf, gc->size + 128,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/html\r\n"
+        "Content-Length: %u\r\n"
+        "\r\n", gc->size);
+
+    fill(buf + n, gc->size, gc);
+
+    if ( (rval = set_payload(gc, &gp->rsp[0], buf, n + gc->size)) != DAQ_SUCCESS )
+        return rval;
+
+    gp->req[1] = gp->req[0];
+    gp->rsp[1] = gp->rsp[0];
+    return DAQ_SUCCESS;
+}
+
+static uint8_t* tls_record(uint8_t* p, uint8_t type, const uint8_t* body, unsigned len)
+{
+    *p++ = type;
+    p = put16(p, 0x0303);
+    p = put16(p, len);
+    memcpy(p, body, len);
+    return p + len;
+}
+
+static uint8_t* tls_app_data(GenContext* gc, uint8_t* p, unsigned len)
+{
+    /* records are limited to 16K so larger responses are split */
+    while ( len )
+    {
+        unsigned n = len < 16384 ? len : 16384;
+        *p++ = 0x17;
+        p = put16(p, 0x0303);
+        p = put16(p, n);
+        fill(p, n, gc);
+        p += n;
+        len -= n;
+    }
+    return p;
+}
+
+static int make_tls(GenContext* gc, GenProto* gp, uint8_t* buf)
+{
+    uint8_t hs[256];
+    uint8_t* p = hs;
+    int rval;
+
+    /* client hello with a random, empty session id, two suites, and no extensions */
+    *p++ = 0x01;
+    p = put24(p, 2 + 32 + 1 + 2 + 4 + 2);
+    p = put16(p, 0x0303);
+    fill(p, 32, gc);
+    p += 32;
+    *p++ = 0;
+    p = put16(p, 4);
+    p = put16(p, 0x1301);
+    p = put16(p, 0xc02f);
+    *p++ = 1;
+    *p++ = 0;
+
+    uint8_t* end = tls_record(buf, 0x16, hs, p - hs);
+
+    if ( (rval = set_payload(gc, &gp->req[0], buf, end - buf)) != DAQ_SUCCESS )
+        return rval;
+
+    /* server hello and hello done */
+    p = hs;
+    *p++ = 0x02;
+    p = put24(p, 2 + 32 + 1 + 2 + 1);
+    p = put16(p, 0x0303);
+    fill(p, 32, gc);
+    p += 32;
+    *p++ = 0;
+    p = put16(p, 0xc02f);
+    *p++ = 0;
+    *p++ = 0x0e;
+    p = put24(p, 0);
+
+    end = tls_record(buf, 0x16, hs, p - hs);
+    end = tls_app_data(gc, end, gc->size);
+
+    if ( (rval = set_payload(gc, &gp->rsp[0], buf, end - buf)) != DAQ_SUCCESS )
+        return rval;
+
+    end = tls_app_data(gc, buf, 512);
+
+    if ( (rval = set_payload(gc, &gp->req[1], buf, end - buf)) != DAQ_SUCCESS )
+        return rval;
+
+    end = tls_app_data(gc, buf, gc->size);
+
+    return set_payload(gc, &gp->rsp[1], buf, end - buf);
+}
+
+static int make_dns(GenContext* gc, GenProto* gp, uint8_t* buf)
+{
+    static const uint8_t qname[] = "\x03www\x07" "example\x03" "com";
+    uint8_t* p = buf;
+    int rval;
+
+    p = put16(p, 0x1234);
+    p = put16(p, 0x0100);
+    p = put16(p, 1);
+    p = put16(p, 0);
+    p = put16(p, 0);
+    p = put16(p, 0);
+    memcpy(p, qname, sizeof(qname));
+    p += sizeof(qname);
+    p = put16(p, 1);
+    p = put16(p, 1);
+
+    unsigned qlen = p - buf;
+
+    if ( (rval = set_payload(gc, &gp->req[0], buf, qlen)) != DAQ_SUCCESS )
+        return rval;
+
+    /* the answer follows the question with a pointer back to its name */
+    put16(buf + 2, 0x8180);
+    put16(buf + 6, 1);
+    p = put16(p, 0xc00c);
+    p = put16(p, 1);
+    p = put16(p, 1);
+    p = put16(p, 0);
+    p = put16(p, 300);
+    p = put16(p, 4);
+    *p++ = 192;
+    *p++ = 0;
+    *p++ = 2;
+    *p++ = 1;
+
+    if ( (rval = set_payload(gc, &gp->rsp[0], buf, p - buf)) != DAQ_SUCCESS )
+        return rval;
+
+    gp->req[1] = gp->req[0];
+    gp->rsp[1] = gp->rsp[0];
+    return DAQ_SUCCESS;
+}
+
+static uint8_t* smb2_header(uint8_t* p, uint16_t cmd, bool response)
+{
+    memset(p, 0, 64);
+    memcpy(p, "\xfeSMB", 4);
+    p[4] = 64;
+    p[6] = 0;
+    p[12] = cmd & 0xff;
+    p[13] = cmd >> 8;
+    p[16] = response ? 1 : 0;
+    put32le(p + 36, 1);    /* tree id */
+    return p + 64;
+}
+
+static int make_smb(GenContext* gc, GenProto* gp, uint8_t* buf)
+{
+    uint8_t* p = buf + 4;
+    int rval;
+
+    /* SMB2 read of size bytes from offset 0 */
+    p = smb2_header(p, 0x0008, false);
+    memset(p, 0, 49);
+    p[0] = 49;
+    put32le(p + 4, gc->size);
+    p += 49;
+
+    buf[0] = 0;
+    put24(buf + 1, p - buf - 4);
+
+    if ( (rval = set_payload(gc, &gp->req[0], buf, p - buf)) != DAQ_SUCCESS )
+        return rval;
+
+    p = smb2_header(buf + 4, 0x0008, true);
+    memset(p, 0, 16);
+    p[0] = 17;
+    p[2] = 64 + 16;
+    put32le(p + 4, gc->size);
+    p += 16;
+    fill(p, gc->size, gc);
+    p += gc->size;
+
+    buf[0] = 0;
+    put24(buf + 1, p - buf - 4);
+
+    if ( (rval = set_payload(gc, &gp->rsp[0], buf, p - buf)) != DAQ_SUCCESS )
+        return rval;
+
+    gp->req[1] = gp->req[0];
+    gp->rsp[1] = gp->rsp[0];
+    return DAQ_SUCCESS;
+}
+
+static int create_protos(GenContext* gc)
+{
+    static const struct
+    {
+        const char* name;
+        uint8_t ip_proto;
+        uint16_t port;
+        int (*make)(GenContext*, GenProto*, uint8_t*);
+    } protos[GEN_MAX_PROTO] =
+    {
+        { "http", IPPROTO_TCP, 80, make_http },
+        { "tls", IPPROTO_TCP, 443, make_tls },
+        { "dns", IPPROTO_UDP, 53, make_dns },
+        { "smb", IPPROTO_TCP, 445, make_smb },
+    };
+
+    /* room for the largest response plus its headers and record framing */
+    uint8_t* buf = malloc(gc->size + gc->size / 16384 * 5 + 1024);
+
+    if ( !buf )
+        return DAQ_ERROR_NOMEM;
+
+    int rval = DAQ_SUCCESS;
+
+    for ( unsigned i = 0; i < GEN_MAX_PROTO && rval == DAQ_SUCCESS; ++i )
+    {
+        GenProto* gp = &gc->protos[i];
+        gp->name = protos[i].name;
+        gp->ip_proto = protos[i].ip_proto;
+        gp->port = protos[i].port;
+        rval = protos[i].make(gc, gp, buf);
+    }
+
+    free(buf);
+    return rval;
+}
+
+static void destroy_protos(GenContext* gc)
+{
+    for ( unsigned i = 0; i < GEN_MAX_PROTO; ++i )
+    {
+        GenProto* gp = &gc->protos[i];
+
+        for ( unsigned j = 0; j < 2; ++j )
+        {
+            /* the second exchange may share the first's payloads */
+            if ( j == 0 || gp->req[1].data != gp->req[0].data )
+            {
+                free(gp->req[j].data);
+                free(gp->req[j].sums);
+            }
+            if ( j == 0 || gp->rsp[1].data != gp->rsp[0].data )
+            {
+                free(gp->rsp[j].data);
+                free(gp->rsp[j].sums);
+            }
+        }
+    }
+    memset(gc->protos, 0, sizeof(gc->protos));
+}
+
+static int parse_mix(GenContext* gc, const char* mix)
+{
+    char* s = strdup(mix);
+
+    if ( !s )
+        return DAQ_ERROR_NOMEM;
+
+    char* save = NULL;
+    gc->total_weight = 0;
+
+    for ( char* tok = strtok_r(s, ",", &save); tok; tok = strtok_r(NULL, ",", &save) )
+    {
+        char* colon = strchr(tok, ':');
+        unsigned weight = 1;
+
+        if ( colon )
+        {
+            *colon = '\0';
+            weight = strtoul(colon + 1, NULL, 10);
+        }
+
+        unsigned i;
+
+        for ( i = 0; i < GEN_MAX_PROTO; ++i )
+        {
+            if ( !strcmp(tok, gc->protos[i].name) )
+                break;
+        }
+
+        if ( i == GEN_MAX_PROTO )
+        {
+            SET_ERROR(gc->modinst, "%s: Unknown protocol in mix: '%s'", DAQ_NAME, tok);
+            free(s);
+            return DAQ_ERROR_INVAL;
+        }
+
+        gc->protos[i].weight = weight;
+        gc->total_weight += weight;
+    }
+
+    free(s);
+
+    if ( !gc->total_weight )
+    {
+        SET_ERROR(gc->modinst, "%s: The mix has no protocols", DAQ_NAME);
+        return DAQ_ERROR_INVAL;
+    }
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+// flows
+//-------------------------------------------------------------------------
+
+static void start_flow(GenContext* gc, GenFlow* f)
+{
+    unsigned w = get_random(gc, gc->total_weight);
+    unsigned i = 0;
+
+    while ( w >= gc->protos[i].weight )
+        w -= gc->protos[i++].weight;
+
+    uint64_t n = gc->flow_count++;
+
+    f->proto = &gc->protos[i];
+    /* the instance keeps the flows of packet threads apart */
+    uint32_t inst = gc->instance & 0xff;
+    f->cli_addr = htonl(0x0a000000 | (inst << 16) | ((n / 32768) & 0xffff));
+    f->srv_addr = htonl(0xc0a80000 | (inst << 8) | (unsigned)(n % 256));
+    f->cli_port = htons(1024 + n % 32768);
+    f->srv_port = htons(f->proto->port);
+    f->cli_seq = (uint32_t)gc->rand;
+    f->srv_seq = (uint32_t)(gc->rand >> 32);
+    f->exchange = 0;
+    f->off = 0;
+    f->held = NO_HELD;
+    f->unacked = 0;
+    f->state = (f->proto->ip_proto == IPPROTO_TCP) ? FLOW_SYN : FLOW_REQUEST;
+}
+
+static const GenPayload* get_payload(GenFlow* f, bool c2s)
+{
+    unsigned i = f->exchange ? 1 : 0;
+    return c2s ? &f->proto->req[i] : &f->proto->rsp[i];
+}
+
+static unsigned build_packet(
+    GenContext* gc, GenFlow* f, uint8_t* pkt, bool c2s, uint8_t flags, uint32_t seq, uint32_t ack,
+    const GenPayload* pay, unsigned off)
+{
+    bool tcp = f->proto->ip_proto == IPPROTO_TCP;
+    unsigned len = 0;
+    uint32_t pay_sum = 0;
+
+    if ( pay )
+    {
+        len = pay->len - off < gc->mss ? pay->len - off : gc->mss;
+        memcpy(pkt + ETH_HDR_LEN + IP_HDR_LEN + (tcp ? TCP_HDR_LEN : UDP_HDR_LEN),
+            pay->data + off, len);
+        pay_sum = pay->sums[off / gc->mss];
+    }
+    unsigned l4_len = (tcp ? TCP_HDR_LEN : UDP_HDR_LEN) + len;
+    uint32_t src = c2s ? f->cli_addr : f->srv_addr;
+    uint32_t dst = c2s ? f->srv_addr : f->cli_addr;
+    uint16_t sp = c2s ? f->cli_port : f->srv_port;
+    uint16_t dp = c2s ? f->srv_port : f->cli_port;
+
+    /* ethernet */
+    uint8_t* p = pkt;
+    static const uint8_t cli_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    static const uint8_t srv_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+    memcpy(p, c2s ? srv_mac : cli_mac, 6);
+    memcpy(p + 6, c2s ? cli_mac : srv_mac, 6);
+    put16(p + 12, 0x0800);
+
+    /* ip4 */
+    uint8_t* ip = pkt + ETH_HDR_LEN;
+    ip[0] = 0x45;
+    ip[1] = 0;
+    put16(ip + 2, IP_HDR_LEN + l4_len);
+    put16(ip + 4, gc->ip_id++);
+    put16(ip + 6, 0x4000);
+    ip[8] = 64;
+    ip[9] = f->proto->ip_proto;
+    put16(ip + 10, 0);
+    memcpy(ip + 12, &src, 4);
+    memcpy(ip + 16, &dst, 4);
+    put16(ip + 10, fold16(sum16(ip, IP_HDR_LEN)));
+
+    /* l4 */
+    uint8_t* l4 = ip + IP_HDR_LEN;
+    memcpy(l4, &sp, 2);
+    memcpy(l4 + 2, &dp, 2);
+
+    if ( tcp )
+    {
+        uint32_t nseq = htonl(seq), nack = htonl(ack);
+        memcpy(l4 + 4, &nseq, 4);
+        memcpy(l4 + 8, &nack, 4);
+        l4[12] = (TCP_HDR_LEN / 4) << 4;
+        l4[13] = flags;
+        put16(l4 + 14, 65535);
+        put16(l4 + 16, 0);
+        put16(l4 + 18, 0);
+    }
+    else
+    {
+        put16(l4 + 4, l4_len);
+        put16(l4 + 6, 0);
+    }
+
+    uint32_t sum = sum16(ip + 12, 8) + f->proto->ip_proto + l4_len;
+    sum += sum16(l4, tcp ? TCP_HDR_LEN : UDP_HDR_LEN) + pay_sum;
+    put16(l4 + (tcp ? 16 : 6), fold16(sum));
+
+    return ETH_HDR_LEN + IP_HDR_LEN + l4_len;
+}
+
+/* send the segment at off, or with probability ooo the one after it first */
+static unsigned next_segment(GenContext* gc, GenFlow* f, const GenPayload* pay)
+{
+    if ( f->held != NO_HELD )
+    {
+        unsigned off = f->held;
+        f->held = NO_HELD;
+        return off;
+    }
+
+    unsigned off = f->off;
+    f->off += gc->mss;
+
+    if ( gc->ooo && f->off < pay->len && get_random(gc, 100) < gc->ooo )
+    {
+        f->held = off;
+        off = f->off;
+        f->off += gc->mss;
+        gc->out_of_order++;
+    }
+
+    if ( f->off > pay->len )
+        f->off = pay->len;
+
+    return off;
+}
+
+static bool payload_done(GenFlow* f, const GenPayload* pay)
+{ return f->off >= pay->len && f->held == NO_HELD; }
+
+static unsigned next_packet(GenContext* gc, GenFlow* f, uint8_t* pkt)
+{
+    const GenPayload* pay;
+    unsigned off, len;
+
+    switch ( f->state )
+    {
+    case FLOW_SYN:
+        f->state = FLOW_SYN_ACK;
+        return build_packet(gc, f, pkt, true, TH_SYN, f->cli_seq++, 0, NULL, 0);
+
+    case FLOW_SYN_ACK:
+        f->state = FLOW_ACK;
+        return build_packet(gc, f, pkt, false, TH_SYN|TH_ACK, f->srv_seq++, f->cli_seq, NULL, 0);
+
+    case FLOW_ACK:
+        f->state = FLOW_REQUEST;
+        return build_packet(gc, f, pkt, true, TH_ACK, f->cli_seq, f->srv_seq, NULL, 0);
+
+    case FLOW_REQUEST:
+        pay = get_payload(f, true);
+        off = next_segment(gc, f, pay);
+        len = build_packet(gc, f, pkt, true, TH_ACK|TH_PUSH, f->cli_seq + off, f->srv_seq, pay, off);
+
+        if ( payload_done(f, pay) )
+        {
+            f->cli_seq += pay->len;
+            f->off = 0;
+            f->state = FLOW_RESPONSE;
+        }
+        return len;
+
+    case FLOW_RESPONSE:
+        pay = get_payload(f, false);
+        off = next_segment(gc, f, pay);
+        len = build_packet(gc, f, pkt, false, TH_ACK|TH_PUSH, f->srv_seq + off, f->cli_seq, pay, off);
+
+        if ( payload_done(f, pay) )
+        {
+            f->srv_seq += pay->len;
+            f->off = 0;
+            f->unacked = 0;
+
+            if ( f->proto->ip_proto != IPPROTO_TCP )
+                f->state = (++f->exchange < gc->exchanges) ? FLOW_REQUEST : FLOW_DONE;
+            else
+                f->state = FLOW_CLIENT_ACK;
+        }
+        else if ( ++f->unacked >= 2 && f->held == NO_HELD )
+        {
+            f->unacked = 0;
+            f->state = FLOW_CLIENT_ACK;
+        }
+        return len;
+
+    case FLOW_CLIENT_ACK:
+        len = build_packet(gc, f, pkt, true, TH_ACK, f->cli_seq, f->srv_seq + f->off, NULL, 0);
+
+        if ( f->off )
+            f->state = FLOW_RESPONSE;
+        else
+            f->state = (++f->exchange < gc->exchanges) ? FLOW_REQUEST : FLOW_CLIENT_FIN;
+        return len;
+
+    case FLOW_CLIENT_FIN:
+        f->state = FLOW_SERVER_FIN;
+        return build_packet(gc, f, pkt, true, TH_FIN|TH_ACK, f->cli_seq++, f->srv_seq, NULL, 0);
+
+    case FLOW_SERVER_FIN:
+        f->state = FLOW_LAST_ACK;
+        return build_packet(gc, f, pkt, false, TH_FIN|TH_ACK, f->srv_seq++, f->cli_seq, NULL, 0);
+
+    case FLOW_LAST_ACK:
+        f->state = FLOW_DONE;
+        return build_packet(gc, f, pkt, true, TH_ACK, f->cli_seq, f->srv_seq, NULL, 0);
+
+    case FLOW_DONE:
+        break;
+    }
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+// message pool
+//-------------------------------------------------------------------------
+
+static void destroy_message_pool(GenContext* gc)
+{
+    GenMsgPool* pool = &gc->pool;
+    if (pool->pool)
+    {
+        while (pool->info.size > 0)
+            free(pool->pool[--pool->info.size].data);
+        free(pool->pool);
+        pool->pool = NULL;
+    }
+    pool->freelist = NULL;
+    pool->info.available = 0;
+    pool->info.mem_size = 0;
+}
+
+static int create_message_pool(GenContext* gc, unsigned size)
+{
+    GenMsgPool* pool = &gc->pool;
+    pool->pool = calloc(sizeof(GenMsgDesc), size);
+    if (!pool->pool)
+    {
+        SET_ERROR(gc->modinst, "%s: Could not allocate %zu bytes for a packet descriptor pool!",
+                __func__, sizeof(GenMsgDesc) * size);
+        return DAQ_ERROR_NOMEM;
+    }
+    pool->info.mem_size = sizeof(GenMsgDesc) * size;
+    while (pool->info.size < size)
+    {
+        /* Allocate packet data and set up descriptor */
+        GenMsgDesc *desc = &pool->pool[pool->info.size];
+        desc->data = malloc(gc->snaplen);
+        if (!desc->data)
+        {
+            SET_ERROR(gc->modinst, "%s: Could not allocate %d bytes for a packet descriptor message buffer!",
+                    __func__, gc->snaplen);
+            return DAQ_ERROR_NOMEM;
+        }
+        pool->info.mem_size += gc->snaplen;
+
+        /* Initialize non-zero invariant packet header fields. */
+        DAQ_PktHdr_t *pkthdr = &desc->pkthdr;
+        pkthdr->ingress_index = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->ingress_group = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->egress_index = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->egress_group = DAQ_PKTHDR_UNKNOWN;
+
+        /* Initialize non-zero invariant message header fields. */
+        DAQ_Msg_t *msg = &desc->msg;
+        msg->type = DAQ_MSG_TYPE_PACKET;
+        msg->hdr_len = sizeof(*pkthdr);
+        msg->hdr = pkthdr;
+        msg->data = desc->data;
+        msg->owner = gc->modinst;
+        msg->priv = desc;
+
+        /* Place it on the free list */
+        desc->next = pool->freelist;
+        pool->freelist = desc;
+
+        pool->info.size++;
+    }
+    pool->info.available = pool->info.size;
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+// report
+//-------------------------------------------------------------------------
+
+static void write_report(GenContext* gc)
+{
+    if ( !gc->packets )
+        return;
+
+    double secs = (gc->last_ns - gc->start_ns) / 1e9;
+    double pps = secs > 0 ? gc->packets / secs : 0;
+    double gbps = secs > 0 ? gc->bytes * 8 / secs / 1e9 : 0;
+    double ns_pp = (double)(gc->last_ns - gc->start_ns) / gc->packets;
+    double cyc_pp = (double)(gc->last_tsc - gc->start_tsc) / gc->packets;
+
+    char buf[1024];
+    int n = snprintf(buf, sizeof(buf),
+        "{ \"daq\": \"%s\", \"instance\": %u, \"packets\": %" PRIu64 ", \"bytes\": %" PRIu64
+        ", \"flows\": %" PRIu64 ", \"out_of_order\": %" PRIu64 ", \"seconds\": %.6f"
+        ", \"pps\": %.0f, \"gbps\": %.3f, \"ns_per_packet\": %.1f, \"cycles_per_packet\": %.1f"
+        ", \"latency_ns\": { \"p50\": %" PRIu64 ", \"p90\": %" PRIu64 ", \"p99\": %" PRIu64
+        ", \"p99.9\": %" PRIu64 ", \"max\": %" PRIu64 " } }\n",
+        DAQ_NAME, gc->instance, gc->packets, gc->bytes, gc->flows_done, gc->out_of_order, secs,
+        pps, gbps, ns_pp, cyc_pp,
+        lat_percentile(gc, 50), lat_percentile(gc, 90), lat_percentile(gc, 99),
+        lat_percentile(gc, 99.9), gc->lat_max);
+
+    if ( n <= 0 )
+        return;
+
+    /* one write per report so reports from concurrent instances don't mix */
+    int fd = STDOUT_FILENO;
+
+    if ( gc->report && (fd = open(gc->report, O_WRONLY|O_CREAT|O_APPEND, 0644)) < 0 )
+        return;
+
+    ssize_t written = write(fd, buf, n);
+    (void)written;
+
+    if ( fd != STDOUT_FILENO )
+        close(fd);
+}
+
+//-------------------------------------------------------------------------
+// daq
+//-------------------------------------------------------------------------
+
+static int gen_daq_module_load(const DAQ_BaseAPI_t* base_api)
+{
+    if (base_api->api_version != DAQ_BASE_API_VERSION || base_api->api_size != sizeof(DAQ_BaseAPI_t))
+        return DAQ_ERROR;
+
+    daq_base_api = *base_api;
+
+    return DAQ_SUCCESS;
+}
+
+static int gen_daq_get_variable_descs(const DAQ_VariableDesc_t** var_desc_table)
+{
+    *var_desc_table = gen_variable_descriptions;
+
+    return sizeof(gen_variable_descriptions) / sizeof(DAQ_VariableDesc_t);
+}
+
+static void gen_daq_destroy(void* handle);
+
+static int gen_daq_instantiate(const DAQ_ModuleConfig_h modcfg, DAQ_ModuleInstance_h modinst, void** ctxt_ptr)
+{
+    GenContext* gc;
+    int rval = DAQ_ERROR;
+
+    gc = calloc(1, sizeof(*gc));
+    if (!gc)
+    {
+        SET_ERROR(modinst, "%s: Couldn't allocate memory for the new Gen context!", DAQ_NAME);
+        return DAQ_ERROR_NOMEM;
+    }
+    gc->modinst = modinst;
+    gc->instance = __atomic_fetch_add(&gen_instances, 1, __ATOMIC_RELAXED);
+
+    gc->snaplen = daq_base_api.config_get_snaplen(modcfg) ? daq_base_api.config_get_snaplen(modcfg) : GEN_DEFAULT_SNAPLEN;
+    gc->num_flows = GEN_DEFAULT_FLOWS;
+    gc->max_packets = GEN_DEFAULT_PACKETS;
+    gc->size = GEN_DEFAULT_SIZE;
+    gc->exchanges = GEN_DEFAULT_EXCHANGES;
+
+    const char* mix = GEN_DEFAULT_MIX;
+    const char* varKey, * varValue;
+    daq_base_api.config_first_variable(modcfg, &varKey, &varValue);
+    while (varKey)
+    {
+        if (!strcmp(varKey, "mix"))
+            mix = varValue;
+        else if (!strcmp(varKey, "flows"))
+            gc->num_flows = strtoul(varValue, NULL, 10);
+        else if (!strcmp(varKey, "packets"))
+            gc->max_packets = strtoull(varValue, NULL, 10);
+        else if (!strcmp(varKey, "size"))
+            gc->size = strtoul(varValue, NULL, 10);
+        else if (!strcmp(varKey, "exchanges"))
+            gc->exchanges = strtoul(varValue, NULL, 10);
+        else if (!strcmp(varKey, "ooo"))
+            gc->ooo = strtoul(varValue, NULL, 10);
+        else if (!strcmp(varKey, "seed"))
+            gc->seed = strtoull(varValue, NULL, 10);
+        else if (!strcmp(varKey, "report"))
+        {
+            if (!(gc->report = strdup(varValue)))
+            {
+                SET_ERROR(modinst, "%s: Couldn't allocate memory for the report name!", DAQ_NAME);
+                rval = DAQ_ERROR_NOMEM;
+                goto err;
+            }
+        }
+        else
+        {
+            SET_ERROR(modinst, "%s: Unknown variable name: '%s'", DAQ_NAME, varKey);
+            rval = DAQ_ERROR_INVAL;
+            goto err;
+        }
+
+        daq_base_api.config_next_variable(modcfg, &varKey, &varValue);
+    }
+
+    if (gc->snaplen < ETH_HDR_LEN + IP_HDR_LEN + TCP_HDR_LEN + 64 || !gc->num_flows ||
+        !gc->exchanges || gc->ooo > 100 || gc->size > (1 << 24))
+    {
+        SET_ERROR(modinst, "%s: Invalid snaplen, flows, exchanges, ooo, or size", DAQ_NAME);
+        rval = DAQ_ERROR_INVAL;
+        goto err;
+    }
+
+    /* even so that every segment starts on a checksum word */
+    gc->mss = gc->snaplen - ETH_HDR_LEN - IP_HDR_LEN - TCP_HDR_LEN;
+    if (gc->mss > MAX_MSS)
+        gc->mss = MAX_MSS;
+    gc->mss &= ~1u;
+
+    gc->rand = (gc->seed + gc->instance) * 0x9e3779b97f4a7c15ull + 1;
+
+    if ((rval = create_protos(gc)) != DAQ_SUCCESS)
+    {
+        SET_ERROR(modinst, "%s: Couldn't allocate memory for the payloads!", DAQ_NAME);
+        goto err;
+    }
+
+    if ((rval = parse_mix(gc, mix)) != DAQ_SUCCESS)
+        goto err;
+
+    if (!(gc->flows = calloc(gc->num_flows, sizeof(*gc->flows))))
+    {
+        SET_ERROR(modinst, "%s: Couldn't allocate memory for the flows!", DAQ_NAME);
+        rval = DAQ_ERROR_NOMEM;
+        goto err;
+    }
+
+    uint32_t pool_size = daq_base_api.config_get_msg_pool_size(modcfg);
+    rval = create_message_pool(gc, pool_size ? pool_size : GEN_DEFAULT_POOL_SIZE);
+    if (rval != DAQ_SUCCESS)
+        goto err;
+
+    *ctxt_ptr = gc;
+
+    return DAQ_SUCCESS;
+
+err:
+    gen_daq_destroy(gc);
+    return rval;
+}
+
+static void gen_daq_destroy(void* handle)
+{
+    GenContext* gc = (GenContext*) handle;
+
+    destroy_message_pool(gc);
+    destroy_protos(gc);
+    free(gc->flows);
+    free(gc->report);
+    free(gc);
+}
+
+static int gen_daq_start(void* handle)
+{
+    GenContext* gc = (GenContext*) handle;
+
+    for (unsigned i = 0; i < gc->num_flows; ++i)
+        start_flow(gc, &gc->flows[i]);
+
+    gc->next_flow = 0;
+    gettimeofday(&gc->ts, NULL);
+
+    return DAQ_SUCCESS;
+}
+
+static int gen_daq_interrupt(void* handle)
+{
+    GenContext* gc = (GenContext*) handle;
+    gc->interrupted = true;
+    return DAQ_SUCCESS;
+}
+
+static int gen_daq_stop (void* handle)
+{
+    GenContext* gc = (GenContext*) handle;
+    write_report(gc);
+    return DAQ_SUCCESS;
+}
+
+static int gen_daq_ioctl(void* handle, DAQ_IoctlCmd cmd, void* arg, size_t arglen)
+{
+    (void) handle;
+    (void) cmd;
+    (void) arg;
+    (void) arglen;
+    return DAQ_ERROR_NOTSUP;
+}
+
+static int gen_daq_get_stats(void* handle, DAQ_Stats_t* stats)
+{
+    GenContext* gc = (GenContext*) handle;
+    memcpy(stats, &gc->stats, sizeof(DAQ_Stats_t));
+    return DAQ_SUCCESS;
+}
+
+static void gen_daq_reset_stats(void* handle)
+{
+    GenContext* gc = (GenContext*) handle;
+    memset(&gc->stats, 0, sizeof(gc->stats));
+}
+
+static int gen_daq_get_snaplen (void* handle)
+{
+    GenContext* gc = (GenContext*) handle;
+    return gc->snaplen;
+}
+
+static uint32_t gen_daq_get_capabilities(void* handle)
+{
+    (void) handle;
+    return DAQ_CAPA_BLOCK | DAQ_CAPA_REPLACE | DAQ_CAPA_INTERRUPT | DAQ_CAPA_UNPRIV_START;
+}
+
+static int gen_daq_get_datalink_type(void *handle)
+{
+    (void)handle;
+    return DLT_EN10MB;
+}
+
+static unsigned gen_daq_msg_receive(void* handle, const unsigned max_recv, const DAQ_Msg_t* msgs[], DAQ_RecvStatus* rstat)
+{
+    GenContext* gc = (GenContext*) handle;
+    DAQ_RecvStatus status = DAQ_RSTAT_OK;
+    unsigned idx = 0;
+
+    if (!gc->start_ns)
+    {
+        gc->start_ns = gc->last_ns = get_ns();
+        gc->start_tsc = gc->last_tsc = get_tsc();
+    }
+
+    while (idx < max_recv)
+    {
+        /* Check to see if the receive has been canceled.  If so, reset it and return appropriately. */
+        if (gc->interrupted)
+        {
+            gc->interrupted = false;
+            status = DAQ_RSTAT_INTERRUPTED;
+            break;
+        }
+
+        if (gc->max_packets && gc->stats.packets_received >= gc->max_packets)
+        {
+            status = DAQ_RSTAT_EOF;
+            break;
+        }
+
+        /* Make sure that we have a message descriptor available to populate. */
+        GenMsgDesc* desc = gc->pool.freelist;
+        if (!desc)
+        {
+            status = DAQ_RSTAT_NOBUF;
+            break;
+        }
+
+        GenFlow* f = &gc->flows[gc->next_flow];
+
+        if (++gc->next_flow == gc->num_flows)
+            gc->next_flow = 0;
+
+        unsigned len = next_packet(gc, f, desc->data);
+
+        if (f->state == FLOW_DONE)
+        {
+            gc->flows_done++;
+            start_flow(gc, f);
+        }
+
+        /* synthetic time keeps flow timeouts independent of the rate */
+        if (++gc->ts.tv_usec == 1000000)
+        {
+            gc->ts.tv_sec++;
+            gc->ts.tv_usec = 0;
+        }
+
+        desc->pkthdr.ts = gc->ts;
+        desc->pkthdr.pktlen = len;
+        desc->msg.data_len = len;
+
+        gc->stats.hw_packets_received++;
+        gc->stats.packets_received++;
+        gc->bytes += len;
+
+        /* Last, but not least, extract this descriptor from the free list and
+           place the message in the return vector. */
+        gc->pool.freelist = desc->next;
+        desc->next = NULL;
+        gc->pool.info.available--;
+        msgs[idx] = &desc->msg;
+
+        idx++;
+    }
+
+    if (idx)
+    {
+        uint64_t now = get_ns();
+
+        for (unsigned i = 0; i < idx; ++i)
+            ((GenMsgDesc*)msgs[i]->priv)->recv_ns = now;
+    }
+
+    *rstat = status;
+
+    return idx;
+}
+
+static int gen_daq_msg_finalize(void* handle, const DAQ_Msg_t* msg, DAQ_Verdict verdict)
+{
+    GenContext* gc = (GenContext*) handle;
+    GenMsgDesc* desc = (GenMsgDesc *) msg->priv;
+
+    if (verdict >= MAX_DAQ_VERDICT)
+        verdict = DAQ_VERDICT_PASS;
+    gc->stats.verdicts[verdict]++;
+
+    /* from receipt so that the time a packet waits for the rest of its
+       batch counts too */
+    uint64_t now = get_ns();
+    uint64_t lat = now - desc->recv_ns;
+
+    gc->lat[lat_bucket(lat)]++;
+    if (lat > gc->lat_max)
+        gc->lat_max = lat;
+
+    gc->last_ns = now;
+    gc->last_tsc = get_tsc();
+    gc->packets++;
+
+    /* Toss the descriptor back on the free list for reuse. */
+    desc->next = gc->pool.freelist;
+    gc->pool.freelist = desc;
+    gc->pool.info.available++;
+
+    return DAQ_SUCCESS;
+}
+
+static int gen_daq_get_msg_pool_info(void* handle, DAQ_MsgPoolInfo_t* info)
+{
+    GenContext* gc = (GenContext*) handle;
+
+    *info = gc->pool.info;
+
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+#ifdef BUILDING_SO
+DAQ_SO_PUBLIC const DAQ_ModuleAPI_t DAQ_MODULE_DATA =
+#else
+const DAQ_ModuleAPI_t gen_daq_module_data =
+#endif
+{
+    /* .api_version = */ DAQ_MODULE_API_VERSION,
+    /* .api_size = */ sizeof(DAQ_ModuleAPI_t),
+    /* .module_version = */ DAQ_MOD_VERSION,
+    /* .name = */ DAQ_NAME,
+    /* .type = */ DAQ_TYPE,
+    /* .load = */ gen_daq_module_load,
+    /* .unload = */ NULL,
+    /* .get_variable_descs = */ gen_daq_get_variable_descs,
+    /* .instantiate = */ gen_daq_instantiate,
+    /* .destroy = */ gen_daq_destroy,
+    /* .set_filter = */ NULL,
+    /* .start = */ gen_daq_start,
+    /* .inject = */ NULL,
+    /* .inject_relative = */ NULL,
+    /* .interrupt = */ gen_daq_interrupt,
+    /* .stop = */ gen_daq_stop,
+    /* .ioctl = */ gen_daq_ioctl,
+    /* .get_stats = */ gen_daq_get_stats,
+    /* .reset_stats = */ gen_daq_reset_stats,
+    /* .get_snaplen = */ gen_daq_get_snaplen,
+    /* .get_capabilities = */ gen_daq_get_capabilities,
+    /* .get_datalink_type = */ gen_daq_get_datalink_type,
+    /* .config_load = */ NULL,
+    /* .config_swap = */ NULL,
+    /* .config_free = */ NULL,
+    /* .msg_receive = */ gen_daq_msg_receive,
+    /* .msg_finalize = */ gen_daq_msg_finalize,
+    /* .get_msg_pool_info = */ gen_daq_get_msg_pool_info,
+};
@@ -0,0 +1,851 @@
+/*--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+*/
+/* daq_replay.c - loads pcaps into memory when instantiated and replays them
+ * in a loop without further I/O */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <daq_dlt.h>
+#include <daq_module_api.h>
+
+#define DAQ_MOD_VERSION 0
+#define DAQ_NAME "replay"
+#define DAQ_TYPE (DAQ_TYPE_FILE_CAPABLE|DAQ_TYPE_MULTI_INSTANCE)
+
+#define REPLAY_DEFAULT_POOL_SIZE 256
+#define REPLAY_DEFAULT_SNAPLEN 65535
+
+#define PCAP_MAGIC_US 0xa1b2c3d4
+#define PCAP_MAGIC_NS 0xa1b23c4d
+#define PCAPNG_MAGIC 0x0a0d0d0a
+#define PCAP_FILE_HDR_LEN 24
+#define PCAP_REC_HDR_LEN 16
+#define LINKTYPE_RAW 101
+
+#define ETH_HDR_LEN 14
+#define IP4_HDR_LEN 20
+#define IP6_HDR_LEN 40
+
+#define SET_ERROR(modinst, ...)    daq_base_api.set_errbuf(modinst, __VA_ARGS__)
+
+typedef struct _replay_msg_desc
+{
+    DAQ_Msg_t msg;
+    DAQ_PktHdr_t pkthdr;
+    struct _replay_msg_desc* next;
+} ReplayMsgDesc;
+
+typedef struct
+{
+    ReplayMsgDesc* pool;
+    ReplayMsgDesc* freelist;
+    DAQ_MsgPoolInfo_t info;
+} ReplayMsgPool;
+
+/* a record of a loaded pcap; data points into the file's buffer */
+typedef struct
+{
+    uint8_t* data;
+    uint32_t caplen;
+    uint32_t pktlen;
+    uint64_t ts;    /* microseconds */
+} ReplayPkt;
+
+typedef struct
+{
+    /* Configuration */
+    unsigned snaplen;
+    unsigned loops;
+    bool rewrite;
+
+    /* State */
+    DAQ_ModuleInstance_h modinst;
+    ReplayMsgPool pool;
+    volatile bool interrupted;
+    int dlt;
+
+    /* the loaded files and their packets */
+    uint8_t** files;
+    unsigned num_files;
+    ReplayPkt* pkts;
+    unsigned num_pkts;
+    unsigned max_pkts;
+    uint64_t first_ts;
+    uint64_t last_ts;
+
+    unsigned next;
+    unsigned loop;
+    uint64_t ts_shift;
+
+    DAQ_Stats_t stats;
+} ReplayContext;
+
+static DAQ_VariableDesc_t replay_variable_descriptions[] = {
+    { "loop", "Number of times to replay the pcaps, 0 until stopped (default 1)", DAQ_VAR_DESC_REQUIRES_ARGUMENT },
+    { "rewrite", "Change the addresses of each instance's packets so that instances have distinct flows", DAQ_VAR_DESC_FORBIDS_ARGUMENT },
+};
+
+static DAQ_BaseAPI_t daq_base_api;
+
+//-------------------------------------------------------------------------
+// utility functions
+//-------------------------------------------------------------------------
+
+static uint32_t get32(const uint8_t* p, bool swap)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+static uint16_t get16be(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void put16be(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+/* incremental update of a checksum for one changed word per RFC 1624 */
+static void adjust_sum(uint8_t* sum, uint16_t old_word, uint16_t new_word, bool udp)
+{
+    uint16_t cur = get16be(sum);
+
+    /* a UDP checksum of zero means there isn't one */
+    if ( udp && !cur )
+        return;
+
+    uint32_t s = (uint16_t)~cur + (uint16_t)~old_word + new_word;
+
+    while ( s >> 16 )
+        s = (s & 0xffff) + (s >> 16);
+
+    cur = (uint16_t)~s;
+
+    if ( udp && !cur )
+        cur = 0xffff;
+
+    put16be(sum, cur);
+}
+
+/* changes one byte of an address and every checksum that covers it */
+static void rewrite_byte(uint8_t* addr, unsigned idx, uint8_t key, uint8_t* ip_sum, uint8_t* l4_sum, bool udp)
+{
+    uint8_t* w = addr + (idx & ~1u);
+    uint16_t old_word = get16be(w);
+
+    addr[idx] ^= key;
+
+    uint16_t new_word = get16be(w);
+
+    if ( ip_sum )
+        adjust_sum(ip_sum, old_word, new_word, false);
+
+    if ( l4_sum )
+        adjust_sum(l4_sum, old_word, new_word, udp);
+}
+
+/* returns the checksum of a TCP, UDP, or ICMPv6 header when it was captured */
+static uint8_t* get_l4_sum(uint8_t proto, uint8_t* l4, const uint8_t* end, bool* udp)
+{
+    unsigned off;
+
+    *udp = false;
+
+    switch ( proto )
+    {
+    case 6:
+        off = 16;
+        break;
+    case 17:
+        off = 6;
+        *udp = true;
+        break;
+    case 58:
+        off = 2;
+        break;
+    default:
+        return NULL;
+    }
+
+    return (l4 + off + 2 <= end) ? l4 + off : NULL;
+}
+
+static void rewrite_ip4(uint8_t* ip, const uint8_t* end, uint8_t key)
+{
+    if ( ip + IP4_HDR_LEN > end )
+        return;
+
+    unsigned hlen = (ip[0] & 0x0f) * 4;
+    uint8_t* l4_sum = NULL;
+    bool udp = false;
+
+    /* only the first fragment has the transport header */
+    if ( hlen >= IP4_HDR_LEN && !(get16be(ip + 6) & 0x1fff) )
+        l4_sum = get_l4_sum(ip[9], ip + hlen, end, &udp);
+
+    /* the third octet keeps /16 networks intact */
+    rewrite_byte(ip + 12, 2, key, ip + 10, l4_sum, udp);
+    rewrite_byte(ip + 16, 2, key, ip + 10, l4_sum, udp);
+}
+
+static void rewrite_ip6(uint8_t* ip, const uint8_t* end, uint8_t key)
+{
+    if ( ip + IP6_HDR_LEN > end )
+        return;
+
+    uint8_t proto = ip[6];
+    uint8_t* p = ip + IP6_HDR_LEN;
+    uint8_t* l4_sum = NULL;
+    bool udp = false;
+
+    /* skip the extension headers that may precede the transport header;
+       a later fragment has none and an authentication header would need
+       recomputing anyway */
+    while ( true )
+    {
+        if ( proto == 0 || proto == 43 || proto == 60 )
+        {
+            if ( end - p < 8 || end - p < (p[1] + 1) * 8 )
+                break;
+            proto = p[0];
+            p += (p[1] + 1) * 8;
+        }
+        else if ( proto == 44 )
+        {
+            if ( end - p < 8 || (get16be(p + 2) & 0xfff8) )
+                break;
+            proto = p[0];
+            p += 8;
+        }
+        else
+        {
+            l4_sum = get_l4_sum(proto, p, end, &udp);
+            break;
+        }
+    }
+
+    /* the interface identifier keeps /64 networks intact */
+    rewrite_byte(ip + 8, 9, key, NULL, l4_sum, udp);
+    rewrite_byte(ip + 24, 9, key, NULL, l4_sum, udp);
+}
+
+/* tunneled addresses are left as is */
+static void rewrite_packet(ReplayContext* rc, ReplayPkt* pkt, uint8_t key)
+{
+    uint8_t* p = pkt->data;
+    const uint8_t* end = p + pkt->caplen;
+    uint16_t type;
+
+    if ( rc->dlt == DLT_EN10MB )
+    {
+        if ( p + ETH_HDR_LEN > end )
+            return;
+
+        type = get16be(p + 12);
+        p += ETH_HDR_LEN;
+
+        while ( (type == 0x8100 || type == 0x88a8 || type == 0x9100) && p + 4 <= end )
+        {
+            type = get16be(p + 2);
+            p += 4;
+        }
+    }
+    else if ( rc->dlt == DLT_RAW )
+    {
+        if ( p >= end )
+            return;
+
+        type = ((p[0] >> 4) == 6) ? 0x86dd : 0x0800;
+    }
+    else
+        return;
+
+    if ( type == 0x0800 )
+        rewrite_ip4(p, end, key);
+
+    else if ( type == 0x86dd )
+        rewrite_ip6(p, end, key);
+}
+
+//-------------------------------------------------------------------------
+// pcap loading
+//-------------------------------------------------------------------------
+
+static int add_packet(ReplayContext* rc, uint8_t* data, uint32_t caplen, uint32_t pktlen, uint64_t ts)
+{
+    if ( rc->num_pkts == rc->max_pkts )
+    {
+        unsigned max = rc->max_pkts ? rc->max_pkts * 2 : 1024;
+        ReplayPkt* pkts = (ReplayPkt*)realloc(rc->pkts, max * sizeof(*pkts));
+
+        if ( !pkts )
+        {
+            SET_ERROR(rc->modinst, "%s: Couldn't allocate memory for %u packets", DAQ_NAME, max);
+            return DAQ_ERROR_NOMEM;
+        }
+        rc->pkts = pkts;
+        rc->max_pkts = max;
+    }
+
+    ReplayPkt* pkt = &rc->pkts[rc->num_pkts++];
+    pkt->data = data;
+    pkt->caplen = caplen < rc->snaplen ? caplen : rc->snaplen;
+    pkt->pktlen = pktlen;
+    pkt->ts = ts;
+
+    if ( rc->num_pkts == 1 || ts < rc->first_ts )
+        rc->first_ts = ts;
+
+    if ( ts > rc->last_ts )
+        rc->last_ts = ts;
+
+    return DAQ_SUCCESS;
+}
+
+static int parse_pcap(ReplayContext* rc, const char* name, uint8_t* buf, size_t size)
+{
+    if ( size < PCAP_FILE_HDR_LEN )
+    {
+        SET_ERROR(rc->modinst, "%s: %s is too short to be a pcap", DAQ_NAME, name);
+        return DAQ_ERROR_INVAL;
+    }
+
+    uint32_t magic = get32(buf, false);
+    bool swap = (magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS));
+
+    if ( swap )
+        magic = __builtin_bswap32(magic);
+
+    if ( magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS )
+    {
+        SET_ERROR(rc->modinst, "%s: %s is not a pcap%s", DAQ_NAME, name,
+            (magic == PCAPNG_MAGIC) ? "; pcapng is not supported" : "");
+        return DAQ_ERROR_INVAL;
+    }
+
+    int dlt = (int)get32(buf + 20, swap);
+
+    if ( dlt == LINKTYPE_RAW )
+        dlt = DLT_RAW;
+
+    if ( rc->dlt < 0 )
+        rc->dlt = dlt;
+
+    else if ( rc->dlt != dlt )
+    {
+        SET_ERROR(rc->modinst, "%s: %s has datalink type %d instead of %d", DAQ_NAME, name, dlt, rc->dlt);
+        return DAQ_ERROR_INVAL;
+    }
+
+    unsigned usec_div = (magic == PCAP_MAGIC_NS) ? 1000 : 1;
+    size_t off = PCAP_FILE_HDR_LEN;
+
+    while ( off + PCAP_REC_HDR_LEN <= size )
+    {
+        const uint8_t* rec = buf + off;
+        uint64_t ts = (uint64_t)get32(rec, swap) * 1000000 + get32(rec + 4, swap) / usec_div;
+        uint32_t caplen = get32(rec + 8, swap);
+        uint32_t pktlen = get32(rec + 12, swap);
+
+        off += PCAP_REC_HDR_LEN;
+
+        /* a truncated last record is dropped like a live capture would */
+        if ( caplen > size - off )
+            break;
+
+        int rval = add_packet(rc, buf + off, caplen, pktlen, ts);
+
+        if ( rval != DAQ_SUCCESS )
+            return rval;
+
+        off += caplen;
+    }
+
+    return DAQ_SUCCESS;
+}
+
+static int load_pcap(ReplayContext* rc, const char* name)
+{
+    int fd = open(name, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        SET_ERROR(rc->modinst, "%s: Couldn't open %s: %s", DAQ_NAME, name, strerror(errno));
+        return DAQ_ERROR;
+    }
+
+    struct stat sb;
+
+    if ( fstat(fd, &sb) || !S_ISREG(sb.st_mode) )
+    {
+        SET_ERROR(rc->modinst, "%s: %s is not a regular file", DAQ_NAME, name);
+        close(fd);
+        return DAQ_ERROR;
+    }
+
+    size_t size = (size_t)sb.st_size;
+    uint8_t* buf = (uint8_t*)malloc(size ? size : 1);
+
+    if ( !buf )
+    {
+        SET_ERROR(rc->modinst, "%s: Couldn't allocate %zu bytes for %s", DAQ_NAME, size, name);
+        close(fd);
+        return DAQ_ERROR_NOMEM;
+    }
+
+    rc->files[rc->num_files++] = buf;
+
+    size_t got = 0;
+
+    while ( got < size )
+    {
+        ssize_t n = read(fd, buf + got, size - got);
+
+        if ( n <= 0 )
+        {
+            if ( n < 0 && errno == EINTR )
+                continue;
+
+            SET_ERROR(rc->modinst, "%s: Couldn't read %s: %s", DAQ_NAME, name,
+                n ? strerror(errno) : "unexpected end of file");
+            close(fd);
+            return DAQ_ERROR;
+        }
+        got += (size_t)n;
+    }
+
+    close(fd);
+
+    return parse_pcap(rc, name, buf, size);
+}
+
+/* the input is a space separated list of pcaps */
+static int load_pcaps(ReplayContext* rc, const char* input)
+{
+    char* list = strdup(input ? input : "");
+
+    if ( !list )
+    {
+        SET_ERROR(rc->modinst, "%s: Couldn't allocate memory for the input", DAQ_NAME);
+        return DAQ_ERROR_NOMEM;
+    }
+
+    unsigned max_files = 1;
+
+    for ( const char* s = list; *s; ++s )
+        if ( *s == ' ' )
+            max_files++;
+
+    if ( !(rc->files = (uint8_t**)calloc(max_files, sizeof(*rc->files))) )
+    {
+        free(list);
+        SET_ERROR(rc->modinst, "%s: Couldn't allocate memory for the input", DAQ_NAME);
+        return DAQ_ERROR_NOMEM;
+    }
+
+    int rval = DAQ_SUCCESS;
+    char* save = NULL;
+
+    for ( char* name = strtok_r(list, " ", &save); name; name = strtok_r(NULL, " ", &save) )
+    {
+        if ( (rval = load_pcap(rc, name)) != DAQ_SUCCESS )
+            break;
+    }
+
+    free(list);
+
+    if ( rval == DAQ_SUCCESS && !rc->num_pkts )
+    {
+        SET_ERROR(rc->modinst, "%s: No packets in '%s'", DAQ_NAME, input ? input : "");
+        rval = DAQ_ERROR_INVAL;
+    }
+
+    return rval;
+}
+
+//-------------------------------------------------------------------------
+// message pool
+//-------------------------------------------------------------------------
+
+static void destroy_message_pool(ReplayContext* rc)
+{
+    ReplayMsgPool* pool = &rc->pool;
+    free(pool->pool);
+    pool->pool = NULL;
+    pool->freelist = NULL;
+    pool->info.size = 0;
+    pool->info.available = 0;
+    pool->info.mem_size = 0;
+}
+
+/* messages point into the loaded pcaps and need no buffers of their own */
+static int create_message_pool(ReplayContext* rc, unsigned size)
+{
+    ReplayMsgPool* pool = &rc->pool;
+    pool->pool = (ReplayMsgDesc*)calloc(sizeof(ReplayMsgDesc), size);
+    if (!pool->pool)
+    {
+        SET_ERROR(rc->modinst, "%s: Could not allocate %zu bytes for a packet descriptor pool!",
+                __func__, sizeof(ReplayMsgDesc) * size);
+        return DAQ_ERROR_NOMEM;
+    }
+    pool->info.mem_size = sizeof(ReplayMsgDesc) * size;
+    while (pool->info.size < size)
+    {
+        ReplayMsgDesc *desc = &pool->pool[pool->info.size];
+
+        /* Initialize non-zero invariant packet header fields. */
+        DAQ_PktHdr_t *pkthdr = &desc->pkthdr;
+        pkthdr->ingress_index = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->ingress_group = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->egress_index = DAQ_PKTHDR_UNKNOWN;
+        pkthdr->egress_group = DAQ_PKTHDR_UNKNOWN;
+
+        /* Initialize non-zero invariant message header fields. */
+        DAQ_Msg_t *msg = &desc->msg;
+        msg->type = DAQ_MSG_TYPE_PACKET;
+        msg->hdr_len = sizeof(*pkthdr);
+        msg->hdr = pkthdr;
+        msg->owner = rc->modinst;
+        msg->priv = desc;
+
+        /* Place it on the free list */
+        desc->next = pool->freelist;
+        pool->freelist = desc;
+
+        pool->info.size++;
+    }
+    pool->info.available = pool->info.size;
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+// daq
+//-------------------------------------------------------------------------
+
+static int replay_daq_module_load(const DAQ_BaseAPI_t* base_api)
+{
+    if (base_api->api_version != DAQ_BASE_API_VERSION || base_api->api_size != sizeof(DAQ_BaseAPI_t))
+        return DAQ_ERROR;
+
+    daq_base_api = *base_api;
+
+    return DAQ_SUCCESS;
+}
+
+static int replay_daq_get_variable_descs(const DAQ_VariableDesc_t** var_desc_table)
+{
+    *var_desc_table = replay_variable_descriptions;
+
+    return sizeof(replay_variable_descriptions) / sizeof(DAQ_VariableDesc_t);
+}
+
+static void replay_daq_destroy(void* handle);
+
+static int replay_daq_instantiate(const DAQ_ModuleConfig_h modcfg, DAQ_ModuleInstance_h modinst, void** ctxt_ptr)
+{
+    ReplayContext* rc;
+    int rval = DAQ_ERROR;
+    unsigned id;
+    uint8_t key;
+    uint32_t pool_size;
+
+    rc = (ReplayContext*)calloc(1, sizeof(*rc));
+    if (!rc)
+    {
+        SET_ERROR(modinst, "%s: Couldn't allocate memory for the new Replay context!", DAQ_NAME);
+        return DAQ_ERROR_NOMEM;
+    }
+    rc->modinst = modinst;
+    rc->dlt = -1;
+    rc->loops = 1;
+
+    rc->snaplen = daq_base_api.config_get_snaplen(modcfg) ? daq_base_api.config_get_snaplen(modcfg) : REPLAY_DEFAULT_SNAPLEN;
+
+    const char* varKey, * varValue;
+    daq_base_api.config_first_variable(modcfg, &varKey, &varValue);
+    while (varKey)
+    {
+        if (!strcmp(varKey, "loop"))
+            rc->loops = strtoul(varValue, NULL, 10);
+        else if (!strcmp(varKey, "rewrite"))
+            rc->rewrite = true;
+        else
+        {
+            SET_ERROR(modinst, "%s: Unknown variable name: '%s'", DAQ_NAME, varKey);
+            rval = DAQ_ERROR_INVAL;
+            goto err;
+        }
+
+        daq_base_api.config_next_variable(modcfg, &varKey, &varValue);
+    }
+
+    /* loading here puts the packets wherever the caller placed this instance */
+    if ((rval = load_pcaps(rc, daq_base_api.config_get_input(modcfg))) != DAQ_SUCCESS)
+        goto err;
+
+    /* rewriting once here leaves nothing to do per packet when replaying;
+       instance ids start at 1 when there are several and the first keeps
+       the original addresses */
+    id = daq_base_api.config_get_instance_id(modcfg);
+    key = (uint8_t)(id ? id - 1 : 0);
+
+    if (rc->rewrite && key)
+    {
+        for (unsigned i = 0; i < rc->num_pkts; ++i)
+            rewrite_packet(rc, &rc->pkts[i], key);
+    }
+
+    pool_size = daq_base_api.config_get_msg_pool_size(modcfg);
+    rval = create_message_pool(rc, pool_size ? pool_size : REPLAY_DEFAULT_POOL_SIZE);
+    if (rval != DAQ_SUCCESS)
+        goto err;
+
+    *ctxt_ptr = rc;
+
+    return DAQ_SUCCESS;
+
+err:
+    replay_daq_destroy(rc);
+    return rval;
+}
+
+static void replay_daq_destroy(void* handle)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+
+    destroy_message_pool(rc);
+
+    while (rc->num_files > 0)
+        free(rc->files[--rc->num_files]);
+
+    free(rc->files);
+    free(rc->pkts);
+    free(rc);
+}
+
+static int replay_daq_start(void* handle)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+
+    rc->next = 0;
+    rc->loop = 0;
+    rc->ts_shift = 0;
+
+    return DAQ_SUCCESS;
+}
+
+static int replay_daq_interrupt(void* handle)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+    rc->interrupted = true;
+    return DAQ_SUCCESS;
+}
+
+static int replay_daq_stop (void* handle)
+{
+    (void) handle;
+    return DAQ_SUCCESS;
+}
+
+static int replay_daq_ioctl(void* handle, DAQ_IoctlCmd cmd, void* arg, size_t arglen)
+{
+    (void) handle;
+    (void) cmd;
+    (void) arg;
+    (void) arglen;
+    return DAQ_ERROR_NOTSUP;
+}
+
+static int replay_daq_get_stats(void* handle, DAQ_Stats_t* stats)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+    memcpy(stats, &rc->stats, sizeof(DAQ_Stats_t));
+    return DAQ_SUCCESS;
+}
+
+static void replay_daq_reset_stats(void* handle)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+    memset(&rc->stats, 0, sizeof(rc->stats));
+}
+
+static int replay_daq_get_snaplen (void* handle)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+    return rc->snaplen;
+}
+
+static uint32_t replay_daq_get_capabilities(void* handle)
+{
+    (void) handle;
+    return DAQ_CAPA_INTERRUPT | DAQ_CAPA_UNPRIV_START;
+}
+
+static int replay_daq_get_datalink_type(void *handle)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+    return rc->dlt;
+}
+
+static unsigned replay_daq_msg_receive(void* handle, const unsigned max_recv, const DAQ_Msg_t* msgs[], DAQ_RecvStatus* rstat)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+    DAQ_RecvStatus status = DAQ_RSTAT_OK;
+    unsigned idx = 0;
+
+    while (idx < max_recv)
+    {
+        /* Check to see if the receive has been canceled.  If so, reset it and return appropriately. */
+        if (rc->interrupted)
+        {
+            rc->interrupted = false;
+            status = DAQ_RSTAT_INTERRUPTED;
+            break;
+        }
+
+        if (rc->next == rc->num_pkts)
+        {
+            if (rc->loops && ++rc->loop >= rc->loops)
+            {
+                status = DAQ_RSTAT_EOF;
+                break;
+            }
+
+            /* each pass starts after the previous one so time keeps moving forward */
+            rc->next = 0;
+            rc->ts_shift += rc->last_ts - rc->first_ts + 1;
+        }
+
+        /* Make sure that we have a message descriptor available to populate. */
+        ReplayMsgDesc* desc = rc->pool.freelist;
+        if (!desc)
+        {
+            status = DAQ_RSTAT_NOBUF;
+            break;
+        }
+
+        const ReplayPkt* pkt = &rc->pkts[rc->next++];
+        uint64_t ts = pkt->ts + rc->ts_shift;
+
+        desc->pkthdr.ts.tv_sec = (time_t)(ts / 1000000);
+        desc->pkthdr.ts.tv_usec = (suseconds_t)(ts % 1000000);
+        desc->pkthdr.pktlen = pkt->pktlen;
+        desc->msg.data = pkt->data;
+        desc->msg.data_len = pkt->caplen;
+
+        rc->stats.hw_packets_received++;
+        rc->stats.packets_received++;
+
+        /* Last, but not least, extract this descriptor from the free list and
+           place the message in the return vector. */
+        rc->pool.freelist = desc->next;
+        desc->next = NULL;
+        rc->pool.info.available--;
+        msgs[idx] = &desc->msg;
+
+        idx++;
+    }
+
+    *rstat = status;
+
+    return idx;
+}
+
+static int replay_daq_msg_finalize(void* handle, const DAQ_Msg_t* msg, DAQ_Verdict verdict)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+    ReplayMsgDesc* desc = (ReplayMsgDesc *) msg->priv;
+
+    if (verdict >= MAX_DAQ_VERDICT)
+        verdict = DAQ_VERDICT_PASS;
+    rc->stats.verdicts[verdict]++;
+
+    /* Toss the descriptor back on the free list for reuse. */
+    desc->next = rc->pool.freelist;
+    rc->pool.freelist = desc;
+    rc->pool.info.available++;
+
+    return DAQ_SUCCESS;
+}
+
+static int replay_daq_get_msg_pool_info(void* handle, DAQ_MsgPoolInfo_t* info)
+{
+    ReplayContext* rc = (ReplayContext*) handle;
+
+    *info = rc->pool.info;
+
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+#ifdef BUILDING_SO
+DAQ_SO_PUBLIC const DAQ_ModuleAPI_t DAQ_MODULE_DATA =
+#else
+const DAQ_ModuleAPI_t replay_daq_module_data =
+#endif
+{
+    /* .api_version = */ DAQ_MODULE_API_VERSION,
+    /* .api_size = */ sizeof(DAQ_ModuleAPI_t),
+    /* .module_version = */ DAQ_MOD_VERSION,
+    /* .name = */ DAQ_NAME,
+    /* .type = */ DAQ_TYPE,
+    /* .load = */ replay_daq_module_load,
+    /* .unload = */ NULL,
+    /* .get_variable_descs = */ replay_daq_get_variable_descs,
+    /* .instantiate = */ replay_daq_instantiate,
+    /* .destroy = */ replay_daq_destroy,
+    /* .set_filter = */ NULL,
+    /* .start = */ replay_daq_start,
+    /* .inject = */ NULL,
+    /* .inject_relative = */ NULL,
+    /* .interrupt = */ replay_daq_interrupt,
+    /* .stop = */ replay_daq_stop,
+    /* .ioctl = */ replay_daq_ioctl,
+    /* .get_stats = */ replay_daq_get_stats,
+    /* .reset_stats = */ replay_daq_reset_stats,
+    /* .get_snaplen = */ replay_daq_get_snaplen,
+    /* .get_capabilities = */ replay_daq_get_capabilities,
+    /* .get_datalink_type = */ replay_daq_get_datalink_type,
+    /* .config_load = */ NULL,
+    /* .config_swap = */ NULL,
+    /* .config_free = */ NULL,
+    /* .msg_receive = */ replay_daq_msg_receive,
+    /* .msg_finalize = */ replay_daq_msg_finalize,
+    /* .get_msg_pool_info = */ replay_daq_get_msg_pool_info,
+};
@@ -0,0 +1,855 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// daq_balance_test.cc - tests for the balance DAQ's hashing, held table, rings, and steering
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "daqs/daq_balance.c"
+
+#include <utility>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+static const uint8_t ip4_a[4] = { 10, 1, 2, 3 };
+static const uint8_t ip4_b[4] = { 192, 168, 7, 9 };
+static const uint8_t ip4_c[4] = { 10, 4, 5, 6 };
+static const uint8_t ip4_d[4] = { 172, 16, 0, 1 };
+
+static const uint8_t ip6_a[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+static const uint8_t ip6_b[16] = { 0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x11, 0x22, 0xff, 0xfe, 0x33, 0x44, 0x55 };
+
+struct Packet
+{
+    DAQ_Msg_t msg;
+    uint8_t data[128];
+};
+
+static unsigned put_eth(uint8_t* p, uint16_t type, unsigned vlans)
+{
+    memset(p, 0, ETH_HDR_LEN);
+    unsigned off = 12;
+
+    for ( unsigned i = 0; i < vlans; ++i )
+    {
+        p[off] = (i ? 0x81 : 0x88);
+        p[off + 1] = (i ? 0x00 : 0xa8);
+        p[off + 2] = 0;
+        p[off + 3] = (uint8_t)(i + 1);
+        off += VLAN_TAG_LEN;
+    }
+    p[off] = (uint8_t)(type >> 8);
+    p[off + 1] = (uint8_t)type;
+    return off + 2;
+}
+
+static void put_ports(uint8_t* p, uint16_t sp, uint16_t dp)
+{
+    p[0] = (uint8_t)(sp >> 8);
+    p[1] = (uint8_t)sp;
+    p[2] = (uint8_t)(dp >> 8);
+    p[3] = (uint8_t)dp;
+}
+
+// a tcp packet or, given a fragment offset, a later fragment without ports
+static void make_ip4(Packet& pkt, unsigned vlans, const uint8_t* src, const uint8_t* dst,
+    uint16_t sp, uint16_t dp, uint16_t frag_off = 0)
+{
+    memset(&pkt, 0, sizeof(pkt));
+    unsigned off = put_eth(pkt.data, 0x0800, vlans);
+    uint8_t* ip = pkt.data + off;
+
+    ip[0] = 0x45;
+    ip[6] = (uint8_t)(frag_off >> 8);
+    ip[7] = (uint8_t)frag_off;
+    ip[9] = 6;
+    memcpy(ip + 12, src, 4);
+    memcpy(ip + 16, dst, 4);
+
+    if ( !frag_off )
+        put_ports(ip + IP4_HDR_LEN, sp, dp);
+
+    pkt.msg.type = DAQ_MSG_TYPE_PACKET;
+    pkt.msg.data = pkt.data;
+    pkt.msg.data_len = off + IP4_HDR_LEN + 20;
+}
+
+// with frag set, a fragment header comes first and only the first fragment has ports
+static void make_ip6(Packet& pkt, unsigned vlans, const uint8_t* src, const uint8_t* dst,
+    uint16_t sp, uint16_t dp, bool frag = false, uint16_t frag_off = 0)
+{
+    memset(&pkt, 0, sizeof(pkt));
+    unsigned off = put_eth(pkt.data, 0x86dd, vlans);
+    uint8_t* ip = pkt.data + off;
+    uint8_t* l4 = ip + IP6_HDR_LEN;
+
+    ip[0] = 0x60;
+    ip[6] = frag ? 44 : 17;
+    memcpy(ip + IP6_SRC_OFF, src, 16);
+    memcpy(ip + IP6_DST_OFF, dst, 16);
+
+    if ( frag )
+    {
+        l4[0] = 17;
+        l4[2] = (uint8_t)(frag_off >> 8);
+        l4[3] = (uint8_t)frag_off;
+        l4 += 8;
+    }
+    if ( !frag_off )
+        put_ports(l4, sp, dp);
+
+    pkt.msg.type = DAQ_MSG_TYPE_PACKET;
+    pkt.msg.data = pkt.data;
+    pkt.msg.data_len = (uint32_t)(l4 - pkt.data) + 8;
+}
+
+static uint32_t hash_of(const BalanceContext& bc, const Packet& pkt)
+{
+    uint32_t hash = 0;
+    CHECK(hash_packet(&bc, &pkt.msg, &hash));
+    return hash;
+}
+
+//-------------------------------------------------------------------------
+// hashing
+//-------------------------------------------------------------------------
+
+TEST_GROUP(balance_hash)
+{
+    BalanceContext bc;
+
+    void setup() override
+    {
+        memset(&bc, 0, sizeof(bc));
+        bc.dlt = DLT_EN10MB;
+    }
+};
+
+TEST(balance_hash, ip4_symmetric)
+{
+    Packet ab, ba;
+    make_ip4(ab, 0, ip4_a, ip4_b, 40000, 443);
+    make_ip4(ba, 0, ip4_b, ip4_a, 443, 40000);
+    CHECK_EQUAL(hash_of(bc, ab), hash_of(bc, ba));
+
+    Packet other;
+    make_ip4(other, 0, ip4_a, ip4_a, 40000, 443);
+    CHECK(hash_of(bc, ab) != hash_of(bc, other));
+}
+
+TEST(balance_hash, ip6_symmetric)
+{
+    Packet ab, ba;
+    make_ip6(ab, 0, ip6_a, ip6_b, 5353, 53);
+    make_ip6(ba, 0, ip6_b, ip6_a, 53, 5353);
+    CHECK_EQUAL(hash_of(bc, ab), hash_of(bc, ba));
+
+    Packet other;
+    make_ip6(other, 0, ip6_b, ip6_b, 5353, 53);
+    CHECK(hash_of(bc, ab) != hash_of(bc, other));
+}
+
+TEST(balance_hash, vlan_ignored)
+{
+    Packet plain, tagged, qinq;
+    make_ip4(plain, 0, ip4_a, ip4_b, 1234, 80);
+    make_ip4(tagged, 1, ip4_b, ip4_a, 80, 1234);
+    make_ip4(qinq, 2, ip4_a, ip4_b, 1234, 80);
+    CHECK_EQUAL(hash_of(bc, plain), hash_of(bc, tagged));
+    CHECK_EQUAL(hash_of(bc, plain), hash_of(bc, qinq));
+
+    Packet plain6, tagged6;
+    make_ip6(plain6, 0, ip6_a, ip6_b, 1234, 80);
+    make_ip6(tagged6, 2, ip6_b, ip6_a, 80, 1234);
+    CHECK_EQUAL(hash_of(bc, plain6), hash_of(bc, tagged6));
+}
+
+TEST(balance_hash, fragments_follow_flow)
+{
+    Packet flow, first, later, reply;
+    make_ip4(flow, 0, ip4_a, ip4_b, 1234, 80);
+    make_ip4(first, 0, ip4_a, ip4_b, 1234, 80, 0x2000);
+    make_ip4(later, 0, ip4_a, ip4_b, 0, 0, 0x00b9);
+    make_ip4(reply, 1, ip4_b, ip4_a, 0, 0, 0x00b9);
+    CHECK_EQUAL(hash_of(bc, flow), hash_of(bc, first));
+    CHECK_EQUAL(hash_of(bc, flow), hash_of(bc, later));
+    CHECK_EQUAL(hash_of(bc, flow), hash_of(bc, reply));
+
+    Packet flow6, first6, later6;
+    make_ip6(flow6, 0, ip6_a, ip6_b, 1234, 80);
+    make_ip6(first6, 0, ip6_a, ip6_b, 1234, 80, true, 0x0001);
+    make_ip6(later6, 0, ip6_b, ip6_a, 0, 0, true, 0x05a8);
+    CHECK_EQUAL(hash_of(bc, flow6), hash_of(bc, first6));
+    CHECK_EQUAL(hash_of(bc, flow6), hash_of(bc, later6));
+}
+
+TEST(balance_hash, raw_ip)
+{
+    Packet eth, raw;
+    make_ip4(eth, 0, ip4_a, ip4_b, 1234, 80);
+    make_ip4(raw, 0, ip4_b, ip4_a, 80, 1234);
+    raw.msg.data += ETH_HDR_LEN;
+    raw.msg.data_len -= ETH_HDR_LEN;
+
+    uint32_t h = hash_of(bc, eth);
+    bc.dlt = DLT_RAW;
+    CHECK_EQUAL(h, hash_of(bc, raw));
+}
+
+TEST(balance_hash, unhashable)
+{
+    Packet arp;
+    make_ip4(arp, 0, ip4_a, ip4_b, 1234, 80);
+    put_eth(arp.data, 0x0806, 0);
+
+    uint32_t hash;
+    CHECK(!hash_packet(&bc, &arp.msg, &hash));
+
+    Packet runt;
+    make_ip4(runt, 0, ip4_a, ip4_b, 1234, 80);
+    runt.msg.data_len = ETH_HDR_LEN + IP4_HDR_LEN - 1;
+    CHECK(!hash_packet(&bc, &runt.msg, &hash));
+
+    Packet other;
+    make_ip4(other, 0, ip4_a, ip4_b, 1234, 80);
+    other.msg.type = DAQ_MSG_TYPE_SOF;
+    CHECK(!hash_packet(&bc, &other.msg, &hash));
+}
+
+//-------------------------------------------------------------------------
+// held table
+//-------------------------------------------------------------------------
+
+TEST_GROUP(balance_held)
+{
+    BalanceContext bc;
+    BalanceHeld table[8];
+    DAQ_Msg_t msgs[256];
+
+    void setup() override
+    {
+        memset(&bc, 0, sizeof(bc));
+        memset(table, 0, sizeof(table));
+        bc.held = table;
+        bc.held_mask = 7;
+    }
+
+    // messages that all start at the last slot so that their probes wrap
+    unsigned at_end(const DAQ_Msg_t* found[], unsigned want)
+    {
+        unsigned n = 0;
+
+        for ( unsigned i = 0; i < 256 && n < want; ++i )
+        {
+            if ( held_home(&bc, &msgs[i]) == bc.held_mask )
+                found[n++] = &msgs[i];
+        }
+        return n;
+    }
+};
+
+TEST(balance_held, add_find_remove)
+{
+    for ( unsigned i = 0; i < 6; ++i )
+        held_add(&bc, &msgs[i], i);
+
+    for ( unsigned i = 0; i < 6; ++i )
+    {
+        int at = held_find(&bc, &msgs[i]);
+        CHECK(at >= 0);
+        CHECK_EQUAL(i, bc.held[at].origin);
+    }
+    CHECK_EQUAL(-1, held_find(&bc, &msgs[6]));
+
+    for ( unsigned i = 0; i < 6; i += 2 )
+        held_remove(&bc, (uint32_t)held_find(&bc, &msgs[i]));
+
+    for ( unsigned i = 0; i < 6; ++i )
+        CHECK_EQUAL(i % 2 != 0, held_find(&bc, &msgs[i]) >= 0);
+}
+
+TEST(balance_held, wraparound)
+{
+    const DAQ_Msg_t* end[3];
+    CHECK_EQUAL(3u, at_end(end, 3));
+
+    // the second and third wrap to slots 0 and 1
+    for ( unsigned i = 0; i < 3; ++i )
+        held_add(&bc, end[i], i);
+
+    CHECK_EQUAL(7, held_find(&bc, end[0]));
+    CHECK_EQUAL(0, held_find(&bc, end[1]));
+    CHECK_EQUAL(1, held_find(&bc, end[2]));
+
+    // removing at the end shifts the wrapped entries back across the boundary
+    held_remove(&bc, 7);
+    CHECK_EQUAL(-1, held_find(&bc, end[0]));
+    CHECK_EQUAL(7, held_find(&bc, end[1]));
+    CHECK_EQUAL(0, held_find(&bc, end[2]));
+    CHECK_EQUAL(2u, bc.held[0].origin);
+    CHECK(!bc.held[1].msg);
+
+    held_remove(&bc, 7);
+    CHECK_EQUAL(7, held_find(&bc, end[2]));
+    CHECK(!bc.held[0].msg);
+
+    held_remove(&bc, 7);
+    for ( unsigned i = 0; i <= bc.held_mask; ++i )
+        CHECK(!bc.held[i].msg);
+}
+
+TEST(balance_held, wrapped_entry_stays_home)
+{
+    const DAQ_Msg_t* end[1];
+    CHECK_EQUAL(1u, at_end(end, 1));
+
+    // an entry in its home slot 0 must not move back into slot 7
+    const DAQ_Msg_t* zero = nullptr;
+
+    for ( unsigned i = 0; i < 256 && !zero; ++i )
+    {
+        if ( held_home(&bc, &msgs[i]) == 0 )
+            zero = &msgs[i];
+    }
+    CHECK(zero);
+
+    held_add(&bc, end[0], 1);
+    held_add(&bc, zero, 2);
+    held_remove(&bc, 7);
+
+    CHECK_EQUAL(0, held_find(&bc, zero));
+    CHECK(!bc.held[7].msg);
+}
+
+//-------------------------------------------------------------------------
+// rings
+//-------------------------------------------------------------------------
+
+TEST_GROUP(balance_ring)
+{
+    BalanceRing ring;
+    DAQ_Msg_t msgs[8];
+
+    void setup() override
+    {
+        memset(&ring, 0, sizeof(ring));
+        CHECK(ring_init(&ring, 3));
+    }
+
+    void teardown() override
+    {
+        free(ring.slots);
+    }
+};
+
+TEST(balance_ring, empty)
+{
+    BalanceSlot slot;
+    CHECK_EQUAL(3u, ring.mask);
+    CHECK(ring_empty(&ring));
+    CHECK(!ring_pop(&ring, &slot));
+}
+
+TEST(balance_ring, full)
+{
+    for ( unsigned i = 0; i < 4; ++i )
+        CHECK(ring_push(&ring, &msgs[i], DAQ_VERDICT_PASS));
+
+    CHECK(!ring_push(&ring, &msgs[4], DAQ_VERDICT_PASS));
+    CHECK(!ring_empty(&ring));
+
+    BalanceSlot slot;
+    CHECK(ring_pop(&ring, &slot));
+    CHECK(slot.msg == &msgs[0]);
+    CHECK(ring_push(&ring, &msgs[4], DAQ_VERDICT_BLOCK));
+    CHECK(!ring_push(&ring, &msgs[5], DAQ_VERDICT_PASS));
+}
+
+TEST(balance_ring, fifo_across_wrap)
+{
+    BalanceSlot slot;
+
+    // run the indices past the size several times
+    for ( unsigned i = 0; i < 13; ++i )
+    {
+        CHECK(ring_push(&ring, &msgs[i % 8], (DAQ_Verdict)(i % 2)));
+        CHECK(ring_pop(&ring, &slot));
+        CHECK(slot.msg == &msgs[i % 8]);
+        CHECK_EQUAL(i % 2, (unsigned)slot.verdict);
+    }
+    CHECK(ring_empty(&ring));
+
+    for ( unsigned i = 0; i < 3; ++i )
+        CHECK(ring_push(&ring, &msgs[i], DAQ_VERDICT_PASS));
+
+    for ( unsigned i = 0; i < 3; ++i )
+    {
+        CHECK(ring_pop(&ring, &slot));
+        CHECK(slot.msg == &msgs[i]);
+    }
+    CHECK(!ring_pop(&ring, &slot));
+}
+
+TEST(balance_ring, indices_overflow)
+{
+    BalanceSlot slot;
+    ring.head = ring.tail = UINT32_MAX - 1;
+
+    for ( unsigned i = 0; i < 4; ++i )
+        CHECK(ring_push(&ring, &msgs[i], DAQ_VERDICT_PASS));
+
+    CHECK(!ring_push(&ring, &msgs[4], DAQ_VERDICT_PASS));
+
+    for ( unsigned i = 0; i < 4; ++i )
+    {
+        CHECK(ring_pop(&ring, &slot));
+        CHECK(slot.msg == &msgs[i]);
+    }
+    CHECK(ring_empty(&ring));
+}
+
+//-------------------------------------------------------------------------
+// instances stacked on fake base modules
+//-------------------------------------------------------------------------
+
+static const unsigned num_inst = 3;
+static const unsigned pool_size = 8;
+
+struct FakeConfig
+{
+    unsigned id;
+};
+
+// one per instance; the base module's handle is this
+struct FakeBase
+{
+    Packet pool[pool_size];
+    std::vector<const DAQ_Msg_t*> queue;
+    DAQ_RecvStatus status = DAQ_RSTAT_OK;
+    std::vector<std::pair<const DAQ_Msg_t*, DAQ_Verdict>> finalized;
+    unsigned interrupts = 0;
+    unsigned stops = 0;
+
+    bool owns(const DAQ_Msg_t* msg) const
+    { return (const void*)msg >= (const void*)pool and (const void*)msg < (const void*)(pool + pool_size); }
+};
+
+static int fake_start(void*)
+{ return DAQ_SUCCESS; }
+
+static int fake_stop(void* handle)
+{
+    ((FakeBase*)handle)->stops++;
+    return DAQ_SUCCESS;
+}
+
+static int fake_interrupt(void* handle)
+{
+    ((FakeBase*)handle)->interrupts++;
+    return DAQ_SUCCESS;
+}
+
+static int fake_get_datalink_type(void*)
+{ return DLT_EN10MB; }
+
+static int fake_get_msg_pool_info(void*, DAQ_MsgPoolInfo_t* info)
+{
+    info->size = info->available = pool_size;
+    info->mem_size = 0;
+    return DAQ_SUCCESS;
+}
+
+// returns what was queued; the status is returned even with messages
+static unsigned fake_msg_receive(void* handle, const unsigned max_recv, const DAQ_Msg_t* msgs[], DAQ_RecvStatus* rstat)
+{
+    FakeBase* base = (FakeBase*)handle;
+    unsigned n = 0;
+
+    while ( n < max_recv and n < base->queue.size() )
+    {
+        msgs[n] = base->queue[n];
+        ++n;
+    }
+    base->queue.erase(base->queue.begin(), base->queue.begin() + n);
+    *rstat = base->status;
+    return n;
+}
+
+// the origin's pool is the only place a message can be finalized
+static int fake_msg_finalize(void* handle, const DAQ_Msg_t* msg, DAQ_Verdict verdict)
+{
+    FakeBase* base = (FakeBase*)handle;
+    CHECK(base->owns(msg));
+    base->finalized.emplace_back(msg, verdict);
+    return DAQ_SUCCESS;
+}
+
+static int resolve_subapi(DAQ_ModuleInstance_h modinst, DAQ_InstanceAPI_t* api)
+{
+    void* base = (void*)modinst;
+    memset(api, 0, sizeof(*api));
+
+    api->start.func = fake_start;
+    api->start.context = base;
+    api->stop.func = fake_stop;
+    api->stop.context = base;
+    api->interrupt.func = fake_interrupt;
+    api->interrupt.context = base;
+    api->get_datalink_type.func = fake_get_datalink_type;
+    api->get_datalink_type.context = base;
+    api->get_msg_pool_info.func = fake_get_msg_pool_info;
+    api->get_msg_pool_info.context = base;
+    api->msg_receive.func = fake_msg_receive;
+    api->msg_receive.context = base;
+    api->msg_finalize.func = fake_msg_finalize;
+    api->msg_finalize.context = base;
+
+    return DAQ_SUCCESS;
+}
+
+static int no_variable(DAQ_ModuleConfig_h, const char** key, const char** value)
+{
+    *key = *value = nullptr;
+    return 0;
+}
+
+static unsigned get_instance_id(DAQ_ModuleConfig_h modcfg)
+{ return ((FakeConfig*)modcfg)->id; }
+
+static unsigned get_total_instances(DAQ_ModuleConfig_h)
+{ return num_inst; }
+
+static void set_errbuf(DAQ_ModuleInstance_h, const char*, ...) { }
+
+TEST_GROUP(balance_multi)
+{
+    FakeConfig cfg[num_inst];
+    FakeBase base[num_inst];
+    BalanceContext* bc[num_inst];
+    const DAQ_Msg_t* msgs[pool_size];
+    DAQ_RecvStatus status;
+
+    void setup() override
+    {
+        daq_base_api.config_first_variable = no_variable;
+        daq_base_api.config_next_variable = no_variable;
+        daq_base_api.config_get_instance_id = get_instance_id;
+        daq_base_api.config_get_total_instances = get_total_instances;
+        daq_base_api.resolve_subapi = resolve_subapi;
+        daq_base_api.set_errbuf = set_errbuf;
+
+        for ( unsigned i = 0; i < num_inst; ++i )
+        {
+            cfg[i].id = i + 1;
+            CHECK_EQUAL(DAQ_SUCCESS, balance_daq_instantiate(
+                (DAQ_ModuleConfig_h)&cfg[i], (DAQ_ModuleInstance_h)&base[i], (void**)&bc[i]));
+            CHECK_EQUAL(DAQ_SUCCESS, balance_daq_start(bc[i]));
+        }
+        CHECK(shared);
+    }
+
+    void teardown() override
+    {
+        for ( unsigned i = 0; i < num_inst; ++i )
+            balance_daq_destroy(bc[i]);
+
+        CHECK(!shared);
+    }
+
+    // a packet between two hosts from the given slot of an instance's pool
+    const DAQ_Msg_t* queue(unsigned i, unsigned slot, const uint8_t* src, const uint8_t* dst)
+    {
+        Packet& pkt = base[i].pool[slot];
+        make_ip4(pkt, 0, src, dst, 1024 + slot, 80);
+        base[i].queue.push_back(&pkt.msg);
+        return &pkt.msg;
+    }
+
+    unsigned receive(unsigned i)
+    { return balance_daq_msg_receive(bc[i], pool_size, msgs, &status); }
+
+    // the part of an instance's load the tests control directly
+    void set_backlog(unsigned i, uint64_t n)
+    { shared->shares[i].backlog = n; }
+
+    DIOCTL_GetBalanceStats stats(unsigned i)
+    {
+        DIOCTL_GetBalanceStats gbs;
+        CHECK_EQUAL(DAQ_SUCCESS, balance_daq_ioctl(bc[i], DIOCTL_GET_BALANCE_STATS, &gbs, sizeof(gbs)));
+        return gbs;
+    }
+
+    uint64_t* bucket(const DAQ_Msg_t* msg)
+    {
+        uint32_t hash;
+        CHECK(hash_packet(bc[0], msg, &hash));
+        return &shared->table[hash & shared->mask];
+    }
+
+    // hands a new flow received by instance 0 to instance 2
+    const DAQ_Msg_t* hand_to_2(unsigned slot)
+    {
+        set_backlog(1, 5);
+        set_backlog(2, 0);
+        const DAQ_Msg_t* msg = queue(0, slot, ip4_a, ip4_b);
+        CHECK_EQUAL(0u, receive(0));
+        return msg;
+    }
+};
+
+TEST(balance_multi, new_flow_to_least_loaded)
+{
+    const DAQ_Msg_t* msg = hand_to_2(0);
+
+    DIOCTL_GetBalanceStats gbs = stats(0);
+    CHECK_EQUAL(1u, gbs.assigned);
+    CHECK_EQUAL(1u, gbs.moved);
+    CHECK_EQUAL(1u, gbs.forwarded);
+    CHECK_EQUAL(0u, gbs.reassigned);
+    CHECK_EQUAL(1u, bc[0]->outstanding);
+    CHECK_EQUAL(1u, shared->shares[2].pending);
+    CHECK_EQUAL(3u, (unsigned)(*bucket(msg) & 0xffff));
+    CHECK_EQUAL(0u, base[2].interrupts);
+
+    // the owner receives it, holds it, and returns it with its verdict
+    CHECK_EQUAL(1u, receive(2));
+    CHECK(msgs[0] == msg);
+    CHECK_EQUAL(1u, stats(2).adopted);
+    CHECK_EQUAL(0u, shared->shares[2].pending);
+    CHECK_EQUAL(1u, stats(2).load);
+
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_msg_finalize(bc[2], msg, DAQ_VERDICT_BLOCK));
+    CHECK(base[2].finalized.empty());
+    CHECK(base[0].finalized.empty());
+    CHECK_EQUAL(0u, stats(2).load);
+
+    // the origin finalizes it on its next receive
+    CHECK_EQUAL(0u, receive(0));
+    CHECK_EQUAL(1u, base[0].finalized.size());
+    CHECK(base[0].finalized[0].first == msg);
+    CHECK_EQUAL(DAQ_VERDICT_BLOCK, base[0].finalized[0].second);
+    CHECK_EQUAL(0u, bc[0]->outstanding);
+}
+
+TEST(balance_multi, ties_stay_local)
+{
+    // instance 0's load is the one message it just received
+    set_backlog(1, 1);
+    set_backlog(2, 1);
+    const DAQ_Msg_t* msg = queue(0, 0, ip4_a, ip4_b);
+
+    CHECK_EQUAL(1u, receive(0));
+    CHECK(msgs[0] == msg);
+
+    DIOCTL_GetBalanceStats gbs = stats(0);
+    CHECK_EQUAL(1u, gbs.assigned);
+    CHECK_EQUAL(0u, gbs.moved);
+    CHECK_EQUAL(0u, gbs.forwarded);
+
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_msg_finalize(bc[0], msg, DAQ_VERDICT_PASS));
+    CHECK_EQUAL(1u, base[0].finalized.size());
+}
+
+TEST(balance_multi, established_flow_pinned)
+{
+    hand_to_2(0);
+
+    // the owner is now the busiest but both directions still go to it
+    set_backlog(2, 100);
+    queue(0, 1, ip4_b, ip4_a);
+    CHECK_EQUAL(0u, receive(0));
+
+    set_backlog(2, 100);
+    queue(1, 0, ip4_a, ip4_b);
+    CHECK_EQUAL(0u, receive(1));
+
+    CHECK_EQUAL(1u, stats(0).assigned);
+    CHECK_EQUAL(2u, stats(0).forwarded);
+    CHECK_EQUAL(0u, stats(1).assigned);
+    CHECK_EQUAL(1u, stats(1).forwarded);
+
+    CHECK_EQUAL(3u, receive(2));
+    CHECK_EQUAL(3u, stats(2).adopted);
+}
+
+TEST(balance_multi, idle_flow_reassigned)
+{
+    const DAQ_Msg_t* msg = hand_to_2(0);
+
+    // age the bucket past the idle time
+    uint64_t* entry = bucket(msg);
+    uint32_t then = coarse_seconds() - BALANCE_DEFAULT_IDLE - 1;
+    *entry = ((uint64_t)then << 32) | (*entry & 0xffff);
+
+    set_backlog(1, 0);
+    set_backlog(2, 100);
+    queue(0, 1, ip4_a, ip4_b);
+    CHECK_EQUAL(0u, receive(0));
+
+    DIOCTL_GetBalanceStats gbs = stats(0);
+    CHECK_EQUAL(2u, gbs.assigned);
+    CHECK_EQUAL(1u, gbs.reassigned);
+    CHECK_EQUAL(2u, (unsigned)(*entry & 0xffff));
+    CHECK_EQUAL(1u, shared->shares[1].pending);
+}
+
+TEST(balance_multi, stopped_owner_replaced)
+{
+    const DAQ_Msg_t* msg = hand_to_2(0);
+
+    CHECK_EQUAL(1u, receive(2));
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_msg_finalize(bc[2], msg, DAQ_VERDICT_PASS));
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_stop(bc[2]));
+    CHECK_EQUAL(1u, base[2].stops);
+
+    // the stopped instance is idle but is given nothing, old or new
+    set_backlog(1, 0);
+    set_backlog(2, 0);
+    queue(0, 1, ip4_a, ip4_b);
+    queue(0, 2, ip4_c, ip4_d);
+    CHECK_EQUAL(0u, receive(0));
+
+    DIOCTL_GetBalanceStats gbs = stats(0);
+    CHECK_EQUAL(3u, gbs.assigned);
+    CHECK_EQUAL(1u, gbs.reassigned);
+    CHECK_EQUAL(0u, shared->shares[2].pending);
+    CHECK_EQUAL(2u, shared->shares[1].pending);
+    CHECK_EQUAL(1u, base[0].finalized.size());
+}
+
+TEST(balance_multi, unhashable_stays_local)
+{
+    set_backlog(1, 0);
+    set_backlog(2, 0);
+    const DAQ_Msg_t* msg = queue(0, 0, ip4_a, ip4_b);
+    put_eth(base[0].pool[0].data, 0x0806, 0);
+
+    CHECK_EQUAL(1u, receive(0));
+    CHECK(msgs[0] == msg);
+    CHECK_EQUAL(1u, stats(0).unsteered);
+    CHECK_EQUAL(0u, stats(0).assigned);
+}
+
+TEST(balance_multi, handoffs_returned_at_stop)
+{
+    // two handoffs the owner never receives
+    const DAQ_Msg_t* one = hand_to_2(0);
+    const DAQ_Msg_t* two = queue(0, 1, ip4_b, ip4_a);
+    CHECK_EQUAL(0u, receive(0));
+    CHECK_EQUAL(2u, bc[0]->outstanding);
+
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_stop(bc[2]));
+    CHECK_EQUAL(0u, shared->shares[2].pending);
+    CHECK(base[2].finalized.empty());
+
+    // the origin takes them back with a pass while it stops
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_stop(bc[0]));
+    CHECK_EQUAL(0u, bc[0]->outstanding);
+    CHECK_EQUAL(2u, base[0].finalized.size());
+    CHECK(base[0].finalized[0].first == one);
+    CHECK(base[0].finalized[1].first == two);
+    CHECK_EQUAL(DAQ_VERDICT_PASS, base[0].finalized[0].second);
+    CHECK_EQUAL(DAQ_VERDICT_PASS, base[0].finalized[1].second);
+    CHECK(base[2].finalized.empty());
+}
+
+TEST(balance_multi, handoff_wakes_owner)
+{
+    // as if the owner were blocked in its base receive
+    shared->shares[2].waiting = true;
+    hand_to_2(0);
+    CHECK_EQUAL(1u, base[2].interrupts);
+    CHECK_EQUAL(0u, base[1].interrupts);
+
+    // the woken receive isn't reported as interrupted
+    base[2].status = DAQ_RSTAT_INTERRUPTED;
+    CHECK_EQUAL(1u, receive(2));
+    CHECK_EQUAL(0u, receive(2));
+    CHECK_EQUAL(DAQ_RSTAT_OK, status);
+
+    // but an interrupt from the caller is, once
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_interrupt(bc[2]));
+    CHECK_EQUAL(2u, base[2].interrupts);
+    CHECK_EQUAL(0u, receive(2));
+    CHECK_EQUAL(DAQ_RSTAT_INTERRUPTED, status);
+    CHECK_EQUAL(0u, receive(2));
+    CHECK_EQUAL(DAQ_RSTAT_OK, status);
+}
+
+TEST(balance_multi, waiting_wakes_sender)
+{
+    // instance 1 hands a flow to instance 0 and then blocks
+    set_backlog(0, 0);
+    set_backlog(2, 5);
+    const DAQ_Msg_t* msg = queue(1, 0, ip4_c, ip4_d);
+    CHECK_EQUAL(0u, receive(1));
+    shared->shares[1].waiting = true;
+
+    // instance 0 wakes it before it blocks itself
+    CHECK_EQUAL(0u, receive_local(bc[0], pool_size, msgs, &status));
+    CHECK_EQUAL(1u, base[1].interrupts);
+    CHECK(!shared->shares[0].waiting);
+
+    CHECK_EQUAL(1u, receive(0));
+    CHECK(msgs[0] == msg);
+}
+
+TEST(balance_multi, turns_alternate)
+{
+    const DAQ_Msg_t* one = hand_to_2(0);
+    const DAQ_Msg_t* local = queue(2, 0, ip4_c, ip4_d);
+
+    CHECK_EQUAL(1u, receive(2));
+    CHECK(msgs[0] == one);
+
+    // another handoff waits while the base module gets its turn
+    const DAQ_Msg_t* two = queue(0, 1, ip4_b, ip4_a);
+    CHECK_EQUAL(0u, receive(0));
+
+    set_backlog(0, 5);
+    set_backlog(1, 5);
+    CHECK_EQUAL(2u, receive(2));
+    CHECK(msgs[0] == local);
+    CHECK(msgs[1] == two);
+}
+
+TEST(balance_multi, nobuf_while_outstanding)
+{
+    const DAQ_Msg_t* msg = hand_to_2(0);
+
+    // the pool refills when the owner returns what it holds
+    base[0].status = DAQ_RSTAT_NOBUF;
+    CHECK_EQUAL(0u, receive(0));
+    CHECK_EQUAL(DAQ_RSTAT_WOULD_BLOCK, status);
+
+    CHECK_EQUAL(1u, receive(2));
+    CHECK_EQUAL(DAQ_SUCCESS, balance_daq_msg_finalize(bc[2], msg, DAQ_VERDICT_PASS));
+
+    CHECK_EQUAL(0u, receive(0));
+    CHECK_EQUAL(DAQ_RSTAT_NOBUF, status);
+    CHECK_EQUAL(1u, base[0].finalized.size());
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,328 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// daq_file_test.cc - tests for the file DAQ's read and mmap modes
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "daqs/daq_file.c"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//-------------------------------------------------------------------------
+// a fake module config
+//-------------------------------------------------------------------------
+
+struct FakeConfig
+{
+    const char* input;
+    int snaplen;
+    unsigned pool_size;
+    bool mmap;
+    bool var_done;
+};
+
+static const char* config_get_input(DAQ_ModuleConfig_h modcfg)
+{ return ((FakeConfig*)modcfg)->input; }
+
+static int config_get_snaplen(DAQ_ModuleConfig_h modcfg)
+{ return ((FakeConfig*)modcfg)->snaplen; }
+
+static uint32_t config_get_msg_pool_size(DAQ_ModuleConfig_h modcfg)
+{ return ((FakeConfig*)modcfg)->pool_size; }
+
+static int config_next_variable(DAQ_ModuleConfig_h modcfg, const char** key, const char** value)
+{
+    FakeConfig* cfg = (FakeConfig*)modcfg;
+    *key = *value = nullptr;
+
+    if ( cfg->mmap and !cfg->var_done )
+        *key = "mmap";
+
+    cfg->var_done = true;
+    return 0;
+}
+
+static int config_first_variable(DAQ_ModuleConfig_h modcfg, const char** key, const char** value)
+{
+    ((FakeConfig*)modcfg)->var_done = false;
+    return config_next_variable(modcfg, key, value);
+}
+
+static void set_errbuf(DAQ_ModuleInstance_h, const char*, ...) { }
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+struct Msg
+{
+    std::string data;
+    uint32_t flags;
+
+    bool operator==(const Msg& m) const
+    { return data == m.data and flags == m.flags; }
+};
+
+static const int snaplen = 100;
+static const unsigned pool_size = 4;
+
+static void write_file(const std::string& path, const std::string& text)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+    CHECK(out.good());
+}
+
+static std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// bytes that differ from one snaplen slice to the next
+static std::string make_text(unsigned len)
+{
+    std::string s;
+
+    for ( unsigned i = 0; i < len; ++i )
+        s += (char)(i * 31 + i / snaplen);
+
+    return s;
+}
+
+static uint32_t get_flags(FileContext* fc, const DAQ_Msg_t* msg)
+{
+    DIOCTL_QueryUsrPCI qup = { msg, nullptr };
+    CHECK_EQUAL(DAQ_SUCCESS, file_daq_ioctl(fc, DIOCTL_QUERY_USR_PCI, &qup, sizeof(qup)));
+    return qup.pci->flags;
+}
+
+TEST_GROUP(daq_file)
+{
+    char dir[32] = "/tmp/daq_file_XXXXXX";
+    std::string input;
+    FakeConfig cfg;
+    FileContext* fc = nullptr;
+
+    void setup() override
+    {
+        CHECK(mkdtemp(dir));
+        input = std::string(dir) + "/input";
+
+        memset(&daq_base_api, 0, sizeof(daq_base_api));
+        daq_base_api.config_get_input = config_get_input;
+        daq_base_api.config_get_snaplen = config_get_snaplen;
+        daq_base_api.config_get_msg_pool_size = config_get_msg_pool_size;
+        daq_base_api.config_first_variable = config_first_variable;
+        daq_base_api.config_next_variable = config_next_variable;
+        daq_base_api.set_errbuf = set_errbuf;
+
+        cfg = { input.c_str(), snaplen, pool_size, false, false };
+    }
+
+    void teardown() override
+    {
+        if ( fc )
+            file_daq_destroy(fc);
+
+        unlink(input.c_str());
+        rmdir(dir);
+    }
+
+    int start(bool mmap)
+    {
+        if ( fc )
+        {
+            file_daq_destroy(fc);
+            fc = nullptr;
+        }
+        cfg.mmap = mmap;
+        CHECK_EQUAL(DAQ_SUCCESS, file_daq_instantiate(
+            (DAQ_ModuleConfig_h)&cfg, (DAQ_ModuleInstance_h)this, (void**)&fc));
+        CHECK_EQUAL(mmap, fc->mmap);
+        return file_daq_start(fc);
+    }
+
+    // everything up to the end of flow, which is added as an empty message
+    std::vector<Msg> receive_all(bool mmap)
+    {
+        std::vector<Msg> got;
+        CHECK_EQUAL(DAQ_SUCCESS, start(mmap));
+
+        DAQ_RecvStatus status = DAQ_RSTAT_OK;
+        uint32_t eof_flags = 0;
+
+        while ( status != DAQ_RSTAT_EOF )
+        {
+            const DAQ_Msg_t* msgs[2 * pool_size];
+            unsigned n = file_daq_msg_receive(fc, 2 * pool_size, msgs, &status);
+
+            // nothing blocks so every batch runs to the pool size or end of file
+            CHECK(status == (n == pool_size ? DAQ_RSTAT_NOBUF : DAQ_RSTAT_EOF));
+
+            // the end of flow is flagged on the next free descriptor, which isn't returned
+            if ( status == DAQ_RSTAT_EOF )
+                eof_flags = fc->pool.freelist->pci.flags;
+
+            for ( unsigned i = 0; i < n; ++i )
+            {
+                got.push_back({ std::string((const char*)msgs[i]->data, msgs[i]->data_len),
+                    get_flags(fc, msgs[i]) });
+                file_daq_msg_finalize(fc, msgs[i], DAQ_VERDICT_PASS);
+            }
+        }
+        got.push_back({ "", eof_flags });
+
+        file_daq_stop(fc);
+        return got;
+    }
+};
+
+TEST(daq_file, same_messages)
+{
+    std::string text = make_text(9 * snaplen + 17);
+    write_file(input, text);
+
+    std::vector<Msg> reads = receive_all(false);
+    std::vector<Msg> maps = receive_all(true);
+
+    CHECK(reads == maps);
+    CHECK_EQUAL(11u, maps.size());
+
+    std::string all;
+    for ( const auto& m : maps )
+        all += m.data;
+
+    CHECK(all == text);
+    CHECK_EQUAL((unsigned)snaplen, maps[0].data.size());
+    CHECK_EQUAL(17u, maps[9].data.size());
+
+    CHECK_EQUAL(DAQ_USR_FLAG_START_FLOW, maps[0].flags);
+    CHECK_EQUAL(0u, maps[1].flags);
+    CHECK_EQUAL(DAQ_USR_FLAG_END_FLOW, maps[10].flags);
+}
+
+TEST(daq_file, multiple_of_snaplen)
+{
+    write_file(input, make_text(2 * snaplen));
+
+    std::vector<Msg> reads = receive_all(false);
+    std::vector<Msg> maps = receive_all(true);
+
+    CHECK(reads == maps);
+    CHECK_EQUAL(3u, maps.size());
+}
+
+TEST(daq_file, empty_file)
+{
+    write_file(input, "");
+
+    std::vector<Msg> reads = receive_all(false);
+    std::vector<Msg> maps = receive_all(true);
+
+    CHECK(reads == maps);
+    CHECK_EQUAL(1u, maps.size());
+    CHECK_EQUAL(DAQ_USR_FLAG_START_FLOW | DAQ_USR_FLAG_END_FLOW, maps[0].flags);
+}
+
+TEST(daq_file, no_buffers_when_mapped)
+{
+    write_file(input, make_text(snaplen));
+
+    CHECK_EQUAL(DAQ_SUCCESS, start(false));
+    CHECK_EQUAL(pool_size * (sizeof(FileMsgDesc) + snaplen), fc->pool.info.mem_size);
+    file_daq_stop(fc);
+
+    CHECK_EQUAL(DAQ_SUCCESS, start(true));
+    CHECK_EQUAL(pool_size * sizeof(FileMsgDesc), fc->pool.info.mem_size);
+    file_daq_stop(fc);
+}
+
+TEST(daq_file, changes_stay_private)
+{
+    std::string text = make_text(snaplen);
+    write_file(input, text);
+
+    CHECK_EQUAL(DAQ_SUCCESS, start(true));
+
+    const DAQ_Msg_t* msg;
+    DAQ_RecvStatus status;
+    CHECK_EQUAL(1u, file_daq_msg_receive(fc, 1, &msg, &status));
+
+    msg->data[0] ^= 0xff;
+    file_daq_msg_finalize(fc, msg, DAQ_VERDICT_PASS);
+    file_daq_stop(fc);
+
+    CHECK(read_file(input) == text);
+}
+
+TEST(daq_file, tty_not_mapped)
+{
+    // even when stdin is a regular file
+    write_file(input, make_text(snaplen));
+    int save = dup(STDIN_FILENO);
+    int fd = open(input.c_str(), O_RDONLY);
+    CHECK(save >= 0 and fd >= 0);
+    CHECK_EQUAL(STDIN_FILENO, dup2(fd, STDIN_FILENO));
+    close(fd);
+
+    cfg.input = "tty";
+    int rval = start(true);
+    file_daq_stop(fc);
+
+    // stdin is left open
+    bool open = fcntl(STDIN_FILENO, F_GETFD) != -1;
+
+    dup2(save, STDIN_FILENO);
+    close(save);
+
+    CHECK_EQUAL(DAQ_ERROR, rval);
+    CHECK(open);
+}
+
+TEST(daq_file, fifo_not_mapped)
+{
+    CHECK_EQUAL(0, mkfifo(input.c_str(), 0600));
+    CHECK_EQUAL(DAQ_ERROR, start(true));
+    file_daq_stop(fc);
+
+    // but can be read
+    CHECK_EQUAL(DAQ_SUCCESS, start(false));
+    file_daq_stop(fc);
+}
+
+TEST(daq_file, directory_not_mapped)
+{
+    cfg.input = dir;
+    CHECK_EQUAL(DAQ_ERROR, start(true));
+    file_daq_stop(fc);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
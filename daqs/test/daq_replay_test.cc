@@ -0,0 +1,549 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// daq_replay_test.cc - tests for the replay DAQ's address rewrite and looping
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "daqs/daq_replay.c"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+static void set_errbuf(DAQ_ModuleInstance_h, const char*, ...) { }
+
+//-------------------------------------------------------------------------
+// checksums computed from scratch
+//-------------------------------------------------------------------------
+
+static uint32_t sum_words(const uint8_t* p, unsigned len, uint32_t sum = 0)
+{
+    for ( unsigned i = 0; i + 1 < len; i += 2 )
+        sum += get16be(p + i);
+
+    if ( len & 1 )
+        sum += p[len - 1] << 8;
+
+    return sum;
+}
+
+static uint16_t fold(uint32_t sum)
+{
+    while ( sum >> 16 )
+        sum = (sum & 0xffff) + (sum >> 16);
+
+    return (uint16_t)~sum;
+}
+
+static void set_ip4_sum(uint8_t* ip)
+{
+    put16be(ip + 10, 0);
+    put16be(ip + 10, fold(sum_words(ip, IP4_HDR_LEN)));
+}
+
+static uint16_t l4_sum(const uint8_t* src, const uint8_t* dst, unsigned alen,
+    uint8_t proto, uint8_t* l4, unsigned len, unsigned sum_off)
+{
+    uint8_t save[2] = { l4[sum_off], l4[sum_off + 1] };
+    put16be(l4 + sum_off, 0);
+
+    uint32_t sum = sum_words(src, alen) + sum_words(dst, alen) + proto + len;
+    uint16_t rval = fold(sum_words(l4, len, sum));
+
+    l4[sum_off] = save[0];
+    l4[sum_off + 1] = save[1];
+    return rval;
+}
+
+//-------------------------------------------------------------------------
+// packet builders
+//-------------------------------------------------------------------------
+
+static const unsigned payload_len = 11;
+
+struct Packet
+{
+    uint8_t data[256];
+    unsigned len;
+    uint8_t* ip;
+    uint8_t* l4;
+};
+
+static void fill_l4(uint8_t* l4, uint8_t proto, unsigned len)
+{
+    for ( unsigned i = 0; i < len; ++i )
+        l4[i] = (uint8_t)(i * 7 + 3);
+
+    if ( proto == 6 )
+        l4[12] = 0x50;
+
+    else if ( proto == 17 )
+        put16be(l4 + 4, (uint16_t)len);
+}
+
+static unsigned l4_len(uint8_t proto)
+{
+    return (proto == 6 ? 20 : 8) + payload_len;
+}
+
+static unsigned sum_off(uint8_t proto)
+{
+    return proto == 6 ? 16 : proto == 17 ? 6 : 2;
+}
+
+static void make_ip4(Packet& pkt, uint8_t proto, uint16_t frag = 0)
+{
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.data[12] = 0x08;
+    pkt.ip = pkt.data + ETH_HDR_LEN;
+    pkt.l4 = pkt.ip + IP4_HDR_LEN;
+
+    unsigned len = l4_len(proto);
+    uint8_t* ip = pkt.ip;
+    ip[0] = 0x45;
+    put16be(ip + 2, (uint16_t)(IP4_HDR_LEN + len));
+    put16be(ip + 6, frag);
+    ip[8] = 64;
+    ip[9] = proto;
+    const uint8_t src[4] = { 10, 9, 8, 7 }, dst[4] = { 172, 16, 254, 1 };
+    memcpy(ip + 12, src, 4);
+    memcpy(ip + 16, dst, 4);
+
+    fill_l4(pkt.l4, proto, len);
+    put16be(pkt.l4 + sum_off(proto), l4_sum(ip + 12, ip + 16, 4, proto, pkt.l4, len, sum_off(proto)));
+    set_ip4_sum(ip);
+    pkt.len = ETH_HDR_LEN + IP4_HDR_LEN + len;
+}
+
+// exts is a list of extension header types ending with the transport protocol
+static void make_ip6(Packet& pkt, const uint8_t* exts, unsigned num_exts, uint16_t frag = 0)
+{
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.data[12] = 0x86;
+    pkt.data[13] = 0xdd;
+    pkt.ip = pkt.data + ETH_HDR_LEN;
+
+    uint8_t* ip = pkt.ip;
+    ip[0] = 0x60;
+    ip[6] = exts[0];
+    ip[7] = 64;
+    for ( unsigned i = 0; i < 16; ++i )
+    {
+        ip[8 + i] = (uint8_t)(0x20 + i);
+        ip[24 + i] = (uint8_t)(0xa0 + i);
+    }
+
+    uint8_t* p = ip + IP6_HDR_LEN;
+
+    for ( unsigned i = 0; i + 1 < num_exts; ++i )
+    {
+        p[0] = exts[i + 1];
+
+        if ( exts[i] == 44 )
+        {
+            put16be(p + 2, frag);
+            p += 8;
+        }
+        else
+        {
+            // one 8 octet unit beyond the first
+            p[1] = 1;
+            p += 16;
+        }
+    }
+    pkt.l4 = p;
+
+    uint8_t proto = exts[num_exts - 1];
+    unsigned len = l4_len(proto);
+    fill_l4(pkt.l4, proto, len);
+    put16be(pkt.l4 + sum_off(proto), l4_sum(ip + 8, ip + 24, 16, proto, pkt.l4, len, sum_off(proto)));
+
+    put16be(ip + 4, (uint16_t)(pkt.l4 + len - ip - IP6_HDR_LEN));
+    pkt.len = (unsigned)(pkt.l4 + len - pkt.data);
+}
+
+//-------------------------------------------------------------------------
+// rewrite
+//-------------------------------------------------------------------------
+
+TEST_GROUP(replay_rewrite)
+{
+    ReplayContext rc;
+    uint8_t before[256];
+
+    void setup() override
+    {
+        memset(&rc, 0, sizeof(rc));
+        rc.dlt = DLT_EN10MB;
+    }
+
+    void rewrite(Packet& pkt, uint8_t key)
+    {
+        memcpy(before, pkt.data, sizeof(before));
+        ReplayPkt rp = { pkt.data, pkt.len, pkt.len, 0 };
+        rewrite_packet(&rc, &rp, key);
+    }
+
+    // nothing but the given bytes and the checksum changed
+    void check_changed(const Packet& pkt, const uint8_t* a, const uint8_t* b, const uint8_t* sum)
+    {
+        for ( unsigned i = 0; i < sizeof(before); ++i )
+        {
+            const uint8_t* p = pkt.data + i;
+
+            if ( p != a && p != b && p != sum && p != sum + 1 && p != pkt.ip + 10 && p != pkt.ip + 11 )
+                CHECK_EQUAL(before[i], pkt.data[i]);
+        }
+    }
+
+    void check_ip4(Packet& pkt, uint8_t proto)
+    {
+        uint8_t* ip = pkt.ip;
+        CHECK_EQUAL(0, fold(sum_words(ip, IP4_HDR_LEN)));
+
+        unsigned len = l4_len(proto);
+        CHECK_EQUAL(l4_sum(ip + 12, ip + 16, 4, proto, pkt.l4, len, sum_off(proto)),
+            get16be(pkt.l4 + sum_off(proto)));
+        check_changed(pkt, ip + 14, ip + 18, pkt.l4 + sum_off(proto));
+    }
+
+    void check_ip6(Packet& pkt, uint8_t proto)
+    {
+        uint8_t* ip = pkt.ip;
+        unsigned len = l4_len(proto);
+        CHECK_EQUAL(l4_sum(ip + 8, ip + 24, 16, proto, pkt.l4, len, sum_off(proto)),
+            get16be(pkt.l4 + sum_off(proto)));
+        check_changed(pkt, ip + 17, ip + 33, pkt.l4 + sum_off(proto));
+    }
+};
+
+TEST(replay_rewrite, ip4_tcp)
+{
+    Packet pkt;
+    make_ip4(pkt, 6);
+    rewrite(pkt, 5);
+
+    CHECK_EQUAL(8 ^ 5, pkt.ip[14]);
+    CHECK_EQUAL(254 ^ 5, pkt.ip[18]);
+    CHECK_EQUAL(10, pkt.ip[12]);
+    CHECK_EQUAL(1, pkt.ip[19]);
+    check_ip4(pkt, 6);
+}
+
+TEST(replay_rewrite, ip4_udp)
+{
+    Packet pkt;
+    make_ip4(pkt, 17);
+
+    for ( unsigned key = 1; key < 256; ++key )
+    {
+        rewrite(pkt, (uint8_t)key);
+        check_ip4(pkt, 17);
+        CHECK(get16be(pkt.l4 + 6) != 0);
+    }
+}
+
+TEST(replay_rewrite, ip4_udp_without_checksum)
+{
+    Packet pkt;
+    make_ip4(pkt, 17);
+    put16be(pkt.l4 + 6, 0);
+    rewrite(pkt, 3);
+
+    CHECK_EQUAL(0, get16be(pkt.l4 + 6));
+    CHECK_EQUAL(0, fold(sum_words(pkt.ip, IP4_HDR_LEN)));
+}
+
+TEST(replay_rewrite, ip4_later_fragment)
+{
+    Packet pkt;
+    make_ip4(pkt, 6, 0x00b9);
+    uint8_t l4[64];
+    memcpy(l4, pkt.l4, sizeof(l4));
+    rewrite(pkt, 9);
+
+    // there is no transport header to update
+    CHECK_EQUAL(0, memcmp(l4, pkt.l4, sizeof(l4)));
+    CHECK_EQUAL(0, fold(sum_words(pkt.ip, IP4_HDR_LEN)));
+}
+
+TEST(replay_rewrite, ip4_vlan)
+{
+    Packet pkt;
+    make_ip4(pkt, 6);
+
+    // push the ip header behind a tag
+    memmove(pkt.data + ETH_HDR_LEN + 4, pkt.data + ETH_HDR_LEN, pkt.len - ETH_HDR_LEN);
+    put16be(pkt.data + 12, 0x8100);
+    put16be(pkt.data + 16, 0x0800);
+    pkt.ip += 4;
+    pkt.l4 += 4;
+    pkt.len += 4;
+
+    rewrite(pkt, 2);
+    CHECK_EQUAL(8 ^ 2, pkt.ip[14]);
+    check_ip4(pkt, 6);
+}
+
+TEST(replay_rewrite, ip6_tcp)
+{
+    const uint8_t exts[] = { 6 };
+    Packet pkt;
+    make_ip6(pkt, exts, 1);
+    rewrite(pkt, 0x42);
+
+    CHECK_EQUAL(0x29 ^ 0x42, pkt.ip[8 + 9]);
+    CHECK_EQUAL(0xa9 ^ 0x42, pkt.ip[24 + 9]);
+    check_ip6(pkt, 6);
+}
+
+TEST(replay_rewrite, ip6_extension_headers)
+{
+    const uint8_t exts[] = { 0, 60, 43, 17 };
+    Packet pkt;
+    make_ip6(pkt, exts, 4);
+    rewrite(pkt, 7);
+    check_ip6(pkt, 17);
+}
+
+TEST(replay_rewrite, ip6_first_fragment)
+{
+    const uint8_t exts[] = { 0, 44, 58 };
+    Packet pkt;
+    make_ip6(pkt, exts, 3, 0x0001);
+    rewrite(pkt, 0x80);
+    check_ip6(pkt, 58);
+}
+
+TEST(replay_rewrite, ip6_later_fragment)
+{
+    const uint8_t exts[] = { 44, 6 };
+    Packet pkt;
+    make_ip6(pkt, exts, 2, 0x05a8);
+    uint16_t sum = get16be(pkt.l4 + 16);
+    rewrite(pkt, 0x80);
+
+    CHECK_EQUAL(0x29 ^ 0x80, pkt.ip[8 + 9]);
+    CHECK_EQUAL(sum, get16be(pkt.l4 + 16));
+}
+
+TEST(replay_rewrite, ip6_truncated_extension)
+{
+    const uint8_t exts[] = { 0, 17 };
+    Packet pkt;
+    make_ip6(pkt, exts, 2);
+
+    // cut into the hop by hop options; only the addresses change
+    pkt.len = ETH_HDR_LEN + IP6_HDR_LEN + 12;
+    rewrite(pkt, 1);
+    CHECK_EQUAL(0x29 ^ 1, pkt.ip[8 + 9]);
+}
+
+TEST(replay_rewrite, raw)
+{
+    Packet pkt;
+    make_ip4(pkt, 17);
+
+    rc.dlt = DLT_RAW;
+    memcpy(before, pkt.data, sizeof(before));
+    ReplayPkt rp = { pkt.ip, pkt.len - ETH_HDR_LEN, pkt.len - ETH_HDR_LEN, 0 };
+    rewrite_packet(&rc, &rp, 4);
+    CHECK_EQUAL(8 ^ 4, pkt.ip[14]);
+    check_ip4(pkt, 17);
+}
+
+//-------------------------------------------------------------------------
+// loading and looping
+//-------------------------------------------------------------------------
+
+static void put32(uint8_t* p, uint32_t v, bool swap)
+{
+    v = swap ? __builtin_bswap32(v) : v;
+    memcpy(p, &v, sizeof(v));
+}
+
+// records at the given seconds with the given fraction and a length of 60
+static unsigned make_pcap(uint8_t* buf, uint32_t magic, bool swap, const uint32_t* secs, unsigned num, uint32_t frac)
+{
+    memset(buf, 0, PCAP_FILE_HDR_LEN);
+    put32(buf, magic, swap);
+    put32(buf + 16, 65535, swap);
+    put32(buf + 20, DLT_EN10MB, swap);
+
+    unsigned off = PCAP_FILE_HDR_LEN;
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        put32(buf + off, secs[i], swap);
+        put32(buf + off + 4, frac, swap);
+        put32(buf + off + 8, 60, swap);
+        put32(buf + off + 12, 60, swap);
+        memset(buf + off + PCAP_REC_HDR_LEN, (int)i, 60);
+        off += PCAP_REC_HDR_LEN + 60;
+    }
+    return off;
+}
+
+TEST_GROUP(replay_loop)
+{
+    ReplayContext rc;
+    uint8_t buf[1024];
+
+    void setup() override
+    {
+        memset(&rc, 0, sizeof(rc));
+        rc.dlt = -1;
+        rc.snaplen = REPLAY_DEFAULT_SNAPLEN;
+        rc.loops = 1;
+        daq_base_api.set_errbuf = set_errbuf;
+    }
+
+    void teardown() override
+    {
+        destroy_message_pool(&rc);
+        free(rc.pkts);
+    }
+
+    void load(const uint32_t* secs, unsigned num)
+    {
+        unsigned len = make_pcap(buf, PCAP_MAGIC_US, false, secs, num, 250);
+        CHECK_EQUAL(DAQ_SUCCESS, parse_pcap(&rc, "test", buf, len));
+        CHECK_EQUAL(DAQ_SUCCESS, create_message_pool(&rc, 4));
+        replay_daq_start(&rc);
+    }
+
+    // receives and finalizes one message
+    uint64_t next_ts(DAQ_RecvStatus& rstat)
+    {
+        const DAQ_Msg_t* msg;
+
+        if ( !replay_daq_msg_receive(&rc, 1, &msg, &rstat) )
+            return 0;
+
+        const DAQ_PktHdr_t* hdr = (const DAQ_PktHdr_t*)msg->hdr;
+        uint64_t ts = (uint64_t)hdr->ts.tv_sec * 1000000 + hdr->ts.tv_usec;
+        replay_daq_msg_finalize(&rc, msg, DAQ_VERDICT_PASS);
+        return ts;
+    }
+};
+
+TEST(replay_loop, parse)
+{
+    const uint32_t secs[] = { 100, 101, 103 };
+    uint8_t* other = buf + 512;
+
+    // byte swapped nanoseconds
+    unsigned len = make_pcap(other, PCAP_MAGIC_NS, true, secs, 3, 250000);
+    CHECK_EQUAL(DAQ_SUCCESS, parse_pcap(&rc, "test", other, len - 10));
+
+    // the truncated last record is dropped
+    CHECK_EQUAL(2u, rc.num_pkts);
+    CHECK_EQUAL(DLT_EN10MB, rc.dlt);
+    CHECK_EQUAL(100000250u, rc.first_ts);
+    CHECK_EQUAL(101000250u, rc.last_ts);
+    CHECK_EQUAL(60u, rc.pkts[1].caplen);
+    CHECK_EQUAL(1, rc.pkts[1].data[0]);
+
+    uint8_t ng[PCAP_FILE_HDR_LEN] = { };
+    put32(ng, PCAPNG_MAGIC, false);
+    CHECK_EQUAL(DAQ_ERROR_INVAL, parse_pcap(&rc, "ng", ng, sizeof(ng)));
+}
+
+TEST(replay_loop, once)
+{
+    const uint32_t secs[] = { 10, 12 };
+    load(secs, 2);
+
+    DAQ_RecvStatus rstat;
+    CHECK_EQUAL(10000250u, next_ts(rstat));
+    CHECK_EQUAL(12000250u, next_ts(rstat));
+    CHECK_EQUAL(0u, next_ts(rstat));
+    CHECK_EQUAL(DAQ_RSTAT_EOF, rstat);
+    CHECK_EQUAL(2u, rc.stats.packets_received);
+}
+
+TEST(replay_loop, shifts_each_pass)
+{
+    const uint32_t secs[] = { 10, 12, 11 };
+    load(secs, 3);
+    rc.loops = 3;
+
+    // each pass starts just after the last packet of the one before
+    const uint64_t span = 2000001;
+    DAQ_RecvStatus rstat;
+
+    for ( unsigned pass = 0; pass < 3; ++pass )
+    {
+        CHECK_EQUAL(10000250u + pass * span, next_ts(rstat));
+        CHECK_EQUAL(12000250u + pass * span, next_ts(rstat));
+        CHECK_EQUAL(11000250u + pass * span, next_ts(rstat));
+        CHECK_EQUAL(DAQ_RSTAT_OK, rstat);
+    }
+    CHECK_EQUAL(0u, next_ts(rstat));
+    CHECK_EQUAL(DAQ_RSTAT_EOF, rstat);
+    CHECK_EQUAL(9u, rc.stats.packets_received);
+}
+
+TEST(replay_loop, until_stopped)
+{
+    const uint32_t secs[] = { 5 };
+    load(secs, 1);
+    rc.loops = 0;
+
+    DAQ_RecvStatus rstat;
+    uint64_t last = 0;
+
+    for ( unsigned i = 0; i < 100; ++i )
+    {
+        uint64_t ts = next_ts(rstat);
+        CHECK_EQUAL(DAQ_RSTAT_OK, rstat);
+        CHECK(ts > last);
+        last = ts;
+    }
+
+    replay_daq_interrupt(&rc);
+    CHECK_EQUAL(0u, next_ts(rstat));
+    CHECK_EQUAL(DAQ_RSTAT_INTERRUPTED, rstat);
+}
+
+TEST(replay_loop, pool_exhausted)
+{
+    const uint32_t secs[] = { 1, 2, 3 };
+    load(secs, 3);
+    rc.loops = 0;
+
+    const DAQ_Msg_t* msgs[8];
+    DAQ_RecvStatus rstat;
+    CHECK_EQUAL(4u, replay_daq_msg_receive(&rc, 8, msgs, &rstat));
+    CHECK_EQUAL(DAQ_RSTAT_NOBUF, rstat);
+
+    // the fourth is the first packet of the second pass
+    CHECK(msgs[3]->data == rc.pkts[0].data);
+
+    for ( unsigned i = 0; i < 4; ++i )
+        replay_daq_msg_finalize(&rc, msgs[i], DAQ_VERDICT_PASS);
+
+    CHECK_EQUAL(4u, rc.pool.info.available);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -120,6 +120,9 @@ static const Parameter detection_params[] =
       "enable strict deduplication of rule headers by ports (saves memory, but "
       "loses some speed during config reading)" },
 
+    { "parallel_rule_lexing", Parameter::PT_BOOL, nullptr, "false",
+      "tokenize rules files on a separate thread while rules are built" },
+
     { "max_continuations_per_flow", Parameter::PT_INT, "0:65535", "1024",
       "maximum number of continuations stored simultaneously on the flow" },
 
@@ -275,6 +278,9 @@ bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("enable_strict_reduction") )
         sc->enable_strict_reduction = v.get_bool();
 
+    else if ( v.is("parallel_rule_lexing") )
+        sc->parallel_rule_lexing = v.get_bool();
+
     else if ( v.is("max_continuations_per_flow") )
         sc->max_continuations = v.get_uint16();
 
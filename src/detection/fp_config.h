@@ -124,6 +124,12 @@ public:
     const std::string& get_rule_db_dir() const
     { return rule_db_dir; }
 
+    void set_reuse_rule_dbs(bool b)
+    { reuse_rule_dbs = b; }
+
+    bool get_reuse_rule_dbs() const
+    { return reuse_rule_dbs; }
+
     bool set_search_method(const char*);
     const char* get_search_method() const;
 
@@ -157,6 +163,7 @@ private:
     bool debug_print_fast_pattern = false;
     bool debug = false;
     bool dedup = true;
+    bool reuse_rule_dbs = false;
 
     unsigned max_queue_events = 5;
     unsigned bleedover_port_limit = 1024;
@@ -1592,17 +1592,25 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
 
     unsigned mpse_loaded = 0;
     unsigned mpse_dumped = 0;
+    unsigned mpse_reused = 0;
+    unsigned mpse_retained = 0;
 
     if ( !sc->test_mode() or sc->mem_check() )
     {
         if ( !fp->get_rule_db_dir().empty() )
             mpse_loaded = fp_deserialize(sc, fp->get_rule_db_dir());
 
+        else if ( fp->get_reuse_rule_dbs() )
+            mpse_reused = fp_reuse(sc);
+
         unsigned c = compile_mpses(sc, can_build_mt(fp));
         unsigned expected = mpse_count + offload_mpse_count;
 
         if ( c != expected )
             ParseError("Failed to compile %u search engines", expected - c);
+
+        else if ( fp->get_reuse_rule_dbs() )
+            mpse_retained = fp_retain(sc);
     }
 
     bool label = fp_print_port_groups(port_tables);
@@ -1629,6 +1637,8 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
     LogCount("fast pattern only", fp_only);
     LogCount("mpse_loaded", mpse_loaded);
     LogCount("mpse_dumped", mpse_dumped);
+    LogCount("mpse_reused", mpse_reused);
+    LogCount("mpse_retained", mpse_retained);
 
     MpseManager::setup_search_engine(fp->get_search_api(), sc);
 
@@ -1640,6 +1650,8 @@ void fpDeleteFastPacketDetection(SnortConfig* sc)
     if (sc == nullptr)
         return;
 
+    fp_release(sc);
+
     /* Cleanup the detection option tree */
     delete sc->detection_option_hash_table;
     delete sc->detection_option_tree_hash_table;
@@ -85,6 +85,10 @@
 #include "tag.h"
 #include "treenodes.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 enum FPTask : uint8_t
@@ -117,12 +121,173 @@ void populate_trace_data()
     }
 }
 
+static int sortOrderByPriority(const void* e1, const void* e2)
+{
+    const OptTreeNode* otn1;
+    const OptTreeNode* otn2;
+
+    if (!e1 || !e2)
+        return 0;
+
+    otn1 = *(OptTreeNode* const*)e1;
+    otn2 = *(OptTreeNode* const*)e2;
+
+    if ( otn1->sigInfo.priority < otn2->sigInfo.priority )
+        return -1;
+
+    if ( otn1->sigInfo.priority > otn2->sigInfo.priority )
+        return +1;
+
+    /* This improves stability of repeated tests */
+    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
+        return -1;
+
+    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
+        return +1;
+
+    return 0;
+}
+
+// FIXIT-L pattern length is not a valid event sort criterion for
+// non-literals
+static int sortOrderByContentLength(const void* e1, const void* e2)
+{
+    const OptTreeNode* otn1;
+    const OptTreeNode* otn2;
+
+    if (!e1 || !e2)
+        return 0;
+
+    otn1 = *(OptTreeNode* const*)e1;
+    otn2 = *(OptTreeNode* const*)e2;
+
+    if (otn1->longestPatternLen < otn2->longestPatternLen)
+        return +1;
+
+    if (otn1->longestPatternLen > otn2->longestPatternLen)
+        return -1;
+
+    /* This improves stability of repeated tests */
+    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
+        return +1;
+
+    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
+        return -1;
+
+    return 0;
+}
+
+// bounds the number of matches held across all rule types at under 40%
+// load so probes stay short; must be a power of 2
+#define MATCH_SET_SIZE 4096
+
+static_assert(MAX_NUM_RULE_TYPES * MAX_EVENT_MATCH * 2 < MATCH_SET_SIZE,
+    "match set must hold every queued match");
+
+static inline void clear_matches(OtnxMatchData* omd, unsigned num_rule_types)
+{
+    for ( unsigned i = 0; i < num_rule_types; i++ )
+        omd->matchInfo[i].iMatchCount = 0;
+
+    for ( unsigned i = 0; i < omd->match_count; i++ )
+        omd->match_set[omd->match_slots[i]] = nullptr;
+
+    omd->match_count = 0;
+}
+
 static inline void init_match_info(const IpsContext* c)
 {
-    for ( unsigned i = 0; i < c->conf->num_rule_types; i++ )
-        c->otnx->matchInfo[i].iMatchCount = 0;
+    OtnxMatchData* omd = c->otnx;
+    clear_matches(omd, c->conf->num_rule_types);
 
-    c->otnx->have_match = false;
+    omd->compar = ( c->conf->event_queue_config->order == SNORT_EVENTQ_PRIORITY )
+        ? &sortOrderByPriority : &sortOrderByContentLength;
+
+    omd->have_match = false;
+}
+
+// returns false if the otn was already matched
+static inline bool add_unique_match(OtnxMatchData* omd, const OptTreeNode* otn)
+{
+    uint32_t h = otn->sigInfo.gid * 0x9e3779b1 ^ otn->sigInfo.sid;
+    h ^= h >> 15;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+
+    for ( unsigned slot = h & (MATCH_SET_SIZE - 1); ; slot = (slot + 1) & (MATCH_SET_SIZE - 1) )
+    {
+        const OptTreeNode* cur = omd->match_set[slot];
+
+        if ( !cur )
+        {
+            omd->match_set[slot] = otn;
+            omd->match_slots[omd->match_count++] = slot;
+            return true;
+        }
+        if ( cur == otn )
+            return false;
+    }
+}
+
+static inline void push_match(MatchInfo* pmi, const OptTreeNode* otn,
+    int (* compar)(const void*, const void*))
+{
+    const OptTreeNode** heap = pmi->MatchArray;
+    unsigned pos = pmi->iMatchCount++;
+
+    while ( pos )
+    {
+        unsigned parent = (pos - 1) / 2;
+
+        if ( compar(&heap[parent], &otn) <= 0 )
+            break;
+
+        heap[pos] = heap[parent];
+        pos = parent;
+    }
+    heap[pos] = otn;
+}
+
+// removes the highest ranked match from the list, which stays a heap of
+// the remaining matches; selection consumes the list this way so nothing
+// may look at it afterwards expecting all the matches of the packet
+static inline const OptTreeNode* pop_match(MatchInfo* pmi,
+    int (* compar)(const void*, const void*))
+{
+    const OptTreeNode** heap = pmi->MatchArray;
+    unsigned& n = pmi->iMatchCount;
+    const OptTreeNode* top = heap[0];
+    const OptTreeNode* last = heap[--n];
+    unsigned pos = 0;
+
+    while ( true )
+    {
+        unsigned child = 2 * pos + 1;
+
+        if ( child >= n )
+            break;
+
+        if ( child + 1 < n and compar(&heap[child + 1], &heap[child]) < 0 )
+            ++child;
+
+        if ( compar(&last, &heap[child]) <= 0 )
+            break;
+
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = last;
+    return top;
+}
+
+// add the otn to the given list unless it was already queued on any list
+static inline void queue_match(OtnxMatchData* omd, MatchInfo* pmi, const OptTreeNode* otn)
+{
+    if ( !add_unique_match(omd, otn) )
+        return;
+
+    push_match(pmi, otn, omd->compar);
+    omd->have_match = true;
 }
 
 // called by fpLogEvent(), which does the filtering etc.
@@ -311,17 +476,7 @@ int fpAddMatch(OtnxMatchData* omd, const OptTreeNode* otn)
         return 1;
     }
 
-    // don't store the same otn again
-    for ( unsigned i = 0; i < pmi->iMatchCount; i++ )
-    {
-        if ( pmi->MatchArray[i] == otn )
-            return 0;
-    }
-
-    //  add the event to the appropriate list
-    pmi->MatchArray[ pmi->iMatchCount ] = otn;
-    pmi->iMatchCount++;
-    omd->have_match = true;
+    queue_match(omd, pmi, otn);
     return 0;
 }
 
@@ -452,62 +607,6 @@ static void rule_tree_match(
     }
 }
 
-static int sortOrderByPriority(const void* e1, const void* e2)
-{
-    const OptTreeNode* otn1;
-    const OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode* const*)e1;
-    otn2 = *(OptTreeNode* const*)e2;
-
-    if ( otn1->sigInfo.priority < otn2->sigInfo.priority )
-        return -1;
-
-    if ( otn1->sigInfo.priority > otn2->sigInfo.priority )
-        return +1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return -1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return +1;
-
-    return 0;
-}
-
-// FIXIT-L pattern length is not a valid event sort criterion for
-// non-literals
-static int sortOrderByContentLength(const void* e1, const void* e2)
-{
-    const OptTreeNode* otn1;
-    const OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode* const*)e1;
-    otn2 = *(OptTreeNode* const*)e2;
-
-    if (otn1->longestPatternLen < otn2->longestPatternLen)
-        return +1;
-
-    if (otn1->longestPatternLen > otn2->longestPatternLen)
-        return -1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return +1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return -1;
-
-    return 0;
-}
-
 /*
 **  DESCRIPTION
 **    This function flags an alert per session.
@@ -626,9 +725,6 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
     unsigned tcnt = 0;
     int res = 0;
     EventQueueConfig* eq = p->context->conf->event_queue_config;
-    int (*compar)(const void *, const void *);
-    compar = ( eq->order == SNORT_EVENTQ_PRIORITY )
-        ? &sortOrderByPriority : sortOrderByContentLength;
 
     for ( unsigned i = 0; i < p->context->conf->num_rule_types; i++ )
     {
@@ -640,8 +736,8 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
         if ( omd->matchInfo[i].iMatchCount )
         {
             /*
-             * We must always sort so if we que 8 and log 3 and they are
-             * all from the same action group we want them sorted so we get
+             * We must always rank so if we que 8 and log 3 and they are
+             * all from the same action group we want them ordered so we get
              * the highest 3 in priority, priority and length sort do NOT
              * take precedence over 'alert drop pass ...' ordering.  If
              * order is 'drop alert', and we log 3 for drop alerts do not
@@ -650,23 +746,22 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
              * built in drop/block/reset comes before alert/pass/log as
              * part of the natural ordering....Jan '06..
              */
-            /* Sort the rules in this action group */
-            qsort(omd->matchInfo[i].MatchArray, omd->matchInfo[i].iMatchCount,
-                sizeof(void*), compar);
+            /* Take the rules in this action group in event order */
+            MatchInfo* pmi = &omd->matchInfo[i];
 
             /* Process each event in the action (alert,drop,log,...) groups */
-            for ( unsigned j = 0; j < omd->matchInfo[i].iMatchCount; j++ )
+            while ( pmi->iMatchCount )
             {
-                const OptTreeNode* otn = omd->matchInfo[i].MatchArray[j];
-                assert(otn);
-
                 if ( tcnt >= eq->max_events )
                 {
-                    pc.queue_limit += omd->matchInfo[i].iMatchCount - j;
+                    pc.queue_limit += pmi->iMatchCount;
                     res = 1;
                     break;
                 }
 
+                const OptTreeNode* otn = pop_match(pmi, omd->compar);
+                assert(otn);
+
                 RuleTreeNode* rtn = getRtnFromOtn(otn);
 
                 if ( !rtn )
@@ -679,19 +774,6 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
                         return 1;
                 }
 
-                //  Loop here so we don't log the same event multiple times.
-                for (unsigned k = 0; k < j; k++)
-                {
-                    if ( omd->matchInfo[i].MatchArray[k] == otn )
-                    {
-                        otn = nullptr;
-                        break;
-                    }
-                }
-
-                if ( !otn )
-                    continue;
-
                 if ( !fpSessionAlerted(p, otn) )
                 {
                     if ( DetectionEngine::queue_event(otn) )
@@ -846,6 +928,9 @@ void fp_set_context(IpsContext& c)
     c.stash = new MpseStash(*fp);
     c.otnx = (OtnxMatchData*)snort_calloc(sizeof(OtnxMatchData));
     c.otnx->matchInfo = (MatchInfo*)snort_calloc(MAX_NUM_RULE_TYPES, sizeof(MatchInfo));
+    c.otnx->match_set = (const OptTreeNode**)snort_calloc(MATCH_SET_SIZE, sizeof(OptTreeNode*));
+    c.otnx->match_slots = (uint16_t*)snort_calloc(MATCH_SET_SIZE, sizeof(uint16_t));
+    c.otnx->compar = &sortOrderByContentLength;
     c.context_num = 0;
 }
 
@@ -853,6 +938,8 @@ void fp_clear_context(const IpsContext& c)
 {
     delete c.stash;
     snort_free(c.otnx->matchInfo);
+    snort_free(c.otnx->match_set);
+    snort_free(c.otnx->match_slots);
     snort_free(c.otnx);
 }
 
@@ -1385,9 +1472,15 @@ static inline int fp_do_actions(OtnxMatchData* omd, Packet* p)
     {
         if (omd->matchInfo[i].iMatchCount)
         {
-            qsort(omd->matchInfo[i].MatchArray, omd->matchInfo[i].iMatchCount,
-                sizeof(void*), sortOrderByContentLength);
-            const OptTreeNode* otn = omd->matchInfo[i].MatchArray[0];
+            const OptTreeNode** m = omd->matchInfo[i].MatchArray;
+            const OptTreeNode* otn = m[0];
+
+            // act on the match with the longest pattern
+            for ( unsigned j = 1; j < omd->matchInfo[i].iMatchCount; j++ )
+            {
+                if ( sortOrderByContentLength(&m[j], &otn) < 0 )
+                    otn = m[j];
+            }
             RuleTreeNode* rtn = getRtnFromOtn(otn);
             IpsAction* act = get_ips_policy()->action[rtn->action];
             act->exec(p, otn);
@@ -1436,3 +1529,138 @@ void fp_eval_service_group(Packet* p, SnortProtocolId snort_protocol_id)
     c->active_rules = actv_rules;
     snort::set_ips_policy(ips_policy);
 }
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+struct MatchTest
+{
+    MatchTest()
+    {
+        omd.matchInfo = match_info;
+        omd.match_set = match_set;
+        omd.match_slots = match_slots;
+        omd.match_count = 0;
+        omd.compar = &sortOrderByContentLength;
+        omd.have_match = false;
+    }
+
+    // the lists in the order selection would take them
+    std::vector<const OptTreeNode*> take(unsigned list)
+    {
+        std::vector<const OptTreeNode*> v;
+
+        while ( match_info[list].iMatchCount )
+            v.emplace_back(pop_match(&match_info[list], omd.compar));
+
+        return v;
+    }
+
+    MatchInfo match_info[MAX_NUM_RULE_TYPES] = { };
+    const OptTreeNode* match_set[MATCH_SET_SIZE] = { };
+    uint16_t match_slots[MATCH_SET_SIZE] = { };
+    OtnxMatchData omd;
+};
+
+static void set_otns(std::vector<OptTreeNode>& otns)
+{
+    // ties on length and priority so the sid decides some
+    for ( unsigned i = 0; i < otns.size(); ++i )
+    {
+        otns[i].sigInfo.gid = 1 + i % 2;
+        otns[i].sigInfo.sid = (i * 37) % 101 + 1000;
+        otns[i].sigInfo.priority = (i * 7) % 4;
+        otns[i].longestPatternLen = (i * 13) % 5;
+    }
+}
+
+TEST_CASE("matches are queued once across lists", "[fp_detect]")
+{
+    MatchTest mt;
+    std::vector<OptTreeNode> otns(3);
+    set_otns(otns);
+
+    queue_match(&mt.omd, &mt.match_info[0], &otns[0]);
+    queue_match(&mt.omd, &mt.match_info[1], &otns[0]);
+    queue_match(&mt.omd, &mt.match_info[1], &otns[1]);
+    queue_match(&mt.omd, &mt.match_info[0], &otns[1]);
+    queue_match(&mt.omd, &mt.match_info[2], &otns[2]);
+    queue_match(&mt.omd, &mt.match_info[2], &otns[2]);
+
+    CHECK(mt.omd.have_match);
+    CHECK(mt.omd.match_count == 3);
+    CHECK(mt.match_info[0].iMatchCount == 1);
+    CHECK(mt.match_info[1].iMatchCount == 1);
+    CHECK(mt.match_info[2].iMatchCount == 1);
+
+    CHECK(mt.take(0) == std::vector<const OptTreeNode*>{ &otns[0] });
+    CHECK(mt.take(1) == std::vector<const OptTreeNode*>{ &otns[1] });
+}
+
+TEST_CASE("matches are taken in sorted order", "[fp_detect]")
+{
+    std::vector<OptTreeNode> otns(MAX_EVENT_MATCH);
+    set_otns(otns);
+
+    auto check_order = [&](int (* compar)(const void*, const void*))
+    {
+        MatchTest mt;
+        mt.omd.compar = compar;
+
+        // what the lists were qsorted into before
+        std::vector<const OptTreeNode*> expect;
+
+        for ( unsigned i = 0; i < otns.size(); ++i )
+        {
+            const OptTreeNode* otn = &otns[(i * 59) % otns.size()];
+            queue_match(&mt.omd, &mt.match_info[0], otn);
+            expect.emplace_back(otn);
+        }
+        qsort(expect.data(), expect.size(), sizeof(expect[0]), compar);
+
+        CHECK(mt.take(0) == expect);
+    };
+
+    SECTION("content length")
+    {
+        check_order(&sortOrderByContentLength);
+    }
+    SECTION("priority")
+    {
+        check_order(&sortOrderByPriority);
+    }
+}
+
+TEST_CASE("matches are cleared between packets", "[fp_detect]")
+{
+    MatchTest mt;
+    std::vector<OptTreeNode> otns(4);
+    set_otns(otns);
+
+    for ( auto& otn : otns )
+        queue_match(&mt.omd, &mt.match_info[1], &otn);
+
+    CHECK(mt.match_info[1].iMatchCount == 4);
+
+    clear_matches(&mt.omd, MAX_NUM_RULE_TYPES);
+
+    CHECK(mt.omd.match_count == 0);
+    CHECK(mt.match_info[1].iMatchCount == 0);
+
+    unsigned used = 0;
+
+    for ( auto* otn : mt.match_set )
+        used += otn ? 1 : 0;
+
+    CHECK(used == 0);
+
+    // the same otns match again on the next packet
+    for ( auto& otn : otns )
+        queue_match(&mt.omd, &mt.match_info[1], &otn);
+
+    CHECK(mt.match_info[1].iMatchCount == 4);
+    CHECK(mt.omd.match_count == 4);
+}
+#endif
@@ -65,9 +65,10 @@ void populate_trace_data();
 #define MAX_EVENT_MATCH 100
 
 /*
-**  The events that are matched get held in this structure,
-**  and iMatchIndex gets set to the event that holds the
-**  highest priority.
+**  The events that are matched get held in this structure.
+**  MatchArray is kept as a binary heap in event order so the
+**  highest ranked event is always MatchArray[0].  Selecting the
+**  events pops them off, consuming the list.
 */
 struct MatchInfo
 {
@@ -88,6 +89,14 @@ struct MatchInfo
 struct OtnxMatchData
 {
     MatchInfo* matchInfo;
+
+    // otns matched so far, open addressed on gid:sid, plus the occupied
+    // slots so reset only touches what was used
+    const OptTreeNode** match_set;
+    uint16_t* match_slots;
+    unsigned match_count;
+
+    int (* compar)(const void*, const void*);
     bool have_match;
 };
 
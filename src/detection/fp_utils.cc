@@ -31,6 +31,7 @@
 #include <sstream>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "framework/inspector.h"
 #include "framework/mpse.h"
@@ -377,6 +378,87 @@ static bool db_load(const std::string& path, const char* proto, const char* dir,
     return true;
 }
 
+// compiled databases retained in memory across reloads, keyed by pattern
+// hash, so that only groups with changed patterns are compiled again.  a
+// database is kept while any config that retained it is alive so it goes
+// with the old config once a reload is done, or with the new one if the
+// reload is aborted.
+struct RetainedDb
+{
+    std::string db;
+    unsigned users = 0;
+};
+
+static std::unordered_map<std::string, RetainedDb> s_db_cache;
+static std::unordered_map<const SnortConfig*, std::unordered_set<std::string>> s_db_users;
+static std::unordered_set<std::string>* s_db_retaining = nullptr;
+
+static bool reuse_db(Mpse* mpse)
+{
+    std::string id;
+    mpse->get_hash(id);
+
+    auto db = s_db_cache.find(id);
+
+    if ( db == s_db_cache.end() )
+        return false;
+
+    return mpse->deserialize((const uint8_t*)db->second.db.data(), db->second.db.size());
+}
+
+static void retain_db(Mpse* mpse, std::unordered_set<std::string>& ids)
+{
+    std::string id;
+    mpse->get_hash(id);
+
+    if ( id.empty() or !ids.insert(id).second )
+        return;
+
+    RetainedDb& rdb = s_db_cache[id];
+
+    if ( rdb.users++ )
+        return;
+
+    uint8_t* db = nullptr;
+    size_t len = 0;
+
+    if ( mpse->serialize(db, len) and db and len > 0 )
+        rdb.db.assign((const char*)db, len);
+
+    else
+    {
+        s_db_cache.erase(id);
+        ids.erase(id);
+    }
+    free(db);
+}
+
+static bool db_reuse(const std::string&, const char*, const char*, RuleGroup* g)
+{
+    for ( int sect = PS_NONE; sect <= PS_MAX; sect++)
+    {
+        for ( auto it : g->pm_list[sect] )
+        {
+            if ( !it->group.normal_is_dup and reuse_db(it->group.normal_mpse) )
+                ++mpse_loaded;
+        }
+    }
+    return true;
+}
+
+static bool db_retain(const std::string&, const char*, const char*, RuleGroup* g)
+{
+    for ( int sect = PS_NONE; sect <= PS_MAX; sect++)
+    {
+        for ( auto it : g->pm_list[sect] )
+        {
+            if ( !it->group.normal_is_dup )
+                retain_db(it->group.normal_mpse, *s_db_retaining);
+        }
+    }
+    return true;
+}
+
 typedef bool (*db_io)(const std::string&, const char*, const char*, RuleGroup*);
 
 static void port_io(
@@ -454,6 +536,44 @@ unsigned fp_deserialize(const SnortConfig* sc, const std::string& dir)
     return mpse_loaded;
 }
 
+unsigned fp_reuse(const SnortConfig* sc)
+{
+    mpse_loaded = 0;
+    fp_io(sc, "", db_reuse);
+    return mpse_loaded;
+}
+
+unsigned fp_retain(const SnortConfig* sc)
+{
+    fp_release(sc);
+
+    s_db_retaining = &s_db_users[sc];
+    fp_io(sc, "", db_retain);
+
+    unsigned n = s_db_retaining->size();
+    s_db_retaining = nullptr;
+
+    return n;
+}
+
+void fp_release(const SnortConfig* sc)
+{
+    auto users = s_db_users.find(sc);
+
+    if ( users == s_db_users.end() )
+        return;
+
+    for ( const auto& id : users->second )
+    {
+        auto rdb = s_db_cache.find(id);
+        assert(rdb != s_db_cache.end());
+
+        if ( !--rdb->second.users )
+            s_db_cache.erase(rdb);
+    }
+    s_db_users.erase(users);
+}
+
 bool has_service_rule_opt(OptTreeNode* otn)
 {
     for (OptFpList* ofl = otn->opt_func; ofl; ofl = ofl->next)
@@ -967,5 +1087,100 @@ TEST_CASE("fp_pkt_key_srvc_rsp", "[FastPatternSelect]")
     CHECK(false == s0.is_better_than(s1, true, RULE_FROM_SERVER));
     CHECK(true == s1.is_better_than(s0, true, RULE_FROM_SERVER));
 }
+
+// hashes and serializes to its patterns; deserializing stands in for compiling
+class DbTestMpse : public Mpse
+{
+public:
+    DbTestMpse(const char* p) : Mpse("db_test"), pats(p) { }
+
+    int add_pattern(const uint8_t*, unsigned, const PatternDescriptor&, void*) override
+    { return 0; }
+
+    int prep_patterns(SnortConfig*) override
+    { return 0; }
+
+    void get_hash(std::string& h) override
+    { h = pats; }
+
+    bool serialize(uint8_t*& db, size_t& len) const override
+    {
+        len = pats.size();
+        db = (uint8_t*)malloc(len);
+        memcpy(db, pats.data(), len);
+        return true;
+    }
+
+    bool deserialize(const uint8_t* db, size_t len) override
+    {
+        loaded.assign((const char*)db, len);
+        return true;
+    }
+
+    std::string pats;
+    std::string loaded;
+
+protected:
+    int _search(const uint8_t*, int, MpseMatch, void*, int*) override
+    { return 0; }
+};
+
+// one rule group database per mpse, retained for the given config
+static void retain_dbs(const SnortConfig* sc, std::vector<DbTestMpse>& groups)
+{
+    fp_release(sc);
+
+    for ( auto& g : groups )
+        retain_db(&g, s_db_users[sc]);
+}
+
+TEST_CASE("rule db reuse across reload", "[fp_reuse]")
+{
+    // the configs are only used as keys
+    int conf_a, conf_b;
+    const SnortConfig* old_sc = (const SnortConfig*)&conf_a;
+    const SnortConfig* new_sc = (const SnortConfig*)&conf_b;
+
+    std::vector<DbTestMpse> old_groups { "abc", "def", "abc" };
+    retain_dbs(old_sc, old_groups);
+
+    CHECK(s_db_cache.size() == 2);
+    CHECK(s_db_users[old_sc].size() == 2);
+
+    std::vector<DbTestMpse> new_groups { "abc", "xyz" };
+
+    // the unchanged group loads the old database, the changed one compiles
+    CHECK(reuse_db(&new_groups[0]));
+    CHECK(new_groups[0].loaded == "abc");
+    CHECK(!reuse_db(&new_groups[1]));
+    CHECK(new_groups[1].loaded.empty());
+
+    retain_dbs(new_sc, new_groups);
+    CHECK(s_db_cache.size() == 3);
+    CHECK(s_db_cache["abc"].users == 2);
+
+    SECTION("reload done")
+    {
+        fp_release(old_sc);
+
+        CHECK(s_db_cache.size() == 2);
+        CHECK(s_db_cache.find("def") == s_db_cache.end());
+        CHECK(s_db_cache["abc"].users == 1);
+
+        fp_release(new_sc);
+    }
+    SECTION("reload aborted")
+    {
+        fp_release(new_sc);
+
+        CHECK(s_db_cache.size() == 2);
+        CHECK(s_db_cache.find("xyz") == s_db_cache.end());
+        CHECK(s_db_cache["abc"].users == 1);
+
+        fp_release(old_sc);
+    }
+    CHECK(s_db_cache.empty());
+    CHECK(s_db_users.empty());
+}
 #endif
 
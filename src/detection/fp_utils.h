@@ -55,6 +55,13 @@ void validate_services(struct snort::SnortConfig*, OptTreeNode*);
 unsigned fp_serialize(const struct snort::SnortConfig*, const std::string& dir);
 unsigned fp_deserialize(const struct snort::SnortConfig*, const std::string& dir);
 
+// load unchanged databases retained from the previous configuration and
+// retain the current ones for the next; both return the number of databases.
+// release drops the databases no other live configuration retains.
+unsigned fp_reuse(const struct snort::SnortConfig*);
+unsigned fp_retain(const struct snort::SnortConfig*);
+void fp_release(const struct snort::SnortConfig*);
+
 void update_buffer_map(const char** bufs, const char* svc);
 void add_default_services(struct snort::SnortConfig*, const std::string&, OptTreeNode*);
 
@@ -180,9 +180,10 @@ ThreadRegexOffload::ThreadRegexOffload(unsigned max) : RegexOffload(max)
 {
     unsigned i = ThreadConfig::get_instance_max();
     const SnortConfig* sc = SnortConfig::get_conf();
+    int node = ThreadConfig::get_numa_node();
 
     for ( auto* req : idle )
-        req->thread = new std::thread(worker, req, sc, i++);
+        req->thread = new std::thread(worker, req, sc, i++, node);
 }
 
 ThreadRegexOffload::~ThreadRegexOffload()
@@ -265,11 +266,15 @@ bool ThreadRegexOffload::get(Packet*& p)
 }
 
 void ThreadRegexOffload::worker(
-    RegexRequest* req, const SnortConfig* initial_config, unsigned id)
+    RegexRequest* req, const SnortConfig* initial_config, unsigned id, int node)
 {
     set_instance_id(id);
     SnortConfig::set_conf(initial_config);
 
+    // search from the packet thread's node like the packet thread does
+    if ( node >= 0 and ThreadConfig::prefer_numa_node(node) )
+        initial_config->localize_scratch();
+
     while ( true )
     {
         {
@@ -88,7 +88,7 @@ public:
     bool get(snort::Packet*&) override;
 
 private:
-    static void worker(RegexRequest*, const snort::SnortConfig*, unsigned id);
+    static void worker(RegexRequest*, const snort::SnortConfig*, unsigned id, int node);
 };
 
 #endif
@@ -31,10 +31,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 
-#include "hash/ghash.h"
 #include "log/messages.h"
-#include "utils/util.h"
 
 #ifdef UNIT_TEST
 #include "catch/snort_catch.h"
@@ -42,12 +41,6 @@
 
 using namespace snort;
 
-struct MergeNode
-{
-    IdentifierNode* shared_node;  /*the node that is shared*/
-    IdentifierNode* append_node;  /*the node that is added*/
-};
-
 void FileMeta::clear()
 {
     rev = 0;
@@ -58,80 +51,8 @@ void FileMeta::clear()
     groups.clear();
 }
 
-void FileIdentifier::init_merge_hash()
-{
-    identifier_merge_hash = new GHash(1000, sizeof(MergeNode), false, nullptr);
-}
-
-FileIdentifier::~FileIdentifier()
-{
-    /*Release memory used for identifiers*/
-    for (auto mem_block:id_memory_blocks)
-        snort_free(mem_block);
-
-    if (identifier_merge_hash != nullptr)
-        delete identifier_merge_hash;
-}
-
-void* FileIdentifier::calloc_mem(size_t size)
-{
-    void* ret = snort_calloc(size);
-    memory_used += size;
-    /*For memory management*/
-    id_memory_blocks.emplace_back(ret);
-    return ret;
-}
-
-void FileIdentifier::set_node_state_shared(IdentifierNode* start)
-{
-    unsigned int i;
-
-    if (!start)
-        return;
-
-    if (start->state == ID_NODE_SHARED)
-        return;
-
-    if (start->state == ID_NODE_USED)
-        start->state = ID_NODE_SHARED;
-    else
-        start->state = ID_NODE_USED;
-
-    for (i = 0; i < MAX_BRANCH; i++)
-        set_node_state_shared(start->next[i]);
-}
-
-/*Clone a trie*/
-IdentifierNode* FileIdentifier::clone_node(IdentifierNode* start)
-{
-    unsigned int index;
-    IdentifierNode* node;
-    if (!start)
-        return nullptr;
-
-    node = (IdentifierNode*)calloc_mem(sizeof(*node));
-
-    node->offset = start->offset;
-    node->type_id = start->type_id;
-
-    for (index = 0; index < MAX_BRANCH; index++)
-    {
-        if (start->next[index])
-        {
-            node->next[index] = start->next[index];
-        }
-    }
-    return node;
-}
-
 void FileIdentifier::add_file_id(FileMeta& rule)
 {
-    if (!identifier_root)
-    {
-        identifier_root = (IdentifierNode*)calloc_mem(sizeof(*identifier_root));
-        init_merge_hash();
-    }
-
     if (file_magic_rules[rule.id].id > 0)
     {
         ParseError("file type: rule id %u found duplicate", rule.id);
@@ -142,56 +63,20 @@ void FileIdentifier::add_file_id(FileMeta& rule)
 }
 
 /*
- * This is the main function to find file type
- * Find file type is to traverse the tries.
- * Context is saved to continue file type identification as data becomes available
+ * File magic is matched by the file_id rules in the detection engine, there
+ * is no magic to scan here. This only completes the lookup for callers that
+ * still ask the identifier directly: once data is seen, the type is unknown.
  */
-uint32_t FileIdentifier::find_file_type_id(const uint8_t* buf, int len, uint64_t file_offset,
+uint32_t FileIdentifier::find_file_type_id(const uint8_t* buf, int len, uint64_t,
     void** context)
 {
-    uint32_t file_type_id = SNORT_FILE_TYPE_CONTINUE;
-
     assert(context);
 
     if ( !buf || len <= 0 )
         return SNORT_FILE_TYPE_CONTINUE;
 
-    if (!(*context))
-        *context = (void*)(identifier_root);
-
-    IdentifierNode* current = (IdentifierNode*)(*context);
-
-    uint64_t end = file_offset + len;
-
-    while (current &&  (current->offset >= file_offset))
-    {
-        /*Found file id, save and continue*/
-        if (current->type_id)
-        {
-            file_type_id = current->type_id;
-        }
-
-        if ( current->offset >= end )
-        {
-            /* Save current state */
-            *context = current;
-            if (file_type_id)
-                return file_type_id;
-            else
-                return SNORT_FILE_TYPE_CONTINUE;
-        }
-
-        /*Move to the next level*/
-        current = current->next[buf[current->offset - file_offset ]];
-    }
-
-    /*Either end of magics or passed the current offset*/
     *context = nullptr;
-
-    if ( file_type_id == SNORT_FILE_TYPE_CONTINUE )
-        file_type_id = SNORT_FILE_TYPE_UNKNOWN;
-
-    return file_type_id;
+    return SNORT_FILE_TYPE_UNKNOWN;
 }
 
 const FileMeta* FileIdentifier::get_rule_from_id(uint32_t id) const
@@ -229,13 +114,6 @@ void FileIdentifier::get_magic_rule_ids_from_type(const std::string& type,
 //--------------------------------------------------------------------------
 
 #ifdef UNIT_TEST
-TEST_CASE ("FileIdMemory", "[FileMagic]")
-{
-    FileIdentifier rc;
-
-    CHECK(rc.memory_usage() == 0);
-}
-
 TEST_CASE ("FileIdRulePDF", "[FileMagic]")
 {
     FileMeta rule;
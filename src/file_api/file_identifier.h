@@ -22,29 +22,16 @@
 #ifndef FILE_IDENTIFIER_H
 #define FILE_IDENTIFIER_H
 
-// File type identification is based on file magic. To improve the detection
-// performance, a trie is created to scan file data once. Currently, only the
-// most specific file type is returned.
+// File type identification is based on file magic. The magic patterns are
+// carried by file_id rules (see file_magic.rules) and matched by the detection
+// engine, so they share the fast pattern search with all other rules. This
+// class only keeps the file_meta of each rule so that type ids can be mapped
+// back to names, categories and versions.
 
-#include <list>
 #include <vector>
 
 #include "file_lib.h"
 
-namespace snort
-{
-class GHash;
-}
-
-#define MAX_BRANCH (UINT8_MAX + 1)
-
-enum IdNodeState
-{
-    ID_NODE_NEW,
-    ID_NODE_USED,
-    ID_NODE_SHARED
-};
-
 class FileMeta
 {
 public:
@@ -62,21 +49,9 @@ public:
     std::vector<std::string> groups;
 };
 
-struct IdentifierNode
-{
-    uint32_t type_id;       /* magic content to match*/
-    IdNodeState state;
-    uint32_t offset;            /* offset from file start */
-    struct IdentifierNode* next[MAX_BRANCH]; /* pointer to an array of 256 identifiers pointers*/
-};
-
-typedef std::list<void* >  IDMemoryBlocks;
-
 class FileIdentifier
 {
 public:
-    ~FileIdentifier();
-    uint32_t memory_usage() const { return memory_used; }
     void add_file_id(FileMeta& rule);
     uint32_t find_file_type_id(const uint8_t* buf, int len, uint64_t offset, void** context);
     const FileMeta* get_rule_from_id(uint32_t) const;
@@ -84,19 +59,7 @@ public:
         snort::FileTypeBitSet&) const;
 
 private:
-    void init_merge_hash();
-    void* calloc_mem(size_t size);
-    void set_node_state_shared(IdentifierNode* start);
-    IdentifierNode* clone_node(IdentifierNode* start);
-    bool update_next(IdentifierNode* start, IdentifierNode** next_ptr, IdentifierNode* append);
-    void update_trie(IdentifierNode* start, IdentifierNode* append);
-
-    /*properties*/
-    IdentifierNode* identifier_root = nullptr; /*Root of magic tries*/
-    uint32_t memory_used = 0; /*Track memory usage*/
-    snort::GHash* identifier_merge_hash = nullptr;
     FileMeta file_magic_rules[FILE_ID_MAX + 1];
-    IDMemoryBlocks id_memory_blocks;
 };
 
 #endif
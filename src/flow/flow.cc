@@ -23,6 +23,8 @@
 
 #include "flow.h"
 
+#include <cassert>
+
 #include "detection/context_switcher.h"
 #include "detection/detection_continuation.h"
 #include "detection/detection_engine.h"
@@ -214,11 +216,58 @@ int Flow::set_flow_data(FlowData* fd)
         flow_data->prev = fd;
 
     flow_data = fd;
+    index_flow_data(fd);
     return 0;
 }
 
+void Flow::index_flow_data(FlowData* fd)
+{
+    unsigned id = fd->get_id();
+
+    if ( id >= FLOW_DATA_INDEX_IDS )
+        return;
+
+    for ( unsigned i = 0; i < FLOW_DATA_SLOTS; ++i )
+    {
+        if ( !fd_slots[i] )
+        {
+            fd_slots[i] = fd;
+            fd_index[id] = i + 1;
+            return;
+        }
+    }
+    ++fd_unindexed;
+}
+
+void Flow::unindex_flow_data(FlowData* fd)
+{
+    unsigned id = fd->get_id();
+
+    if ( id >= FLOW_DATA_INDEX_IDS )
+        return;
+
+    if ( unsigned slot = fd_index[id] )
+    {
+        assert(fd_slots[slot - 1] == fd);
+        fd_slots[slot - 1] = nullptr;
+        fd_index[id] = 0;
+        return;
+    }
+    assert(fd_unindexed);
+    --fd_unindexed;
+}
+
 FlowData* Flow::get_flow_data(unsigned id) const
 {
+    if ( id < FLOW_DATA_INDEX_IDS )
+    {
+        if ( unsigned slot = fd_index[id] )
+            return fd_slots[slot - 1];
+
+        if ( !fd_unindexed )
+            return nullptr;
+    }
+
     FlowData* fd = flow_data;
 
     while (fd)
@@ -249,6 +298,7 @@ void Flow::free_flow_data(FlowData* fd)
         fd->prev->next = fd->next;
         fd->next->prev = fd->prev;
     }
+    unindex_flow_data(fd);
     delete fd;
 }
 
@@ -295,6 +345,7 @@ void Flow::free_flow_data()
     {
         FlowData* tmp = flow_data;
         flow_data = flow_data->next;
+        unindex_flow_data(tmp);
         delete tmp;
     }
 
@@ -101,6 +101,12 @@
 #define STREAM_STATE_BLOCK_PENDING     0x0080
 #define STREAM_STATE_RELEASING         0x0100
 
+// flow data ids are assigned in order as inspectors are initialized so the
+// builtin ids are all small; FLOW_DATA_SLOTS covers the typical number of
+// flow data items on one flow
+#define FLOW_DATA_INDEX_IDS 64
+#define FLOW_DATA_SLOTS     12
+
 class Continuation;
 class BitOp;
 class Session;
@@ -442,6 +448,13 @@ public:  // FIXIT-M privatize if possible
 
     IpsContextChain context_chain;
     FlowData* flow_data = nullptr;
+
+    // flow data with a low id is also held in a slot found through fd_index
+    // so lookup doesn't have to walk the list
+    FlowData* fd_slots[FLOW_DATA_SLOTS] = { };
+    uint8_t fd_index[FLOW_DATA_INDEX_IDS] = { };  // slot + 1 by id, 0 if none
+    uint8_t fd_unindexed = 0;                     // low ids found only on the list
+
     FlowStats flowstats = {};
     StreamFlowIntf* stream_intf = nullptr;
 
@@ -511,6 +524,8 @@ public:  // FIXIT-M privatize if possible
 
 private:
     void clean();
+    void index_flow_data(FlowData*);
+    void unindex_flow_data(FlowData*);
 };
 
 inline void Flow::set_to_client_detection(bool enable)
@@ -24,14 +24,53 @@
 
 #include "flow_stash.h"
 
+#include <atomic>
 #include <cassert>
+#include <mutex>
 
+#include "log/messages.h"
 #include "pub_sub/auxiliary_ip_event.h"
 #include "pub_sub/stash_events.h"
 
 using namespace snort;
 using namespace std;
 
+// interned keys are only ever added, and a name is written before the
+// count that publishes it, so packet threads can search without the lock
+static string key_names[STASH_MAX_KEYS];
+static atomic<unsigned> key_count { 0 };
+static mutex key_lock;
+
+static unsigned find_key(const string& key)
+{
+    unsigned n = key_count.load(memory_order_acquire);
+
+    for ( unsigned id = 0; id < n; ++id )
+    {
+        if ( key_names[id] == key )
+            return id;
+    }
+    return STASH_MAX_KEYS;
+}
+
+unsigned FlowStash::get_key_id(const char* key)
+{
+    lock_guard<mutex> lock(key_lock);
+    unsigned id = find_key(key);
+
+    if ( id < STASH_MAX_KEYS )
+        return id;
+
+    id = key_count.load(memory_order_relaxed);
+
+    if ( id == STASH_MAX_KEYS )
+        FatalError("flow stash: can't intern %s, all %d keys are in use\n", key, STASH_MAX_KEYS);
+
+    key_names[id] = key;
+    key_count.store(id + 1, memory_order_release);
+    return id;
+}
+
 FlowStash::~FlowStash()
 {
     reset();
@@ -44,6 +83,116 @@ void FlowStash::reset()
         delete it->second;
     }
     container.clear();
+
+    for ( auto& item : items )
+        item.clear();
+}
+
+StashItem& FlowStash::get_item(unsigned key_id)
+{
+    assert(key_id < key_count.load(memory_order_relaxed));
+
+    // size the array for every key interned so far so it is allocated once
+    if ( key_id >= items.size() )
+        items.resize(key_count.load(memory_order_acquire));
+
+    return items[key_id];
+}
+
+bool FlowStash::get(unsigned key_id, int32_t& val) const
+{
+    return get(key_id, val, STASH_ITEM_TYPE_INT32);
+}
+
+bool FlowStash::get(unsigned key_id, uint32_t& val) const
+{
+    return get(key_id, val, STASH_ITEM_TYPE_UINT32);
+}
+
+bool FlowStash::get(unsigned key_id, string& val) const
+{
+    return get(key_id, val, STASH_ITEM_TYPE_STRING);
+}
+
+bool FlowStash::get(unsigned key_id, StashGenericObject* &val) const
+{
+    return get(key_id, val, STASH_ITEM_TYPE_GENERIC_OBJECT);
+}
+
+void FlowStash::store(unsigned key_id, int32_t val, unsigned pubid, unsigned evid)
+{
+    store(key_id, val, STASH_ITEM_TYPE_INT32, pubid, evid);
+}
+
+void FlowStash::store(unsigned key_id, uint32_t val, unsigned pubid, unsigned evid)
+{
+    store(key_id, val, STASH_ITEM_TYPE_UINT32, pubid, evid);
+}
+
+void FlowStash::store(unsigned key_id, const string& val, unsigned pubid, unsigned evid)
+{
+    store(key_id, val, STASH_ITEM_TYPE_STRING, pubid, evid);
+}
+
+void FlowStash::store(unsigned key_id, string* val, unsigned pubid, unsigned evid)
+{
+    store(key_id, val, STASH_ITEM_TYPE_STRING, pubid, evid);
+}
+
+void FlowStash::store(unsigned key_id, StashGenericObject* val, unsigned pubid, unsigned evid)
+{
+    store(key_id, val, STASH_ITEM_TYPE_GENERIC_OBJECT, pubid, evid);
+}
+
+void FlowStash::store(unsigned key_id, StashGenericObject* &val, StashItemType type, unsigned pubid, unsigned evid)
+{
+#ifdef NDEBUG
+    UNUSED(type);
+#endif
+    StashItem& item = get_item(key_id);
+
+    if ( item.get_type() != STASH_ITEM_TYPE_NONE )
+    {
+        StashGenericObject* stored_object;
+        assert(item.get_type() == type);
+        item.get_val(stored_object);
+        assert(stored_object->get_object_type() == val->get_object_type());
+    }
+    item.set(val);
+
+    if (DataBus::valid(pubid))
+    {
+        StashEvent e(&item);
+        DataBus::publish(pubid, evid, e);
+    }
+}
+
+template<typename T>
+bool FlowStash::get(unsigned key_id, T& val, StashItemType type) const
+{
+#ifdef NDEBUG
+    UNUSED(type);
+#endif
+    if ( key_id >= items.size() or items[key_id].get_type() == STASH_ITEM_TYPE_NONE )
+        return false;
+
+    assert(items[key_id].get_type() == type);
+    items[key_id].get_val(val);
+    return true;
+}
+
+template<typename T>
+void FlowStash::store(unsigned key_id, T& val, StashItemType type, unsigned pubid, unsigned evid)
+{
+#ifdef NDEBUG
+    UNUSED(type);
+#endif
+    StashItem& item = get_item(key_id);
+    assert(item.get_type() == type or item.get_type() == STASH_ITEM_TYPE_NONE);
+    item.set(val);
+
+    StashEvent e(&item);
+    DataBus::publish(pubid, evid, e);
 }
 
 bool FlowStash::get(const string& key, int32_t& val)
@@ -96,6 +245,14 @@ void FlowStash::store(const string& key, StashGenericObject* &val, StashItemType
 #ifdef NDEBUG
     UNUSED(type);
 #endif
+    unsigned key_id = find_key(key);
+
+    if ( key_id < STASH_MAX_KEYS )
+    {
+        store(key_id, val, type, pubid, evid);
+        return;
+    }
+
     auto item = new StashItem(val);
     auto it_and_status = container.emplace(key, item);
 
@@ -122,6 +279,11 @@ bool FlowStash::get(const string& key, T& val, StashItemType type)
 #ifdef NDEBUG
     UNUSED(type);
 #endif
+    unsigned key_id = find_key(key);
+
+    if ( key_id < STASH_MAX_KEYS )
+        return get(key_id, val, type);
+
     auto it = container.find(key);
 
     if (it != container.end())
@@ -139,6 +301,14 @@ void FlowStash::store(const string& key, T& val, StashItemType type, unsigned pu
 #ifdef NDEBUG
     UNUSED(type);
 #endif
+    unsigned key_id = find_key(key);
+
+    if ( key_id < STASH_MAX_KEYS )
+    {
+        store(key_id, val, type, pubid, evid);
+        return;
+    }
+
     auto item = new StashItem(val);
     auto it_and_status = container.emplace(key, item);
 
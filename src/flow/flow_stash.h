@@ -25,6 +25,7 @@
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "main/snort_config.h"
 #include "main/snort_types.h"
@@ -35,12 +36,34 @@
 namespace snort
 {
 
+// Keys may be interned with get_key_id() when a plugin is initialized.
+// Items with interned keys are kept in a flat array indexed by key id so
+// get and store don't hash the key or allocate once the flow has its
+// array; string keyed calls use the same items when the key is interned
+// and a map otherwise.
+
+#define STASH_MAX_KEYS 64
+
 class SO_PUBLIC FlowStash
 {
 public:
     ~FlowStash();
     void reset();
 
+    // returns the id of key, interning it if needed; not for the packet path
+    static unsigned get_key_id(const char* key);
+
+    bool get(unsigned key_id, int32_t& val) const;
+    bool get(unsigned key_id, uint32_t& val) const;
+    bool get(unsigned key_id, std::string& val) const;
+    bool get(unsigned key_id, StashGenericObject* &val) const;
+
+    void store(unsigned key_id, int32_t val, unsigned pubid = 0, unsigned evid = 0);
+    void store(unsigned key_id, uint32_t val, unsigned pubid = 0, unsigned evid = 0);
+    void store(unsigned key_id, const std::string& val, unsigned pubid = 0, unsigned evid = 0);
+    void store(unsigned key_id, std::string* val, unsigned pubid = 0, unsigned evid = 0);
+    void store(unsigned key_id, StashGenericObject* val, unsigned pubid = 0, unsigned evid = 0);
+
     bool get(const std::string& key, int32_t& val);
     bool get(const std::string& key, uint32_t& val);
     bool get(const std::string& key, std::string& val);
@@ -60,12 +83,21 @@ public:
 private:
     std::list<snort::SfIp> aux_ip_fifo;
     std::unordered_map<std::string, StashItem*> container;
+    std::vector<StashItem> items;
+
+    StashItem& get_item(unsigned key_id);
 
     template<typename T>
     bool get(const std::string& key, T& val, StashItemType type);
     template<typename T>
     void store(const std::string& key, T& val, StashItemType type, unsigned = 0, unsigned = 0);
     void store(const std::string& key, StashGenericObject* &val, StashItemType type, unsigned, unsigned);
+
+    template<typename T>
+    bool get(unsigned key_id, T& val, StashItemType type) const;
+    template<typename T>
+    void store(unsigned key_id, T& val, StashItemType type, unsigned, unsigned);
+    void store(unsigned key_id, StashGenericObject* &val, StashItemType type, unsigned, unsigned);
 };
 
 }
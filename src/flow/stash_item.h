@@ -52,7 +52,8 @@ enum StashItemType
     STASH_ITEM_TYPE_INT32,
     STASH_ITEM_TYPE_UINT32,
     STASH_ITEM_TYPE_STRING,
-    STASH_ITEM_TYPE_GENERIC_OBJECT
+    STASH_ITEM_TYPE_GENERIC_OBJECT,
+    STASH_ITEM_TYPE_NONE
 };
 
 union StashItemVal
@@ -66,6 +67,19 @@ union StashItemVal
 class StashItem
 {
 public:
+    StashItem()
+    { type = STASH_ITEM_TYPE_NONE; }
+
+    StashItem(StashItem&& rhs) noexcept
+    {
+        type = rhs.type;
+        val = rhs.val;
+        rhs.type = STASH_ITEM_TYPE_NONE;
+    }
+
+    StashItem(const StashItem&) = delete;
+    StashItem& operator=(const StashItem&) = delete;
+
     StashItem(int32_t int32_val)
     {
         type = STASH_ITEM_TYPE_INT32;
@@ -97,17 +111,58 @@ public:
     }
 
     ~StashItem()
+    { release(); }
+
+    // the set functions replace the value in place; a string value reuses
+    // the string already held so an update needn't allocate
+    void set(int32_t int32_val)
     {
-        switch (type)
+        release();
+        type = STASH_ITEM_TYPE_INT32;
+        val.int32_val = int32_val;
+    }
+
+    void set(uint32_t uint32_val)
+    {
+        release();
+        type = STASH_ITEM_TYPE_UINT32;
+        val.uint32_val = uint32_val;
+    }
+
+    void set(const std::string& str_val)
+    {
+        if ( type == STASH_ITEM_TYPE_STRING )
         {
-        case STASH_ITEM_TYPE_STRING:
-            delete val.str_val;
-            break;
-        case STASH_ITEM_TYPE_GENERIC_OBJECT:
-            delete val.generic_obj_val;
-        default:
-            break;
+            *val.str_val = str_val;
+            return;
         }
+        release();
+        type = STASH_ITEM_TYPE_STRING;
+        val.str_val = new std::string(str_val);
+    }
+
+    void set(std::string* str_val)
+    {
+        if ( type == STASH_ITEM_TYPE_STRING and val.str_val == str_val )
+            return;
+        release();
+        type = STASH_ITEM_TYPE_STRING;
+        val.str_val = str_val;
+    }
+
+    void set(StashGenericObject* obj)
+    {
+        if ( type == STASH_ITEM_TYPE_GENERIC_OBJECT and val.generic_obj_val == obj )
+            return;
+        release();
+        type = STASH_ITEM_TYPE_GENERIC_OBJECT;
+        val.generic_obj_val = obj;
+    }
+
+    void clear()
+    {
+        release();
+        type = STASH_ITEM_TYPE_NONE;
     }
 
     StashItemType get_type() const
@@ -126,6 +181,20 @@ public:
     { obj_val = val.generic_obj_val; }
 
 private:
+    void release()
+    {
+        switch (type)
+        {
+        case STASH_ITEM_TYPE_STRING:
+            delete val.str_val;
+            break;
+        case STASH_ITEM_TYPE_GENERIC_OBJECT:
+            delete val.generic_obj_val;
+        default:
+            break;
+        }
+    }
+
     StashItemType type;
     StashItemVal val;
 };
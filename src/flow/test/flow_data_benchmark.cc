@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "detection/context_switcher.h"
+#include "detection/detection_engine.h"
+#include "flow/flow.h"
+#include "flow/flow_stash.h"
+#include "flow/ha.h"
+#include "main/analyzer.h"
+#include "protocols/ip.h"
+
+#include "flow_stubs.h"
+
+using namespace snort;
+
+void Inspector::rem_ref() { }
+void Inspector::add_ref() { }
+
+bool HighAvailabilityManager::active() { return false; }
+FlowHAState::FlowHAState() = default;
+void FlowHAState::reset() { }
+
+FlowStash::~FlowStash() = default;
+void FlowStash::reset() { }
+
+void DetectionEngine::onload(Flow*) { }
+Packet* DetectionEngine::set_next_packet(const Packet*, Flow*) { return nullptr; }
+DetectionEngine::DetectionEngine() { context = nullptr; }
+DetectionEngine::~DetectionEngine() = default;
+IpsContext* DetectionEngine::get_context() { return nullptr; }
+
+ContextSwitcher* Analyzer::get_switcher() { return nullptr; }
+IpsContext* ContextSwitcher::get_context() const { return nullptr; }
+
+bool layer::set_outer_ip_api(const Packet* const, ip::IpApi&, int8_t&) { return false; }
+uint8_t ip::IpApi::ttl() const { return 0; }
+const Layer* layer::get_mpls_layer(const Packet* const) { return nullptr; }
+
+const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+
+// ids are spread like those of stream, http_inspect, ssl, appid, file, and
+// friends on a typical https flow; each lookup round asks for all of them
+static const unsigned ids[] = { 3, 7, 9, 12, 15, 18, 21, 24, 26, 28 };
+static const unsigned num_ids = sizeof(ids) / sizeof(ids[0]);
+
+// enough flows that their flow data doesn't stay in cache between visits,
+// as with live traffic
+#define NUM_FLOWS 16384
+
+// inspector flow data is typically a few hundred bytes
+class BenchFlowData : public FlowData
+{
+public:
+    BenchFlowData(unsigned id) : FlowData(id) { }
+    char state[256] = { };
+};
+
+static FlowData* list_lookup(const Flow* flow, unsigned id)
+{
+    for ( FlowData* fd = flow->flow_data; fd; fd = fd->next )
+    {
+        if ( fd->get_id() == id )
+            return fd;
+    }
+    return nullptr;
+}
+
+TEST_CASE("flow data lookup", "[flow_data]")
+{
+    std::vector<Flow*> flows;
+
+    for ( unsigned i = 0; i < NUM_FLOWS; ++i )
+        flows.emplace_back(new Flow);
+
+    // interleave allocations so one flow's data isn't contiguous
+    for ( unsigned i = 0; i < num_ids; ++i )
+        for ( auto* flow : flows )
+            flow->set_flow_data(new BenchFlowData(ids[i]));
+
+    unsigned next = 0;
+
+    BENCHMARK("list walk")
+    {
+        const Flow* flow = flows[next++ % NUM_FLOWS];
+        unsigned found = 0;
+
+        for ( unsigned i = 0; i < num_ids; ++i )
+            found += list_lookup(flow, ids[i]) != nullptr;
+
+        return found;
+    };
+
+    BENCHMARK("indexed slots")
+    {
+        const Flow* flow = flows[next++ % NUM_FLOWS];
+        unsigned found = 0;
+
+        for ( unsigned i = 0; i < num_ids; ++i )
+            found += flow->get_flow_data(ids[i]) != nullptr;
+
+        return found;
+    };
+
+    for ( auto* flow : flows )
+    {
+        for ( unsigned i = 0; i < num_ids; ++i )
+            flow->free_flow_data(ids[i]);
+
+        delete flow;
+    }
+}
+
+#endif
@@ -87,6 +87,9 @@ SnortConfig::SnortConfig(const SnortConfig* const, const char*)
 SnortConfig::~SnortConfig() = default;
 const SnortConfig* SnortConfig::get_conf() { return &snort_conf; }
 
+[[noreturn]] void FatalError(const char*, ...)
+{ abort(); }
+
 char* snort_strdup(const char* str)
 {
     assert(str);
@@ -330,6 +333,87 @@ TEST(stash_tests, store_ip)
     CHECK_FALSE(stash.store(ip3));
 }
 
+TEST(stash_tests, interned_items)
+{
+    unsigned int_key = FlowStash::get_key_id("interned_int");
+    unsigned str_key = FlowStash::get_key_id("interned_str");
+    unsigned obj_key = FlowStash::get_key_id("interned_obj");
+
+    CHECK_EQUAL(int_key, FlowStash::get_key_id("interned_int"));
+    CHECK(int_key != str_key);
+
+    FlowStash stash;
+    int32_t int32_val;
+    string str_val;
+    StashGenericObject* obj_val;
+
+    CHECK_FALSE(stash.get(int_key, int32_val));
+    CHECK_FALSE(stash.get(obj_key, obj_val));
+
+    stash.store(int_key, 10);
+    stash.store(int_key, 20);
+    CHECK(stash.get(int_key, int32_val));
+    CHECK_EQUAL(20, int32_val);
+
+    stash.store(str_key, "value_1");
+    stash.store(str_key, "value_2");
+    CHECK(stash.get(str_key, str_val));
+    STRCMP_EQUAL("value_2", str_val.c_str());
+
+    stash.store(str_key, new string("value_3"));
+    CHECK(stash.get(str_key, str_val));
+    STRCMP_EQUAL("value_3", str_val.c_str());
+
+    StashGenericObject* test_object = new StashGenericObject(111);
+    stash.store(obj_key, test_object);
+    stash.store(obj_key, test_object);
+    CHECK(stash.get(obj_key, obj_val));
+    POINTERS_EQUAL(test_object, obj_val);
+
+    StashGenericObject* new_test_object = new StashGenericObject(111);
+    stash.store(obj_key, new_test_object);
+    CHECK(stash.get(obj_key, obj_val));
+    POINTERS_EQUAL(new_test_object, obj_val);
+
+    stash.reset();
+    CHECK_FALSE(stash.get(int_key, int32_val));
+    CHECK_FALSE(stash.get(str_key, str_val));
+}
+
+TEST(stash_tests, interned_string_keys)
+{
+    unsigned key = FlowStash::get_key_id("interned_shared");
+    FlowStash stash;
+    int32_t val;
+
+    // string keyed calls find items stored by id and vice versa
+    stash.store(key, 10);
+    CHECK(stash.get("interned_shared", val));
+    CHECK_EQUAL(10, val);
+
+    stash.store("interned_shared", 20);
+    CHECK(stash.get(key, val));
+    CHECK_EQUAL(20, val);
+}
+
+TEST(stash_tests, interned_publish)
+{
+    DBConsumer<uint32_t> c("foo");
+    PubKey pub_key { };
+    DataBus::subscribe(pub_key, 0, &c);
+
+    unsigned key = FlowStash::get_key_id("interned_event");
+    FlowStash stash;
+
+    stash.store(key, 10u, 1, 1);
+    CHECK_EQUAL(10u, c.get_value());
+
+    stash.store(key, 20u, 1, 1);
+    CHECK_EQUAL(20u, c.get_value());
+
+    s_handler = nullptr;
+}
+
 int main(int argc, char** argv)
 {
     MemoryLeakWarningPlugin::turnOffNewDeleteOverloads();
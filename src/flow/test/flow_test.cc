@@ -103,6 +103,54 @@ TEST(nondefault_timeout, hard_expiration)
     delete flow;
 }
 
+TEST_GROUP(flow_data)
+{
+};
+
+TEST(flow_data, lookup)
+{
+    Flow* flow = new Flow;
+    const unsigned ids[] = { 1, 2, 3, 5, 8, 13, 21, 34, 55, 63, 64, 65, 100, 4, 6, 7 };
+    const unsigned num = sizeof(ids) / sizeof(ids[0]);
+
+    // more low ids than slots so some are only on the list
+    for ( auto id : ids )
+        flow->set_flow_data(new FlowData(id));
+
+    for ( auto id : ids )
+    {
+        FlowData* fd = flow->get_flow_data(id);
+        CHECK(fd != nullptr);
+        CHECK(fd->get_id() == id);
+    }
+    CHECK(flow->get_flow_data(9) == nullptr);
+    CHECK(flow->get_flow_data(99) == nullptr);
+
+    // replacing keeps one item per id
+    FlowData* fd = new FlowData(5);
+    flow->set_flow_data(fd);
+    CHECK(flow->get_flow_data(5) == fd);
+
+    // freed slots are reused and lookups stay correct
+    flow->free_flow_data(1);
+    flow->free_flow_data(64);
+    CHECK(flow->get_flow_data(1) == nullptr);
+    CHECK(flow->get_flow_data(64) == nullptr);
+
+    fd = new FlowData(9);
+    flow->set_flow_data(fd);
+    CHECK(flow->get_flow_data(9) == fd);
+
+    for ( unsigned i = 0; i < num; ++i )
+        flow->free_flow_data(ids[i]);
+
+    flow->free_flow_data(9);
+    CHECK(flow->flow_data == nullptr);
+    CHECK(flow->get_flow_data(2) == nullptr);
+
+    delete flow;
+}
+
 int main(int argc, char** argv)
 {
     int return_value = CommandLineTestRunner::RunAllTests(argc, argv);
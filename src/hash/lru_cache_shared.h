@@ -23,12 +23,20 @@
 
 // LruCacheShared -- Implements a thread-safe unordered map where the
 // least-recently-used (LRU) entries are removed once a fixed size is hit.
+//
+// In read-mostly mode, find() only takes a shared lock and marks the entry
+// as referenced rather than moving it to the front of the list. Eviction
+// then gives referenced entries a second chance (a clock approximation of
+// LRU), so concurrent lookups no longer serialize on the cache mutex.
+// Otherwise the cache is locked with a plain mutex, which is about half the
+// cost of an exclusive shared_mutex lock (see lru_cache_shared_benchmark).
 
 #include <atomic>
 #include <cassert>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <typeinfo>
 #include <unordered_map>
 #include <vector>
@@ -50,6 +58,60 @@ struct LruCacheSharedStats
     PegCount replaced = 0;      // found entry and replaced it
 };
 
+// Exclusive locking takes a std::mutex and, only in read-mostly mode, also
+// the shared_mutex that excludes shared lookups. The mode changes while both
+// are held so a holder of either one sees it stable.
+class LruCacheMutex
+{
+public:
+    void lock()
+    {
+        mutex.lock();
+        if ( read_mostly.load(std::memory_order_relaxed) )
+            readers.lock();
+    }
+
+    void unlock()
+    {
+        if ( read_mostly.load(std::memory_order_relaxed) )
+            readers.unlock();
+        mutex.unlock();
+    }
+
+    // Returns false without locking when not in read-mostly mode.
+    bool lock_shared_if_read_mostly()
+    {
+        if ( !read_mostly.load(std::memory_order_acquire) )
+            return false;
+
+        readers.lock_shared();
+
+        if ( read_mostly.load(std::memory_order_relaxed) )
+            return true;
+
+        readers.unlock_shared();
+        return false;
+    }
+
+    void unlock_shared()
+    { readers.unlock_shared(); }
+
+    void set_read_mostly(bool enable)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<std::shared_mutex> readers_lock(readers);
+        read_mostly.store(enable, std::memory_order_release);
+    }
+
+    bool is_read_mostly() const
+    { return read_mostly.load(std::memory_order_relaxed); }
+
+private:
+    std::mutex mutex;
+    std::shared_mutex readers;
+    std::atomic<bool> read_mostly { false };
+};
+
 enum class LcsInsertStatus {
     LCS_ITEM_PRESENT,
     LCS_ITEM_INSERTED,
@@ -100,13 +162,13 @@ public:
     //  Get current number of elements in the LruCache.
     size_t size()
     {
-        std::lock_guard<std::mutex> cache_lock(cache_mutex);
+        std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
         return list.size();
     }
 
     virtual size_t mem_size()
     {
-        std::lock_guard<std::mutex> cache_lock(cache_mutex);
+        std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
         return list.size() * mem_chunk;
     }
 
@@ -132,7 +194,23 @@ public:
     { return lru_cache_shared_peg_names; }
 
     const PegCount* get_counts() const
-    { return (const PegCount*)&stats; }
+    {
+        if ( !shared_find_hits and !shared_find_misses )
+            return (const PegCount*)&stats;
+
+        counts = stats;
+        counts.find_hits += shared_find_hits;
+        counts.find_misses += shared_find_misses;
+        return (const PegCount*)&counts;
+    }
+
+    // Lookups via find() use a shared lock and clock bits instead of list
+    // splicing. Writers are unaffected.
+    void set_read_mostly(bool enable)
+    { cache_mutex.set_read_mostly(enable); }
+
+    bool is_read_mostly() const
+    { return cache_mutex.is_read_mostly(); }
 
     void lock()
     { cache_mutex.lock(); }
@@ -141,7 +219,15 @@ public:
     { cache_mutex.unlock(); }
 
 protected:
-    using LruList = std::list<std::pair<Key, Data>>;
+    struct LruEntry : public std::pair<Key, Data>
+    {
+        LruEntry(const Key& key, const Data& data) : std::pair<Key, Data>(key, data) { }
+
+        // Set by read-mostly lookups, cleared when the entry gets its second chance
+        std::atomic<bool> referenced { false };
+    };
+
+    using LruList = std::list<LruEntry>;
     using LruListIter = typename LruList::iterator;
     using LruMap = std::unordered_map<Key, LruListIter, Hash, Eq>;
     using LruMapIter = typename LruMap::iterator;
@@ -153,13 +239,19 @@ protected:
 
     std::atomic<size_t> current_size;// Number of entries currently in the cache.
 
-    std::mutex cache_mutex;
+    LruCacheMutex cache_mutex;
     LruList list;  //  Contains key/data pairs. Maintains LRU order with
                    //  least recently used at the end.
     LruMap map;    //  Maps key to list iterator for fast lookup.
 
     struct LruCacheSharedStats stats;
 
+    // Hits and misses counted under the shared lock; added to a copy of
+    // stats by get_counts()
+    std::atomic<PegCount> shared_find_hits { 0 };
+    std::atomic<PegCount> shared_find_misses { 0 };
+    mutable struct LruCacheSharedStats counts;
+
     // The reason for these functions is to allow derived classes to do their
     // size book keeping differently (e.g. host_cache). This effectively
     // decouples the current_size variable from the actual size in memory,
@@ -177,6 +269,25 @@ protected:
         current_size--;
     }
 
+    // Caller must hold the shared lock, which this releases. Kept out of
+    // find() so the exclusive path stays as small as it was.
+    Data find_shared(const Key&);
+
+    // Caller must hold the exclusive lock and the list must not be empty.
+    // Returns the entry to evict; entries referenced since the last pass are
+    // moved to the front with their bit cleared instead.
+    LruListIter lru_victim()
+    {
+        LruListIter list_iter = --list.end();
+        while ( list_iter->referenced.load(std::memory_order_relaxed) )
+        {
+            list_iter->referenced.store(false, std::memory_order_relaxed);
+            list.splice(list.begin(), list, list_iter);
+            list_iter = --list.end();
+        }
+        return list_iter;
+    }
+
     // Caller must lock and unlock. Don't use this during snort reload for which
     // we need gradual pruning and size reduction via reload resource tuner.
     void prune(Purgatory& data)
@@ -185,7 +296,7 @@ protected:
         assert(data.empty());
         while (current_size > max_size && !list.empty())
         {
-            list_iter = --list.end();
+            list_iter = lru_victim();
             data.emplace_back(list_iter->second); // increase reference count
             decrease_size(list_iter->second.get());
             map.erase(list_iter->first);
@@ -206,7 +317,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::set_max_size(size_t newsiz
     // after the cache_lock does.
     Purgatory data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     //  Remove the oldest entries if we have to reduce cache size.
     max_size = newsize;
@@ -216,10 +327,33 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::set_max_size(size_t newsiz
     return true;
 }
 
+template<typename Key, typename Value, typename Hash, typename Eq, typename Purgatory>
+std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_shared(const Key& key)
+{
+    std::shared_lock<LruCacheMutex> cache_lock(cache_mutex, std::adopt_lock);
+
+    auto map_iter = map.find(key);
+    if (map_iter == map.end())
+    {
+        shared_find_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    //  Leave the list alone; eviction checks the referenced bit. Avoid
+    //  dirtying the cache line when the bit is already set.
+    if ( !map_iter->second->referenced.load(std::memory_order_relaxed) )
+        map_iter->second->referenced.store(true, std::memory_order_relaxed);
+    shared_find_hits.fetch_add(1, std::memory_order_relaxed);
+    return map_iter->second->second;
+}
+
 template<typename Key, typename Value, typename Hash, typename Eq, typename Purgatory>
 std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find(const Key& key)
 {
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    if ( cache_mutex.lock_shared_if_read_mostly() )
+        return find_shared(key);
+
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter == map.end())
@@ -252,7 +386,7 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_els
     // delete it before we got a chance to return it.
     Purgatory tmp_data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter != map.end())
@@ -269,7 +403,7 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_els
     Data data = Data(new Value);
 
     //  Add key/data pair to front of list.
-    list.emplace_front(std::make_pair(key, data));
+    list.emplace_front(key, data);
     increase_size(data.get());
 
     //  Add list iterator for the new entry to map.
@@ -286,7 +420,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_else_insert(const Key
 {
     Purgatory tmp_data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter != map.end())
@@ -309,7 +443,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_else_insert(const Key
     stats.adds++;
 
     //  Add key/data pair to front of list.
-    list.emplace_front(std::make_pair(key, data));
+    list.emplace_front(key, data);
     increase_size(data.get());
 
     //  Add list iterator for the new entry to map.
@@ -326,7 +460,7 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_els
 {
     Purgatory tmp_data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter != map.end())
@@ -352,7 +486,7 @@ std::shared_ptr<Value> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::find_els
     if (status) *status = LcsInsertStatus::LCS_ITEM_INSERTED;
 
     //  Add key/data pair to front of list.
-    list.emplace_front(std::make_pair(key, data));
+    list.emplace_front(key, data);
     increase_size(data.get());
 
     //  Add list iterator for the new entry to map.
@@ -367,7 +501,7 @@ template<typename Key, typename Value, typename Hash, typename Eq, typename Purg
 std::vector<std::pair<Key, std::shared_ptr<Value>>> LruCacheShared<Key, Value, Hash, Eq, Purgatory>::get_all_data()
 {
     std::vector<std::pair<Key, Data> > vec;
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     vec.reserve(list.size());
     std::copy(list.cbegin(), list.cend(), std::back_inserter(vec));
@@ -390,7 +524,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::remove(const Key& key)
     // data and cache_lock!
     Data data;
 
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter == map.end())
@@ -414,7 +548,7 @@ bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::remove(const Key& key)
 template<typename Key, typename Value, typename Hash, typename Eq, typename Purgatory>
 bool LruCacheShared<Key, Value, Hash, Eq, Purgatory>::remove(const Key& key, Data& data)
 {
-    std::lock_guard<std::mutex> cache_lock(cache_mutex);
+    std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
     auto map_iter = map.find(key);
     if (map_iter == map.end())
@@ -105,6 +105,17 @@ public:
         return success;
     }
 
+    void set_read_mostly(bool enable)
+    {
+        for ( const auto& segment : segments )
+            segment->set_read_mostly(enable);
+    }
+
+    bool is_read_mostly() const
+    {
+        return segments[0]->is_read_mostly();
+    }
+
     std::vector<std::pair<Key, std::shared_ptr<Value>>> get_all_data()
     {
         std::vector<std::pair<Key, std::shared_ptr<Value>>> all_data;
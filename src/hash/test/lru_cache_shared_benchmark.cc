@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// lru_cache_shared_benchmark.cc - lookups with and without read-mostly mode
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch/catch.hpp"
+
+#include "hash/lru_cache_shared.h"
+
+using LruCache = LruCacheShared<int, std::string, std::hash<int>>;
+
+// the cache is full so each insert prunes, like a host cache at its memcap
+#define NUM_KEYS 16384
+
+// per run; the writer adds one new key for every ten lookups by a reader
+#define NUM_READERS 4
+#define NUM_LOOKUPS 10000
+#define NUM_INSERTS (NUM_LOOKUPS / 10)
+
+static void fill(LruCache& cache)
+{
+    for ( int i = 0; i < NUM_KEYS; ++i )
+        cache[i];
+}
+
+// readers stride through the keys so that they don't follow each other
+static unsigned lookups(LruCache& cache, unsigned seed)
+{
+    unsigned key = seed, found = 0;
+
+    for ( unsigned i = 0; i < NUM_LOOKUPS; ++i )
+    {
+        key = (key + 7919) % NUM_KEYS;
+        found += cache.find((int)key) != nullptr;
+    }
+    return found;
+}
+
+// new keys evict old ones so some lookups miss, as with live traffic
+static void inserts(LruCache& cache, int& next)
+{
+    for ( unsigned i = 0; i < NUM_INSERTS; ++i )
+    {
+        auto data = std::make_shared<std::string>();
+        cache.find_else_insert(next, data);
+        next = NUM_KEYS + (next + 1) % NUM_KEYS;
+    }
+}
+
+static unsigned readers_and_writer(LruCache& cache, int& next)
+{
+    std::vector<std::thread> threads;
+    unsigned found[NUM_READERS] = { };
+
+    for ( unsigned r = 0; r < NUM_READERS; ++r )
+        threads.emplace_back([&cache, &found, r] { found[r] = lookups(cache, r * 1021); });
+
+    threads.emplace_back([&cache, &next] { inserts(cache, next); });
+
+    unsigned total = 0;
+
+    for ( unsigned r = 0; r < NUM_READERS; ++r )
+    {
+        threads[r].join();
+        total += found[r];
+    }
+    threads.back().join();
+
+    return total;
+}
+
+TEST_CASE("lru cache shared lookups", "[lru_cache_shared]")
+{
+    LruCache cache(NUM_KEYS);
+    fill(cache);
+
+    int next = NUM_KEYS;
+    unsigned seed = 0;
+
+    // the default mode splices under the exclusive lock
+    BENCHMARK("one thread, exclusive")
+    {
+        return lookups(cache, seed++);
+    };
+
+    BENCHMARK("4 readers + writer, exclusive")
+    {
+        return readers_and_writer(cache, next);
+    };
+
+    cache.set_read_mostly(true);
+
+    BENCHMARK("one thread, read mostly")
+    {
+        return lookups(cache, seed++);
+    };
+
+    BENCHMARK("4 readers + writer, read mostly")
+    {
+        return readers_and_writer(cache, next);
+    };
+}
+
+#endif
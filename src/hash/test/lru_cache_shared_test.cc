@@ -214,6 +214,50 @@ TEST(lru_cache_shared, stats_test)
     CHECK(!strcmp(pegs[7].name, "removes"));
 }
 
+//  Test read-mostly lookups and second chance eviction.
+TEST(lru_cache_shared, read_mostly_test)
+{
+    LruCacheShared<int, std::string, std::hash<int> > lru_cache(3);
+
+    for (int i = 0; i < 3; i++)
+        lru_cache[i]->assign(std::to_string(i));
+
+    lru_cache.set_read_mostly(true);
+    CHECK(lru_cache.is_read_mostly());
+
+    //  A read-mostly hit doesn't reorder the list
+    CHECK(lru_cache.find(0) != nullptr);
+    CHECK(lru_cache.find(5) == nullptr);
+
+    auto vec = lru_cache.get_all_data();
+    CHECK(vec[0].first == 2);
+    CHECK(vec[2].first == 0);
+
+    //  0 is the oldest but was referenced, so 1 is evicted instead
+    lru_cache[3]->assign("3");
+
+    vec = lru_cache.get_all_data();
+    CHECK(vec.size() == 3);
+    CHECK(vec[0].first == 0 and *vec[0].second == "0");
+    CHECK(vec[1].first == 3);
+    CHECK(vec[2].first == 2);
+
+    //  Unreferenced entries are evicted in list order
+    lru_cache[4];
+    lru_cache[6];
+
+    vec = lru_cache.get_all_data();
+    CHECK(vec.size() == 3);
+    CHECK(vec[0].first == 6);
+    CHECK(vec[1].first == 4);
+    CHECK(vec[2].first == 0);
+
+    const PegCount* stats = lru_cache.get_counts();
+    CHECK(stats[1] == 3);   //  alloc prunes
+    CHECK(stats[4] == 1);   //  find hits
+    CHECK(stats[5] == 7);   //  find misses
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
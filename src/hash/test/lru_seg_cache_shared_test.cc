@@ -83,6 +83,34 @@ TEST(segmented_lru_cache, get_counts_test)
     CHECK(nullptr != cache.get_counts());
 }
 
+// Test read-mostly lookups across segments
+TEST(segmented_lru_cache, read_mostly_test)
+{
+    SegmentedLruCache<int, std::string> cache(8);
+    CHECK(!cache.is_read_mostly());
+
+    for ( int i = 0; i < 4; i++ )
+        cache[i]->assign(std::to_string(i));
+
+    cache.set_read_mostly(true);
+    CHECK(cache.is_read_mostly());
+
+    for ( int i = 0; i < 4; i++ )
+        CHECK(*cache.find(i) == std::to_string(i));
+
+    CHECK(cache.find(4) == nullptr);
+
+    //  shared lookups are counted with the others
+    const PegCount* stats = cache.get_counts();
+    CHECK(stats[4] == 4);   //  find hits
+    CHECK(stats[5] == 5);   //  find misses
+
+    cache.set_read_mostly(false);
+    CHECK(!cache.is_read_mostly());
+    CHECK(cache.find(0) != nullptr);
+    CHECK(cache.get_counts()[4] == 5);
+}
+
 // Test size function
 TEST(segmented_lru_cache, size_test)
 {
@@ -52,6 +52,18 @@ bool HyperScratchAllocator::setup(SnortConfig* sc)
     return true;
 }
 
+void HyperScratchAllocator::localize(const SnortConfig* sc)
+{
+    hs_scratch_t** ss = (hs_scratch_t**)&sc->state[get_instance_id()][id];
+    hs_scratch_t* local = nullptr;
+
+    if ( *ss and hs_clone_scratch(*ss, &local) == HS_SUCCESS )
+    {
+        hs_free_scratch(*ss);
+        *ss = local;
+    }
+}
+
 void HyperScratchAllocator::cleanup(SnortConfig* sc)
 {
     for ( unsigned i = 0; i < sc->num_slots; ++i )
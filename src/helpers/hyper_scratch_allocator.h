@@ -46,6 +46,7 @@ public:
     void cleanup(SnortConfig*) override;
     void update(SnortConfig*) override
     { }
+    void localize(const SnortConfig*) override;
     bool allocate(hs_database_t*);
 
     hs_scratch_t* get()
@@ -34,6 +34,9 @@
 // memory.  the prototype should be freed in setup to avoid leaks and to
 // ensure the prototypes for different configs are not interdependent (eg
 // preventing a decrease in required scratch).
+//
+// localize() is called on the packet thread once it is placed on its NUMA
+// node so that scratch allocated by the main thread can be moved there.
 
 #include "main/snort_types.h"
 
@@ -50,6 +53,9 @@ public:
     virtual void cleanup(SnortConfig*) = 0;
     virtual void update(SnortConfig*) = 0;
 
+    virtual void localize(const SnortConfig*)
+    { }
+
     int get_id() { return id; }
 
 protected:
@@ -61,12 +67,14 @@ protected:
 typedef bool (* ScratchSetup)(SnortConfig*);
 typedef void (* ScratchCleanup)(SnortConfig*);
 typedef void (* ScratchUpdate)(SnortConfig*);
+typedef void (* ScratchLocalize)(const SnortConfig*);
 
 class SO_PUBLIC SimpleScratchAllocator : public ScratchAllocator
 {
 public:
-    SimpleScratchAllocator(ScratchSetup fs, ScratchCleanup fc, ScratchUpdate fu = nullptr)
-        : fsetup(fs), fcleanup(fc), fupdate(fu) { }
+    SimpleScratchAllocator(ScratchSetup fs, ScratchCleanup fc, ScratchUpdate fu = nullptr,
+        ScratchLocalize fl = nullptr)
+        : fsetup(fs), fcleanup(fc), fupdate(fu), flocalize(fl) { }
 
     bool setup(SnortConfig* sc) override
     { return fsetup(sc); }
@@ -80,10 +88,17 @@ public:
             fupdate(sc);
     }
 
+    void localize(const SnortConfig* sc) override
+    {
+        if (flocalize)
+            flocalize(sc);
+    }
+
 private:
     ScratchSetup fsetup;
     ScratchCleanup fcleanup;
     ScratchUpdate fupdate;
+    ScratchLocalize flocalize;
 };
 
 }
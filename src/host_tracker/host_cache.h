@@ -129,14 +129,14 @@ public:
             // Get a local temporary reference of data being deleted (as if a trash can).
             // To avoid race condition, data needs to self-destruct after the cache_lock does.
             Data data;
-            std::lock_guard<std::mutex> cache_lock(cache_mutex);
+            std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
 
             if ( !list.empty() )
             {
                 max_size.store(current_size);
                 if ( max_size > new_size )
                 {
-                    LruListIter list_iter = --list.end();
+                    LruListIter list_iter = LruBase::lru_victim();
                     data = list_iter->second; // increase reference count
                     decrease_size();
                     max_size -= mem_chunk; // in sync with current_size
@@ -205,7 +205,7 @@ private:
             // Do not change the order of data and cache_lock, as the data must
             // self destruct after cache_lock.
             Purgatory data;
-            std::lock_guard<std::mutex> cache_lock(cache_mutex);
+            std::lock_guard<LruCacheMutex> cache_lock(cache_mutex);
             LruBase::prune(data);
         }
     }
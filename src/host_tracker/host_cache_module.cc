@@ -369,6 +369,9 @@ static const Parameter host_cache_params[] =
     { "segments", Parameter::PT_INT, "1:32", "4",
       "number of host cache segments. It must be power of 2."},
 
+    { "read_mostly", Parameter::PT_BOOL, nullptr, "false",
+      "use shared-lock lookups with approximate (clock) LRU eviction" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -382,6 +385,10 @@ bool HostCacheModule::set(const char*, Value& v, SnortConfig*)
     {
         memcap = v.get_size();
     }
+    else if ( v.is("read_mostly") )
+    {
+        read_mostly = v.get_bool();
+    }
     else if ( v.is("segments"))
     {
         segments = v.get_uint8();
@@ -405,10 +412,12 @@ bool HostCacheModule::end(const char* fqn, int, SnortConfig* sc)
 {
     if ( memcap and !strcmp(fqn, HOST_CACHE_NAME) )
     {
+        // the live cache is only changed once the reload is committed
         if ( Snort::is_reloading() )
-            sc->register_reload_handler(new HostCacheReloadTuner(memcap));
+            sc->register_reload_handler(new HostCacheReloadTuner(memcap, read_mostly));
         else
         {
+            host_cache.set_read_mostly(read_mostly);
             host_cache.setup(segments, memcap);
             ControlConn::log_command("host_cache.delete_host",false);
         }
@@ -39,9 +39,14 @@
 class HostCacheReloadTuner : public snort::ReloadResourceTuner
 {
 public:
-    explicit HostCacheReloadTuner(size_t memcap) : memcap(memcap) { }
+    HostCacheReloadTuner(size_t memcap, bool read_mostly) :
+        memcap(memcap), read_mostly(read_mostly) { }
+
     bool tinit() override
-    { return host_cache.reload_resize(memcap); }
+    {
+        host_cache.set_read_mostly(read_mostly);
+        return host_cache.reload_resize(memcap);
+    }
 
     bool tune_idle_context() override
     { return host_cache.reload_prune(memcap, max_work_idle); }
@@ -51,6 +56,7 @@ public:
 
 private:
     size_t memcap;
+    bool read_mostly;
 };
 
 class HostCacheModule : public snort::Module
@@ -85,6 +91,7 @@ private:
     std::string dump_file;
     size_t memcap = 0;
     uint8_t segments = 1;
+    bool read_mostly = false;
 };
 extern THREAD_LOCAL const snort::Trace* host_cache_trace;
 
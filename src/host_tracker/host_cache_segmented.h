@@ -57,6 +57,7 @@ public:
     PegCount* get_counts();
 
     void set_segments(uint8_t segments) { segment_count = segments; }
+    void set_read_mostly(bool);
     void print_config();
     bool set_max_size(size_t max_size);
     bool reload_resize(size_t memcap_per_segment);
@@ -85,6 +86,7 @@ private:
     std::atomic<size_t> memcap_per_segment;
     struct LruCacheSharedStats counts;
     bool init_done = false;
+    std::atomic<bool> read_mostly { false };
 };
 
 
@@ -114,11 +116,21 @@ void HostCacheSegmented<Key, Value>::init()
     for (size_t i = 0; i < segment_count; ++i)
     {
         auto cache = new HostCacheIp(memcap_per_segment.load());
+        cache->set_read_mostly(read_mostly);
         seg_list.emplace_back((HostCacheIp*)cache);
     }
     init_done = true;
 }
 
+template<typename Key, typename Value>
+void HostCacheSegmented<Key, Value>::set_read_mostly(bool enable)
+{
+    read_mostly = enable;
+
+    for (auto cache : seg_list)
+        cache->set_read_mostly(enable);
+}
+
 template<typename Key, typename Value>
 void HostCacheSegmented<Key, Value>::term()
 {
@@ -154,6 +166,7 @@ void HostCacheSegmented<Key, Value>::print_config()
     {
         snort::LogLabel("host_cache");
         snort::LogMessage("    memcap: %zu bytes\n", get_max_size());
+        snort::LogMessage("    read_mostly: %s\n", read_mostly.load() ? "enabled" : "disabled");
     }
 }
 
@@ -355,7 +368,7 @@ bool HostCacheSegmented<Key, Value>::remove(const Key& key, typename LruCacheSha
 }
 
 /*
-Warning!!!: update_allocator and update_set_allocator don't copy data to old container
+Warning!!!: update_allocator doesn't copy data to old container
 but erase it for speed. Use with care!!!
 */
 template <template <typename, typename...> class Container, typename T, typename Alloc>
@@ -366,14 +379,6 @@ void update_allocator(Container<T, Alloc>& cont, CacheInterface* new_lru)
     cont = std::move(Container<T, Alloc>(new_allocator));
 }
 
-template <template <typename, typename, typename...> class Container, typename T, typename Comp, typename Alloc>
-void update_set_allocator(Container<T, Comp, Alloc>& cont, CacheInterface* new_lru)
-{
-    Alloc new_allocator;
-    new_allocator.set_cache(new_lru);
-    cont = std::move(Container<T, Comp, Alloc> (new_allocator));
-}
-
 
 typedef HostCacheSegmented<snort::SfIp, snort::HostTracker> HostCacheSegmentedIp;
 extern SO_PUBLIC HostCacheSegmentedIp host_cache;
@@ -374,6 +374,11 @@ bool HostTracker::add_service(Port port, IpProtocol proto, AppId appid, bool inf
     return true;
 }
 
+// clear() keeps the capacity, which stays charged to the host cache memcap
+template <typename Vector>
+static inline void release(Vector& v)
+{ Vector(v.get_allocator()).swap(v); }
+
 void HostTracker::clear_service(HostApplication& ha)
 {
     lock_guard<mutex> lck(host_tracker_lock);
@@ -383,8 +388,8 @@ void HostTracker::clear_service(HostApplication& ha)
     ha.inferred_appid = false;
     ha.hits = 0;
     ha.last_seen = 0;
-    ha.payloads.clear();
-    ha.info.clear();
+    release(ha.payloads);
+    release(ha.info);
     ha.banner_updated = false;
 }
 
@@ -783,15 +788,13 @@ void HostTracker::remove_inferred_services()
 bool HostTracker::add_tcp_fingerprint(uint32_t fpid)
 {
     lock_guard<mutex> lck(host_tracker_lock);
-    auto result = tcp_fpids.emplace(fpid);
-    return result.second;
+    return add_fpid_no_lock(tcp_fpids, fpid);
 }
 
 bool HostTracker::add_udp_fingerprint(uint32_t fpid)
 {
     lock_guard<mutex> lck(host_tracker_lock);
-    auto result = udp_fpids.emplace(fpid);
-    return result.second;
+    return add_fpid_no_lock(udp_fpids, fpid);
 }
 
 bool HostTracker::set_netbios_name(const char* nb_name)
@@ -809,15 +812,23 @@ bool HostTracker::set_netbios_name(const char* nb_name)
 bool HostTracker::add_smb_fingerprint(uint32_t fpid)
 {
     lock_guard<mutex> lck(host_tracker_lock);
-    auto result = smb_fpids.emplace(fpid);
-    return result.second;
+    return add_fpid_no_lock(smb_fpids, fpid);
 }
 
 bool HostTracker::add_cpe_os_hash(uint32_t hash)
 {
     lock_guard<mutex> lck(host_tracker_lock);
-    auto result = cpe_fpids.emplace(hash);
-    return result.second;
+    return add_fpid_no_lock(cpe_fpids, hash);
+}
+
+bool HostTracker::add_fpid_no_lock(FpidVector& fpids, uint32_t fpid)
+{
+    auto it = lower_bound(fpids.begin(), fpids.end(), fpid);
+    if ( it != fpids.end() and *it == fpid )
+        return false;
+
+    fpids.insert(it, fpid);
+    return true;
 }
 
 bool HostTracker::set_visibility(bool v)
@@ -858,12 +869,12 @@ bool HostTracker::set_visibility(bool v)
         }
         num_visible_clients = 0;
 
-        tcp_fpids.clear();
-        ua_fps.clear();
-        udp_fpids.clear();
-        smb_fpids.clear();
+        release(tcp_fpids);
+        release(ua_fps);
+        release(udp_fpids);
+        release(smb_fpids);
         netbios_name.clear();
-        cpe_fpids.clear();
+        release(cpe_fpids);
         host_type = HostType::HOST_TYPE_HOST;
     }
 
@@ -905,7 +916,7 @@ bool HostTracker::set_xproto_visibility(uint8_t proto, bool v)
     return false;
 }
 
-void HostTracker::set_payload_visibility_no_lock(PayloadVector& pv, bool v, size_t& num_vis)
+void HostTracker::set_payload_visibility_no_lock(PayloadVector& pv, bool v, uint32_t& num_vis)
 {
     std::for_each(pv.begin(), pv.end(),
         [v, &num_vis](Payload_t& p)
@@ -1130,10 +1141,10 @@ void HostTracker::update_cache_interface(uint8_t idx)
     update_allocator(services, cache_interface);
     update_allocator(clients, cache_interface);
     update_allocator(ua_fps, cache_interface);
-    update_set_allocator(tcp_fpids, cache_interface);
-    update_set_allocator(udp_fpids, cache_interface);
-    update_set_allocator(smb_fpids, cache_interface);
-    update_set_allocator(cpe_fpids, cache_interface);
+    update_allocator(tcp_fpids, cache_interface);
+    update_allocator(udp_fpids, cache_interface);
+    update_allocator(smb_fpids, cache_interface);
+    update_allocator(cpe_fpids, cache_interface);
 }
 
 HostApplicationInfo::HostApplicationInfo(const char *ver, const char *ven)
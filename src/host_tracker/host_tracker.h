@@ -93,10 +93,10 @@ struct HostApplication
 {
     HostApplication() = default;
     HostApplication(Port pt, IpProtocol pr, AppId ap, bool in, uint32_t ht = 0, uint32_t ls = 0,
-        bool banner = false) : port(pt), proto(pr), appid(ap), inferred_appid(in), hits(ht),
+        bool banner = false) : port(pt), proto(pr), inferred_appid(in), appid(ap), hits(ht),
         last_seen(ls), banner_updated(banner) { }
-    HostApplication(const HostApplication& ha): port(ha.port), proto(ha.proto), appid(ha.appid),
-        inferred_appid(ha.inferred_appid), hits(ha.hits), last_seen(ha.last_seen),
+    HostApplication(const HostApplication& ha): port(ha.port), proto(ha.proto),
+        inferred_appid(ha.inferred_appid), appid(ha.appid), hits(ha.hits), last_seen(ha.last_seen),
         num_visible_payloads(ha.num_visible_payloads), info(ha.info), payloads(ha.payloads),
         visibility(ha.visibility) { }
 
@@ -118,16 +118,17 @@ struct HostApplication
         return *this;
     }
 
+    // Members are ordered to avoid padding; there is one of these per service per host
     Port port = 0;
     IpProtocol proto = IpProtocol::PROTO_NOT_SET;
-    AppId appid = APP_ID_NONE;
     bool inferred_appid = false;
+    AppId appid = APP_ID_NONE;
     uint32_t hits = 0;
     uint32_t last_seen = 0;
     char user[INFO_SIZE] = { '\0' };
     uint8_t user_login = 0;
     bool banner_updated = false;
-    size_t num_visible_payloads = 0;
+    uint32_t num_visible_payloads = 0;
 
     std::vector<HostApplicationInfo, HostAppInfoAllocator> info;
     PayloadVector payloads;
@@ -150,7 +151,7 @@ struct HostClient
     char version[INFO_SIZE] = { '\0' };
     AppId service = APP_ID_NONE;
     PayloadVector payloads;
-    size_t num_visible_payloads = 0;
+    uint32_t num_visible_payloads = 0;
 
     bool operator==(const HostClient& c) const
     {
@@ -207,6 +208,11 @@ typedef HostCacheAllocIp<HostApplication> HostAppAllocator;
 typedef HostCacheAllocIp<HostClient> HostClientAllocator;
 typedef HostCacheAllocIp<DeviceFingerprint> HostDeviceFpAllocator;
 
+// Fingerprint ids are kept in a sorted vector rather than a std::set. A host
+// only has a handful of them, and a set costs a 40 byte tree node per id on
+// top of a larger empty footprint, all charged to the host cache memcap.
+typedef std::vector<uint32_t, HostCacheAllocIp<uint32_t>> FpidVector;
+
 class SO_PUBLIC HostTracker
 {
 public:
@@ -456,10 +462,10 @@ private:
     std::vector<XProto_t, HostCacheAllocIp<XProto_t>> xport_protos;
     std::vector<HostApplication, HostAppAllocator> services;
     std::vector<HostClient, HostClientAllocator> clients;
-    std::set<uint32_t, std::less<uint32_t>, HostCacheAllocIp<uint32_t>> tcp_fpids;
-    std::set<uint32_t, std::less<uint32_t>, HostCacheAllocIp<uint32_t>> udp_fpids;
-    std::set<uint32_t, std::less<uint32_t>, HostCacheAllocIp<uint32_t>> smb_fpids;
-    std::set<uint32_t, std::less<uint32_t>, HostCacheAllocIp<uint32_t>> cpe_fpids;
+    FpidVector tcp_fpids;
+    FpidVector udp_fpids;
+    FpidVector smb_fpids;
+    FpidVector cpe_fpids;
     std::vector<DeviceFingerprint, HostDeviceFpAllocator> ua_fps;
     std::string netbios_name;
 
@@ -493,7 +499,10 @@ private:
         bool& is_new, AppId, uint16_t max_services = 0);
 
     // Sets all payloads visible or invisible
-    void set_payload_visibility_no_lock(PayloadVector& pv, bool v, size_t& num_vis);
+    void set_payload_visibility_no_lock(PayloadVector& pv, bool v, uint32_t& num_vis);
+
+    // Returns true if the id was not already present
+    static bool add_fpid_no_lock(FpidVector&, uint32_t);
 
     // Hide / delete the constructor from the outside world. We don't want to
     // have zombie host trackers, i.e. host tracker objects that live outside
@@ -369,6 +369,48 @@ TEST(host_tracker, stringify)
         "\n    port: 443, proto: 6, appid: 1122");
 }
 
+TEST(host_tracker, fingerprints)
+{
+    HostTracker ht;
+
+    CHECK_TRUE(ht.add_tcp_fingerprint(30));
+    CHECK_TRUE(ht.add_tcp_fingerprint(10));
+    CHECK_TRUE(ht.add_tcp_fingerprint(20));
+    CHECK_FALSE(ht.add_tcp_fingerprint(10));
+    CHECK_TRUE(ht.add_udp_fingerprint(5));
+    CHECK_FALSE(ht.add_udp_fingerprint(5));
+    CHECK_TRUE(ht.add_smb_fingerprint(7));
+    CHECK_TRUE(ht.add_cpe_os_hash(7));
+
+    string host_tracker_string;
+    ht.stringify(host_tracker_string);
+
+    // ids are unique and listed in ascending order
+    CHECK(host_tracker_string.find("\ntcp fingerprint: 10, 20, 30"
+        "\nudp fingerprint: 5"
+        "\nsmb fingerprint: 7") != string::npos);
+}
+
+TEST(host_tracker, hidden_host_releases_fingerprints)
+{
+    HostTracker ht;
+    size_t empty = default_host_cache.mem_size();
+
+    for ( uint32_t i = 0; i < 16; ++i )
+    {
+        ht.add_tcp_fingerprint(i);
+        ht.add_udp_fingerprint(i);
+        ht.add_smb_fingerprint(i);
+        ht.add_cpe_os_hash(i);
+        ht.add_ua_fingerprint(i, 1, false, "device", 16);
+    }
+    CHECK(default_host_cache.mem_size() > empty);
+
+    // nothing stays charged to the memcap while the host is hidden
+    ht.set_visibility(false);
+    CHECK_EQUAL(empty, default_host_cache.mem_size());
+}
+
 TEST(host_tracker, rediscover_host)
 {
     test_time = 1562198400; // this time will be updated and should not be seen in stringify
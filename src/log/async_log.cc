@@ -0,0 +1,634 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "async_log.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "main/snort_config.h"
+#include "utils/util.h"
+
+#include "messages.h"
+
+using namespace snort;
+
+const PegInfo async_log_pegs[] =
+{
+    { CountType::SUM, "async_records", "log records queued for the writer threads" },
+    { CountType::SUM, "async_bytes", "log bytes queued for the writer threads" },
+    { CountType::SUM, "async_blocked", "log records that waited for room in a full ring" },
+    { CountType::SUM, "async_dropped_oldest", "queued log events dropped to make room" },
+    { CountType::SUM, "async_dropped_new", "log events dropped because the ring was full" },
+    { CountType::END, nullptr, nullptr }
+};
+
+THREAD_LOCAL AsyncLogStats async_log_stats;
+
+//--------------------------------------------------------------------------
+// ring
+//--------------------------------------------------------------------------
+
+#define REC_DATA   0
+#define REC_REOPEN 1
+#define REC_PAD    2
+#define REC_MORE   3   // continues the event of the data record before it
+
+#define MAX_IOV 64
+
+struct RecHdr
+{
+    uint32_t len;   // payload bytes
+    uint32_t type;
+};
+
+// records are 8 byte aligned so a header never wraps
+static inline size_t rec_size(size_t len)
+{ return (sizeof(RecHdr) + len + 7) & ~(size_t)7; }
+
+class AsyncLogWriter;
+
+struct AsyncLog
+{
+    uint8_t* ring;
+    size_t capacity;
+    size_t mask;
+    AsyncLogOverflow overflow;
+    AsyncLogWriter* writer;
+
+    // head is only moved by the producer.  records are claimed by moving
+    // tail, which the writer does to copy them out and the producer does to
+    // drop the oldest.  the producer only reuses space below released, which
+    // moves once nothing below it is being copied.
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint64_t> released;
+
+    std::atomic<bool> closing;
+    std::atomic<bool> closed;
+
+    // producer state; the rest of a dropped event is dropped too
+    bool in_event;
+    bool dropping;
+
+    // writer state
+    int fd;
+    bool failed;
+    std::string path;
+    std::vector<uint8_t> batch;
+};
+
+static void ring_copy(const AsyncLog* log, uint64_t from, size_t len, uint8_t* to)
+{
+    size_t pos = from & log->mask;
+    size_t n = std::min(len, log->capacity - pos);
+
+    memcpy(to, log->ring + pos, n);
+    memcpy(to + n, log->ring, len - n);
+}
+
+static void release(AsyncLog* log, uint64_t to)
+{
+    uint64_t r = log->released.load(std::memory_order_relaxed);
+
+    while ( r < to and !log->released.compare_exchange_weak(r, to, std::memory_order_release) )
+        ;
+}
+
+// payloads larger than this are split so a record and the pad before it
+// always fit the ring
+static inline size_t max_payload(const AsyncLog* log)
+{ return log->capacity / 2 - sizeof(RecHdr); }
+
+// called by the producer with a full ring; returns false if the oldest
+// record must not be dropped.  the oldest event is claimed like the writer
+// claims records so the two never hold the same bytes.
+static bool drop_oldest(AsyncLog* log, uint64_t r)
+{
+    uint64_t t = log->tail.load(std::memory_order_acquire);
+
+    // wait for the writer to finish copying what it claimed
+    if ( t != r )
+        return true;
+
+    RecHdr hdr;
+    memcpy(&hdr, log->ring + (t & log->mask), sizeof(hdr));
+
+    // the writer already took the start of this event
+    if ( hdr.type == REC_REOPEN or hdr.type == REC_MORE )
+        return false;
+
+    uint64_t next = t + rec_size(hdr.len);
+
+    // only the producer moves head and it is between events here
+    if ( hdr.type == REC_DATA )
+    {
+        uint64_t h = log->head.load(std::memory_order_relaxed);
+
+        while ( next < h )
+        {
+            RecHdr more;
+            memcpy(&more, log->ring + (next & log->mask), sizeof(more));
+
+            if ( more.type != REC_MORE and more.type != REC_PAD )
+                break;
+
+            next += rec_size(more.len);
+        }
+    }
+
+    // fails if the writer claimed the record meanwhile
+    if ( !log->tail.compare_exchange_strong(t, next, std::memory_order_acq_rel) )
+        return true;
+
+    release(log, next);
+
+    if ( hdr.type == REC_DATA )
+        ++async_log_stats.dropped_oldest;
+
+    return true;
+}
+
+static void notify(AsyncLog*);
+
+// queue a record of at most max_payload(); only the first record of an
+// event is subject to the overflow policy, everything else waits for room
+static bool put_rec(AsyncLog* log, uint32_t type, const void* data, size_t len)
+{
+    size_t need = rec_size(len);
+    assert(need <= log->capacity / 2);
+
+    uint64_t h = log->head.load(std::memory_order_relaxed);
+    size_t pos = h & log->mask;
+    size_t pad = (log->capacity - pos < need) ? log->capacity - pos : 0;
+    bool blocked = false;
+
+    while ( true )
+    {
+        uint64_t r = log->released.load(std::memory_order_acquire);
+
+        if ( h + pad + need - r <= log->capacity )
+            break;
+
+        if ( type == REC_DATA and log->overflow == ASYNC_LOG_DROP_NEW )
+            return false;
+
+        if ( type == REC_DATA and log->overflow == ASYNC_LOG_DROP_OLDEST and drop_oldest(log, r) )
+            continue;
+
+        if ( !blocked )
+        {
+            ++async_log_stats.blocked;
+            blocked = true;
+        }
+        std::this_thread::yield();
+    }
+
+    if ( pad )
+    {
+        RecHdr hdr = { (uint32_t)(pad - sizeof(RecHdr)), REC_PAD };
+        memcpy(log->ring + pos, &hdr, sizeof(hdr));
+        pos = 0;
+    }
+
+    RecHdr hdr = { (uint32_t)len, type };
+    memcpy(log->ring + pos, &hdr, sizeof(hdr));
+    memcpy(log->ring + pos + sizeof(hdr), data, len);
+
+    log->head.store(h + pad + need, std::memory_order_release);
+    notify(log);
+
+    return true;
+}
+
+// more is set if the data doesn't end the event.  big data is split into
+// records that continue the event so it is queued or dropped as a whole.
+static bool put_data(AsyncLog* log, const void* data, size_t len, bool more)
+{
+    bool cont = log->in_event;
+    log->in_event = more;
+
+    if ( cont and log->dropping )
+    {
+        log->dropping = more;
+        return false;
+    }
+
+    const uint8_t* p = (const uint8_t*)data;
+    size_t n = std::min(len, max_payload(log));
+
+    if ( !put_rec(log, cont ? REC_MORE : REC_DATA, p, n) )
+    {
+        ++async_log_stats.dropped_new;
+        log->dropping = more;
+        return false;
+    }
+
+    ++async_log_stats.records;
+    async_log_stats.bytes += len;
+
+    while ( len > n )
+    {
+        p += n;
+        len -= n;
+        n = std::min(len, max_payload(log));
+        put_rec(log, REC_MORE, p, n);
+    }
+    return true;
+}
+
+// claim everything queued and copy it out
+static bool take(AsyncLog* log, const uint8_t*& data, size_t& len)
+{
+    uint64_t t = log->tail.load(std::memory_order_acquire);
+    uint64_t h;
+
+    do
+    {
+        h = log->head.load(std::memory_order_acquire);
+
+        if ( t == h )
+            return false;
+    }
+    while ( !log->tail.compare_exchange_weak(t, h, std::memory_order_acq_rel) );
+
+    ring_copy(log, t, h - t, log->batch.data());
+    release(log, h);
+
+    data = log->batch.data();
+    len = h - t;
+    return true;
+}
+
+//--------------------------------------------------------------------------
+// writer
+//--------------------------------------------------------------------------
+
+static int open_file(const char* path, bool truncate)
+{
+    int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
+    return open(path, flags, 0666);
+}
+
+static void write_iov(AsyncLog* log, struct iovec* iov, int n)
+{
+    while ( n and log->fd >= 0 )
+    {
+        ssize_t ret = writev(log->fd, iov, n);
+
+        if ( ret < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+
+            if ( !log->failed )
+                ErrorMessage("async log can't write %s: %s\n", log->path.c_str(), get_error(errno));
+
+            log->failed = true;
+            return;
+        }
+
+        // skip what was written and retry the rest
+        size_t done = ret;
+
+        while ( n and done >= iov->iov_len )
+        {
+            done -= iov->iov_len;
+            ++iov;
+            --n;
+        }
+        if ( n )
+        {
+            iov->iov_base = (uint8_t*)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+}
+
+static void reopen(AsyncLog* log, const uint8_t* data)
+{
+    bool truncate = data[0];
+    const char* path = (const char*)data + 1;
+    const char* rolled = path + strlen(path) + 1;
+
+    if ( log->fd >= 0 )
+        close(log->fd);
+
+    if ( *rolled and rename(log->path.c_str(), rolled) )
+        ErrorMessage("async log can't rename %s to %s: %s\n",
+            log->path.c_str(), rolled, get_error(errno));
+
+    log->path = path;
+    log->fd = open_file(path, truncate);
+    log->failed = false;
+
+    if ( log->fd < 0 )
+        ErrorMessage("async log can't open %s: %s\n", path, get_error(errno));
+}
+
+static bool drain(AsyncLog* log)
+{
+    const uint8_t* data;
+    size_t len;
+
+    if ( !take(log, data, len) )
+        return false;
+
+    struct iovec iov[MAX_IOV];
+    int n = 0;
+    size_t off = 0;
+
+    while ( off < len )
+    {
+        RecHdr hdr;
+        memcpy(&hdr, data + off, sizeof(hdr));
+        const uint8_t* payload = data + off + sizeof(hdr);
+        off += rec_size(hdr.len);
+
+        if ( hdr.type == REC_PAD )
+            continue;
+
+        if ( hdr.type == REC_REOPEN or n == MAX_IOV )
+        {
+            write_iov(log, iov, n);
+            n = 0;
+        }
+
+        if ( hdr.type == REC_REOPEN )
+            reopen(log, payload);
+
+        else
+        {
+            iov[n].iov_base = (void*)payload;
+            iov[n++].iov_len = hdr.len;
+        }
+    }
+    write_iov(log, iov, n);
+    return true;
+}
+
+class AsyncLogWriter
+{
+public:
+    AsyncLogWriter()
+    { thread = new std::thread(&AsyncLogWriter::run, this); }
+
+    ~AsyncLogWriter()
+    {
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            stop = true;
+        }
+        wake_cond.notify_one();
+        thread->join();
+        delete thread;
+    }
+
+    void add(AsyncLog* log)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        logs.emplace_back(log);
+    }
+
+    // called after queuing something; only takes the lock if the writer sleeps
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if ( sleeping.load(std::memory_order_relaxed) )
+        {
+            {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                woken = true;
+            }
+            wake_cond.notify_one();
+        }
+    }
+
+    void close(AsyncLog* log)
+    {
+        log->closing.store(true, std::memory_order_release);
+        notify();
+
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        closed_cond.wait(guard, [log]() { return log->closed.load(std::memory_order_acquire); });
+    }
+
+private:
+    bool drain_all(bool& idle);
+    void run();
+
+    std::mutex lock;
+    std::vector<AsyncLog*> logs;
+
+    // sleep_lock is taken after lock when both are needed
+    std::mutex sleep_lock;
+    std::condition_variable wake_cond;
+    std::condition_variable closed_cond;
+    std::atomic<bool> sleeping { false };
+    bool woken = false;
+    bool stop = false;
+    std::thread* thread;
+};
+
+// returns true if anything was written; idle is set when there are no logs
+bool AsyncLogWriter::drain_all(bool& idle)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    bool busy = false;
+
+    for ( auto it = logs.begin(); it != logs.end(); )
+    {
+        AsyncLog* log = *it;
+
+        // check before draining so nothing queued before the close is missed
+        bool closing = log->closing.load(std::memory_order_acquire);
+
+        if ( drain(log) )
+            busy = true;
+
+        else if ( closing )
+        {
+            if ( log->fd >= 0 )
+                ::close(log->fd);
+
+            it = logs.erase(it);
+            {
+                std::lock_guard<std::mutex> sleep_guard(sleep_lock);
+                log->closed.store(true, std::memory_order_release);
+            }
+            closed_cond.notify_all();
+            continue;
+        }
+        ++it;
+    }
+    idle = logs.empty();
+    return busy;
+}
+
+void AsyncLogWriter::run()
+{
+    while ( true )
+    {
+        bool idle;
+
+        if ( drain_all(idle) )
+            continue;
+
+        // announce the sleep before looking again; anything queued after
+        // that look sees the announcement and wakes this thread
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if ( drain_all(idle) )
+        {
+            sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleep_lock);
+
+        if ( stop and idle )
+            break;
+
+        wake_cond.wait(guard, [this]() { return woken or stop; });
+        woken = false;
+        sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+static void notify(AsyncLog* log)
+{ log->writer->notify(); }
+
+// the writers are started with the first log and stopped with the last
+static std::mutex writers_lock;
+static std::vector<AsyncLogWriter*> writers;
+static unsigned open_logs = 0;
+static unsigned next_writer = 0;
+
+namespace snort
+{
+AsyncLog* AsyncLog_Open(const char* path, bool truncate, size_t* size)
+{
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    if ( !sc or !sc->async_log_writers )
+        return nullptr;
+
+    int fd = open_file(path, truncate);
+
+    if ( fd < 0 )
+        return nullptr;
+
+    if ( size )
+    {
+        struct stat st;
+        *size = fstat(fd, &st) ? 0 : st.st_size;
+    }
+
+    AsyncLog* log = new AsyncLog;
+    log->capacity = 1;
+
+    while ( log->capacity < sc->async_log_ring_size )
+        log->capacity <<= 1;
+
+    log->mask = log->capacity - 1;
+    log->ring = new uint8_t[log->capacity];
+    log->overflow = (AsyncLogOverflow)sc->async_log_overflow;
+    log->head = 0;
+    log->tail = 0;
+    log->released = 0;
+    log->closing = false;
+    log->closed = false;
+    log->in_event = false;
+    log->dropping = false;
+    log->fd = fd;
+    log->failed = false;
+    log->path = path;
+    log->batch.resize(log->capacity);
+
+    std::lock_guard<std::mutex> guard(writers_lock);
+
+    if ( !open_logs++ )
+    {
+        for ( unsigned i = 0; i < sc->async_log_writers; ++i )
+            writers.emplace_back(new AsyncLogWriter);
+    }
+    log->writer = writers[next_writer++ % writers.size()];
+    log->writer->add(log);
+
+    return log;
+}
+
+bool AsyncLog_Write(AsyncLog* log, const void* data, size_t len, bool more)
+{ return put_data(log, data, len, more); }
+
+bool AsyncLog_Reopen(AsyncLog* log, const char* path, bool truncate, const char* rolled)
+{
+    std::string rec(1, truncate ? '\1' : '\0');
+    rec += path;
+    rec += '\0';
+
+    if ( rolled )
+        rec += rolled;
+
+    rec += '\0';
+
+    // paths are bounded so this fits the minimum ring
+    return put_rec(log, REC_REOPEN, rec.data(), rec.size());
+}
+
+void AsyncLog_Close(AsyncLog* log)
+{
+    if ( !log )
+        return;
+
+    log->writer->close(log);
+
+    delete[] log->ring;
+    delete log;
+
+    std::lock_guard<std::mutex> guard(writers_lock);
+
+    if ( !--open_logs )
+    {
+        for ( auto* w : writers )
+            delete w;
+
+        writers.clear();
+        next_writer = 0;
+    }
+}
+}
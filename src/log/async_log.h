@@ -0,0 +1,81 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+// AsyncLog moves log file writes off the packet threads.  Each open log
+// has a single producer ring of length prefixed records which one of the
+// writer threads drains with writev().  Reopening and rolling the file are
+// queued as records too so they are done in order with the data around
+// them.  Those records are never dropped; when the ring is full they wait
+// for room whatever the overflow policy.
+//
+// The overflow policy drops whole events.  An event is one write or, when
+// a logger flushes part way through, the writes up to one without more.
+// Once the start of an event is queued the rest waits for room, and data
+// too big for one record is split the same way, so the file never gets
+// part of an event.
+
+#include <cstddef>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+struct AsyncLog;
+
+enum AsyncLogOverflow
+{
+    ASYNC_LOG_BLOCK,
+    ASYNC_LOG_DROP_OLDEST,
+    ASYNC_LOG_DROP_NEW
+};
+
+struct AsyncLogStats
+{
+    PegCount records;
+    PegCount bytes;
+    PegCount blocked;
+    PegCount dropped_oldest;
+    PegCount dropped_new;
+};
+
+extern const PegInfo async_log_pegs[];
+extern THREAD_LOCAL AsyncLogStats async_log_stats;
+
+namespace snort
+{
+// returns nullptr if async logging is disabled or path can't be opened;
+// size is set to the current size of the file
+SO_PUBLIC AsyncLog* AsyncLog_Open(const char* path, bool truncate, size_t* size = nullptr);
+
+// more is set if the event continues with the next write; returns false
+// if the event was dropped
+SO_PUBLIC bool AsyncLog_Write(AsyncLog*, const void*, size_t, bool more = false);
+
+// close the current file, renaming it to rolled if given, and open path
+SO_PUBLIC bool AsyncLog_Reopen(AsyncLog*, const char* path, bool truncate,
+    const char* rolled = nullptr);
+
+// waits until everything queued is written and closes the file
+SO_PUBLIC void AsyncLog_Close(AsyncLog*);
+}
+
+#endif
+
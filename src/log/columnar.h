@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+// Columnar alert log shared header.
+//
+// A file is a ColumnarFileHeader followed by blocks.  Each block is a
+// ColumnarBlockHeader followed by comp_size bytes of deflated body.  The
+// body holds the block's schema followed by one section per column:
+//
+//   schema:  uint32 columns, then per column uint8 type, uint8 name length
+//            and the name
+//   section: uint32 section length, then for COL_DICT a uint32 entry count
+//            and per entry a uint32 length and the string, followed by the
+//            rows' values, each COL_DICT value being a dictionary index
+//
+// Dictionary index 0 is always the empty string.  IP addresses are 16
+// bytes with IPv4 mapped as ::ffff:a.b.c.d.  Values are written in host
+// byte order; byte_order tells readers which one that was.
+
+#include <cstdint>
+
+#define COLUMNAR_MAGIC "SNCOLS01"
+#define COLUMNAR_VERSION 1
+#define COLUMNAR_BYTE_ORDER 0x01020304
+#define COLUMNAR_BLOCK_MAGIC 0x4b4c4243  // "CBLK" little endian
+
+enum ColumnarType : uint8_t
+{
+    COL_U8,
+    COL_U16,
+    COL_U32,
+    COL_U64,
+    COL_IP,
+    COL_DICT,
+    COL_MAX
+};
+
+struct ColumnarFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+};
+
+struct ColumnarBlockHeader
+{
+    uint32_t magic;
+    uint32_t rows;
+    uint32_t raw_size;      // inflated body size
+    uint32_t comp_size;     // deflated body size
+    uint32_t crc;           // crc32 of the inflated body
+    uint32_t reserved;
+};
+
+inline unsigned columnar_width(uint8_t type)
+{
+    switch ( type )
+    {
+    case COL_U8: return 1;
+    case COL_U16: return 2;
+    case COL_U32: return 4;
+    case COL_U64: return 8;
+    case COL_IP: return 16;
+    case COL_DICT: return 4;
+    default: return 0;
+    }
+}
+
+#endif
+
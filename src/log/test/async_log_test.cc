@@ -0,0 +1,756 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// async_log_test.cc - the async log ring, its overflow policies and writers
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "log/async_log.cc"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static SnortConfig snort_conf;
+
+SnortConfig::SnortConfig(const SnortConfig* const, const char*) { }
+SnortConfig::~SnortConfig() = default;
+const SnortConfig* SnortConfig::get_conf() { return &snort_conf; }
+
+namespace snort
+{
+void ErrorMessage(const char*, ...) { }
+const char* get_error(int) { return ""; }
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+struct Rec
+{
+    uint32_t type;
+    std::string data;
+};
+
+// the ring tests drive put and take directly; the writer is only there to
+// be notified and never drains these logs
+static AsyncLogWriter* idle_writer = nullptr;
+
+static AsyncLog* make_log(size_t capacity, AsyncLogOverflow overflow)
+{
+    AsyncLog* log = new AsyncLog;
+    log->capacity = capacity;
+    log->mask = capacity - 1;
+    log->ring = new uint8_t[capacity];
+    log->overflow = overflow;
+    log->writer = idle_writer;
+    log->head = 0;
+    log->tail = 0;
+    log->released = 0;
+    log->closing = false;
+    log->closed = false;
+    log->in_event = false;
+    log->dropping = false;
+    log->fd = -1;
+    log->failed = false;
+    log->batch.resize(capacity);
+    return log;
+}
+
+static void free_log(AsyncLog* log)
+{
+    delete[] log->ring;
+    delete log;
+}
+
+static bool put_str(AsyncLog* log, const std::string& s, bool more = false)
+{ return put_data(log, s.data(), s.size(), more); }
+
+// take everything queued and split it into records, skipping pads
+static std::vector<Rec> take_recs(AsyncLog* log)
+{
+    std::vector<Rec> recs;
+    const uint8_t* data;
+    size_t len;
+
+    if ( !take(log, data, len) )
+        return recs;
+
+    for ( size_t off = 0; off < len; )
+    {
+        RecHdr hdr;
+        memcpy(&hdr, data + off, sizeof(hdr));
+
+        if ( hdr.type != REC_PAD )
+            recs.push_back({ hdr.type, std::string((const char*)data + off + sizeof(hdr), hdr.len) });
+
+        off += rec_size(hdr.len);
+    }
+    return recs;
+}
+
+// 8 byte payloads make 16 byte records
+static std::string payload(unsigned n)
+{
+    char buf[9];
+    snprintf(buf, sizeof(buf), "rec%05u", n % 100000);
+    return buf;
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(async_log_ring)
+{
+    void setup() override
+    {
+        idle_writer = new AsyncLogWriter;
+        async_log_stats = { };
+    }
+
+    void teardown() override
+    {
+        delete idle_writer;
+        idle_writer = nullptr;
+    }
+};
+
+TEST(async_log_ring, put_take)
+{
+    AsyncLog* log = make_log(256, ASYNC_LOG_BLOCK);
+
+    CHECK(take_recs(log).empty());
+
+    CHECK(put_str(log, "one"));
+    CHECK(put_str(log, "two two"));
+    CHECK(put_str(log, ""));
+
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(3u, recs.size());
+    CHECK(recs[0].data == "one");
+    CHECK(recs[1].data == "two two");
+    CHECK(recs[2].data.empty());
+
+    CHECK(take_recs(log).empty());
+    CHECK_EQUAL(3u, async_log_stats.records);
+    CHECK_EQUAL(10u, async_log_stats.bytes);
+
+    free_log(log);
+}
+
+TEST(async_log_ring, wrap_pads)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_NEW);
+
+    // 40 bytes, then a 24 byte record only fits by padding to the start
+    CHECK(put_str(log, std::string(24, 'a')));
+    CHECK(put_str(log, "b"));
+    CHECK_EQUAL(2u, take_recs(log).size());
+
+    CHECK(put_str(log, std::string(16, 'c')));
+    CHECK_EQUAL(88u, log->head.load());
+
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(1u, recs.size());
+    CHECK(recs[0].data == std::string(16, 'c'));
+
+    CHECK(put_str(log, std::string(20, 'd')));
+    CHECK(put_str(log, "e"));
+
+    recs = take_recs(log);
+    CHECK_EQUAL(2u, recs.size());
+    CHECK(recs[0].data == std::string(20, 'd'));
+    CHECK(recs[1].data == "e");
+
+    // no record may need more than half the ring so bigger data is split
+    CHECK(put_str(log, std::string(32, 'f')));
+
+    recs = take_recs(log);
+    CHECK_EQUAL(2u, recs.size());
+    CHECK_EQUAL((uint32_t)REC_DATA, recs[0].type);
+    CHECK_EQUAL((uint32_t)REC_MORE, recs[1].type);
+    CHECK(recs[0].data + recs[1].data == std::string(32, 'f'));
+    CHECK_EQUAL(0u, async_log_stats.dropped_new);
+
+    free_log(log);
+}
+
+TEST(async_log_ring, drop_new)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_NEW);
+
+    for ( unsigned i = 0; i < 4; ++i )
+        CHECK(put_str(log, payload(i)));
+
+    CHECK_FALSE(put_str(log, payload(4)));
+    CHECK_FALSE(put_str(log, payload(5)));
+    CHECK_EQUAL(2u, async_log_stats.dropped_new);
+    CHECK_EQUAL(4u, async_log_stats.records);
+
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(4u, recs.size());
+
+    for ( unsigned i = 0; i < recs.size(); ++i )
+        CHECK(recs[i].data == payload(i));
+
+    // room again once taken
+    CHECK(put_str(log, payload(6)));
+
+    free_log(log);
+}
+
+TEST(async_log_ring, drop_oldest)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_OLDEST);
+
+    for ( unsigned i = 0; i < 7; ++i )
+        CHECK(put_str(log, payload(i)));
+
+    CHECK_EQUAL(3u, async_log_stats.dropped_oldest);
+    CHECK_EQUAL(7u, async_log_stats.records);
+    CHECK_EQUAL(0u, async_log_stats.blocked);
+
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(4u, recs.size());
+
+    for ( unsigned i = 0; i < recs.size(); ++i )
+        CHECK(recs[i].data == payload(i + 3));
+
+    free_log(log);
+}
+
+// space claimed by the writer isn't reused until it is copied out
+TEST(async_log_ring, drop_oldest_waits_for_claim)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_OLDEST);
+
+    for ( unsigned i = 0; i < 4; ++i )
+        CHECK(put_str(log, payload(i)));
+
+    // claim everything as take does but hold off copying
+    uint64_t h = log->head.load();
+    log->tail.store(h);
+
+    std::atomic<bool> done { false };
+    AsyncLogStats stats { };
+
+    std::thread producer([&]()
+    {
+        put_str(log, payload(4));
+        stats = async_log_stats;
+        done = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_FALSE(done);
+
+    release(log, h);
+    producer.join();
+
+    CHECK_EQUAL(0u, stats.dropped_oldest);
+
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(1u, recs.size());
+    CHECK(recs[0].data == payload(4));
+
+    free_log(log);
+}
+
+// the writer keeps what it claimed until copied; dropping never reaches into it
+TEST(async_log_ring, drop_oldest_with_writer)
+{
+    AsyncLog* log = make_log(256, ASYNC_LOG_DROP_OLDEST);
+    const uint32_t count = 200000;
+    std::atomic<bool> done { false };
+    PegCount dropped = 0;
+
+    std::thread producer([&]()
+    {
+        for ( uint32_t i = 0; i < count; ++i )
+        {
+            uint32_t rec[2] = { i, ~i };
+            put_data(log, rec, sizeof(rec), false);
+        }
+        dropped = async_log_stats.dropped_oldest;
+        done = true;
+    });
+
+    uint32_t taken = 0;
+    uint32_t next = 0;
+    bool intact = true;
+
+    while ( true )
+    {
+        bool was_done = done;
+        std::vector<Rec> recs = take_recs(log);
+
+        for ( const auto& r : recs )
+        {
+            uint32_t rec[2] = { };
+
+            if ( r.type == REC_DATA and r.data.size() == sizeof(rec) )
+                memcpy(rec, r.data.data(), sizeof(rec));
+
+            // records may be missing but never torn or out of order
+            if ( rec[1] != ~rec[0] or rec[0] < next )
+                intact = false;
+
+            next = rec[0] + 1;
+            ++taken;
+        }
+        if ( was_done and recs.empty() )
+            break;
+    }
+    producer.join();
+
+    CHECK(intact);
+    CHECK_EQUAL(count, next);
+    CHECK_EQUAL(count, taken + dropped);
+
+    free_log(log);
+}
+
+// events of two records are dropped whole by either policy
+TEST(async_log_ring, drop_events_with_writer)
+{
+    for ( auto overflow : { ASYNC_LOG_DROP_OLDEST, ASYNC_LOG_DROP_NEW } )
+    {
+        AsyncLog* log = make_log(256, overflow);
+        const uint32_t count = 100000;
+        std::atomic<bool> done { false };
+        AsyncLogStats stats { };
+
+        std::thread producer([&]()
+        {
+            async_log_stats = { };
+
+            for ( uint32_t i = 0; i < count; ++i )
+            {
+                uint32_t first = i;
+                uint32_t second = ~i;
+                put_data(log, &first, sizeof(first), true);
+                put_data(log, &second, sizeof(second), false);
+            }
+            stats = async_log_stats;
+            done = true;
+        });
+
+        uint32_t taken = 0;
+        uint32_t next = 0;
+        bool pending = false;
+        bool intact = true;
+
+        while ( true )
+        {
+            bool was_done = done;
+            std::vector<Rec> recs = take_recs(log);
+
+            for ( const auto& r : recs )
+            {
+                uint32_t v = 0;
+
+                if ( r.data.size() == sizeof(v) )
+                    memcpy(&v, r.data.data(), sizeof(v));
+
+                // each start is followed by its end, possibly in the next take
+                if ( r.type == REC_DATA and !pending and v >= next )
+                {
+                    next = v;
+                    pending = true;
+                }
+                else if ( r.type == REC_MORE and pending and v == ~next )
+                {
+                    ++next;
+                    ++taken;
+                    pending = false;
+                }
+                else
+                    intact = false;
+            }
+            if ( was_done and recs.empty() )
+                break;
+        }
+        producer.join();
+
+        CHECK(intact);
+        CHECK_FALSE(pending);
+        CHECK_EQUAL(count, taken + stats.dropped_oldest + stats.dropped_new);
+
+        free_log(log);
+    }
+}
+
+TEST(async_log_ring, reopen_not_dropped)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_OLDEST);
+    std::string rec("\0path\0\0", 7);
+
+    CHECK(put_rec(log, REC_REOPEN, rec.data(), rec.size()));
+
+    for ( unsigned i = 0; i < 3; ++i )
+        CHECK(put_str(log, payload(i)));
+
+    std::atomic<bool> done { false };
+    AsyncLogStats stats { };
+
+    std::thread producer([&]()
+    {
+        put_str(log, payload(3));
+        stats = async_log_stats;
+        done = true;
+    });
+
+    // the reopen is oldest so the producer must wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_FALSE(done);
+
+    std::vector<Rec> recs = take_recs(log);
+    producer.join();
+
+    CHECK_EQUAL(4u, recs.size());
+    CHECK_EQUAL((uint32_t)REC_REOPEN, recs[0].type);
+    CHECK_EQUAL(1u, stats.blocked);
+    CHECK_EQUAL(0u, stats.dropped_oldest);
+
+    recs = take_recs(log);
+    CHECK_EQUAL(1u, recs.size());
+    CHECK(recs[0].data == payload(3));
+
+    free_log(log);
+}
+
+TEST(async_log_ring, block)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_BLOCK);
+
+    for ( unsigned i = 0; i < 4; ++i )
+        CHECK(put_str(log, payload(i)));
+
+    std::atomic<bool> done { false };
+    AsyncLogStats stats { };
+
+    std::thread producer([&]()
+    {
+        put_str(log, payload(4));
+        put_str(log, payload(5));
+        stats = async_log_stats;
+        done = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_FALSE(done);
+
+    std::vector<Rec> recs = take_recs(log);
+    producer.join();
+
+    CHECK_EQUAL(4u, recs.size());
+    CHECK_EQUAL(1u, stats.blocked);
+    CHECK_EQUAL(0u, stats.dropped_new);
+    CHECK_EQUAL(0u, stats.dropped_oldest);
+
+    recs = take_recs(log);
+    CHECK_EQUAL(2u, recs.size());
+    CHECK(recs[0].data == payload(4));
+    CHECK(recs[1].data == payload(5));
+
+    free_log(log);
+}
+
+// data bigger than the ring is queued in parts as room is made
+TEST(async_log_ring, big_data_waits)
+{
+    for ( auto overflow : { ASYNC_LOG_BLOCK, ASYNC_LOG_DROP_OLDEST, ASYNC_LOG_DROP_NEW } )
+    {
+        AsyncLog* log = make_log(64, overflow);
+        async_log_stats = { };
+
+        std::string big;
+
+        for ( unsigned i = 0; i < 20; ++i )
+            big += payload(i);
+
+        std::atomic<bool> done { false };
+        bool queued = false;
+        AsyncLogStats stats { };
+
+        std::thread producer([&]()
+        {
+            queued = put_str(log, big);
+            stats = async_log_stats;
+            done = true;
+        });
+
+        std::string got;
+
+        while ( true )
+        {
+            bool was_done = done;
+            std::vector<Rec> recs = take_recs(log);
+
+            for ( const auto& r : recs )
+            {
+                CHECK_EQUAL((uint32_t)(got.empty() ? REC_DATA : REC_MORE), r.type);
+                got += r.data;
+            }
+            if ( was_done and recs.empty() )
+                break;
+        }
+        producer.join();
+
+        CHECK(queued);
+        CHECK(got == big);
+        CHECK_EQUAL(1u, stats.records);
+        CHECK_EQUAL(big.size(), stats.bytes);
+        CHECK_EQUAL(0u, stats.dropped_new);
+        CHECK_EQUAL(0u, stats.dropped_oldest);
+
+        free_log(log);
+    }
+}
+
+// the rest of an event goes with its start
+TEST(async_log_ring, drop_new_event)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_NEW);
+
+    for ( unsigned i = 0; i < 4; ++i )
+        CHECK(put_str(log, payload(i)));
+
+    CHECK_FALSE(put_str(log, payload(4), true));
+    take_recs(log);
+
+    // room now but still dropped
+    CHECK_FALSE(put_str(log, payload(5), true));
+    CHECK_FALSE(put_str(log, payload(6)));
+
+    CHECK(put_str(log, payload(7), true));
+    CHECK(put_str(log, payload(8)));
+
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(2u, recs.size());
+    CHECK_EQUAL((uint32_t)REC_DATA, recs[0].type);
+    CHECK_EQUAL((uint32_t)REC_MORE, recs[1].type);
+    CHECK(recs[0].data == payload(7));
+    CHECK(recs[1].data == payload(8));
+
+    CHECK_EQUAL(1u, async_log_stats.dropped_new);
+    CHECK_EQUAL(6u, async_log_stats.records);
+
+    free_log(log);
+}
+
+// once the start of an event is queued the rest waits for room
+TEST(async_log_ring, drop_new_event_waits)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_NEW);
+
+    for ( unsigned i = 0; i < 3; ++i )
+        CHECK(put_str(log, payload(i)));
+
+    CHECK(put_str(log, payload(3), true));
+
+    std::atomic<bool> done { false };
+    bool queued = false;
+
+    std::thread producer([&]()
+    {
+        queued = put_str(log, payload(4));
+        done = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_FALSE(done);
+
+    CHECK_EQUAL(4u, take_recs(log).size());
+    producer.join();
+
+    CHECK(queued);
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(1u, recs.size());
+    CHECK_EQUAL((uint32_t)REC_MORE, recs[0].type);
+    CHECK(recs[0].data == payload(4));
+
+    free_log(log);
+}
+
+TEST(async_log_ring, drop_oldest_event)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_OLDEST);
+
+    CHECK(put_str(log, payload(0), true));
+    CHECK(put_str(log, payload(1)));
+    CHECK(put_str(log, payload(2)));
+    CHECK(put_str(log, payload(3)));
+
+    // both parts of the first event make room
+    CHECK(put_str(log, payload(4)));
+    CHECK(put_str(log, payload(5)));
+    CHECK_EQUAL(1u, async_log_stats.dropped_oldest);
+
+    std::vector<Rec> recs = take_recs(log);
+    CHECK_EQUAL(4u, recs.size());
+
+    for ( unsigned i = 0; i < recs.size(); ++i )
+    {
+        CHECK_EQUAL((uint32_t)REC_DATA, recs[i].type);
+        CHECK(recs[i].data == payload(i + 2));
+    }
+    free_log(log);
+}
+
+// the end of an event whose start was taken is never dropped
+TEST(async_log_ring, drop_oldest_event_taken)
+{
+    AsyncLog* log = make_log(64, ASYNC_LOG_DROP_OLDEST);
+
+    CHECK(put_str(log, payload(0), true));
+    CHECK_EQUAL(1u, take_recs(log).size());
+
+    for ( unsigned i = 1; i < 4; ++i )
+        CHECK(put_str(log, payload(i), true));
+
+    CHECK(put_str(log, payload(4)));
+
+    std::atomic<bool> done { false };
+    AsyncLogStats stats { };
+
+    std::thread producer([&]()
+    {
+        put_str(log, payload(5));
+        stats = async_log_stats;
+        done = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_FALSE(done);
+
+    std::vector<Rec> recs = take_recs(log);
+    producer.join();
+
+    CHECK_EQUAL(4u, recs.size());
+    CHECK_EQUAL(0u, stats.dropped_oldest);
+    CHECK_EQUAL(1u, stats.blocked);
+
+    free_log(log);
+}
+
+//--------------------------------------------------------------------------
+// writers
+//--------------------------------------------------------------------------
+
+static std::string read_file(const std::string& path)
+{
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+TEST_GROUP(async_log_writer)
+{
+    std::string dir;
+
+    void setup() override
+    {
+        char tmpl[] = "/tmp/async_log_test.XXXXXX";
+        dir = mkdtemp(tmpl);
+        snort_conf.async_log_writers = 1;
+        snort_conf.async_log_ring_size = 4096;
+        snort_conf.async_log_overflow = ASYNC_LOG_BLOCK;
+    }
+
+    void teardown() override
+    {
+        snort_conf.async_log_writers = 0;
+        rmdir(dir.c_str());
+    }
+};
+
+TEST(async_log_writer, disabled)
+{
+    snort_conf.async_log_writers = 0;
+    CHECK(AsyncLog_Open((dir + "/log").c_str(), true) == nullptr);
+}
+
+TEST(async_log_writer, write_roll_close)
+{
+    std::string path = dir + "/log";
+    std::string rolled = dir + "/log.1";
+    std::string expect;
+
+    AsyncLog* log = AsyncLog_Open(path.c_str(), true);
+    CHECK(log != nullptr);
+
+    for ( unsigned i = 0; i < 1000; ++i )
+    {
+        std::string s = payload(i) + "\n";
+        CHECK(AsyncLog_Write(log, s.data(), s.size()));
+        expect += s;
+    }
+
+    CHECK(AsyncLog_Reopen(log, path.c_str(), true, rolled.c_str()));
+    CHECK(AsyncLog_Write(log, "after\n", 6));
+
+    // close waits for everything queued to be written
+    AsyncLog_Close(log);
+
+    CHECK(read_file(rolled) == expect);
+    CHECK(read_file(path) == "after\n");
+
+    unlink(path.c_str());
+    unlink(rolled.c_str());
+}
+
+TEST(async_log_writer, idle_wakeup)
+{
+    std::string path = dir + "/log";
+    AsyncLog* log = AsyncLog_Open(path.c_str(), true);
+    CHECK(log != nullptr);
+
+    // the writer sleeps until something is queued
+    for ( unsigned i = 0; i < 3; ++i )
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        AsyncLog_Write(log, "x", 1);
+
+        unsigned tries = 0;
+
+        while ( read_file(path).size() < i + 1 and ++tries < 1000 )
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        CHECK_EQUAL(i + 1, read_file(path).size());
+    }
+    AsyncLog_Close(log);
+    unlink(path.c_str());
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
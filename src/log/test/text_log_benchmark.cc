@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cinttypes>
+
+#include "catch/catch.hpp"
+
+#include "log/text_log.h"
+#include "sfip/sf_ip.h"
+
+using namespace snort;
+
+// each run formats this many alerts with the default alert_csv fields that
+// aren't strings, so the benchmark covers a few million alerts overall
+#define ALERTS 1000
+
+struct Alert
+{
+    SfIp src;
+    SfIp dst;
+    uint16_t sp;
+    uint16_t dp;
+    uint32_t gid;
+    uint32_t sid;
+    uint32_t rev;
+    uint64_t pkt_num;
+    uint32_t pkt_len;
+    uint8_t mac[6];
+};
+
+static void make_alerts(Alert* alerts)
+{
+    for ( unsigned i = 0; i < ALERTS; ++i )
+    {
+        Alert& a = alerts[i];
+        uint32_t s = htonl(0x0a000000 + i * 2654435761u % 0xffffff);
+        uint32_t d = htonl(0xc0a80000 + i % 0xffff);
+        a.src.set(&s, AF_INET);
+        a.dst.set(&d, AF_INET);
+        a.sp = 1024 + i * 31 % 60000;
+        a.dp = i % 3 ? 443 : 80;
+        a.gid = 1;
+        a.sid = 1000000 + i;
+        a.rev = 1 + i % 5;
+        a.pkt_num = 1000000000ull + i * 977;
+        a.pkt_len = 40 + i % 1460;
+
+        for ( unsigned j = 0; j < sizeof(a.mac); ++j )
+            a.mac[j] = (i >> j) * 37;
+    }
+}
+
+static void print_alert(TextLog* t, const Alert& a)
+{
+    SfIpString src, dst;
+    const uint8_t* m = a.mac;
+
+    TextLog_Print(t, STDu64 ", %u, ", a.pkt_num, a.pkt_len);
+    TextLog_Print(t, "%s:%u, ", a.src.ntop(src), a.sp);
+    TextLog_Print(t, "%s:%u, ", a.dst.ntop(dst), a.dp);
+    TextLog_Print(t, "%u:%u:%u, ", a.gid, a.sid, a.rev);
+    TextLog_Print(t, "%02X:%02X:%02X:%02X:%02X:%02X\n", m[0], m[1], m[2], m[3], m[4], m[5]);
+    TextLog_Flush(t);
+}
+
+static void put_alert(TextLog* t, const Alert& a)
+{
+    TextLog_PutUInt(t, a.pkt_num);
+    TextLog_Puts(t, ", ");
+    TextLog_PutUInt(t, a.pkt_len);
+    TextLog_Puts(t, ", ");
+    TextLog_PutIp(t, &a.src);
+    TextLog_Putc(t, ':');
+    TextLog_PutUInt(t, a.sp);
+    TextLog_Puts(t, ", ");
+    TextLog_PutIp(t, &a.dst);
+    TextLog_Putc(t, ':');
+    TextLog_PutUInt(t, a.dp);
+    TextLog_Puts(t, ", ");
+    TextLog_PutUInt(t, a.gid);
+    TextLog_Putc(t, ':');
+    TextLog_PutUInt(t, a.sid);
+    TextLog_Putc(t, ':');
+    TextLog_PutUInt(t, a.rev);
+    TextLog_Puts(t, ", ");
+    TextLog_PutMac(t, a.mac);
+    TextLog_Putc(t, '\n');
+    TextLog_Flush(t);
+}
+
+TEST_CASE("alert formatting", "[text_log]")
+{
+    static Alert alerts[ALERTS];
+    make_alerts(alerts);
+
+    TextLog* txt = TextLog_Init("/dev/null", 4096);
+
+    BENCHMARK("printf fields")
+    {
+        for ( const auto& a : alerts )
+            print_alert(txt, a);
+    };
+
+    BENCHMARK("direct fields")
+    {
+        for ( const auto& a : alerts )
+            put_alert(txt, a);
+    };
+
+    TextLog_Term(txt);
+}
+
+#endif
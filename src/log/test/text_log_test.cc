@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "catch/catch.hpp"
+
+#include "log/text_log.h"
+#include "sfip/sf_ip.h"
+
+using namespace snort;
+
+static const char* log_name = "text_log_test.txt";
+
+// run f against a fresh log and return what it wrote
+template<typename F>
+static std::string capture(F f, unsigned buf_size = 0)
+{
+    remove(log_name);
+
+    TextLog* txt = TextLog_Init(log_name, buf_size);
+    f(txt);
+    TextLog_Term(txt);
+
+    std::ifstream in(log_name);
+    std::stringstream ss;
+    ss << in.rdbuf();
+
+    remove(log_name);
+    return ss.str();
+}
+
+static std::string print(const char* fmt, uint64_t n)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), fmt, n);
+    return buf;
+}
+
+TEST_CASE("integers", "[text_log]")
+{
+    static const uint64_t values[] =
+    { 0, 1, 9, 10, 99, 100, 101, 999, 1000, 65535, 4294967295u, 1234567890123456789u, UINT64_MAX };
+
+    for ( auto n : values )
+    {
+        CHECK(capture([n](TextLog* t) { TextLog_PutUInt(t, n); }) == print("%" PRIu64, n));
+        CHECK(capture([n](TextLog* t) { TextLog_PutHex(t, n); }) == print("%" PRIX64, n));
+    }
+
+    CHECK(capture([](TextLog* t) { TextLog_PutInt(t, -42); }) == "-42");
+    CHECK(capture([](TextLog* t) { TextLog_PutInt(t, INT64_MIN); }) == "-9223372036854775808");
+    CHECK(capture([](TextLog* t) { TextLog_PutInt(t, 1700000000); }) == "1700000000");
+}
+
+TEST_CASE("addresses", "[text_log]")
+{
+    const uint8_t mac[6] = { 0x00, 0x1a, 0x2B, 0xc0, 0xff, 0x09 };
+    CHECK(capture([&mac](TextLog* t) { TextLog_PutMac(t, mac); }) == "00:1A:2B:C0:FF:09");
+
+    SfIp ip;
+
+    ip.set("10.0.255.1");
+    CHECK(capture([&ip](TextLog* t) { TextLog_PutIp(t, &ip); }) == "10.0.255.1");
+
+    ip.set("0.0.0.0");
+    CHECK(capture([&ip](TextLog* t) { TextLog_PutIp(t, &ip); }) == "0.0.0.0");
+
+    ip.set("2001:db8::1");
+    CHECK(capture([&ip](TextLog* t) { TextLog_PutIp(t, &ip); }) == "2001:db8::1");
+}
+
+TEST_CASE("buffer wrap", "[text_log]")
+{
+    // the minimum buffer is 4K so this flushes several times mid string
+    std::string big(10000, 'x');
+    big += "end";
+
+    CHECK(capture([&big](TextLog* t) { TextLog_Write(t, big.c_str(), big.size()); }) == big);
+
+    std::string nums;
+    for ( unsigned i = 0; i < 2000; ++i )
+        nums += std::to_string(i * 7919u) + ",";
+
+    CHECK(capture([](TextLog* t)
+    {
+        for ( unsigned i = 0; i < 2000; ++i )
+        {
+            TextLog_PutUInt(t, i * 7919u);
+            TextLog_Putc(t, ',');
+        }
+    }) == nums);
+
+    // stops at an embedded null
+    CHECK(capture([](TextLog* t) { CHECK(!TextLog_Write(t, "ab\0cd", 5)); }) == "ab");
+}
@@ -0,0 +1,62 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "log/async_log.h"
+#include "log/log.h"
+#include "main/thread.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+// test logs are written to the named file as is
+FILE* OpenAlertFile(const char* name)
+{ return fopen(name, "a"); }
+
+int RollAlertFile(const char*)
+{ return 0; }
+
+namespace snort
+{
+const char* get_instance_file(std::string& file, const char* name)
+{
+    file = name;
+    return file.c_str();
+}
+
+char* snort_strdup(const char* s)
+{ return strdup(s); }
+
+AsyncLog* AsyncLog_Open(const char*, bool, size_t*)
+{ return nullptr; }
+
+bool AsyncLog_Write(AsyncLog*, const void*, size_t, bool)
+{ return false; }
+
+bool AsyncLog_Reopen(AsyncLog*, const char*, bool, const char*)
+{ return false; }
+
+void AsyncLog_Close(AsyncLog*) { }
+}
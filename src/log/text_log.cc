@@ -36,9 +36,13 @@
 
 #include <algorithm>
 #include <cstdarg>
+#include <string>
 
+#include "main/thread.h"
+#include "sfip/sf_ip.h"
 #include "utils/util.h"
 
+#include "async_log.h"
 #include "log.h"
 
 using namespace snort;
@@ -52,6 +56,8 @@ struct TextLog
 /* private:
    file attributes: */
     FILE* file;
+    AsyncLog* async;
+    char* path;
     char* name;
     size_t size;
     size_t maxFile;
@@ -90,6 +96,23 @@ static void TextLog_Close(FILE* file)
         fclose(file);
 }
 
+static AsyncLog* TextLog_OpenAsync(TextLog* txt)
+{
+    if ( !txt->name or !strcasecmp(txt->name, "stdout") )
+        return nullptr;
+
+    // the writer thread can't resolve instance file names
+    std::string path;
+    get_instance_file(path, txt->name);
+
+    AsyncLog* async = AsyncLog_Open(path.c_str(), false, &txt->size);
+
+    if ( async )
+        txt->path = snort_strdup(path.c_str());
+
+    return async;
+}
+
 static size_t TextLog_Size(FILE* file)
 {
     struct stat sbuf;
@@ -126,8 +149,16 @@ TextLog* TextLog_Init(
     txt = (TextLog*)snort_alloc(sizeof(TextLog)+maxBuf);
 
     txt->name = name ? snort_strdup(name) : nullptr;
-    txt->file = TextLog_Open(txt->name);
-    txt->size = TextLog_Size(txt->file);
+    txt->path = nullptr;
+    txt->async = TextLog_OpenAsync(txt);
+
+    if ( txt->async )
+        txt->file = nullptr;
+    else
+    {
+        txt->file = TextLog_Open(txt->name);
+        txt->size = TextLog_Size(txt->file);
+    }
     txt->last = time(nullptr);
     txt->maxFile = maxFile;
 
@@ -147,8 +178,14 @@ void TextLog_Term(TextLog* const txt)
         return;
 
     TextLog_Flush(txt);
-    TextLog_Close(txt->file);
 
+    if ( txt->async )
+        AsyncLog_Close(txt->async);
+    else
+        TextLog_Close(txt->file);
+
+    if ( txt->path )
+        snort_free(txt->path);
     if ( txt->name )
         snort_free(txt->name);
     snort_free(txt);
@@ -167,19 +204,31 @@ static void TextLog_Roll(TextLog* const txt)
     if ( txt->last >= time(nullptr) )
         return;
 
-    TextLog_Close(txt->file);
-    RollAlertFile(txt->name);
-    txt->file = TextLog_Open(txt->name);
+    if ( txt->async )
+    {
+        // same naming as RollAlertFile() but done by the writer thread
+        std::string rolled(txt->path);
+        rolled += "." + std::to_string((unsigned long)time(nullptr));
+        AsyncLog_Reopen(txt->async, txt->path, false, rolled.c_str());
+    }
+    else
+    {
+        TextLog_Close(txt->file);
+        RollAlertFile(txt->name);
+        txt->file = TextLog_Open(txt->name);
+    }
 
     txt->last = time(nullptr);
     txt->size = 0;
 }
 
 /*-------------------------------------------------------------------
- * TextLog_Flush: write buffered stream to file
+ * TextLog_Drain: write buffered stream to file; more is set when the
+ * buffer is full part way through an event so the async writer can
+ * keep the event together
  *-------------------------------------------------------------------
  */
-bool TextLog_Flush(TextLog* const txt)
+static bool TextLog_Drain(TextLog* const txt, bool more)
 {
     int ok;
 
@@ -189,6 +238,18 @@ bool TextLog_Flush(TextLog* const txt)
     if ( txt->maxFile and txt->size + txt->pos > txt->maxFile )
         TextLog_Roll(txt);
 
+    if ( txt->async )
+    {
+        // an event dropped by the overflow policy is discarded
+        bool queued = AsyncLog_Write(txt->async, txt->buf, txt->pos, more);
+
+        if ( queued )
+            txt->size += txt->pos;
+
+        TextLog_Reset(txt);
+        return queued;
+    }
+
     ok = fwrite(txt->buf, txt->pos, 1, txt->file);
 
     if ( ok == 1 )
@@ -200,6 +261,15 @@ bool TextLog_Flush(TextLog* const txt)
     return false;
 }
 
+/*-------------------------------------------------------------------
+ * TextLog_Flush: write buffered stream to file
+ *-------------------------------------------------------------------
+ */
+bool TextLog_Flush(TextLog* const txt)
+{
+    return TextLog_Drain(txt, false);
+}
+
 /*-------------------------------------------------------------------
  * TextLog_Putc: append char to buffer
  *-------------------------------------------------------------------
@@ -208,7 +278,7 @@ bool TextLog_Putc(TextLog* const txt, char c)
 {
     if ( TextLog_Avail(txt) < 1 )
     {
-        TextLog_Flush(txt);
+        TextLog_Drain(txt, true);
     }
     txt->buf[txt->pos++] = c;
     txt->buf[txt->pos] = '\0';
@@ -217,32 +287,41 @@ bool TextLog_Putc(TextLog* const txt, char c)
 }
 
 /*-------------------------------------------------------------------
- * TextLog_Write: append string to buffer
+ * TextLog_Copy: append len bytes to buffer, flushing as it fills
  *-------------------------------------------------------------------
  */
-bool TextLog_Write(TextLog* const txt, const char* str, int len)
+static bool TextLog_Copy(TextLog* const txt, const char* str, size_t len)
 {
-    do
+    while ( true )
     {
-        int avail = TextLog_Avail(txt);
-        int n = snprintf(txt->buf+txt->pos, avail, "%.*s", len, str);
-        if ( n < avail and n < len )
-            return false;
+        size_t n = std::min(len, (size_t)std::max(TextLog_Avail(txt), 0));
+
+        memcpy(txt->buf + txt->pos, str, n);
+        txt->pos += n;
+        txt->buf[txt->pos] = '\0';
+        str += n;
+        len -= n;
 
-        // actual bytes written:
-        // 1) if avail is a limit, auto-appended '\0' should be truncated
-        // 2) avail could be zero from the start, keep it as 0
-        int l = std::min(n, avail > 0 ? avail - 1 : 0);
-        txt->pos += l;
-        str += l;
-        len -= l;
+        if ( !len )
+            return true;
 
-        if ( n >= avail )
-            TextLog_Flush(txt);
+        if ( !TextLog_Drain(txt, true) )
+            return false;
     }
-    while ( len > 0 );
+}
 
-    return true;
+/*-------------------------------------------------------------------
+ * TextLog_Write: append string to buffer
+ *-------------------------------------------------------------------
+ */
+bool TextLog_Write(TextLog* const txt, const char* str, int len)
+{
+    if ( len < 0 )
+        len = strlen(str);
+
+    // stop at an embedded null as "%.*s" formatting did
+    size_t n = strnlen(str, len);
+    return TextLog_Copy(txt, str, n) and n == (size_t)len;
 }
 
 /*-------------------------------------------------------------------
@@ -261,7 +340,7 @@ bool TextLog_Print(TextLog* const txt, const char* fmt, ...)
 
     if ( len >= avail )
     {
-        TextLog_Flush(txt);
+        TextLog_Drain(txt, true);
         avail = TextLog_Avail(txt);
 
         va_start(ap, fmt);
@@ -284,6 +363,119 @@ bool TextLog_Print(TextLog* const txt, const char* fmt, ...)
     return true;
 }
 
+/*-------------------------------------------------------------------
+ * TextLog_Put*: append formatted values without vsnprintf()
+ *-------------------------------------------------------------------
+ */
+static const char dec_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+// write n right aligned ending at end and return the first digit
+static char* format_uint(char* end, uint64_t n)
+{
+    while ( n >= 100 )
+    {
+        end -= 2;
+        memcpy(end, dec_pairs + (n % 100) * 2, 2);
+        n /= 100;
+    }
+    if ( n >= 10 )
+    {
+        end -= 2;
+        memcpy(end, dec_pairs + n * 2, 2);
+    }
+    else
+        *--end = '0' + n;
+
+    return end;
+}
+
+bool TextLog_PutUInt(TextLog* const txt, uint64_t n)
+{
+    char tmp[20];
+    char* end = tmp + sizeof(tmp);
+    char* p = format_uint(end, n);
+    return TextLog_Copy(txt, p, end - p);
+}
+
+bool TextLog_PutInt(TextLog* const txt, int64_t n)
+{
+    char tmp[21];
+    char* end = tmp + sizeof(tmp);
+    char* p = format_uint(end, n < 0 ? -(uint64_t)n : n);
+
+    if ( n < 0 )
+        *--p = '-';
+
+    return TextLog_Copy(txt, p, end - p);
+}
+
+bool TextLog_PutHex(TextLog* const txt, uint64_t n)
+{
+    char tmp[16];
+    char* end = tmp + sizeof(tmp);
+    char* p = end;
+
+    do
+    {
+        *--p = hex_digits[n & 0xF];
+        n >>= 4;
+    }
+    while ( n );
+
+    return TextLog_Copy(txt, p, end - p);
+}
+
+bool TextLog_PutMac(TextLog* const txt, const uint8_t* mac)
+{
+    char tmp[17];
+
+    for ( int i = 0; i < 6; ++i )
+    {
+        tmp[3*i] = hex_digits[mac[i] >> 4];
+        tmp[3*i+1] = hex_digits[mac[i] & 0xF];
+
+        if ( i < 5 )
+            tmp[3*i+2] = ':';
+    }
+    return TextLog_Copy(txt, tmp, sizeof(tmp));
+}
+
+bool TextLog_PutIp(TextLog* const txt, const SfIp* ip)
+{
+    if ( ip->is_ip4() )
+    {
+        const uint8_t* b = (const uint8_t*)ip->get_ip4_ptr();
+        char tmp[15];
+        char* end = tmp + sizeof(tmp);
+        char* p = end;
+
+        for ( int i = 3; i >= 0; --i )
+        {
+            p = format_uint(p, b[i]);
+
+            if ( i )
+                *--p = '.';
+        }
+        return TextLog_Copy(txt, p, end - p);
+    }
+
+    // ntop() is good enough for the rarer v6 addresses
+    if ( TextLog_Avail(txt) < INET6_ADDRSTRLEN )
+        TextLog_Drain(txt, true);
+
+    if ( TextLog_Avail(txt) < INET6_ADDRSTRLEN )
+        return false;
+
+    ip->ntop(txt->buf + txt->pos, INET6_ADDRSTRLEN);
+    txt->pos += strlen(txt->buf + txt->pos);
+    return true;
+}
+
 /*-------------------------------------------------------------------
  * TextLog_Quote: write string escaping quotes
  *-------------------------------------------------------------------
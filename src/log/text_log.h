@@ -34,6 +34,7 @@
  * name plus a timestamp.
  */
 
+#include <cstdint>
 #include <cstring>
 
 #include "main/snort_types.h"
@@ -48,6 +49,8 @@ struct TextLog;
 
 namespace snort
 {
+struct SfIp;
+
 SO_PUBLIC TextLog* TextLog_Init(
     const char* name, unsigned int maxBuf = 0, size_t maxFile = 0);
 SO_PUBLIC void TextLog_Term(TextLog*);
@@ -57,6 +60,15 @@ SO_PUBLIC bool TextLog_Quote(TextLog* const, const char*);
 SO_PUBLIC bool TextLog_Write(TextLog* const, const char*, int len);
 SO_PUBLIC bool TextLog_Print(TextLog* const, const char* format, ...) __attribute__((format (printf, 2, 3)));
 
+// formatters that write straight into the buffer instead of going
+// through vsnprintf(); hex is upper case without a 0x prefix and a mac
+// is 6 bytes written as XX:XX:XX:XX:XX:XX
+SO_PUBLIC bool TextLog_PutUInt(TextLog* const, uint64_t);
+SO_PUBLIC bool TextLog_PutInt(TextLog* const, int64_t);
+SO_PUBLIC bool TextLog_PutHex(TextLog* const, uint64_t);
+SO_PUBLIC bool TextLog_PutMac(TextLog* const, const uint8_t*);
+SO_PUBLIC bool TextLog_PutIp(TextLog* const, const SfIp*);
+
 SO_PUBLIC bool TextLog_Flush(TextLog* const);
 SO_PUBLIC int TextLog_Avail(TextLog* const);
 SO_PUBLIC void TextLog_Reset(TextLog* const);
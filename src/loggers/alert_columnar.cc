@@ -0,0 +1,568 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// alert_columnar writes events as blocks of compressed columns so that
+// exporters can load them without parsing text.  See log/columnar.h for
+// the file format and tools/columnar_dump for a reader.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <zlib.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "detection/detection_engine.h"
+#include "detection/signature.h"
+#include "events/event.h"
+#include "flow/flow.h"
+#include "flow/flow_key.h"
+#include "framework/data_bus.h"
+#include "framework/logger.h"
+#include "framework/module.h"
+#include "log/async_log.h"
+#include "log/columnar.h"
+#include "log/messages.h"
+#include "main/thread.h"
+#include "network_inspectors/appid/appid_api.h"
+#include "packet_io/active.h"
+#include "protocols/packet.h"
+#include "pub_sub/intrinsic_event_ids.h"
+#include "utils/util.h"
+
+using namespace snort;
+using namespace std;
+
+#define S_NAME "alert_columnar"
+#define F_NAME S_NAME ".log"
+
+//-------------------------------------------------------------------------
+// columns
+//-------------------------------------------------------------------------
+
+enum ColumnId
+{
+    C_SECONDS, C_USECS, C_PKT_NUM, C_GID, C_SID, C_REV, C_PRIORITY, C_CLASS,
+    C_MSG, C_ACTION, C_DIR, C_PROTO, C_IP_PROTO, C_SRC_ADDR, C_SRC_PORT,
+    C_DST_ADDR, C_DST_PORT, C_PKT_LEN, C_VLAN, C_MPLS, C_SERVICE, C_APP, C_MAX
+};
+
+struct ColumnDef
+{
+    const char* name;
+    ColumnarType type;
+};
+
+static const ColumnDef columns[C_MAX] =
+{
+    { "seconds", COL_U64 },
+    { "usecs", COL_U32 },
+    { "pkt_num", COL_U64 },
+    { "gid", COL_U32 },
+    { "sid", COL_U32 },
+    { "rev", COL_U32 },
+    { "priority", COL_U32 },
+    { "class", COL_DICT },
+    { "msg", COL_DICT },
+    { "action", COL_DICT },
+    { "dir", COL_U8 },
+    { "proto", COL_DICT },
+    { "ip_proto", COL_U8 },
+    { "src_addr", COL_IP },
+    { "src_port", COL_U16 },
+    { "dst_addr", COL_IP },
+    { "dst_port", COL_U16 },
+    { "pkt_len", COL_U32 },
+    { "vlan", COL_U16 },
+    { "mpls", COL_U32 },
+    { "service", COL_DICT },
+    { "app", COL_DICT },
+};
+
+// per block string table; the map keys view the stored strings
+class Dictionary
+{
+public:
+    Dictionary()
+    { clear(); }
+
+    uint32_t get(const char* s)
+    {
+        if ( !s or !*s )
+            return 0;
+
+        auto it = index.find(s);
+
+        if ( it != index.end() )
+            return it->second;
+
+        uint32_t id = strings.size();
+        strings.emplace_back(s);
+        index[strings.back()] = id;
+        return id;
+    }
+
+    void clear()
+    {
+        index.clear();
+        strings.clear();
+        strings.emplace_back("");
+    }
+
+    const deque<string>& get_strings() const
+    { return strings; }
+
+private:
+    deque<string> strings;
+    unordered_map<string_view, uint32_t> index;
+};
+
+struct ColumnarConfig
+{
+    size_t limit;
+    unsigned rotate;
+    unsigned flush;
+    unsigned block_rows;
+    int level;
+};
+
+//-------------------------------------------------------------------------
+// writer
+//-------------------------------------------------------------------------
+
+class ColumnarWriter
+{
+public:
+    ColumnarWriter(const ColumnarConfig&);
+    ~ColumnarWriter();
+
+    void add(Packet*, const char* msg, const Event&);
+    void flush();
+
+private:
+    template<typename T>
+    void put(ColumnId c, T v)
+    {
+        assert(sizeof(v) == columnar_width(columns[c].type));
+        const uint8_t* p = (const uint8_t*)&v;
+        data[c].insert(data[c].end(), p, p + sizeof(v));
+    }
+
+    void put_ip(ColumnId, const SfIp*);
+    void put_str(ColumnId, const char*);
+
+    void open_file();
+    void close_file();
+    bool write(const void*, size_t);
+
+    const ColumnarConfig& config;
+    vector<uint8_t> data[C_MAX];
+    Dictionary dicts[C_MAX];
+    unsigned rows = 0;
+    time_t first = 0;
+
+    vector<uint8_t> body;
+    vector<uint8_t> comp;
+
+    string base;
+    FILE* file = nullptr;
+    AsyncLog* async = nullptr;
+    size_t size = 0;
+    time_t opened = 0;
+    time_t stamp = 0;
+};
+
+ColumnarWriter::ColumnarWriter(const ColumnarConfig& c) : config(c)
+{
+    get_instance_file(base, F_NAME);
+
+    for ( auto& d : data )
+        d.reserve(config.block_rows * 4);
+}
+
+ColumnarWriter::~ColumnarWriter()
+{
+    flush();
+    close_file();
+}
+
+void ColumnarWriter::put_ip(ColumnId c, const SfIp* ip)
+{
+    static const uint8_t none[16] = { };
+    const uint8_t* p = ip ? (const uint8_t*)ip->get_ip6_ptr() : none;
+    data[c].insert(data[c].end(), p, p + 16);
+}
+
+void ColumnarWriter::put_str(ColumnId c, const char* s)
+{ put<uint32_t>(c, dicts[c].get(s)); }
+
+void ColumnarWriter::add(Packet* p, const char* msg, const Event& event)
+{
+    const SigInfo* si = event.sig_info;
+    time_t now = (config.flush or config.rotate) ? time(nullptr) : 0;
+
+    if ( !rows )
+        first = now;
+
+    put<uint64_t>(C_SECONDS, p->pkth->ts.tv_sec);
+    put<uint32_t>(C_USECS, p->pkth->ts.tv_usec);
+    put<uint64_t>(C_PKT_NUM, p->context->packet_number);
+    put<uint32_t>(C_GID, si->gid);
+    put<uint32_t>(C_SID, si->sid);
+    put<uint32_t>(C_REV, si->rev);
+    put<uint32_t>(C_PRIORITY, si->priority);
+    put_str(C_CLASS, si->class_type ? si->class_type->text.c_str() : nullptr);
+    put_str(C_MSG, msg);
+    put_str(C_ACTION, p->active->get_action_string());
+
+    uint8_t dir = 0;
+
+    if ( p->is_from_application_client() )
+        dir = 1;
+    else if ( p->is_from_application_server() )
+        dir = 2;
+
+    put<uint8_t>(C_DIR, dir);
+    put_str(C_PROTO, p->get_type());
+
+    bool ip = p->has_ip() or p->is_data();
+    put<uint8_t>(C_IP_PROTO, p->has_ip() ? (uint8_t)p->get_ip_proto_next() : 0);
+    put_ip(C_SRC_ADDR, ip ? p->ptrs.ip_api.get_src() : nullptr);
+    put_ip(C_DST_ADDR, ip ? p->ptrs.ip_api.get_dst() : nullptr);
+
+    bool ports = p->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP);
+    put<uint16_t>(C_SRC_PORT, ports ? p->ptrs.sp : 0);
+    put<uint16_t>(C_DST_PORT, ports ? p->ptrs.dp : 0);
+
+    put<uint32_t>(C_PKT_LEN, p->has_ip() ? p->ptrs.ip_api.dgram_len() : p->dsize);
+    put<uint16_t>(C_VLAN, p->get_flow_vlan_id());
+
+    uint32_t mpls = 0;
+
+    if ( p->flow )
+        mpls = p->flow->key->mplsLabel;
+    else if ( p->proto_bits & PROTO_BIT__MPLS )
+        mpls = p->ptrs.mplsHdr.label;
+
+    put<uint32_t>(C_MPLS, mpls);
+    put_str(C_SERVICE, p->flow ? p->flow->service : nullptr);
+    put_str(C_APP, p->flow ?
+        appid_api.get_application_name(*p->flow, p->is_from_client()) : nullptr);
+
+    // a full block, a stale one or a due rotation writes what is buffered
+    if ( ++rows >= config.block_rows or (config.flush and now - first >= config.flush) or
+        (config.rotate and (file or async) and now - opened >= config.rotate) )
+        flush();
+}
+
+static void append(vector<uint8_t>& v, const void* p, size_t n)
+{
+    const uint8_t* b = (const uint8_t*)p;
+    v.insert(v.end(), b, b + n);
+}
+
+static void append_u32(vector<uint8_t>& v, uint32_t n)
+{ append(v, &n, sizeof(n)); }
+
+void ColumnarWriter::flush()
+{
+    if ( !rows )
+        return;
+
+    body.clear();
+    append_u32(body, C_MAX);
+
+    for ( const auto& c : columns )
+    {
+        uint8_t hdr[2] = { c.type, (uint8_t)strlen(c.name) };
+        append(body, hdr, sizeof(hdr));
+        append(body, c.name, hdr[1]);
+    }
+
+    for ( unsigned c = 0; c < C_MAX; ++c )
+    {
+        size_t start = body.size();
+        append_u32(body, 0);
+
+        if ( columns[c].type == COL_DICT )
+        {
+            const auto& strings = dicts[c].get_strings();
+            append_u32(body, strings.size());
+
+            for ( const auto& s : strings )
+            {
+                append_u32(body, s.size());
+                append(body, s.data(), s.size());
+            }
+        }
+        append(body, data[c].data(), data[c].size());
+
+        uint32_t len = body.size() - start - sizeof(uint32_t);
+        memcpy(body.data() + start, &len, sizeof(len));
+
+        data[c].clear();
+        dicts[c].clear();
+    }
+
+    uLongf comp_size = compressBound(body.size());
+    comp.resize(comp_size);
+
+    if ( compress2(comp.data(), &comp_size, body.data(), body.size(), config.level) != Z_OK )
+    {
+        ErrorMessage(S_NAME ": failed to compress %u events\n", rows);
+        rows = 0;
+        return;
+    }
+
+    ColumnarBlockHeader hdr;
+    hdr.magic = COLUMNAR_BLOCK_MAGIC;
+    hdr.rows = rows;
+    hdr.raw_size = body.size();
+    hdr.comp_size = comp_size;
+    hdr.crc = crc32(0, body.data(), body.size());
+    hdr.reserved = 0;
+    rows = 0;
+
+    time_t now = time(nullptr);
+
+    if ( (file or async) and ((config.limit and size + sizeof(hdr) + comp_size > config.limit) or
+        (config.rotate and now - opened >= config.rotate)) )
+        close_file();
+
+    if ( !file and !async )
+        open_file();
+
+    write(&hdr, sizeof(hdr));
+    write(comp.data(), comp_size);
+
+    // blocks are large so a partial block flushed on idle is readable
+    if ( file )
+        fflush(file);
+}
+
+void ColumnarWriter::open_file()
+{
+    // keep names unique when rotating more than once a second
+    time_t now = time(nullptr);
+    stamp = now > stamp ? now : stamp + 1;
+    opened = now;
+
+    string name = base + "." + to_string((unsigned long)stamp);
+
+    async = AsyncLog_Open(name.c_str(), true);
+
+    if ( !async and !(file = fopen(name.c_str(), "wb")) )
+        FatalError(S_NAME " could not open %s: %s\n", name.c_str(), get_error(errno));
+
+    ColumnarFileHeader hdr;
+    memcpy(hdr.magic, COLUMNAR_MAGIC, sizeof(hdr.magic));
+    hdr.version = COLUMNAR_VERSION;
+    hdr.byte_order = COLUMNAR_BYTE_ORDER;
+
+    size = 0;
+    write(&hdr, sizeof(hdr));
+}
+
+void ColumnarWriter::close_file()
+{
+    if ( async )
+        AsyncLog_Close(async);
+
+    else if ( file )
+        fclose(file);
+
+    async = nullptr;
+    file = nullptr;
+}
+
+bool ColumnarWriter::write(const void* buf, size_t len)
+{
+    bool ok = async ? AsyncLog_Write(async, buf, len) : fwrite(buf, len, 1, file) == 1;
+
+    if ( ok )
+        size += len;
+
+    return ok;
+}
+
+static THREAD_LOCAL ColumnarWriter* writer = nullptr;
+
+// write partial blocks while there is no traffic rather than hold them
+class ColumnarIdleHandler : public DataHandler
+{
+public:
+    ColumnarIdleHandler() : DataHandler(S_NAME) { }
+
+    void handle(DataEvent&, Flow*) override
+    {
+        if ( writer )
+            writer->flush();
+    }
+};
+
+//-------------------------------------------------------------------------
+// module stuff
+//-------------------------------------------------------------------------
+
+static const Parameter s_params[] =
+{
+    { "block_rows", Parameter::PT_INT, "1:65536", "4096",
+      "events buffered before a block is compressed and written" },
+
+    { "flush", Parameter::PT_INT, "0:max32", "5",
+      "seconds before a partial block is written (0 waits for a full block or idle)" },
+
+    { "level", Parameter::PT_INT, "0:9", "6",
+      "zlib compression level" },
+
+    { "limit", Parameter::PT_INT, "0:maxSZ", "0",
+      "set maximum size in MB before rollover (0 is unlimited)" },
+
+    { "rotate", Parameter::PT_INT, "0:max32", "0",
+      "seconds before rollover (0 is unlimited)" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "output event in compressed column blocks"
+
+class ColumnarModule : public Module
+{
+public:
+    ColumnarModule() : Module(S_NAME, s_help, s_params) { }
+
+    bool set(const char*, Value&, SnortConfig*) override;
+    bool begin(const char*, int, SnortConfig*) override;
+
+    Usage get_usage() const override
+    { return GLOBAL; }
+
+public:
+    ColumnarConfig config;
+};
+
+bool ColumnarModule::set(const char*, Value& v, SnortConfig*)
+{
+    if ( v.is("block_rows") )
+        config.block_rows = v.get_uint32();
+
+    else if ( v.is("flush") )
+        config.flush = v.get_uint32();
+
+    else if ( v.is("level") )
+        config.level = v.get_uint8();
+
+    else if ( v.is("limit") )
+        config.limit = v.get_size() * 1024 * 1024;
+
+    else if ( v.is("rotate") )
+        config.rotate = v.get_uint32();
+
+    return true;
+}
+
+bool ColumnarModule::begin(const char*, int, SnortConfig*)
+{
+    config.block_rows = 4096;
+    config.flush = 5;
+    config.level = 6;
+    config.limit = 0;
+    config.rotate = 0;
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// logger stuff
+//-------------------------------------------------------------------------
+
+class ColumnarLogger : public Logger
+{
+public:
+    ColumnarLogger(ColumnarModule* m) : config(m->config)
+    { DataBus::subscribe(intrinsic_pub_key, IntrinsicEventIds::THREAD_IDLE, new ColumnarIdleHandler); }
+
+    void open() override
+    { writer = new ColumnarWriter(config); }
+
+    void close() override
+    {
+        delete writer;
+        writer = nullptr;
+    }
+
+    void alert(Packet* p, const char* msg, const Event& event) override
+    { writer->add(p, msg, event); }
+
+private:
+    ColumnarConfig config;
+};
+
+//-------------------------------------------------------------------------
+// api stuff
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{ return new ColumnarModule; }
+
+static void mod_dtor(Module* m)
+{ delete m; }
+
+static Logger* columnar_ctor(Module* mod)
+{ return new ColumnarLogger((ColumnarModule*)mod); }
+
+static void columnar_dtor(Logger* p)
+{ delete p; }
+
+static LogApi columnar_api
+{
+    {
+        PT_LOGGER,
+        sizeof(LogApi),
+        LOGAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        S_NAME,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OUTPUT_TYPE_FLAG__ALERT,
+    columnar_ctor,
+    columnar_dtor
+};
+
+#ifdef BUILDING_SO
+SO_PUBLIC const BaseApi* snort_plugins[] =
+#else
+const BaseApi* alert_columnar[] =
+#endif
+{
+    &columnar_api.base,
+    nullptr
+};
@@ -75,9 +75,37 @@ struct Args
 static void print_label(const Args& a, const char* label)
 {
     if ( a.comma )
-        TextLog_Print(json_log, ",");
+        TextLog_Putc(json_log, ',');
 
-    TextLog_Print(json_log, " \"%s\" : ", label);
+    TextLog_Puts(json_log, " \"");
+    TextLog_Puts(json_log, label);
+    TextLog_Puts(json_log, "\" : ");
+}
+
+static void print_ip(const SfIp* ip)
+{
+    TextLog_Putc(json_log, '"');
+    TextLog_PutIp(json_log, ip);
+    TextLog_Putc(json_log, '"');
+}
+
+static void print_ap(const Args& a, const SfIp* ip, unsigned port)
+{
+    TextLog_Putc(json_log, '"');
+
+    if ( a.pkt->has_ip() or a.pkt->is_data() )
+        TextLog_PutIp(json_log, ip);
+
+    TextLog_Putc(json_log, ':');
+    TextLog_PutUInt(json_log, port);
+    TextLog_Putc(json_log, '"');
+}
+
+static void print_mac(const uint8_t* mac)
+{
+    TextLog_Putc(json_log, '"');
+    TextLog_PutMac(json_log, mac);
+    TextLog_Putc(json_log, '"');
 }
 
 static bool ff_action(const Args& a)
@@ -134,7 +162,7 @@ static bool ff_client_bytes(const Args& a)
     if (a.pkt->flow)
     {
         print_label(a, "client_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_bytes);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.client_bytes);
         return true;
     }
     return false;
@@ -145,7 +173,7 @@ static bool ff_client_pkts(const Args& a)
     if (a.pkt->flow)
     {
         print_label(a, "client_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_pkts);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.client_pkts);
         return true;
     }
     return false;
@@ -171,9 +199,8 @@ static bool ff_dst_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
-        SfIpString ip_str;
         print_label(a, "dst_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_dst()->ntop(ip_str));
+        print_ip(a.pkt->ptrs.ip_api.get_dst());
         return true;
     }
     return false;
@@ -181,17 +208,13 @@ static bool ff_dst_addr(const Args& a)
 
 static bool ff_dst_ap(const Args& a)
 {
-    SfIpString addr = "";
     unsigned port = 0;
 
-    if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
-
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.dp;
 
     print_label(a, "dst_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
+    print_ap(a, a.pkt->ptrs.ip_api.get_dst(), port);
     return true;
 }
 
@@ -200,7 +223,7 @@ static bool ff_dst_port(const Args& a)
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
     {
         print_label(a, "dst_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.dp);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.dp);
         return true;
     }
     return false;
@@ -214,9 +237,7 @@ static bool ff_eth_dst(const Args& a)
     print_label(a, "eth_dst");
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_dst[0],
-        eh->ether_dst[1], eh->ether_dst[2], eh->ether_dst[3],
-        eh->ether_dst[4], eh->ether_dst[5]);
+    print_mac(eh->ether_dst);
 
     return true;
 }
@@ -227,7 +248,7 @@ static bool ff_eth_len(const Args& a)
         return false;
 
     print_label(a, "eth_len");
-    TextLog_Print(json_log, "%u", a.pkt->pkth->pktlen);
+    TextLog_PutUInt(json_log, a.pkt->pkth->pktlen);
     return true;
 }
 
@@ -239,9 +260,7 @@ static bool ff_eth_src(const Args& a)
     print_label(a, "eth_src");
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_src[0],
-        eh->ether_src[1], eh->ether_src[2], eh->ether_src[3],
-        eh->ether_src[4], eh->ether_src[5]);
+    print_mac(eh->ether_src);
     return true;
 }
 
@@ -253,7 +272,9 @@ static bool ff_eth_type(const Args& a)
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
     print_label(a, "eth_type");
-    TextLog_Print(json_log, "\"0x%X\"", ntohs(eh->ether_type));
+    TextLog_Puts(json_log, "\"0x");
+    TextLog_PutHex(json_log, ntohs(eh->ether_type));
+    TextLog_Putc(json_log, '"');
     return true;
 }
 
@@ -262,7 +283,7 @@ static bool ff_flowstart_time(const Args& a)
     if (a.pkt->flow)
     {
         print_label(a, "flowstart_time");
-        TextLog_Print(json_log, "%ld", a.pkt->flow->flowstats.start_time.tv_sec);
+        TextLog_PutInt(json_log, a.pkt->flow->flowstats.start_time.tv_sec);
         return true;
     }
     return false;
@@ -273,7 +294,7 @@ static bool ff_geneve_vni(const Args& a)
     if (a.pkt->proto_bits & PROTO_BIT__GENEVE)
     {
         print_label(a, "geneve_vni");
-        TextLog_Print(json_log, "%u", a.pkt->get_flow_geneve_vni());
+        TextLog_PutUInt(json_log, a.pkt->get_flow_geneve_vni());
     }
     return true;
 }
@@ -281,7 +302,7 @@ static bool ff_geneve_vni(const Args& a)
 static bool ff_gid(const Args& a)
 {
     print_label(a, "gid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->gid);
+    TextLog_PutUInt(json_log, a.event.sig_info->gid);
     return true;
 }
 
@@ -290,7 +311,7 @@ static bool ff_icmp_code(const Args& a)
     if (a.pkt->ptrs.icmph )
     {
         print_label(a, "icmp_code");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->code);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.icmph->code);
         return true;
     }
     return false;
@@ -301,7 +322,7 @@ static bool ff_icmp_id(const Args& a)
     if (a.pkt->ptrs.icmph )
     {
         print_label(a, "icmp_id");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_id));
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.icmph->s_icmp_id));
         return true;
     }
     return false;
@@ -312,7 +333,7 @@ static bool ff_icmp_seq(const Args& a)
     if (a.pkt->ptrs.icmph )
     {
         print_label(a, "icmp_seq");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
         return true;
     }
     return false;
@@ -323,7 +344,7 @@ static bool ff_icmp_type(const Args& a)
     if (a.pkt->ptrs.icmph )
     {
         print_label(a, "icmp_type");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->type);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.icmph->type);
         return true;
     }
     return false;
@@ -341,7 +362,7 @@ static bool ff_ip_id(const Args& a)
     if (a.pkt->has_ip())
     {
         print_label(a, "ip_id");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.id());
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.id());
         return true;
     }
     return false;
@@ -352,7 +373,7 @@ static bool ff_ip_len(const Args& a)
     if (a.pkt->has_ip())
     {
         print_label(a, "ip_len");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.pay_len());
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.pay_len());
         return true;
     }
     return false;
@@ -379,7 +400,7 @@ static bool ff_mpls(const Args& a)
         return false;
 
     print_label(a, "mpls");
-    TextLog_Print(json_log, "%u", mpls);
+    TextLog_PutUInt(json_log, mpls);
     return true;
 }
 
@@ -395,9 +416,9 @@ static bool ff_pkt_len(const Args& a)
     print_label(a, "pkt_len");
 
     if (a.pkt->has_ip())
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.dgram_len());
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.dgram_len());
     else
-        TextLog_Print(json_log, "%u", a.pkt->dsize);
+        TextLog_PutUInt(json_log, a.pkt->dsize);
 
     return true;
 }
@@ -405,14 +426,14 @@ static bool ff_pkt_len(const Args& a)
 static bool ff_pkt_num(const Args& a)
 {
     print_label(a, "pkt_num");
-    TextLog_Print(json_log, STDu64, a.pkt->context->packet_number);
+    TextLog_PutUInt(json_log, a.pkt->context->packet_number);
     return true;
 }
 
 static bool ff_priority(const Args& a)
 {
     print_label(a, "priority");
-    TextLog_Print(json_log, "%u", a.event.sig_info->priority);
+    TextLog_PutUInt(json_log, a.event.sig_info->priority);
     return true;
 }
 
@@ -426,7 +447,7 @@ static bool ff_proto(const Args& a)
 static bool ff_rev(const Args& a)
 {
     print_label(a, "rev");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->rev);
+    TextLog_PutUInt(json_log, a.event.sig_info->rev);
     return true;
 }
 
@@ -434,8 +455,13 @@ static bool ff_rule(const Args& a)
 {
     print_label(a, "rule");
 
-    TextLog_Print(json_log, "\"%u:%u:%u\"",
-        a.event.sig_info->gid, a.event.sig_info->sid, a.event.sig_info->rev);
+    TextLog_Putc(json_log, '"');
+    TextLog_PutUInt(json_log, a.event.sig_info->gid);
+    TextLog_Putc(json_log, ':');
+    TextLog_PutUInt(json_log, a.event.sig_info->sid);
+    TextLog_Putc(json_log, ':');
+    TextLog_PutUInt(json_log, a.event.sig_info->rev);
+    TextLog_Putc(json_log, '"');
 
     return true;
 }
@@ -443,7 +469,7 @@ static bool ff_rule(const Args& a)
 static bool ff_seconds(const Args& a)
 {
     print_label(a, "seconds");
-    TextLog_Print(json_log, "%ld",  a.pkt->pkth->ts.tv_sec);
+    TextLog_PutInt(json_log, a.pkt->pkth->ts.tv_sec);
     return true;
 }
 
@@ -452,7 +478,7 @@ static bool ff_server_bytes(const Args& a)
     if (a.pkt->flow)
     {
         print_label(a, "server_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_bytes);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.server_bytes);
         return true;
     }
     return false;
@@ -463,7 +489,7 @@ static bool ff_server_pkts(const Args& a)
     if (a.pkt->flow)
     {
         print_label(a, "server_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_pkts);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.server_pkts);
         return true;
     }
     return false;
@@ -487,7 +513,7 @@ static bool ff_sgt(const Args& a)
     {
         const cisco_meta_data::CiscoMetaDataHdr* cmdh = layer::get_cisco_meta_data_layer(a.pkt);
         print_label(a, "sgt");
-        TextLog_Print(json_log, "%hu", cmdh->sgt_val());
+        TextLog_PutUInt(json_log, cmdh->sgt_val());
         return true;
     }
     return false;
@@ -496,7 +522,7 @@ static bool ff_sgt(const Args& a)
 static bool ff_sid(const Args& a)
 {
     print_label(a, "sid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->sid);
+    TextLog_PutUInt(json_log, a.event.sig_info->sid);
     return true;
 }
 
@@ -504,9 +530,8 @@ static bool ff_src_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
-        SfIpString ip_str;
         print_label(a, "src_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_src()->ntop(ip_str));
+        print_ip(a.pkt->ptrs.ip_api.get_src());
         return true;
     }
     return false;
@@ -514,17 +539,13 @@ static bool ff_src_addr(const Args& a)
 
 static bool ff_src_ap(const Args& a)
 {
-    SfIpString addr = "";
     unsigned port = 0;
 
-    if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
-
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.sp;
 
     print_label(a, "src_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
+    print_ap(a, a.pkt->ptrs.ip_api.get_src(), port);
     return true;
 }
 
@@ -533,7 +554,7 @@ static bool ff_src_port(const Args& a)
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
     {
         print_label(a, "src_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.sp);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.sp);
         return true;
     }
     return false;
@@ -541,19 +562,19 @@ static bool ff_src_port(const Args& a)
 
 static bool ff_target(const Args& a)
 {
-    SfIpString addr = "";
+    const SfIp* addr;
 
     if ( a.event.sig_info->target == TARGET_SRC )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_src();
 
     else if ( a.event.sig_info->target == TARGET_DST )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_dst();
 
     else
         return false;
 
     print_label(a, "target");
-    TextLog_Quote(json_log, addr);
+    print_ip(addr);
     return true;
 }
 
@@ -562,7 +583,7 @@ static bool ff_tcp_ack(const Args& a)
     if (a.pkt->ptrs.tcph )
     {
         print_label(a, "tcp_ack");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_ack));
+        TextLog_PutUInt(json_log, ntohl(a.pkt->ptrs.tcph->th_ack));
         return true;
     }
     return false;
@@ -587,7 +608,7 @@ static bool ff_tcp_len(const Args& a)
     if (a.pkt->ptrs.tcph )
     {
         print_label(a, "tcp_len");
-        TextLog_Print(json_log, "%u", (a.pkt->ptrs.tcph->off()));
+        TextLog_PutUInt(json_log, (a.pkt->ptrs.tcph->off()));
         return true;
     }
     return false;
@@ -598,7 +619,7 @@ static bool ff_tcp_seq(const Args& a)
     if (a.pkt->ptrs.tcph )
     {
         print_label(a, "tcp_seq");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_seq));
+        TextLog_PutUInt(json_log, ntohl(a.pkt->ptrs.tcph->th_seq));
         return true;
     }
     return false;
@@ -609,7 +630,7 @@ static bool ff_tcp_win(const Args& a)
     if (a.pkt->ptrs.tcph )
     {
         print_label(a, "tcp_win");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.tcph->th_win));
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.tcph->th_win));
         return true;
     }
     return false;
@@ -629,7 +650,7 @@ static bool ff_tos(const Args& a)
     if (a.pkt->has_ip())
     {
         print_label(a, "tos");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.tos());
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.tos());
         return true;
     }
     return false;
@@ -640,7 +661,7 @@ static bool ff_ttl(const Args& a)
     if (a.pkt->has_ip())
     {
         print_label(a, "ttl");
-        TextLog_Print(json_log, "%u",a.pkt->ptrs.ip_api.ttl());
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.ttl());
         return true;
     }
     return false;
@@ -651,7 +672,7 @@ static bool ff_udp_len(const Args& a)
     if (a.pkt->ptrs.udph )
     {
         print_label(a, "udp_len");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.udph->uh_len));
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.udph->uh_len));
         return true;
     }
     return false;
@@ -660,7 +681,7 @@ static bool ff_udp_len(const Args& a)
 static bool ff_vlan(const Args& a)
 {
     print_label(a, "vlan");
-    TextLog_Print(json_log, "%hu", a.pkt->get_flow_vlan_id());
+    TextLog_PutUInt(json_log, a.pkt->get_flow_vlan_id());
     return true;
 }
 
@@ -829,7 +850,7 @@ void JsonLogger::alert(Packet* p, const char* msg, const Event& event)
         a.comma = true;
     }
 
-    TextLog_Print(json_log, " }\n");
+    TextLog_Puts(json_log, " }\n");
     TextLog_Flush(json_log);
 }
 
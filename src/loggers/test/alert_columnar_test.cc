@@ -0,0 +1,288 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// alert_columnar_test.cc - events written by alert_columnar read back by columnar_dump
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "loggers/alert_columnar.cc"
+
+#define main columnar_dump_main
+#include "tools/columnar_dump/columnar_dump.cc"
+#undef main
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "protocols/ipv4.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+static std::string test_dir;
+
+const char* Active::act_str[Active::ACT_MAX][Active::AST_MAX] = { { }, { "allow" } };
+
+void Active::reset()
+{
+    active_status = AST_ALLOW;
+    active_action = ACT_ALLOW;
+}
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+const char* Packet::get_type() const { return "TCP"; }
+bool Packet::is_from_application_client() const { return true; }
+bool Packet::is_from_application_server() const { return false; }
+uint16_t Packet::get_flow_vlan_id() const { return 0; }
+
+IpsContext::IpsContext(unsigned) { }
+IpsContext::~IpsContext() = default;
+
+void show_stats(PegCount*, const PegInfo*, unsigned, const char*) { }
+void show_stats(PegCount*, const PegInfo*, const IndexVec&, const char*, FILE*) { }
+
+void DataBus::subscribe(const PubKey&, unsigned, DataHandler* h)
+{ delete h; }
+
+namespace snort
+{
+AppIdApi appid_api;
+const char* AppIdApi::get_application_name(const Flow&, bool) { return nullptr; }
+
+namespace layer
+{
+const ip::IP6Frag* get_inner_ip6_frag() { return nullptr; }
+}
+
+const char* get_instance_file(std::string& file, const char* name)
+{
+    file = test_dir + "/" + name;
+    return file.c_str();
+}
+
+AsyncLog* AsyncLog_Open(const char*, bool, size_t*) { return nullptr; }
+bool AsyncLog_Write(AsyncLog*, const void*, size_t, bool) { return false; }
+void AsyncLog_Close(AsyncLog*) { }
+
+char* snort_strdup(const char* s) { return strdup(s); }
+void ErrorMessage(const char*, ...) { }
+[[noreturn]] void FatalError(const char*, ...) { abort(); }
+const char* get_error(int) { return ""; }
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+struct TestPacket
+{
+    TestPacket(uint32_t src, uint32_t dst, uint16_t sp, uint16_t dp, uint16_t len)
+    {
+        memset((void*)&ip4, 0, sizeof(ip4));
+        ip4.ip_verhl = 0x45;
+        ip4.ip_len = htons(len);
+        ip4.ip_proto = IpProtocol::TCP;
+        ip4.ip_src = htonl(src);
+        ip4.ip_dst = htonl(dst);
+
+        pkth.ts.tv_sec = 1700000000;
+        pkth.ts.tv_usec = 42;
+        ctx.packet_number = 7;
+        active.reset();
+
+        pkt.pkth = &pkth;
+        pkt.context = &ctx;
+        pkt.active = &active;
+        pkt.flow = nullptr;
+        pkt.proto_bits = PROTO_BIT__TCP;
+        pkt.ip_proto_next = IpProtocol::TCP;
+        pkt.ptrs.ip_api.set(&ip4);
+        pkt.ptrs.sp = sp;
+        pkt.ptrs.dp = dp;
+    }
+
+    ip::IP4Hdr ip4;
+    DAQ_PktHdr_t pkth { };
+    IpsContext ctx;
+    Active active;
+    Packet pkt { false };
+};
+
+static void log_event(ColumnarWriter& w, uint32_t sid, const char* msg, uint32_t src)
+{
+    TestPacket tp(src, 0xc0a80001, 1234, 80, 60);
+    SigInfo si;
+    si.gid = 1;
+    si.sid = sid;
+    si.rev = 2;
+    si.priority = 3;
+    Event event(si);
+    w.add(&tp.pkt, msg, event);
+}
+
+static std::vector<std::string> get_files()
+{
+    std::vector<std::string> files;
+    DIR* d = opendir(test_dir.c_str());
+
+    while ( dirent* de = readdir(d) )
+    {
+        if ( de->d_name[0] != '.' )
+            files.emplace_back(test_dir + "/" + de->d_name);
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static std::string dump_file(const std::string& file, bool summary)
+{
+    char* buf = nullptr;
+    size_t len = 0;
+    FILE* out = open_memstream(&buf, &len);
+
+    int ret = dump(file.c_str(), summary, out);
+    fclose(out);
+
+    std::string s(buf, len);
+    free(buf);
+
+    return ret ? "failed: " + s : s;
+}
+
+static const char* header =
+    "seconds,usecs,pkt_num,gid,sid,rev,priority,class,msg,action,dir,proto,ip_proto,"
+    "src_addr,src_port,dst_addr,dst_port,pkt_len,vlan,mpls,service,app\n";
+
+static std::string row(uint32_t sid, const char* msg, const char* src)
+{
+    return std::string("1700000000,42,7,1,") + std::to_string(sid) + ",2,3,\"\"," + msg +
+        ",\"allow\",1,\"TCP\",6," + src + ",1234,192.168.0.1,80,60,0,0,\"\",\"\"\n";
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(alert_columnar)
+{
+    ColumnarConfig config { };
+
+    void setup() override
+    {
+        char tmpl[] = "/tmp/alert_columnar_test.XXXXXX";
+        test_dir = mkdtemp(tmpl);
+
+        config.block_rows = 2;
+        config.level = 6;
+    }
+
+    void teardown() override
+    {
+        for ( const auto& f : get_files() )
+            unlink(f.c_str());
+
+        rmdir(test_dir.c_str());
+    }
+};
+
+TEST(alert_columnar, round_trip)
+{
+    {
+        ColumnarWriter w(config);
+        log_event(w, 100, "first", 0x0a000001);
+        log_event(w, 200, "say \"hi\", twice", 0x0a000002);
+
+        // the last block is partial and written on close
+        log_event(w, 100, "first", 0x0a000003);
+    }
+
+    std::vector<std::string> files = get_files();
+    CHECK_EQUAL(1u, files.size());
+
+    std::string expect = header;
+    expect += row(100, "\"first\"", "10.0.0.1");
+    expect += row(200, "\"say \"\"hi\"\", twice\"", "10.0.0.2");
+    expect += row(100, "\"first\"", "10.0.0.3");
+
+    std::string csv = dump_file(files[0], false);
+    CHECK_TEXT(csv == expect, csv.c_str());
+
+    std::string summary = dump_file(files[0], true);
+    CHECK(summary.find("block 1: 2 events") == 0);
+    CHECK(summary.find("block 2: 1 events") != std::string::npos);
+    CHECK(summary.find(": 2 blocks, 3 events") != std::string::npos);
+}
+
+TEST(alert_columnar, idle_flush)
+{
+    config.block_rows = 100;
+    writer = new ColumnarWriter(config);
+
+    log_event(*writer, 300, "idle", 0x0a000001);
+    CHECK(get_files().empty());
+
+    BareDataEvent idle;
+    ColumnarIdleHandler handler;
+    handler.handle(idle, nullptr);
+
+    std::vector<std::string> files = get_files();
+    CHECK_EQUAL(1u, files.size());
+
+    std::string csv = dump_file(files[0], false);
+    CHECK_TEXT(csv == header + row(300, "\"idle\"", "10.0.0.1"), csv.c_str());
+
+    // nothing more to write
+    handler.handle(idle, nullptr);
+    CHECK(dump_file(files[0], true).find(": 1 blocks, 1 events") != std::string::npos);
+
+    delete writer;
+    writer = nullptr;
+}
+
+TEST(alert_columnar, corrupt_block)
+{
+    {
+        ColumnarWriter w(config);
+        log_event(w, 100, "first", 0x0a000001);
+    }
+    std::vector<std::string> files = get_files();
+    CHECK_EQUAL(1u, files.size());
+
+    // flip a byte of the compressed body
+    FILE* f = fopen(files[0].c_str(), "r+b");
+    fseek(f, -1, SEEK_END);
+    int c = fgetc(f);
+    fseek(f, -1, SEEK_END);
+    fputc(c ^ 0xff, f);
+    fclose(f);
+
+    CHECK(dump_file(files[0], false).find("failed: ERROR: corrupt block 0") == 0);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
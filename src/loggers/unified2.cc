@@ -37,6 +37,7 @@
 #include "events/event.h"
 #include "framework/logger.h"
 #include "framework/module.h"
+#include "log/async_log.h"
 #include "log/messages.h"
 #include "log/obfuscator.h"
 #include "log/unified2.h"
@@ -71,6 +72,7 @@ struct Unified2Config
 struct U2
 {
     FILE* stream;
+    AsyncLog* async;
     unsigned int current;
     int base_proto;
     uint32_t timestamp;
@@ -128,6 +130,16 @@ static void Unified2InitFile(Unified2Config* config)
         fname_ptr = u2.filepath;
     }
 
+    // the writer thread does the actual close and open when rotating
+    if ( u2.async )
+    {
+        AsyncLog_Reopen(u2.async, fname_ptr, true);
+        return;
+    }
+
+    if ( !u2.stream and (u2.async = AsyncLog_Open(fname_ptr, true)) )
+        return;
+
     if ((u2.stream = fopen(fname_ptr, "wb")) == nullptr)
     {
         FatalError("unified2 could not open %s: %s\n", fname_ptr, get_error(errno));
@@ -144,7 +156,9 @@ static void Unified2InitFile(Unified2Config* config)
 
 static inline void Unified2RotateFile(Unified2Config* config)
 {
-    fclose(u2.stream);
+    if ( u2.stream )
+        fclose(u2.stream);
+
     u2.current = 0;
     Unified2InitFile(config);
 }
@@ -467,6 +481,13 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
 {
     size_t fwcount = 0;
 
+    if ( u2.async and buf )
+    {
+        if ( AsyncLog_Write(u2.async, buf, buf_len) )
+            u2.current += buf_len;
+        return;
+    }
+
     /* Nothing to write or nothing to write to */
     if ((buf == nullptr) || (config == nullptr) || (u2.stream == nullptr))
         return;
@@ -921,9 +942,15 @@ void U2Logger::open()
 
 void U2Logger::close()
 {
-    if ( u2.stream )
+    if ( u2.async )
+        AsyncLog_Close(u2.async);
+
+    else if ( u2.stream )
         fclose(u2.stream);
 
+    u2.async = nullptr;
+    u2.stream = nullptr;
+
     delete[] write_pkt_buffer;
     delete[] io_buffer;
 
@@ -168,7 +168,16 @@ bool Pig::prep(const char* source)
     const SnortConfig* sc = SnortConfig::get_conf();
     SFDAQInstance *instance = new SFDAQInstance(source, idx, sc->daq_config);
 
-    if (!SFDAQ::init_instance(instance, sc->bpf_filter))
+    // the DAQ message pool is allocated here, put it on the packet thread's node
+    int node = sc->thread_config->get_thread_numa_node(STHREAD_TYPE_PACKET, idx);
+    bool placed = node >= 0 and ThreadConfig::prefer_numa_node(node);
+
+    bool ok = SFDAQ::init_instance(instance, sc->bpf_filter);
+
+    if ( placed )
+        ThreadConfig::prefer_numa_node(-1);
+
+    if (!ok)
     {
         delete instance;
         return false;
@@ -663,6 +663,7 @@ void Analyzer::init_unprivileged()
 
 void Analyzer::reinit(const SnortConfig* sc)
 {
+    sc->localize_scratch();
     InspectorManager::thread_reinit(sc);
     ActionManager::thread_reinit(sc);
     TraceApi::thread_reinit(sc->trace_config);
@@ -758,7 +759,14 @@ void Analyzer::operator()(Swapper* ps, uint16_t run_num)
 
     ps->apply(*this);
 
-    if (SnortConfig::get_conf()->pcap_show())
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    // place everything allocated from here on, including offload threads,
+    // on this thread's node
+    sc->thread_config->apply_thread_mempolicy(STHREAD_TYPE_PACKET, get_instance_id());
+    sc->localize_scratch();
+
+    if (sc->pcap_show())
         show_source();
 
     // init here to pin separately from packet threads
@@ -867,9 +875,9 @@ void Analyzer::handle_uncompleted_commands()
 
 DAQ_RecvStatus Analyzer::process_messages()
 {
-    // Max receive becomes the minimum of the configured batch size, the remaining exit_after
-    // count (if requested), and the remaining pause_after count (if requested).
-    unsigned max_recv = daq_instance->get_batch_size();
+    // Max receive becomes the minimum of the configured or adapted batch size, the remaining
+    // exit_after count (if requested), and the remaining pause_after count (if requested).
+    unsigned max_recv = daq_instance->get_recv_size();
     if (exit_after_cnt && exit_after_cnt < max_recv)
         max_recv = exit_after_cnt;
     if (pause_after_cnt && pause_after_cnt < max_recv)
@@ -907,6 +915,7 @@ DAQ_RecvStatus Analyzer::process_messages()
         process_retry_queue();
         handle_uncompleted_commands();
     }
+    daq_instance->batch_processed();
 
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
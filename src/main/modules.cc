@@ -44,6 +44,7 @@
 #include "host_tracker/host_cache_module.h"
 #include "js_norm/js_norm_module.h"
 #include "latency/latency_module.h"
+#include "log/async_log.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
 #include "managers/plugin_manager.h"
@@ -195,6 +196,9 @@ static const Parameter search_engine_params[] =
     { "rule_db_dir", Parameter::PT_STRING, nullptr, nullptr,
       "deserialize rule databases from given directory" },
 
+    { "reuse_rule_dbs", Parameter::PT_BOOL, nullptr, "false",
+      "retain compiled rule databases in memory and reuse those with unchanged patterns on reload" },
+
     { "show_fast_patterns", Parameter::PT_BOOL, nullptr, "false",
       "print fast pattern info for each rule" },
 
@@ -298,6 +302,9 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("rule_db_dir") )
         fp->set_rule_db_dir(v.get_string());
 
+    else if ( v.is("reuse_rule_dbs") )
+        fp->set_reuse_rule_dbs(v.get_bool());
+
     else if ( v.is("search_method") )
     {
         if ( !fp->set_search_method(v.get_string()) )
@@ -541,6 +548,15 @@ static const Parameter output_event_trace_params[] =
 
 static const Parameter output_params[] =
 {
+    { "async_overflow", Parameter::PT_ENUM, "block | drop_oldest | drop_new", "block",
+      "what to do with a log record when the async ring is full" },
+
+    { "async_ring_size", Parameter::PT_INT, "65536:max32", "1048576",
+      "bytes queued per log and packet thread for the writer threads; larger writes are split" },
+
+    { "async_writers", Parameter::PT_INT, "0:32", "0",
+      "number of threads writing text and unified2 logs (0 writes on the packet threads)" },
+
     { "dump_chars_only", Parameter::PT_BOOL, nullptr, "false",
       "turns on character dumps (same as -C)" },
 
@@ -604,11 +620,26 @@ public:
 
     const RuleMap* get_rules() const override
     { return output_rules; }
+
+    const PegInfo* get_pegs() const override
+    { return async_log_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&async_log_stats; }
 };
 
 bool OutputModule::set(const char*, Value& v, SnortConfig* sc)
 {
-    if ( v.is("dump_chars_only") )
+    if ( v.is("async_overflow") )
+        sc->async_log_overflow = v.get_uint8();
+
+    else if ( v.is("async_ring_size") )
+        sc->async_log_ring_size = v.get_uint32();
+
+    else if ( v.is("async_writers") )
+        sc->async_log_writers = v.get_uint8();
+
+    else if ( v.is("dump_chars_only") )
         v.update_mask(sc->output_flags, OUTPUT_FLAG__CHAR_DATA);
 
     else if ( v.is("dump_payload") )
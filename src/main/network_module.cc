@@ -43,6 +43,10 @@ static const Parameter network_params[] =
       "all | ip | noip | tcp | notcp | udp | noudp | icmp | noicmp | none", "all",
       "checksums to verify" },
 
+    { "fast_decode", Parameter::PT_BOOL, nullptr, "false",
+      "decode well formed Ethernet, VLAN, IP, and TCP headers inline instead of "
+      "with their codecs" },
+
     // The maximum is max64-1. This is because the code uses the max64 value to determine if a network policy
     // has been set using the network_set_policy command
     { "id", Parameter::PT_INT, "0:18446744073709551614", "0",
@@ -108,6 +112,9 @@ bool NetworkModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("checksum_eval") )
         ConfigChecksumMode(v.get_string());
 
+    else if ( v.is("fast_decode") )
+        sc->fast_decode = v.get_bool();
+
     else if ( v.is("id") )
         p->user_policy_id = v.get_uint64();
 
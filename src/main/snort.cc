@@ -224,7 +224,7 @@ void Snort::init(int argc, char** argv)
         MpseManager::activate_search_engine(offload_search_api, sc);
 
     /* Finish up the pcap list and put in the queues */
-    Trough::setup();
+    Trough::setup(sc->daq_config);
 
     // FIXIT-L refactor stuff done here and in snort_config.cc::VerifyReload()
     if ( sc->bpf_filter.empty() && !sc->bpf_file.empty() )
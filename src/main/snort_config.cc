@@ -345,6 +345,16 @@ void SnortConfig::update_scratch(ControlConn* ctrlcon)
     main_broadcast_command(new ACScratchUpdate(this, scratch_handlers, ctrlcon));
 }
 
+// called by each packet thread once placed on its node
+void SnortConfig::localize_scratch() const
+{
+    if ( ThreadConfig::get_numa_node() < 0 )
+        return;
+
+    for ( auto* s : scratchers )
+        s->localize(this);
+}
+
 void SnortConfig::clone(const SnortConfig* const conf)
 {
     *this = *conf;
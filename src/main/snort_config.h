@@ -178,6 +178,7 @@ public:
     void setup();
     void post_setup();
     void update_scratch(ControlConn*);
+    void localize_scratch() const;
     bool verify() const;
 
     void merge(const SnortConfig*);
@@ -206,6 +207,11 @@ public:
     uint32_t tagged_packet_limit = 256;
     uint16_t event_trace_max = 0;
 
+    // async_log_writers == 0 writes logs on the packet threads
+    uint32_t async_log_ring_size = 1048576;
+    uint8_t async_log_writers = 0;
+    uint8_t async_log_overflow = 0;
+
     std::string log_dir;
 
     //------------------------------------------------------
@@ -234,6 +240,7 @@ public:
     bool global_default_rule_state = true;
     bool allow_missing_so_rules = false;
     bool enable_strict_reduction = false;
+    bool parallel_rule_lexing = false;
     uint16_t max_continuations = 1024;
 
     std::unordered_map<std::string, std::vector<std::string>> service_extension =
@@ -268,6 +275,7 @@ public:
     uint8_t max_ip_layers = 0;
 
     bool enable_esp = false;
+    bool fast_decode = false;
     bool address_anomaly_check_enabled = false;
 
     //------------------------------------------------------
@@ -359,6 +359,9 @@ static const Parameter s_params[] =
     { "--daq", Parameter::PT_STRING, nullptr, nullptr,
       "<type> select packet acquisition module (default is pcap)" },
 
+    { "--daq-batch-latency", Parameter::PT_INT, "0:max32", nullptr,
+      "<usecs> adapt the DAQ receive batch size so packets wait no more than this for those ahead of them; 0 is fixed", },
+
     { "--daq-batch-size", Parameter::PT_INT, "1:", nullptr,
       "<size> set the DAQ receive batch size; default is 64", },
 
@@ -534,6 +537,12 @@ static const Parameter s_params[] =
     { "--pcap-filter", Parameter::PT_STRING, nullptr, nullptr,
       "<filter> filter to apply when getting pcaps from file or directory" },
 
+    { "--pcap-hot-loop", Parameter::PT_IMPLIED, nullptr, nullptr,
+      "load all pcaps into memory once per packet thread and replay them from there with the replay DAQ" },
+
+    { "--pcap-hot-loop-rewrite", Parameter::PT_IMPLIED, nullptr, nullptr,
+      "same as --pcap-hot-loop but change addresses so that each packet thread has distinct flows" },
+
     { "--pcap-loop", Parameter::PT_INT, "0:max32", nullptr,
       "<count> read all pcaps <count> times;  0 will read until Snort is terminated" },
 
@@ -884,6 +893,9 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( is(v, "--daq") )
         module_config = sc->daq_config->add_module_config(v.get_string());
 
+    else if ( is(v, "--daq-batch-latency") )
+        sc->daq_config->set_batch_latency(v.get_uint32());
+
     else if ( is(v, "--daq-batch-size") )
         sc->daq_config->set_batch_size(v.get_uint32());
 
@@ -1100,6 +1112,12 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( is(v, "--pcap-filter") )
         Trough::set_filter(v.get_string());
 
+    else if ( is(v, "--pcap-hot-loop") )
+        Trough::set_hot_loop(false);
+
+    else if ( is(v, "--pcap-hot-loop-rewrite") )
+        Trough::set_hot_loop(true);
+
     else if ( is(v, "--pcap-loop") )
         Trough::set_loop_count(v.get_uint32());
 
@@ -153,6 +153,8 @@ const char* SFDAQInstance::get_error() { return nullptr; }
 bool SFDAQInstance::interrupt() { return false; }
 int SFDAQInstance::inject(DAQ_Msg_h, int, const uint8_t*, uint32_t) { return -1; }
 DAQ_RecvStatus SFDAQInstance::receive_messages(unsigned) { return DAQ_RSTAT_ERROR; }
+uint32_t SFDAQInstance::get_recv_size() const { return 0; }
+void SFDAQInstance::batch_processed() { }
 int SFDAQInstance::ioctl(DAQ_IoctlCmd, void*, size_t) { return -4; }
 void SFDAQ::set_local_instance(SFDAQInstance*) { }
 const char* SFDAQ::verdict_to_string(DAQ_Verdict) { return nullptr; }
@@ -177,6 +179,7 @@ void DetectionEngine::disable_all(Packet*) { }
 unsigned get_instance_id() { return 0; }
 const SnortConfig* SnortConfig::get_conf() { return nullptr; }
 void SnortConfig::update_thread_reload_id() { }
+void SnortConfig::localize_scratch() const { }
 void PacketTracer::thread_init() { }
 void PacketTracer::thread_term() { }
 void PacketTracer::log(const char*, ...) { }
@@ -226,6 +229,7 @@ InspectionPolicy* get_inspection_policy() { return nullptr; }
 Flow::~Flow() = default;
 void ThreadConfig::implement_thread_affinity(SThreadType, unsigned) { }
 void ThreadConfig::apply_thread_policy(SThreadType , unsigned ) { }
+void ThreadConfig::apply_thread_mempolicy(SThreadType , unsigned ) { }
 void ThreadConfig::set_instance_tid(int) { }
 }
 
@@ -54,6 +54,9 @@ static std::map<int, int> instance_id_to_tid;
 std::shared_ptr<NumaWrapper> numa;
 std::shared_ptr<HwlocWrapper> hwloc;
 
+// node preferred for allocations by this thread, if any
+static THREAD_LOCAL int numa_node = -1;
+
 #endif
 
 struct CpuSet
@@ -224,9 +227,20 @@ void ThreadConfig::apply_thread_policy(SThreadType type, unsigned id)
 {
     implement_thread_affinity( type, id );
 
+    apply_thread_mempolicy( type, id );
+}
+
+void ThreadConfig::apply_thread_mempolicy(SThreadType type, unsigned id)
+{
 #ifdef HAVE_NUMA
 
-    implement_thread_mempolicy( type, id );
+    if ( numa_node < 0 )
+        implement_thread_mempolicy( type, id );
+
+#else
+
+    UNUSED(type);
+    UNUSED(id);
 
 #endif
 }
@@ -261,9 +275,66 @@ bool ThreadConfig::set_preferred_mempolicy(int node)
     if(numa->preferred() != node)
         return false;
 
+    numa_node = node;
     return true;
 }
 
+bool ThreadConfig::prefer_numa_node(int node)
+{
+    if ( !numa or numa->available() < 0 )
+        return false;
+
+    if ( node >= 0 )
+        return set_preferred_mempolicy(node);
+
+    if ( numa->set_mem_policy(MPOL_DEFAULT, nullptr, 0) )
+        return false;
+
+    numa_node = -1;
+    return true;
+}
+
+int ThreadConfig::get_numa_node()
+{ return numa_node; }
+
+int ThreadConfig::get_memory_node(const void* addr)
+{
+    if ( !numa or numa->available() < 0 )
+        return -1;
+
+    return numa->node_of(const_cast<void*>(addr));
+}
+
+int ThreadConfig::get_thread_numa_node(SThreadType type, unsigned id)
+{
+    if ( !topology_support->cpubind->set_thisthread_cpubind or
+        numa->available() < 0 or numa->max_node() <= 0 )
+    {
+        return -1;
+    }
+
+    auto iter = thread_affinity.find({ type, id });
+
+    if ( iter == thread_affinity.end() )
+        return -1;
+
+    return get_numa_node(topology, iter->second->cpuset);
+}
+
+unsigned ThreadConfig::get_numa_node_count() const
+{
+    if ( !numa or numa->available() < 0 or numa->max_node() <= 0 )
+        return 1;
+
+    // without pinned packet threads there is no local node to replicate for
+    for ( const auto& ta : thread_affinity )
+    {
+        if ( ta.first.type == STHREAD_TYPE_PACKET )
+            return numa->max_node() + 1;
+    }
+    return 1;
+}
+
 bool ThreadConfig::implement_thread_mempolicy(SThreadType type, unsigned id)
 {
     if (!topology_support->cpubind->set_thisthread_cpubind or
@@ -290,6 +361,23 @@ bool ThreadConfig::implement_thread_mempolicy(SThreadType type, unsigned id)
     return true;
 }
 
+#else
+
+bool ThreadConfig::prefer_numa_node(int)
+{ return false; }
+
+int ThreadConfig::get_numa_node()
+{ return -1; }
+
+int ThreadConfig::get_memory_node(const void*)
+{ return -1; }
+
+int ThreadConfig::get_thread_numa_node(SThreadType, unsigned)
+{ return -1; }
+
+unsigned ThreadConfig::get_numa_node_count() const
+{ return 1; }
+
 #endif
 
 void ThreadConfig::implement_thread_affinity(SThreadType type, unsigned id)
@@ -580,6 +668,7 @@ public:
     int max_n = 1;
     int pref = 0;
     int mem_policy = 0;
+    int mem_node = 0;
 
     int available() override { return numa_avail; }
     int max_node() override { return max_n; }
@@ -587,6 +676,7 @@ public:
     int set_mem_policy(int , const unsigned long *,
                               unsigned long ) override
     { return mem_policy; }
+    int node_of(void*) override { return mem_node; }
 };
 
 class HwlocWrapperMock : public HwlocWrapper
@@ -631,6 +721,44 @@ TEST_CASE("set node for thread", "[ThreadConfig]")
     CHECK(true == tc.implement_thread_mempolicy(STHREAD_TYPE_PACKET, 1));
 }
 
+TEST_CASE("prefer node for thread", "[ThreadConfig]")
+{
+    CpuSet* cpuset = new CpuSet(hwloc_bitmap_dup(process_cpuset));
+    ThreadConfig tc;
+
+    std::shared_ptr<NumaWrapperMock> numa_mock = std::make_shared<NumaWrapperMock>();
+    std::shared_ptr<HwlocWrapperMock> hwloc_mock = std::make_shared<HwlocWrapperMock>();
+
+    hwloc_mock->node.os_index = 1;
+    numa_mock->pref = 1;
+
+    numa = numa_mock;
+    hwloc = hwloc_mock;
+
+    CHECK(1 == tc.get_numa_node_count());
+    tc.set_thread_affinity(STHREAD_TYPE_PACKET, 0, cpuset);
+    CHECK(2 == tc.get_numa_node_count());
+
+    CHECK(1 == tc.get_thread_numa_node(STHREAD_TYPE_PACKET, 0));
+    CHECK(-1 == tc.get_thread_numa_node(STHREAD_TYPE_PACKET, 1));
+
+    CHECK(true == ThreadConfig::prefer_numa_node(1));
+    CHECK(1 == ThreadConfig::get_numa_node());
+
+    CHECK(true == ThreadConfig::prefer_numa_node(-1));
+    CHECK(-1 == ThreadConfig::get_numa_node());
+
+    numa_mock->mem_policy = -1;
+    CHECK(false == ThreadConfig::prefer_numa_node(1));
+    CHECK(-1 == ThreadConfig::get_numa_node());
+
+    numa_mock->mem_node = 1;
+    CHECK(1 == ThreadConfig::get_memory_node(&tc));
+
+    numa_mock->numa_avail = -1;
+    CHECK(-1 == ThreadConfig::get_memory_node(&tc));
+}
+
 TEST_CASE("numa_available negative test", "[ThreadConfig]")
 {
     CpuSet* cpuset = new CpuSet(hwloc_bitmap_dup(process_cpuset));
@@ -44,14 +44,31 @@ public:
     static void set_instance_tid(int);
     static int get_instance_tid(int);
 
+    // prefer the given node for allocations by the calling thread or
+    // restore the default policy if node < 0
+    static bool prefer_numa_node(int node);
+
+    // the node preferred by the calling thread or -1 if none
+    static int get_numa_node();
+
+    // the node holding the page at the given address or -1 if unknown
+    static int get_memory_node(const void*);
+
     ~ThreadConfig();
     void apply_thread_policy(SThreadType type, unsigned id);
+    void apply_thread_mempolicy(SThreadType type, unsigned id);
     void set_thread_affinity(SThreadType, unsigned id, CpuSet*);
     void set_named_thread_affinity(const std::string&, CpuSet*);
     void implement_thread_affinity(SThreadType, unsigned id);
     void implement_named_thread_affinity(const std::string& name);
     bool implement_thread_mempolicy(SThreadType type, unsigned id);
 
+    // the node local to the given thread's affinity or -1 if none
+    int get_thread_numa_node(SThreadType type, unsigned id);
+
+    // nodes packet threads may be placed on, 1 unless NUMA and pinned
+    unsigned get_numa_node_count() const;
+
     static constexpr unsigned int DEFAULT_THREAD_ID = 0;
 
 private:
@@ -74,7 +91,7 @@ private:
     std::map<TypeIdPair, CpuSet*, TypeIdPairComparer> thread_affinity;
     std::map<std::string, CpuSet*> named_thread_affinity;
 
-    bool set_preferred_mempolicy(int node);
+    static bool set_preferred_mempolicy(int node);
     int get_numa_node(hwloc_topology_t, hwloc_cpuset_t);
 };
 }
@@ -209,19 +209,35 @@ struct FrameworkConfig
     PHClassList clist;  // List of inspector module classes that have been configured
 };
 
+// the packet types that select inspectors by api.proto_bits alone; packets
+// of type NONE are checked against their own proto_bits instead
+#define PH_PKT_TYPES ((unsigned)PktType::MAX)
+
 struct PHVector
 {
     PHInstance** vec = nullptr;
     unsigned num = 0;
     unsigned total_num = 0;
 
+    // the enabled instances that handle each packet type, in vec order
+    PHInstance** type_vec = nullptr;
+    unsigned type_num[PH_PKT_TYPES] = { };
+    unsigned max = 0;
+
     PHVector() = default;
 
     ~PHVector()
-    { if ( vec ) delete[] vec; }
+    {
+        if ( vec ) delete[] vec;
+        if ( type_vec ) delete[] type_vec;
+    }
 
-    void alloc(unsigned max)
-    { vec = new PHInstance*[max]; }
+    void alloc(unsigned n)
+    {
+        max = n;
+        vec = new PHInstance*[max];
+        type_vec = new PHInstance*[max * PH_PKT_TYPES];
+    }
 
     void add(PHInstance* p)
     {
@@ -230,6 +246,13 @@ struct PHVector
     }
 
     void add_control(PHInstance*);
+    void build_dispatch();
+
+    PHInstance* const* get_vec(PktType type) const
+    { return type_vec + (unsigned)type * max; }
+
+    unsigned get_num(PktType type) const
+    { return type_num[(unsigned)type]; }
 };
 
 // FIXIT-L a more sophisticated approach to handling controls etc. may be
@@ -249,6 +272,23 @@ void PHVector::add_control(PHInstance* p)
     }
 }
 
+// done whenever num changes so packet dispatch needn't check proto_bits
+void PHVector::build_dispatch()
+{
+    for ( unsigned t = 1; t < PH_PKT_TYPES; ++t )
+    {
+        PHInstance** tv = type_vec + t * max;
+        unsigned n = 0;
+
+        for ( unsigned i = 0; i < num; ++i )
+        {
+            if ( BIT(t) & vec[i]->pp_class.api.proto_bits )
+                tv[n++] = vec[i];
+        }
+        type_num[t] = n;
+    }
+}
+
 struct InspectorList
 {
     virtual ~InspectorList();
@@ -454,6 +494,10 @@ void TrafficPolicy::vectorize(SnortConfig*)
             break;
         }
     }
+
+    packet.build_dispatch();
+    first.build_dispatch();
+    control.build_dispatch();
 }
 
 PHObjectList* TrafficPolicy::get_specific_handlers()
@@ -663,6 +707,9 @@ void GlobalInspectorPolicy::vectorize(SnortConfig*)
             break;
         }
     }
+
+    probe.build_dispatch();
+    control.build_dispatch();
 }
 
 PHInstance* GlobalInspectorPolicy::get_instance_by_type(const char* key, InspectorType type)
@@ -789,6 +836,9 @@ void FrameworkPolicy::vectorize(SnortConfig* sc)
         }
     }
 
+    packet.build_dispatch();
+    network.build_dispatch();
+
     // create cache
     inspector_cache_by_id.clear();
     inspector_cache_by_service.clear();
@@ -1911,6 +1961,7 @@ void InspectorManager::prepare_controls(SnortConfig* sc)
     // cppcheck-suppress constVariable
     for (auto* ph : g_disabled)
         gp->control.vec[g_c++] = ph;
+    gp->control.build_dispatch();
     for ( unsigned idx = 0; idx < sc->policy_map->network_policy_count(); ++idx )
     {
         TrafficPolicy* tp = sc->policy_map->get_network_policy(idx)->traffic_policy;
@@ -1927,6 +1978,7 @@ void InspectorManager::prepare_controls(SnortConfig* sc)
         // cppcheck-suppress constVariable
         for (auto* ph : disabled)
             tp->control.vec[c++] = ph;
+        tp->control.build_dispatch();
     }
 }
 
@@ -2026,14 +2078,6 @@ static inline void execute(
         if ( p->packet_flags & PKT_PASS_RULE )
             break;
 
-        const PHClass& ppc = (*prep)->pp_class;
-
-        // FIXIT-P these checks can eventually be optimized
-        // but they are required to ensure that session and app
-        // handlers aren't called w/o a session pointer
-        if ( !p->flow && (ppc.api.type == IT_SERVICE) )
-            break;
-
         const char* inspector_name = nullptr;
         if ( T )
         {
@@ -2043,15 +2087,7 @@ static inline void execute(
             timer.start();
         }
 
-        // FIXIT-L ideally we could eliminate PktType and just use
-        // proto_bits but things like teredo need to be fixed up.
-        if ( p->type() == PktType::NONE )
-        {
-            if ( p->proto_bits & ppc.api.proto_bits )
-                (*prep)->handler->eval(p);
-        }
-        else if ( BIT((unsigned)p->type()) & ppc.api.proto_bits )
-            (*prep)->handler->eval(p);
+        (*prep)->handler->eval(p);
 
         if ( T )
             trace_ulogf(snort_trace, TRACE_INSPECTOR_MANAGER, p,
@@ -2063,6 +2099,38 @@ static inline void execute(
     }
 }
 
+// FIXIT-L ideally we could eliminate PktType and just use
+// proto_bits but things like teredo need to be fixed up.
+static inline bool handles(const Packet* p, const PHInstance* ph)
+{
+    if ( p->type() == PktType::NONE )
+        return p->proto_bits & ph->pp_class.api.proto_bits;
+
+    return BIT((unsigned)p->type()) & ph->pp_class.api.proto_bits;
+}
+
+// typed packets walk the list prepared for their type by build_dispatch()
+template<bool T>
+static inline void execute(Packet* p, const PHVector& v, bool probe = false)
+{
+    if ( p->type() != PktType::NONE )
+    {
+        ::execute<T>(p, v.get_vec(p->type()), v.get_num(p->type()), probe);
+        return;
+    }
+
+    for ( unsigned i = 0; i < v.num; ++i )
+    {
+        if ( !handles(p, v.vec[i]) )
+            continue;
+
+        ::execute<T>(p, v.vec + i, 1, probe);
+
+        if ( (p->packet_flags & PKT_PASS_RULE) or (!probe && p->disable_inspect) )
+            return;
+    }
+}
+
 void InspectorManager::bumble(Packet* p)
 {
     Flow* flow = p->flow;
@@ -2144,7 +2212,7 @@ inline void InspectorManager::internal_execute(Packet* p)
     if ( !p->has_paf_payload() )
     {
         SingleInstanceInspectorPolicy* ft = sc->policy_map->get_flow_tracking();
-        if (ft->instance )
+        if ( ft->instance and handles(p, ft->instance) )
             ::execute<T>(p, &ft->instance, 1);
     }
 
@@ -2165,7 +2233,7 @@ inline void InspectorManager::internal_execute(Packet* p)
     assert(fp);
 
     if ( !p->is_cooked() )
-        ::execute<T>(p, fp->packet.vec, fp->packet.num);
+        ::execute<T>(p, fp->packet);
 
     if ( p->disable_inspect )
         return;
@@ -2174,7 +2242,7 @@ inline void InspectorManager::internal_execute(Packet* p)
     assert(tp);
 
     if ( !p->is_cooked() )
-        ::execute<T>(p, tp->packet.vec, tp->packet.num);
+        ::execute<T>(p, tp->packet);
 
     if ( p->disable_inspect )
         return;
@@ -2184,18 +2252,18 @@ inline void InspectorManager::internal_execute(Packet* p)
 
     if ( !p->flow )
     {
-        ::execute<T>(p, tp->first.vec, tp->first.num);
+        ::execute<T>(p, tp->first);
 
         if ( p->disable_inspect )
             return;
 
-        ::execute<T>(p, fp->network.vec, fp->network.num);
+        ::execute<T>(p, fp->network);
 
         if ( p->disable_inspect )
             return;
 
-        ::execute<T>(p, pp->control.vec, pp->control.num);
-        ::execute<T>(p, tp->control.vec, tp->control.num);
+        ::execute<T>(p, pp->control);
+        ::execute<T>(p, tp->control);
     }
     else
     {
@@ -2207,7 +2275,7 @@ inline void InspectorManager::internal_execute(Packet* p)
 
         if ( p->flow->reload_id != reload_id )
         {
-            ::execute<T>(p, tp->first.vec, tp->first.num);
+            ::execute<T>(p, tp->first);
 
             p->flow->reload_id = reload_id;
             if ( p->disable_inspect )
@@ -2215,7 +2283,7 @@ inline void InspectorManager::internal_execute(Packet* p)
         }
 
         if ( !p->flow->service )
-            ::execute<T>(p, fp->network.vec, fp->network.num);
+            ::execute<T>(p, fp->network);
 
         if ( p->disable_inspect )
             return;
@@ -2224,9 +2292,9 @@ inline void InspectorManager::internal_execute(Packet* p)
             full_inspection<T>(p);
 
         if ( !p->disable_inspect and !p->flow->is_inspection_disabled() )
-            ::execute<T>(p, pp->control.vec, pp->control.num);
+            ::execute<T>(p, pp->control);
         if ( !p->disable_inspect and !p->flow->is_inspection_disabled() )
-            ::execute<T>(p, tp->control.vec, tp->control.num);
+            ::execute<T>(p, tp->control);
     }
 
     if ( T )
@@ -2254,7 +2322,7 @@ void InspectorManager::probe(Packet* p)
     assert(pp);
 
     if ( !trace_enabled(snort_trace, TRACE_INSPECTOR_MANAGER, DEFAULT_TRACE_LOG_LEVEL, p) )
-        ::execute<false>(p, pp->probe.vec, pp->probe.num, true);
+        ::execute<false>(p, pp->probe, true);
     else
     {
         Stopwatch<SnortClock> timer;
@@ -2265,7 +2333,7 @@ void InspectorManager::probe(Packet* p)
 
         timer.start();
 
-        ::execute<true>(p, pp->probe.vec, pp->probe.num, true);
+        ::execute<true>(p, pp->probe, true);
 
         trace_ulogf(snort_trace, TRACE_INSPECTOR_MANAGER, p,
             "end inspection, %s, packet %" PRId64", context %" PRId64", total time: %" PRId64" usec\n",
@@ -0,0 +1,284 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <unordered_map>
+
+#include "catch/catch.hpp"
+
+#include "detection/ips_context.h"
+#include "framework/codec.h"
+#include "protocols/packet.h"
+
+#include "get_inspector_stubs.h"
+
+using namespace snort;
+
+static SnortConfig* s_conf = nullptr;
+
+bool Inspector::is_inactive() { return false; }
+
+NetworkPolicy* snort::get_network_policy()
+{ return s_conf->policy_map->get_network_policy(); }
+NetworkPolicy* PolicyMap::get_user_network(uint64_t) const
+{ return snort::get_network_policy(); }
+InspectionPolicy* snort::get_inspection_policy()
+{ return get_network_policy()->get_inspection_policy(); }
+InspectionPolicy* NetworkPolicy::get_user_inspection_policy(uint64_t) const
+{ return snort::get_inspection_policy(); }
+
+InspectionPolicy::InspectionPolicy(PolicyId)
+{ InspectorManager::new_policy(this, nullptr); }
+InspectionPolicy::~InspectionPolicy()
+{ InspectorManager::delete_policy(this, false); }
+NetworkPolicy::NetworkPolicy(PolicyId, PolicyId)
+{ InspectorManager::new_policy(this, nullptr); }
+NetworkPolicy::~NetworkPolicy()
+{
+    for ( auto p : inspection_policy )
+        delete p;
+
+    InspectorManager::delete_policy(this, false);
+    inspection_policy.clear();
+}
+PolicyMap::PolicyMap(PolicyMap*, const char*)
+{
+    empty_ips_policy = nullptr;
+    inspector_tinit_complete = nullptr;
+    file_id = InspectorManager::create_single_instance_inspector_policy();
+    flow_tracking = InspectorManager::create_single_instance_inspector_policy();
+    global_inspector_policy = InspectorManager::create_global_inspector_policy();
+    NetworkPolicy* np = new NetworkPolicy(network_policy.size(), 0);
+    network_policy.push_back(np);
+    InspectionPolicy* ip = new InspectionPolicy();
+    np->inspection_policy.push_back(ip);
+}
+PolicyMap::~PolicyMap()
+{
+    InspectorManager::destroy_single_instance_inspector(file_id);
+    InspectorManager::destroy_single_instance_inspector(flow_tracking);
+    InspectorManager::destroy_global_inspector_policy(global_inspector_policy, false);
+    for ( auto p : network_policy )
+        delete p;
+}
+SnortConfig::SnortConfig(const SnortConfig* const, const char*)
+{
+    policy_map = new PolicyMap();
+    InspectorManager::new_config(this);
+}
+SnortConfig::~SnortConfig()
+{
+    InspectorManager::delete_config(this);
+    delete policy_map;
+}
+const SnortConfig* SnortConfig::get_conf()
+{ return s_conf; }
+
+Module::Module(const char* name, const char*) : name(name), help(nullptr), params(nullptr), list(false)
+{ }
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+
+IpsContext::IpsContext(unsigned) { }
+IpsContext::~IpsContext() = default;
+
+class BenchInspector : public Inspector
+{
+public:
+    void eval(Packet*) override
+    { ++calls; }
+
+    unsigned calls = 0;
+};
+
+class BenchModule : public Module
+{
+public:
+    BenchModule(const char* name, Usage usage) : Module(name, ""), usage(usage)
+    { }
+
+    Usage get_usage() const override
+    { return usage; }
+
+    Usage usage;
+};
+
+// roughly the inspectors of a typical deployment: most handle a single
+// protocol, a few handle any IP packet, and services are never dispatched
+// per packet
+struct BenchEntry
+{
+    const char* name;
+    Module::Usage usage;
+    InspectorType type;
+    uint32_t proto_bits;
+};
+
+static const BenchEntry entries[] =
+{
+    { "arp_spoof", Module::Usage::CONTEXT, IT_PACKET, PROTO_BIT__ARP },
+    { "normalizer", Module::Usage::INSPECT, IT_PACKET, PROTO_BIT__ANY_IP },
+    { "packet_capture", Module::Usage::GLOBAL, IT_PROBE, PROTO_BIT__ANY_TYPE },
+    { "perf_monitor", Module::Usage::GLOBAL, IT_PROBE, PROTO_BIT__ALL },
+    { "port_scan", Module::Usage::GLOBAL, IT_PROBE, PROTO_BIT__ANY_IP },
+    { "reputation", Module::Usage::CONTEXT, IT_FIRST, PROTO_BIT__ANY_IP },
+    { "appid", Module::Usage::GLOBAL, IT_CONTROL, PROTO_BIT__ANY_IP },
+    { "rna", Module::Usage::CONTEXT, IT_CONTROL, PROTO_BIT__ANY_TYPE },
+    { "back_orifice", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__UDP },
+    { "dce_smb_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__TCP },
+    { "dnp3_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__TCP },
+    { "gtp_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__UDP },
+    { "icmp_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__ICMP },
+    { "ip_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__IP },
+    { "modbus_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__TCP },
+    { "s7comm_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__TCP },
+    { "iec104_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__TCP },
+    { "mms_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__TCP },
+    { "cip_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__TCP },
+    { "user_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__USER },
+    { "file_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__FILE },
+    { "pdu_net", Module::Usage::INSPECT, IT_NETWORK, PROTO_BIT__PDU },
+    { "dce_udp", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__UDP },
+    { "dns", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__ANY_PDU },
+    { "ftp_server", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "http_inspect", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "http2_inspect", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "imap", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "netflow", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__UDP },
+    { "pop", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "rpc_decode", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "sip", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__UDP | PROTO_BIT__PDU },
+    { "smtp", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "ssh", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "ssl", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "telnet", Module::Usage::INSPECT, IT_SERVICE, PROTO_BIT__PDU },
+    { "binder", Module::Usage::INSPECT, IT_PASSIVE, PROTO_BIT__NONE },
+    { "data_log", Module::Usage::INSPECT, IT_PASSIVE, PROTO_BIT__NONE },
+    { "stream", Module::Usage::GLOBAL, IT_STREAM, PROTO_BIT__ANY_SSN },
+    { "wizard", Module::Usage::INSPECT, IT_WIZARD, PROTO_BIT__PDU },
+};
+
+#define NUM_ENTRIES (sizeof(entries) / sizeof(entries[0]))
+
+static std::unordered_map<Module*, Inspector*> mod_to_ins;
+
+static Inspector* bench_ctor(Module* mod)
+{ return mod_to_ins[mod]; }
+
+static void bench_dtor(Inspector*)
+{ }
+
+TEST_CASE("inspector dispatch", "[InspectorManager]")
+{
+    BenchModule* mods[NUM_ENTRIES];
+    BenchInspector ins[NUM_ENTRIES];
+    InspectApi apis[NUM_ENTRIES];
+
+    for ( unsigned i = 0; i < NUM_ENTRIES; ++i )
+    {
+        mods[i] = new BenchModule(entries[i].name, entries[i].usage);
+        mod_to_ins[mods[i]] = &ins[i];
+
+        apis[i] = {};
+        apis[i].base.name = entries[i].name;
+        apis[i].type = entries[i].type;
+        apis[i].proto_bits = entries[i].proto_bits;
+        apis[i].ctor = bench_ctor;
+        apis[i].dtor = bench_dtor;
+        ins[i].set_api(&apis[i]);
+        InspectorManager::add_plugin(&apis[i]);
+    }
+
+    s_conf = new SnortConfig;
+
+    for ( unsigned i = 0; i < NUM_ENTRIES; ++i )
+        InspectorManager::instantiate(&apis[i], mods[i], s_conf, entries[i].name);
+
+    InspectorManager::configure(s_conf, false);
+    InspectorManager::prepare_controls(s_conf);
+
+    IpsContext context;
+    context.conf = s_conf;
+
+    Packet p(false);
+    p.context = &context;
+    p.flow = nullptr;
+    p.packet_flags = 0;
+    p.proto_bits = 0;
+    p.disable_inspect = false;
+
+    // only inspectors that handle the packet type are called
+    p.ptrs.set_pkt_type(PktType::UDP);
+    InspectorManager::execute(&p);
+
+    for ( unsigned i = 0; i < NUM_ENTRIES; ++i )
+    {
+        bool dispatched = entries[i].type != IT_SERVICE and entries[i].type != IT_PASSIVE
+            and entries[i].type != IT_PROBE and entries[i].type != IT_WIZARD;
+        bool called = dispatched and (entries[i].proto_bits & PROTO_BIT__UDP);
+        CHECK(ins[i].calls == (called ? 1u : 0u));
+    }
+
+    p.ptrs.set_pkt_type(PktType::TCP);
+    BENCHMARK("tcp")
+    {
+        InspectorManager::execute(&p);
+        return p.disable_inspect;
+    };
+
+    p.ptrs.set_pkt_type(PktType::UDP);
+    BENCHMARK("udp")
+    {
+        InspectorManager::execute(&p);
+        return p.disable_inspect;
+    };
+
+    p.ptrs.set_pkt_type(PktType::NONE);
+    p.proto_bits = PROTO_BIT__ARP;
+    BENCHMARK("arp")
+    {
+        InspectorManager::execute(&p);
+        return p.disable_inspect;
+    };
+
+    p.ptrs.set_pkt_type(PktType::TCP);
+    BENCHMARK("tcp probe")
+    {
+        InspectorManager::probe(&p);
+        return p.disable_inspect;
+    };
+
+    delete s_conf;
+    s_conf = nullptr;
+    InspectorManager::empty_trash();
+    InspectorManager::release_plugins();
+
+    for ( auto* m : mods )
+        delete m;
+
+    mod_to_ins.clear();
+}
+
+#endif
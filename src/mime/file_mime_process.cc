@@ -74,6 +74,8 @@ struct MIMESearchInfo
 static THREAD_LOCAL MIMESearchInfo mime_search_info;
 static THREAD_LOCAL MIMESearch* mime_current_search = nullptr;
 
+static unsigned mime_stash_key = 0;
+
 SearchTool* mime_hdr_search_mpse = nullptr;
 MIMESearch mime_hdr_search[HDR_LAST];
 
@@ -834,6 +836,7 @@ int MimeSession::extract_file_name(const char*& start, int length)
 void MimeSession::init()
 {
     MimeDecode::init();
+    mime_stash_key = FlowStash::get_key_id(STASH_EXTRADATA_MIME);
 
     mime_hdr_search_mpse = new SearchTool;
     for (const MimeToken* tmp = &mime_hdrs[0]; tmp->name != nullptr; tmp++)
@@ -861,7 +864,7 @@ MimeSession::MimeSession(Packet* p, const DecodeConfig* dconf, MailLogConfig* lc
     uri(uri),
     uri_length(uri_length)
 {
-    p->flow->stash->store(STASH_EXTRADATA_MIME, log_state);
+    p->flow->stash->store(mime_stash_key, log_state);
     reset_mime_paf_state(&mime_boundary);
 }
 
@@ -93,6 +93,7 @@ void AppIdConfig::show() const
     ConfigLogger::log_flag("tp_appid_config_dump", tp_appid_config_dump);
 
     ConfigLogger::log_flag("log_all_sessions", log_all_sessions);
+    ConfigLogger::log_flag("detector_timing", detector_timing);
     ConfigLogger::log_flag("log_stats", log_stats);
     ConfigLogger::log_value("memcap", memcap);
 }
@@ -210,6 +211,7 @@ void OdpContext::initialize(AppIdInspector& inspector)
     client_pattern_detector->finalize_client_port_patterns(inspector);
     service_disco_mgr.finalize_service_patterns();
     client_disco_mgr.finalize_client_patterns();
+    http_matchers.set_shared_url_mpse(shared_url_mpse);
     http_matchers.finalize_patterns();
     eve_ca_matchers.finalize_patterns();
     alpn_matchers.finalize_patterns();
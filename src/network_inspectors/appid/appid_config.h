@@ -103,6 +103,7 @@ public:
     bool list_odp_detectors = false;
     bool log_all_sessions = false;
     bool enable_rna_filter = false;
+    bool detector_timing = false;
     std::string rna_conf_path = "";
     SnortProtocolId snort_proto_ids[PROTO_INDEX_MAX] = {};
     void show() const;
@@ -137,6 +138,7 @@ public:
     uint16_t max_packet_service_fail_ignore_bytes = MIN_MAX_PKT_BEFORE_SERVICE_FAIL_IGNORE_BYTES;
     FirstPktAppIdDiscovered first_pkt_appid_prefix = NO_APPID_FOUND;
     bool eve_http_client = true;
+    bool shared_url_mpse = false;
 
     OdpContext(const AppIdConfig&, snort::SnortConfig*);
     void initialize(AppIdInspector& inspector);
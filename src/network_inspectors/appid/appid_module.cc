@@ -49,6 +49,7 @@
 #include "appid_debug.h"
 #include "appid_inspector.h"
 #include "appid_peg_counts.h"
+#include "lua_detector_module.h"
 #include "service_state.h"
 
 using namespace snort;
@@ -102,6 +103,8 @@ static const Parameter s_params[] =
       "enable logging of all appid sessions" },
     { "enable_rna_filter", Parameter::PT_BOOL, nullptr, "false",
       "monitor only the networks specified in rna configuration" },
+    { "detector_timing", Parameter::PT_BOOL, nullptr, "false",
+      "count and time the validate calls of each Lua detector" },
     { "rna_conf_path", Parameter::PT_STRING, nullptr, nullptr,
       "path to rna configuration file" },
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
@@ -471,6 +474,8 @@ static const PegInfo appid_pegs[] =
     { CountType::SUM, "tp_reload_ignored_pkts", "count of packets ignored after third-party module is reloaded" },
     { CountType::NOW, "bytes_in_use", "number of bytes in use in the cache" },
     { CountType::NOW, "items_in_use", "items in use in the cache" },
+    { CountType::SUM, "lua_detector_calls", "count of Lua detector validate calls" },
+    { CountType::SUM, "lua_detector_errors", "count of Lua detector validate calls that failed" },
     { CountType::END, nullptr, nullptr },
 };
 
@@ -552,6 +557,8 @@ bool AppIdModule::set(const char*, Value& v, SnortConfig*)
         config->log_all_sessions = v.get_bool();
     else if ( v.is("enable_rna_filter") )
         config->enable_rna_filter = v.get_bool();
+    else if ( v.is("detector_timing") )
+        config->detector_timing = v.get_bool();
     else if ( v.is("rna_conf_path") )
         config->rna_conf_path = std::string(v.get_string());
 
@@ -600,17 +607,20 @@ PegCount* AppIdModule::get_counts() const
 void AppIdModule::sum_stats(bool dump_stats)
 {
     AppIdPegCounts::sum_stats();
+    LuaDetectorManager::sum_stats();
     Module::sum_stats(dump_stats);
 }
 
 void AppIdModule::show_dynamic_stats()
 {
     AppIdPegCounts::print();
+    LuaDetectorManager::print_stats();
 }
 
 void AppIdModule::reset_stats()
 {
     AppIdPegCounts::cleanup_dynamic_sum();
+    LuaDetectorManager::reset_stats();
     Module::reset_stats();
 }
 
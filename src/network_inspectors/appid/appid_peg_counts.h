@@ -50,6 +50,8 @@ struct AppIdStats
     PegCount tp_reload_ignored_pkts;
     PegCount bytes_in_use;
     PegCount items_in_use;
+    PegCount lua_detector_calls;
+    PegCount lua_detector_errors;
 };
 
 class AppIdPegCounts
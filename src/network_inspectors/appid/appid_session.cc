@@ -54,6 +54,7 @@
 using namespace snort;
 
 unsigned AppIdSession::inspector_id = 0;
+unsigned AppIdSession::stash_key = 0;
 std::mutex AppIdSession::inferred_svcs_lock;
 uint16_t AppIdSession::inferred_svcs_ver = 0;
 
@@ -1166,7 +1167,7 @@ void AppIdSession::publish_appid_event(AppidChangeBits& change_bits, const Packe
     if (!api.flags.stored_in_stash)
     {
         assert(p.flow and p.flow->stash);
-        p.flow->stash->store(STASH_APPID_DATA, &api, false);
+        p.flow->stash->store(stash_key, &api, false);
         api.flags.stored_in_stash = true;
     }
 
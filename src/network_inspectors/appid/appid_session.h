@@ -313,9 +313,14 @@ public:
 
     bool in_expected_cache = false;
     static unsigned inspector_id;
+    static unsigned stash_key;
     static std::mutex inferred_svcs_lock;
 
-    static void init() { inspector_id = FlowData::create_flow_data_id(); }
+    static void init()
+    {
+        inspector_id = FlowData::create_flow_data_id();
+        stash_key = snort::FlowStash::get_key_id(STASH_APPID_DATA);
+    }
 
     void set_session_flags(uint64_t set_flags) { flags |= set_flags; }
     void clear_session_flags(uint64_t clear_flags) { flags &= ~clear_flags; }
@@ -25,6 +25,9 @@
 
 #include "sf_mlmp.h"
 
+#include <string>
+#include <vector>
+
 #include "search_engines/search_tool.h"
 #include "utils/util.h"
 
@@ -45,6 +48,9 @@ struct tPatternNode
     /**Unique non-zero identifier to tie parts of a multi-part patterns together. */
     uint32_t patternId;
 
+    /**Tree node this pattern was added to; used to filter matches of a shared MPSE. */
+    const tMlmpTree* owner;
+
     tPatternNode* nextPattern;
 };
 
@@ -64,6 +70,9 @@ struct tMlmpTree
     SearchTool* patternTree;
     tPatternPrimaryNode* patternList;
     uint32_t level;
+
+    /*all levels use the SearchTool owned by the level 0 node */
+    bool sharedMpse;
 };
 
 /*Used to track matched patterns. */
@@ -75,8 +84,15 @@ struct tMatchedPatternList
     tMatchedPatternList* next;
 };
 
+/*Match of a shared MPSE scan over the input of all levels. */
+struct tSharedMatch
+{
+    tPatternNode* patternNode;
+    size_t match_end_pos;
+};
+
 static int compareMlmpPatterns(const void* p1, const void* p2);
-static int createTreesRecusively(tMlmpTree* root);
+static int createTreesRecusively(tMlmpTree* root, SearchTool* sharedMatcher);
 static void destroyTreesRecursively(tMlmpTree* root);
 static int addPatternRecursively(tMlmpTree* root, const tMlmpPattern* inputPatternList,
     void* metaData, uint32_t level);
@@ -86,15 +102,22 @@ static tPatternNode* genericPatternSelector(const tMatchedPatternList* matchList
     uint8_t* payload);
 static void* mlmpMatchPatternCustom(tMlmpTree* root, tMlmpPattern* inputPatternList,
     tPatternNode* (*callback)(const tMatchedPatternList*, const uint8_t*));
+static void* mlmpMatchPatternShared(tMlmpTree* root, const tMlmpPattern* inputPatternList,
+    tPatternNode* (*callback)(const tMatchedPatternList*, const uint8_t*));
+static void addMatch(tMatchedPatternList** matchList, tPatternNode* target, size_t match_start_pos);
+static void freeMatches(tMatchedPatternList* matchList);
 static int patternMatcherCallback(void* id, void* unused_tree, int match_end_pos, void* data,
     void* unused_neg);
+static int sharedMatcherCallback(void* id, void* unused_tree, int match_end_pos, void* data,
+    void* unused_neg);
 
 static uint32_t gPatternId = 1;
 
-tMlmpTree* mlmpCreate()
+tMlmpTree* mlmpCreate(bool shared_mpse)
 {
     tMlmpTree* root = (tMlmpTree*)snort_calloc(sizeof(tMlmpTree));
     root->level = 0;
+    root->sharedMpse = shared_mpse;
     return root;
 }
 
@@ -108,7 +131,16 @@ int mlmpProcessPatterns(tMlmpTree* root)
 {
     int rvalue;
 
-    rvalue = createTreesRecusively(root);
+    if (root->sharedMpse)
+    {
+        root->patternTree = new SearchTool;
+        rvalue = createTreesRecusively(root, root->patternTree);
+        if (!rvalue)
+            root->patternTree->prep();
+    }
+    else
+        rvalue = createTreesRecusively(root, nullptr);
+
     if (rvalue)
         destroyTreesRecursively(root);
     return rvalue;
@@ -152,17 +184,14 @@ static void* mlmpMatchPatternCustom(tMlmpTree* rootNode, tMlmpPattern* inputPatt
     if (!rootNode || !pattern || !pattern->pattern)
         return nullptr;
 
+    if (rootNode->sharedMpse)
+        return mlmpMatchPatternShared(rootNode, inputPatternList, callback);
+
     rootNode->patternTree->find_all((const char*)pattern->pattern, pattern->patternSize,
         patternMatcherCallback, false, (void*)&mp);
 
     primaryNode = (tPatternPrimaryNode*)callback(mp, pattern->pattern);
-
-    while (mp)
-    {
-        tMatchedPatternList* tmpMp = mp;
-        mp = mp->next;
-        snort_free(tmpMp);
-    }
+    freeMatches(mp);
 
     if (primaryNode)
     {
@@ -176,6 +205,60 @@ static void* mlmpMatchPatternCustom(tMlmpTree* rootNode, tMlmpPattern* inputPatt
     return data;
 }
 
+/*the shared MPSE has the patterns of all levels so the inputs of all levels are
+  scanned at once; each level then keeps the matches of the node being evaluated
+  that lie within its own input. */
+static void* mlmpMatchPatternShared(tMlmpTree* rootNode, const tMlmpPattern* inputPatternList,
+    tPatternNode* (*callback)(const tMatchedPatternList*, const uint8_t*))
+{
+    std::string input;
+    std::vector<size_t> starts;
+    const tMlmpPattern* pattern;
+
+    for (pattern = inputPatternList; pattern->pattern; pattern++)
+    {
+        starts.emplace_back(input.size());
+        input.append((const char*)pattern->pattern, pattern->patternSize);
+    }
+    starts.emplace_back(input.size());
+
+    std::vector<tSharedMatch> matches;
+    rootNode->patternTree->find_all(input.data(), input.size(), sharedMatcherCallback, false,
+        (void*)&matches);
+
+    void* data = nullptr;
+    tMlmpTree* node = rootNode;
+
+    for (size_t level = 0; node and level + 1 < starts.size(); level++)
+    {
+        tMatchedPatternList* mp = nullptr;
+
+        for (const auto& m : matches)
+        {
+            size_t size = m.patternNode->pattern.patternSize;
+
+            if (m.patternNode->owner == node and m.match_end_pos - size >= starts[level]
+                and m.match_end_pos <= starts[level+1])
+                addMatch(&mp, m.patternNode, m.match_end_pos - size - starts[level]);
+        }
+
+        tPatternPrimaryNode* primaryNode =
+            (tPatternPrimaryNode*)callback(mp, inputPatternList[level].pattern);
+        freeMatches(mp);
+
+        if (!primaryNode)
+            break;
+
+        /*the deepest level with data wins */
+        if (primaryNode->patternNode.userData)
+            data = primaryNode->patternNode.userData;
+
+        node = primaryNode->nextLevelMatcher;
+    }
+
+    return data;
+}
+
 void mlmpDestroy(tMlmpTree* root)
 {
     destroyTreesRecursively(root);
@@ -203,15 +286,19 @@ static int compareMlmpPatterns(const void* p1, const void* p2)
 }
 
 /*pattern trees are not freed on error because in case of error, caller should call
-   detroyTreesRecursively. */
-static int createTreesRecusively(tMlmpTree* rootNode)
+   detroyTreesRecursively. When sharedMatcher is given, patterns of all levels are
+   added to it and the caller preps it once. */
+static int createTreesRecusively(tMlmpTree* rootNode, SearchTool* sharedMatcher)
 {
     SearchTool* patternMatcher;
     tPatternPrimaryNode* primaryPatternNode;
     tPatternNode* ddPatternNode;
 
     /* set up the MPSE for url patterns */
-    patternMatcher = rootNode->patternTree = new SearchTool;
+    if (sharedMatcher)
+        patternMatcher = rootNode->patternTree = sharedMatcher;
+    else
+        patternMatcher = rootNode->patternTree = new SearchTool;
 
     for (primaryPatternNode = rootNode->patternList;
         primaryPatternNode;
@@ -220,7 +307,7 @@ static int createTreesRecusively(tMlmpTree* rootNode)
         /*recursion into next lower level */
         if (primaryPatternNode->nextLevelMatcher)
         {
-            if (createTreesRecusively(primaryPatternNode->nextLevelMatcher))
+            if (createTreesRecusively(primaryPatternNode->nextLevelMatcher, sharedMatcher))
                 return -1;
         }
 
@@ -233,7 +320,8 @@ static int createTreesRecusively(tMlmpTree* rootNode)
         }
     }
 
-    patternMatcher->prep();
+    if (!sharedMatcher)
+        patternMatcher->prep();
 
     return 0;
 }
@@ -264,7 +352,9 @@ static void destroyTreesRecursively(tMlmpTree* rootNode)
         snort_free(primaryPatternNode);
     }
 
-    delete rootNode->patternTree;
+    /*a shared MPSE belongs to the level 0 node */
+    if (!rootNode->sharedMpse or !rootNode->level)
+        delete rootNode->patternTree;
     snort_free(rootNode);
 }
 
@@ -351,6 +441,31 @@ static int patternMatcherCallback(void* id, void*, int match_end_pos, void* data
 {
     tPatternNode* target = (tPatternNode*)id;
     tMatchedPatternList** matchList = (tMatchedPatternList**)data;
+
+    addMatch(matchList, target, match_end_pos - target->pattern.patternSize);
+    return 0;
+}
+
+static int sharedMatcherCallback(void* id, void*, int match_end_pos, void* data, void*)
+{
+    std::vector<tSharedMatch>* matches = (std::vector<tSharedMatch>*)data;
+
+    matches->push_back({ (tPatternNode*)id, (size_t)match_end_pos });
+    return 0;
+}
+
+static void freeMatches(tMatchedPatternList* matchList)
+{
+    while (matchList)
+    {
+        tMatchedPatternList* tmpList = matchList;
+        matchList = matchList->next;
+        snort_free(tmpList);
+    }
+}
+
+static void addMatch(tMatchedPatternList** matchList, tPatternNode* target, size_t match_start_pos)
+{
     tMatchedPatternList* prevNode;
     tMatchedPatternList* tmpList;
     tMatchedPatternList* newNode;
@@ -365,12 +480,12 @@ static int patternMatcherCallback(void* id, void*, int match_end_pos, void* data
         if (cmp > 0 )
             continue;
         if (cmp == 0)
-            return 0;
+            return;
         break;
     }
 
     newNode = (tMatchedPatternList*)snort_calloc(sizeof(tMatchedPatternList));
-    newNode->match_start_pos = match_end_pos - target->pattern.patternSize;
+    newNode->match_start_pos = match_start_pos;
     newNode->patternNode = target;
 
     if (prevNode == nullptr)
@@ -384,8 +499,6 @@ static int patternMatcherCallback(void* id, void*, int match_end_pos, void* data
         newNode->next = prevNode->next;
         prevNode->next = newNode;
     }
-
-    return 0;
 }
 
 /*find a match and insertion point if no match is found. Insertion point nullptr means */
@@ -488,6 +601,7 @@ static int addPatternRecursively(tMlmpTree* rootNode, const tMlmpPattern* inputP
         tmpPrimaryNode->patternNode.partNum = 1;
         tmpPrimaryNode->patternNode.partTotal = partTotal;
         tmpPrimaryNode->patternNode.patternId = patternId;
+        tmpPrimaryNode->patternNode.owner = rootNode;
 
         if (prevPrimaryPatternNode)
         {
@@ -515,6 +629,7 @@ static int addPatternRecursively(tMlmpTree* rootNode, const tMlmpPattern* inputP
             newNode->partNum = partNum;
             newNode->partTotal = partTotal;
             newNode->patternId = patternId;
+            newNode->owner = rootNode;
             if (partNum < partTotal)
                 newNode->nextPattern = newNode+1;
             else
@@ -548,6 +663,7 @@ static int addPatternRecursively(tMlmpTree* rootNode, const tMlmpPattern* inputP
                 tmpRootNode = (tMlmpTree*)snort_calloc(sizeof(tMlmpTree));
                 primaryNode->nextLevelMatcher = tmpRootNode;
                 primaryNode->nextLevelMatcher->level = rootNode->level+1;
+                primaryNode->nextLevelMatcher->sharedMpse = rootNode->sharedMpse;
             }
             addPatternRecursively(primaryNode->nextLevelMatcher, inputPatternList+partTotal,
                 metaData, level+1);
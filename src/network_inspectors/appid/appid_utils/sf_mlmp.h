@@ -45,7 +45,13 @@ struct tMlmpPattern
 
 struct tMlmpTree;
 
-tMlmpTree* mlmpCreate();
+// With shared_mpse all levels and all nodes of the tree are added to a single
+// SearchTool owned by the root. The inputs of all levels are scanned at once
+// and each level keeps only the matches within its input of patterns that
+// belong to the node being evaluated. This trades some extra candidate
+// matches for one search engine instance and one scan instead of one per
+// node and level.
+tMlmpTree* mlmpCreate(bool shared_mpse = false);
 int mlmpAddPattern(tMlmpTree*, const tMlmpPattern*, void* metaData);
 int mlmpProcessPatterns(tMlmpTree*);
 void mlmp_reload_patterns(tMlmpTree&);
@@ -0,0 +1,243 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// sf_mlmp_test.cc - multi-level matching with shared and per-node MPSEs
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/appid_utils/sf_mlmp.cc"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//--------------------------------------------------------------------------
+// a brute force SearchTool that remembers what each instance was given
+//--------------------------------------------------------------------------
+
+struct ToolPattern
+{
+    std::string pattern;
+    void* context;
+};
+
+static std::map<const SearchTool*, std::vector<ToolPattern>> tools;
+static unsigned tools_created = 0;
+static unsigned tools_prepped = 0;
+static unsigned tools_scanned = 0;
+
+SearchTool::SearchTool(bool, const char*)
+{
+    tools[this];
+    ++tools_created;
+}
+
+SearchTool::~SearchTool()
+{ tools.erase(this); }
+
+void SearchTool::add(const uint8_t* pattern, unsigned len, void* context, bool, bool)
+{ tools[this].push_back({ std::string((const char*)pattern, len), context }); }
+
+void SearchTool::prep()
+{ ++tools_prepped; }
+
+void SearchTool::reload() { }
+
+int SearchTool::find_all(
+    const char* s, unsigned len, MpseMatch match, bool, void* data, const SnortConfig*)
+{
+    ++tools_scanned;
+
+    for ( const auto& p : tools[this] )
+    {
+        for ( unsigned i = 0; i + p.pattern.size() <= len; ++i )
+        {
+            if ( !strncasecmp(s + i, p.pattern.c_str(), p.pattern.size()) )
+                match(p.context, nullptr, i + p.pattern.size(), data, nullptr);
+        }
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+static const uint8_t* copy(const char* s)
+{
+    size_t len = strlen(s);
+    uint8_t* p = (uint8_t*)snort_calloc(len + 1);
+    memcpy(p, s, len);
+    return p;
+}
+
+// each part is at its own level, like the host and path of a URL pattern
+static void add(tMlmpTree* tree, const std::vector<const char*>& parts, const char* data)
+{
+    std::vector<tMlmpPattern> patterns;
+
+    for ( const char* s : parts )
+        patterns.push_back({ copy(s), strlen(s), (uint32_t)patterns.size() });
+
+    patterns.push_back({ nullptr, 0, 0 });
+
+    CHECK_EQUAL(0, mlmpAddPattern(tree, patterns.data(), (void*)data));
+}
+
+static const char* match(tMlmpTree* tree, const char* host, const char* path)
+{
+    tMlmpPattern patterns[3] =
+    {
+        { (const uint8_t*)host, strlen(host), 0 },
+        { (const uint8_t*)path, strlen(path), 1 },
+        { nullptr, 0, 0 }
+    };
+    return (const char*)mlmpMatchPatternUrl(tree, patterns);
+}
+
+static tMlmpTree* build(bool shared)
+{
+    tMlmpTree* tree = mlmpCreate(shared);
+
+    // two hosts with a path group of their own and one path in common
+    add(tree, { "a.com" }, "a");
+    add(tree, { "a.com", "/x" }, "a/x");
+    add(tree, { "a.com", "/y" }, "a/y");
+    add(tree, { "b.com" }, "b");
+    add(tree, { "b.com", "/x" }, "b/x");
+    add(tree, { "b.com", "/z" }, "b/z");
+    add(tree, { "c.com" }, "c");
+
+    CHECK_EQUAL(0, mlmpProcessPatterns(tree));
+    return tree;
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(sf_mlmp)
+{
+    void setup() override
+    {
+        tools_created = 0;
+        tools_prepped = 0;
+        tools_scanned = 0;
+    }
+
+    void teardown() override
+    {
+        CHECK(tools.empty());
+    }
+};
+
+TEST(sf_mlmp, shared_mpse)
+{
+    tMlmpTree* tree = build(true);
+
+    // every level of every host uses the one engine and it's prepped once
+    CHECK_EQUAL(1u, tools_created);
+    CHECK_EQUAL(1u, tools_prepped);
+    CHECK_EQUAL(1u, tools.size());
+    CHECK_EQUAL(7u, tools.begin()->second.size());
+
+    mlmpDestroy(tree);
+}
+
+TEST(sf_mlmp, per_node_mpse)
+{
+    tMlmpTree* tree = build(false);
+
+    // hosts with their own path groups get their own engines
+    CHECK_EQUAL(3u, tools_created);
+    CHECK_EQUAL(3u, tools_prepped);
+
+    std::vector<size_t> sizes;
+    for ( const auto& t : tools )
+        sizes.push_back(t.second.size());
+
+    std::sort(sizes.begin(), sizes.end());
+    CHECK_EQUAL(2u, sizes[0]);
+    CHECK_EQUAL(2u, sizes[1]);
+    CHECK_EQUAL(3u, sizes[2]);
+
+    mlmpDestroy(tree);
+}
+
+TEST(sf_mlmp, same_matches)
+{
+    tMlmpTree* shared = build(true);
+    tMlmpTree* per_node = build(false);
+
+    // a.co with m/x or a.com/ with x would match across levels if scanned together
+    const char* const hosts[] = { "a.com", "www.a.com", "xa.com", "b.com", "c.com", "d.com",
+        "a.co", "a.com/" };
+    const char* const paths[] = { "/", "/x", "/y", "/z", "/x/y/z", "m/x", "x" };
+
+    for ( auto h : hosts )
+    {
+        for ( auto p : paths )
+        {
+            const char* s = match(shared, h, p);
+            const char* n = match(per_node, h, p);
+            STRCMP_EQUAL(n ? n : "none", s ? s : "none");
+        }
+    }
+
+    // a path matches only within its host's group
+    STRCMP_EQUAL("a/y", match(shared, "www.a.com", "/y"));
+    STRCMP_EQUAL("b", match(shared, "b.com", "/y"));
+    STRCMP_EQUAL("b/z", match(shared, "b.com", "/z"));
+    STRCMP_EQUAL("a", match(shared, "a.com", "/z"));
+    STRCMP_EQUAL("c", match(shared, "c.com", "/x"));
+
+    // and a host only at a domain boundary
+    CHECK(!match(shared, "xa.com", "/x"));
+    CHECK(!match(shared, "d.com", "/x"));
+
+    mlmpDestroy(shared);
+    mlmpDestroy(per_node);
+}
+
+TEST(sf_mlmp, shared_scans_once)
+{
+    tMlmpTree* shared = build(true);
+    tMlmpTree* per_node = build(false);
+
+    tools_scanned = 0;
+    STRCMP_EQUAL("a/x", match(shared, "a.com", "/x"));
+    CHECK_EQUAL(1u, tools_scanned);
+
+    tools_scanned = 0;
+    STRCMP_EQUAL("a/x", match(per_node, "a.com", "/x"));
+    CHECK_EQUAL(2u, tools_scanned);
+
+    mlmpDestroy(shared);
+    mlmpDestroy(per_node);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -642,10 +642,10 @@ static int http_pattern_match(void* id, void*, int match_end_pos, void* data, vo
 int HttpPatternMatchers::process_host_patterns(DetectorHTTPPatterns& patterns)
 {
     if (!host_url_matcher)
-        host_url_matcher = mlmpCreate();
+        host_url_matcher = mlmpCreate(shared_url_mpse);
 
     if (!rtmp_host_url_matcher)
-        rtmp_host_url_matcher = mlmpCreate();
+        rtmp_host_url_matcher = mlmpCreate(shared_url_mpse);
 
     for (auto& pat : patterns)
     {
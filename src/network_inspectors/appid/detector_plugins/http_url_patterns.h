@@ -311,6 +311,9 @@ public:
     uint32_t parse_multiple_http_patterns(const char* pattern, tMlmpPattern*,
         uint32_t numPartLimit, int level);
 
+    void set_shared_url_mpse(bool enable)
+    { shared_url_mpse = enable; }
+
 private:
     DetectorHTTPPatterns client_agent_patterns;
     DetectorHTTPPatterns content_type_patterns;
@@ -330,6 +333,7 @@ private:
     tMlmpTree* host_url_matcher = nullptr;
     tMlmpTree* rtmp_host_url_matcher = nullptr;
     unsigned chp_pattern_count = 0;
+    bool shared_url_mpse = false;
 
     void free_chp_app_elements();
     int add_mlmp_pattern(tMlmpTree* matcher, DetectorHTTPPattern& pattern );
@@ -37,6 +37,7 @@
 #include "managers/mpse_manager.h"
 #include "profiler/profiler.h"
 #include "protocols/packet.h"
+#include "time/stopwatch.h"
 #include "trace/trace_api.h"
 
 #include "app_info_table.h"
@@ -564,7 +565,7 @@ static int service_set_validator(lua_State* L)
     }
 
     lua_pop(L, 1);
-    ud->lsd.package_info.validateFunctionName = pValidator;
+    ud->lsd.set_validate_function(L, pValidator);
     lua_pushnumber(L, 0);
     return 1;
 }
@@ -3363,6 +3364,45 @@ int register_detector(lua_State* L)
     return 1;                         /* return methods on the stack */
 }
 
+void LuaStateDescriptor::set_validate_function(lua_State* L, const char* name)
+{
+    if (validate_ref)
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, validate_ref);
+        validate_ref = 0;
+    }
+    package_info.validateFunctionName = name;
+}
+
+// Leaves the validate function of this detector on the stack. The function is
+// looked up in the detector environment once and then kept in the registry so
+// that each call is a single indexed fetch instead of two string lookups.
+bool LuaStateDescriptor::push_validate_function(lua_State* L)
+{
+    if (validate_ref)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, validate_ref);
+        return true;
+    }
+
+    const char* validateFn = package_info.validateFunctionName.c_str();
+
+    if ((!validateFn) or (validateFn[0] == '\0'))
+        return false;
+
+    // get the table for this chunk (env) and the function we want to call
+    lua_getfield(L, LUA_REGISTRYINDEX, package_info.name.c_str());
+    lua_getfield(L, -1, validateFn);
+
+    // anything else is left for lua_pcall to report
+    if (lua_isfunction(L, -1))
+    {
+        lua_pushvalue(L, -1);
+        validate_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    return true;
+}
+
 int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
 {
     LuaDetectorManager& lua_detector_mgr = odp_thread_local_ctxt->get_lua_detector_mgr();
@@ -3374,32 +3414,37 @@ int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
         return APPID_ENULL;
     }
 
-    // get the table for this chunk (env)
-    lua_getfield(my_lua_state, LUA_REGISTRYINDEX, package_info.name.c_str());
-    ldp.data = args.data;
-    ldp.size = args.size;
-    ldp.dir = args.dir;
-    ldp.asd = &args.asd;
-    ldp.change_bits = &args.change_bits;
-    ldp.pkt = args.pkt;
-    const char* validateFn = package_info.validateFunctionName.c_str();
+    ldp.init(args);
 
-    if ((!validateFn) or (validateFn[0] == '\0'))
+    if (!push_validate_function(my_lua_state))
     {
         ldp.pkt = nullptr;
         lua_settop(my_lua_state, 0);
         return APPID_NOMATCH;
     }
 
-    lua_getfield(my_lua_state, -1, validateFn); // get the function we want to call
+    Stopwatch<SnortClock> timer;
+    bool timed = lua_detector_mgr.is_timing_enabled();
 
-    if (lua_pcall(my_lua_state, 0, 1, 0))
+    if (timed)
+        timer.start();
+
+    int status = lua_pcall(my_lua_state, 0, 1, 0);
+
+    if (timed)
+        stats.elapsed += timer.get();
+    stats.calls++;
+    appid_stats.lua_detector_calls++;
+
+    if (status)
     {
         // Runtime Lua errors are suppressed in production code since detectors are written for
         // efficiency and with defensive minimum checks. Errors are dealt as exceptions
         // that don't impact processing by other detectors or future packets by the same detector.
         appid_log(args.pkt, TRACE_ERROR_LEVEL, "lua detector %s: error validating %s\n",
             package_info.name.c_str(), lua_tostring(my_lua_state, -1));
+        stats.errors++;
+        appid_stats.lua_detector_errors++;
         ldp.pkt = nullptr;
         lua_detector_mgr.free_detector_flow();
         lua_settop(my_lua_state, 0);
@@ -3415,6 +3460,8 @@ int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
     {
         appid_log(args.pkt, TRACE_ERROR_LEVEL, "lua detector %s: returned non-numeric value\n",
             package_info.name.c_str());
+        stats.errors++;
+        appid_stats.lua_detector_errors++;
         ldp.pkt = nullptr;
         lua_settop(my_lua_state, 0);
         return APPID_ENULL;
@@ -3505,11 +3552,15 @@ LuaServiceObject::LuaServiceObject(AppIdDiscovery* sdm, const std::string& detec
 
 int LuaServiceDetector::validate(AppIdDiscoveryArgs& args)
 {
-    auto my_lua_state = odp_thread_local_ctxt->get_lua_detector_mgr().L;
+    LuaDetectorManager& lua_detector_mgr = odp_thread_local_ctxt->get_lua_detector_mgr();
+    auto my_lua_state = lua_detector_mgr.L;
     if (lua_gettop(my_lua_state))
     appid_log(args.pkt, TRACE_WARNING_LEVEL, "appid: leak of %d lua stack elements before service validate\n",
         lua_gettop(my_lua_state));
 
+    if (LuaObject* lo = lua_detector_mgr.get_lua_object(this))
+        return lo->lsd.lua_validate(args);
+
     std::string name = this->name + "_";
     lua_getglobal(my_lua_state, name.c_str());
     auto& ud = *UserData<LuaServiceObject>::check(my_lua_state, DETECTOR, 1);
@@ -3581,11 +3632,15 @@ LuaStateDescriptor* LuaObject::validate_lua_state(bool packet_context)
 
 int LuaClientDetector::validate(AppIdDiscoveryArgs& args)
 {
-    auto my_lua_state = odp_thread_local_ctxt->get_lua_detector_mgr().L;
+    LuaDetectorManager& lua_detector_mgr = odp_thread_local_ctxt->get_lua_detector_mgr();
+    auto my_lua_state = lua_detector_mgr.L;
     if (lua_gettop(my_lua_state))
         appid_log(args.pkt, TRACE_WARNING_LEVEL, "appid: leak of %d lua stack elements before client validate\n",
             lua_gettop(my_lua_state));
 
+    if (LuaObject* lo = lua_detector_mgr.get_lua_object(this))
+        return lo->lsd.lua_validate(args);
+
     std::string name = this->name + "_";
     lua_getglobal(my_lua_state, name.c_str());
     auto& ud = *UserData<LuaClientObject>::check(my_lua_state, DETECTOR, 1);
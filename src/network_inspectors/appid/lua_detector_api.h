@@ -29,7 +29,9 @@
 
 #include "appid_types.h"
 #include "client_plugins/client_detector.h"
+#include "framework/counts.h"
 #include "service_plugins/service_detector.h"
+#include "time/clock_defs.h"
 
 namespace snort
 {
@@ -74,13 +76,31 @@ struct LuaDetectorParameters
     const snort::Packet* pkt = nullptr;
 };
 
+// validate calls of one detector in one packet thread, see appid.detector_timing;
+// totals over all detectors are the lua_detector_calls and lua_detector_errors pegs
+struct LuaDetectorStats
+{
+    PegCount calls = 0;
+    PegCount errors = 0;
+    hr_duration elapsed { };
+};
+
 class LuaStateDescriptor
 {
 public:
     LuaDetectorParameters ldp;
     DetectorPackageInfo package_info;
     AppId service_id = APP_ID_UNKNOWN;
+    LuaDetectorStats stats;
     int lua_validate(AppIdDiscoveryArgs&);
+    void set_validate_function(lua_State*, const char*);
+
+private:
+    bool push_validate_function(lua_State*);
+
+    // registry reference to the validate function in the state owning this
+    // descriptor; luaL_ref never returns 0 so it means not resolved yet
+    int validate_ref = 0;
 };
 
 class LuaServiceDetector : public ServiceDetector
@@ -28,11 +28,14 @@
 #include <glob.h>
 #include <libgen.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <fstream>
+#include <mutex>
 
 #include "log/messages.h"
+#include "utils/stats.h"
 
 #include "appid_config.h"
 #include "appid_debug.h"
@@ -56,6 +59,9 @@ using namespace std;
 static vector<LuaDetectorManager*> lua_detector_mgr_list;
 static unordered_set<string> lua_detectors_w_validate;
 
+static map<string, LuaDetectorStats> lua_detector_stats_sum;
+static mutex lua_detector_stats_mutex;
+
 bool get_lua_field(lua_State* L, int table, const char* field, string& out)
 {
     lua_getfield(L, table, field);
@@ -183,6 +189,7 @@ LuaDetectorManager::LuaDetectorManager(AppIdContext& ctxt, bool is_control) :
 {
     allocated_objects.clear();
     cb_detectors.clear();
+    timing_enabled = ctxt.config.detector_timing;
     L = create_lua_state(ctxt.config, is_control);
     if (is_control)
         init_chp_glossary();
@@ -225,6 +232,7 @@ LuaDetectorManager::~LuaDetectorManager()
     if (detector_flow)
         free_detector_flow();
     allocated_objects.clear();
+    lua_objects.clear();
     cb_detectors.clear(); // do not free Lua objects in cb_detectors
 }
 
@@ -282,6 +290,79 @@ void LuaDetectorManager::clear_lua_detector_mgrs()
     lua_detector_mgr_list.clear();
 }
 
+void LuaDetectorManager::sum_stats()
+{
+    if (!odp_thread_local_ctxt)
+        return;
+
+    LuaDetectorManager& mgr = odp_thread_local_ctxt->get_lua_detector_mgr();
+    const lock_guard<mutex> lock(lua_detector_stats_mutex);
+
+    for (auto lua_object : mgr.allocated_objects)
+    {
+        LuaStateDescriptor& lsd = lua_object->lsd;
+
+        if (!lsd.stats.calls)
+            continue;
+
+        LuaDetectorStats& sum = lua_detector_stats_sum[lsd.package_info.name];
+        sum.calls += lsd.stats.calls;
+        sum.errors += lsd.stats.errors;
+        sum.elapsed += lsd.stats.elapsed;
+        lsd.stats = LuaDetectorStats();
+    }
+}
+
+void LuaDetectorManager::print_stats()
+{
+    const lock_guard<mutex> lock(lua_detector_stats_mutex);
+
+    if (lua_detector_stats_sum.empty())
+        return;
+
+    vector<const pair<const string, LuaDetectorStats>*> sorted;
+    for (const auto& ds : lua_detector_stats_sum)
+        sorted.emplace_back(&ds);
+
+    // slowest first, by total time or by calls when timing is off
+    sort(sorted.begin(), sorted.end(), [](auto a, auto b)
+        {
+            if (a->second.elapsed != b->second.elapsed)
+                return a->second.elapsed > b->second.elapsed;
+            return a->second.calls > b->second.calls;
+        });
+
+    LogLabel("lua detectors");
+
+    char buff[120];
+    snprintf(buff, sizeof(buff), "%40.40s: %-12s %-10s %-12s %-10s",
+        "Detector", "Calls", "Errors", "Usecs", "Avg");
+    LogText(buff);
+
+    for (auto ds : sorted)
+    {
+        const LuaDetectorStats& s = ds->second;
+        uint64_t usecs = clock_usecs(TO_USECS(s.elapsed));
+
+        snprintf(buff, sizeof(buff), "%40.40s: " FMTu64("-12") " " FMTu64("-10") " "
+            FMTu64("-12") " " FMTu64("-10"), ds->first.c_str(), s.calls, s.errors, usecs,
+            usecs / s.calls);
+        LogText(buff);
+    }
+}
+
+void LuaDetectorManager::reset_stats()
+{
+    const lock_guard<mutex> lock(lua_detector_stats_mutex);
+    lua_detector_stats_sum.clear();
+
+    if (!odp_thread_local_ctxt)
+        return;
+
+    for (auto lua_object : odp_thread_local_ctxt->get_lua_detector_mgr().allocated_objects)
+        lua_object->lsd.stats = LuaDetectorStats();
+}
+
 void LuaDetectorManager::free_detector_flow()
 {
     delete detector_flow;
@@ -515,7 +596,11 @@ bool LuaDetectorManager::load_detector(char* detector_filename, bool is_custom,
     bool has_validate;
     LuaObject* lua_object = create_lua_detector(detectorName, is_custom, detector_filename, has_validate);
     if (lua_object)
+    {
         allocated_objects.push_front(lua_object);
+        if (AppIdDetector* detector = lua_object->get_detector())
+            lua_objects[detector] = lua_object;
+    }
 
     return has_validate;
 }
@@ -26,6 +26,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include <lua.hpp>
 #include <lua/lua.h>
@@ -61,6 +62,11 @@ public:
     static void cleanup_after_swap();
     static void clear_lua_detector_mgrs();
 
+    // per detector validate stats, see appid.detector_timing
+    static void sum_stats();
+    static void print_stats();
+    static void reset_stats();
+
     void set_detector_flow(DetectorFlow* df)
     {
         detector_flow = df;
@@ -76,6 +82,16 @@ public:
         ignore_chp_cleanup = value;
     }
 
+    bool is_timing_enabled() const
+    { return timing_enabled; }
+
+    // the Lua object of this thread's state backing a shared detector
+    LuaObject* get_lua_object(const AppIdDetector* detector) const
+    {
+        auto it = lua_objects.find(detector);
+        return it != lua_objects.end() ? it->second : nullptr;
+    }
+
     void free_detector_flow();
     lua_State* L;
     bool insert_cb_detector(AppId app_id, LuaObject* ud);
@@ -94,8 +110,10 @@ private:
     std::list<LuaObject*> allocated_objects;
     size_t num_odp_detectors = 0;
     std::map<AppId, LuaObject*> cb_detectors;
+    std::unordered_map<const AppIdDetector*, LuaObject*> lua_objects;
     DetectorFlow* detector_flow = nullptr;
     bool ignore_chp_cleanup = false;
+    bool timing_enabled = false;
 };
 
 #endif
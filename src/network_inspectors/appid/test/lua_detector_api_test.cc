@@ -0,0 +1,331 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// lua_detector_api_test.cc - tests for Lua detector validate calls and their counts
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/lua_detector_api.cc"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+Analyzer* Analyzer::get_local_analyzer() { return nullptr; }
+
+namespace snort
+{
+IpsContext* DetectionEngine::get_context() { return nullptr; }
+Packet* DetectionEngine::get_current_packet() { return nullptr; }
+const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+char* snort_strdup(const char* s) { return strdup(s); }
+
+void AppIdSessionApi::set_netbios_domain(AppidChangeBits&, const char*) { }
+SfIpRet SfIp::set(const void*, int) { return SFIP_FAILURE; }
+
+HostTracker::HostTracker() { }
+bool HostTracker::add_service(Port, IpProtocol, AppId, bool, bool*) { return false; }
+void HostTracker::remove_flows() { }
+void HostTracker::update_cache_interface(uint8_t) { }
+}
+
+THREAD_LOCAL AppIdStats appid_stats;
+THREAD_LOCAL OdpThreadContext* odp_thread_local_ctxt = nullptr;
+THREAD_LOCAL AppIdDebug* appidDebug = nullptr;
+HostCacheIp default_host_cache(LRU_CACHE_INITIAL_SIZE);
+HostCacheSegmentedIp host_cache;
+
+AppIdConfig::~AppIdConfig() = default;
+DiscoveryFilter::~DiscoveryFilter() = default;
+
+std::mutex AppIdSession::inferred_svcs_lock;
+uint16_t AppIdSession::inferred_svcs_ver = 0;
+int AppIdSession::add_flow_data_id(uint16_t, ServiceDetector*) { return 0; }
+AppIdHttpSession* AppIdSession::get_http_session(uint32_t) const { return nullptr; }
+AppIdSession* AppIdSession::create_future_session(const Packet*, const SfIp*, uint16_t,
+    const SfIp*, uint16_t, IpProtocol, SnortProtocolId, OdpContext&, bool, bool, bool)
+{ return nullptr; }
+
+void ApplicationDescriptor::set_id(AppId) { }
+void ApplicationDescriptor::set_id(const Packet&, AppIdSession&, AppidSessionDirection, AppId,
+    AppidChangeBits&) { }
+void ServiceAppDescriptor::set_id(AppId, OdpContext&) { }
+
+int AppIdDetector::initialize(AppIdInspector&) { return 0; }
+void AppIdDetector::reload() { }
+int AppIdDetector::data_add(AppIdSession&, void*, AppIdFreeFCN) { return 0; }
+void* AppIdDetector::data_get(AppIdSession&) { return nullptr; }
+void AppIdDetector::add_user(AppIdSession&, const char*, AppId, bool, AppidChangeBits&) { }
+void AppIdDetector::add_payload(AppIdSession&, AppId) { }
+void AppIdDetector::add_app(const Packet&, AppIdSession&, AppidSessionDirection, AppId, AppId,
+    const char*, AppidChangeBits&) { }
+
+ClientDetector::ClientDetector() = default;
+void ClientDetector::register_appid(AppId, unsigned, OdpContext&) { }
+
+ServiceDetector::ServiceDetector() = default;
+void ServiceDetector::register_appid(AppId, unsigned, OdpContext&) { }
+int ServiceDetector::service_inprocess(AppIdSession&, const Packet*, AppidSessionDirection)
+{ return 0; }
+int ServiceDetector::add_service(AppidChangeBits&, AppIdSession&, const Packet*,
+    AppidSessionDirection, AppId, const char*, const char*, AppIdServiceSubtype*)
+{ return 0; }
+int ServiceDetector::incompatible_data(AppIdSession&, const Packet*, AppidSessionDirection)
+{ return 0; }
+int ServiceDiscovery::fail_service(AppIdSession&, const Packet*, AppidSessionDirection,
+    ServiceDetector*, ServiceDiscoveryState*) { return 0; }
+
+void PatternClientDetector::insert_client_port_pattern(PortPatternNode*) { }
+void PatternServiceDetector::insert_service_port_pattern(PortPatternNode*) { }
+
+void AlpnPatternMatchers::add_alpn_pattern(AppId, const std::string&, const std::string&) { }
+void CipPatternMatchers::cip_add_enip_command(AppId, uint16_t) { }
+void CipPatternMatchers::cip_add_path(AppId, uint32_t, uint8_t) { }
+void CipPatternMatchers::cip_add_set_attribute(AppId, uint32_t, bool, uint32_t) { }
+void CipPatternMatchers::cip_add_extended_symbol_service(AppId, uint8_t) { }
+void CipPatternMatchers::cip_add_service(AppId, uint8_t) { }
+void CipPatternMatchers::cip_add_connection_class(AppId, uint32_t) { }
+void DnsPatternMatchers::add_host_pattern(uint8_t*, size_t, uint8_t, AppId) { }
+void EveCaPatternMatchers::add_eve_ca_pattern(AppId, const std::string&, uint8_t,
+    const std::string&) { }
+void HttpPatternMatchers::insert_chp_pattern(CHPListElement*) { }
+void HttpPatternMatchers::insert_http_pattern(enum httpPatternType, DetectorHTTPPattern&) { }
+void HttpPatternMatchers::remove_http_patterns_for_id(AppId) { }
+void HttpPatternMatchers::insert_content_type_pattern(DetectorHTTPPattern&) { }
+void HttpPatternMatchers::insert_url_pattern(DetectorAppUrlPattern*) { }
+void HttpPatternMatchers::insert_rtmp_url_pattern(DetectorAppUrlPattern*) { }
+void HttpPatternMatchers::insert_app_url_pattern(DetectorAppUrlPattern*) { }
+int SipPatternMatchers::add_ua_pattern(AppId, const char*, const char*) { return 0; }
+int SipPatternMatchers::add_server_pattern(AppId, const char*, const char*) { return 0; }
+void SshPatternMatchers::add_ssh_pattern(const std::string&, AppId) { }
+void SslPatternMatchers::add_cert_pattern(uint8_t*, size_t, uint8_t, AppId, bool, bool) { }
+
+bool HostPortCache::add(const SnortConfig*, const SfIp*, uint16_t, IpProtocol, unsigned, AppId)
+{ return false; }
+bool HostPortCache::add_host(const SnortConfig*, const SfIp*, uint32_t*, uint16_t, IpProtocol,
+    AppId, AppId, AppId, unsigned) { return false; }
+
+void AppIdPegCounts::add_app_peg_info(std::string, AppId) { }
+
+void OdpContext::add_port_service_id(IpProtocol, uint16_t, AppId) { }
+void OdpContext::add_protocol_service_id(IpProtocol, AppId) { }
+
+AppInfoTableEntry* AppInfoManager::add_dynamic_app_entry(const char*) { return nullptr; }
+AppInfoTableEntry* AppInfoManager::get_app_info_entry(AppId) { return nullptr; }
+AppId AppInfoManager::get_appid_by_service_id(uint32_t) { return APP_ID_NONE; }
+AppId AppInfoManager::get_appid_by_client_id(uint32_t) { return APP_ID_NONE; }
+AppId AppInfoManager::get_appid_by_payload_id(uint32_t) { return APP_ID_NONE; }
+int32_t AppInfoManager::get_appid_by_name(const char*) { return APP_ID_NONE; }
+void AppInfoManager::set_app_info_active(AppId) { }
+
+bool MpseManager::is_regex_capable(const MpseApi*) { return false; }
+
+bool get_lua_field(lua_State*, int, const char*, std::string&) { return false; }
+bool get_lua_field(lua_State*, int, const char*, int&) { return false; }
+
+pcre* pcre_compile(const char*, int, const char**, int*, const unsigned char*) { return nullptr; }
+int pcre_exec(const pcre*, const pcre_extra*, const char*, int, int, int, int*, int) { return -1; }
+void (*pcre_free)(void*) = free;
+
+static bool timing = false;
+
+LuaDetectorManager::LuaDetectorManager(AppIdContext& ctxt, bool) : ctxt(ctxt)
+{
+    L = luaL_newstate();
+    luaL_openlibs(L);
+    timing_enabled = timing;
+}
+
+LuaDetectorManager::~LuaDetectorManager()
+{ lua_close(L); }
+
+void LuaDetectorManager::free_detector_flow()
+{
+    delete detector_flow;
+    detector_flow = nullptr;
+}
+
+bool LuaDetectorManager::insert_cb_detector(AppId, LuaObject*) { return false; }
+LuaObject* LuaDetectorManager::get_cb_detector(AppId) { return nullptr; }
+
+OdpThreadContext::~OdpThreadContext() = default;
+
+void appid_log(const snort::Packet*, unsigned char, const char*, ...) { }
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+// a detector environment in the registry, as the manager loads it
+static void load_detector(lua_State* L, const char* name, const char* code)
+{
+    lua_newtable(L);
+
+    CHECK_EQUAL(0, luaL_loadstring(L, code));
+    lua_pushvalue(L, -2);
+    lua_setfenv(L, -2);
+    CHECK_EQUAL(0, lua_pcall(L, 0, 0, 0));
+
+    lua_setfield(L, LUA_REGISTRYINDEX, name);
+    lua_settop(L, 0);
+}
+
+static const char* const detector_code =
+    "function ok() return 0 end\n"
+    "function nomatch() return 100 end\n"
+    "function fails() error('boom') end\n"
+    "function not_a_number() return {} end\n";
+
+TEST_GROUP(lua_detector_validate)
+{
+    AppIdConfig* config = nullptr;
+    AppIdContext* ctxt = nullptr;
+    LuaDetectorManager* mgr = nullptr;
+    OdpThreadContext* odp_ctxt = nullptr;
+    LuaStateDescriptor lsd;
+
+    uint8_t asd_space[sizeof(void*)] = { };
+    AppidChangeBits change_bits;
+    AppIdDiscoveryArgs* args = nullptr;
+
+    void setup() override
+    {
+        memset(&appid_stats, 0, sizeof(appid_stats));
+    }
+
+    void teardown() override
+    {
+        delete args;
+        delete mgr;
+        delete odp_ctxt;
+        delete ctxt;
+        delete config;
+        odp_thread_local_ctxt = nullptr;
+    }
+
+    void start(bool timed)
+    {
+        timing = timed;
+        config = new AppIdConfig;
+        ctxt = new AppIdContext(*config);
+        mgr = new LuaDetectorManager(*ctxt, false);
+
+        odp_ctxt = new OdpThreadContext;
+        odp_ctxt->set_lua_detector_mgr(*mgr);
+        odp_thread_local_ctxt = odp_ctxt;
+
+        load_detector(mgr->L, "test_detector", detector_code);
+        lsd.package_info.name = "test_detector";
+
+        // the session is only passed through to the detector
+        args = new AppIdDiscoveryArgs(nullptr, 0, APP_ID_FROM_INITIATOR,
+            *(AppIdSession*)asd_space, nullptr, change_bits);
+    }
+
+    int validate(const char* fn)
+    {
+        lsd.set_validate_function(mgr->L, fn);
+        return lsd.lua_validate(*args);
+    }
+};
+
+TEST(lua_detector_validate, calls_counted)
+{
+    start(false);
+
+    CHECK_EQUAL(APPID_SUCCESS, validate("ok"));
+    CHECK_EQUAL(APPID_NOMATCH, validate("nomatch"));
+    CHECK_EQUAL(APPID_SUCCESS, validate("ok"));
+
+    CHECK_EQUAL(3u, lsd.stats.calls);
+    CHECK_EQUAL(0u, lsd.stats.errors);
+    CHECK(lsd.stats.elapsed == hr_duration::zero());
+
+    CHECK_EQUAL(3u, appid_stats.lua_detector_calls);
+    CHECK_EQUAL(0u, appid_stats.lua_detector_errors);
+    CHECK_EQUAL(0, lua_gettop(mgr->L));
+}
+
+TEST(lua_detector_validate, errors_counted)
+{
+    start(false);
+
+    CHECK_EQUAL(APPID_ENULL, validate("fails"));
+    CHECK_EQUAL(APPID_ENULL, validate("not_a_number"));
+    CHECK_EQUAL(APPID_SUCCESS, validate("ok"));
+
+    CHECK_EQUAL(3u, lsd.stats.calls);
+    CHECK_EQUAL(2u, lsd.stats.errors);
+
+    CHECK_EQUAL(3u, appid_stats.lua_detector_calls);
+    CHECK_EQUAL(2u, appid_stats.lua_detector_errors);
+    CHECK_EQUAL(0, lua_gettop(mgr->L));
+}
+
+TEST(lua_detector_validate, missing_function_counted_as_error)
+{
+    start(false);
+
+    // lua_pcall reports calling nil
+    CHECK_EQUAL(APPID_ENULL, validate("no_such_function"));
+
+    CHECK_EQUAL(1u, appid_stats.lua_detector_calls);
+    CHECK_EQUAL(1u, appid_stats.lua_detector_errors);
+}
+
+TEST(lua_detector_validate, no_validator_not_counted)
+{
+    start(false);
+
+    CHECK_EQUAL(APPID_NOMATCH, validate(""));
+
+    CHECK_EQUAL(0u, lsd.stats.calls);
+    CHECK_EQUAL(0u, appid_stats.lua_detector_calls);
+}
+
+TEST(lua_detector_validate, changed_validator_called)
+{
+    start(false);
+
+    // the cached function reference is dropped when the validator changes
+    CHECK_EQUAL(APPID_SUCCESS, validate("ok"));
+    CHECK_EQUAL(APPID_NOMATCH, validate("nomatch"));
+    CHECK_EQUAL(APPID_NOMATCH, lsd.lua_validate(*args));
+
+    CHECK_EQUAL(3u, appid_stats.lua_detector_calls);
+}
+
+TEST(lua_detector_validate, timed)
+{
+    start(true);
+
+    CHECK_EQUAL(APPID_SUCCESS, validate("ok"));
+
+    CHECK_EQUAL(1u, lsd.stats.calls);
+    CHECK(lsd.stats.elapsed > hr_duration::zero());
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
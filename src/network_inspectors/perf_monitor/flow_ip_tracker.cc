@@ -24,10 +24,14 @@
 
 #include "flow_ip_tracker.h"
 
+#include <cstdio>
+#include <cstring>
+
 #include "hash/hash_defs.h"
 #include "log/messages.h"
 #include "protocols/packet.h"
 
+#include "heavy_hitters.h"
 #include "perf_pegs.h"
 
 using namespace snort;
@@ -36,30 +40,47 @@ using namespace snort;
 #define DEFAULT_XHASH_NROWS 1021
 #define TRACKER_NAME PERF_NAME "_flow_ip"
 
-struct FlowStateKey
-{
-    SfIp ipA;
-    SfIp ipB;
-};
+static const char* const top_names[SFS_TOP_MAX] = { "bytes", "packets", "sessions" };
 
-FlowStateValue* FlowIPTracker::find_stats(const SfIp* src_addr, const SfIp* dst_addr,
-    int* swapped)
+static int make_key(const SfIp* src_addr, const SfIp* dst_addr, FlowStateKey& key)
 {
-    FlowStateKey key;
-    FlowStateValue* value = nullptr;
-
     if ( src_addr->less_than(*dst_addr) )
     {
         key.ipA = *src_addr;
         key.ipB = *dst_addr;
-        *swapped = 0;
+        return 0;
+    }
+
+    key.ipA = *dst_addr;
+    key.ipB = *src_addr;
+    return 1;
+}
+
+static void update_traffic(FlowStateValue* value, FlowType type, int swapped, int len)
+{
+    TrafficStats* tmp_stats = &value->traffic_stats[type];
+
+    if ( !swapped )
+    {
+        tmp_stats->packets_a_to_b++;
+        tmp_stats->bytes_a_to_b += len;
     }
     else
     {
-        key.ipA = *dst_addr;
-        key.ipB = *src_addr;
-        *swapped = 1;
+        tmp_stats->packets_b_to_a++;
+        tmp_stats->bytes_b_to_a += len;
     }
+    value->total_packets++;
+    value->total_bytes += len;
+}
+
+FlowStateValue* FlowIPTracker::find_stats(const SfIp* src_addr, const SfIp* dst_addr,
+    int* swapped)
+{
+    FlowStateKey key;
+    FlowStateValue* value = nullptr;
+
+    *swapped = make_key(src_addr, dst_addr, key);
 
     value = (FlowStateValue*)ip_map->get_user_data(&key);
     if ( !value )
@@ -75,6 +96,10 @@ FlowStateValue* FlowIPTracker::find_stats(const SfIp* src_addr, const SfIp* dst_
 
 bool FlowIPTracker::initialize(size_t new_memcap)
 {
+    // the top maps are sized once; a new memcap applies on restart
+    if ( top )
+        return false;
+
     bool need_pruning = false;
 
     if ( !ip_map )
@@ -93,7 +118,7 @@ bool FlowIPTracker::initialize(size_t new_memcap)
 }
 
 FlowIPTracker::FlowIPTracker(PerfConfig* perf) : PerfTracker(perf, TRACKER_NAME),
-    perf_flags(perf->perf_flags), perf_conf(perf)
+    perf_flags(perf->perf_flags), perf_conf(perf), top(perf->flowip_top)
 {
     formatter->register_section("flow_ip");
     formatter->register_field("ip_a", ip_a);
@@ -128,25 +153,122 @@ FlowIPTracker::FlowIPTracker(PerfConfig* perf) : PerfTracker(perf, TRACKER_NAME)
         &stats.state_changes[SFS_STATE_TCP_CLOSED]);
     formatter->register_field("udp_created", (PegCount*)
         &stats.state_changes[SFS_STATE_UDP_CREATED]);
+
+    if ( top )
+    {
+        formatter->register_field("top_by", top_by);
+        formatter->register_field("rank", &top_rank);
+        formatter->register_field("count", &top_count);
+        formatter->register_field("error", &top_error);
+    }
     formatter->finalize_fields();
     stats.total_packets = stats.total_bytes = 0;
+    top_by[0] = '\0';
+    top_rank = top_count = top_error = 0;
 
     memcap = perf->flowip_memcap;
-    ip_map = new XHash(DEFAULT_XHASH_NROWS, sizeof(FlowStateKey), sizeof(FlowStateValue), memcap);
+
+    if ( top )
+    {
+        // split the memcap evenly across the rankings
+        size_t capacity = memcap / (SFS_TOP_MAX * HeavyHitters::get_entry_size());
+
+        if ( capacity < top )
+            capacity = top;
+
+        for ( auto& map : top_map )
+            map = new HeavyHitters(capacity);
+    }
+    else
+        ip_map = new XHash(DEFAULT_XHASH_NROWS, sizeof(FlowStateKey), sizeof(FlowStateValue), memcap);
 }
 
 FlowIPTracker::~FlowIPTracker()
 {
-    const XHashStats& tmp_stats = ip_map->get_stats();
-    pmstats.flow_tracker_creates = tmp_stats.nodes_created;
-    pmstats.flow_tracker_total_deletes = tmp_stats.memcap_deletes;
-    pmstats.flow_tracker_prunes = tmp_stats.memcap_prunes;
+    if ( ip_map )
+    {
+        const XHashStats& tmp_stats = ip_map->get_stats();
+        pmstats.flow_tracker_creates = tmp_stats.nodes_created;
+        pmstats.flow_tracker_total_deletes = tmp_stats.memcap_deletes;
+        pmstats.flow_tracker_prunes = tmp_stats.memcap_prunes;
+    }
 
     delete ip_map;
+
+    for ( auto map : top_map )
+        delete map;
 }
 
 void FlowIPTracker::reset()
-{ ip_map->clear_hash(); }
+{
+    if ( ip_map )
+        ip_map->clear_hash();
+
+    for ( auto map : top_map )
+    {
+        if ( map )
+            map->clear();
+    }
+}
+
+void FlowIPTracker::update_top(const SfIp* src_addr, const SfIp* dst_addr, FlowType type,
+    int len)
+{
+    FlowStateKey key;
+    int swapped = make_key(src_addr, dst_addr, key);
+
+    update_traffic(&top_map[SFS_TOP_BYTES]->add(key, len)->stats, type, swapped, len);
+    update_traffic(&top_map[SFS_TOP_PACKETS]->add(key, 1)->stats, type, swapped, len);
+
+    if ( auto e = top_map[SFS_TOP_SESSIONS]->find(key) )
+        update_traffic(&e->stats, type, swapped, len);
+}
+
+void FlowIPTracker::update_top_state(const SfIp* src_addr, const SfIp* dst_addr,
+    FlowState state)
+{
+    FlowStateKey key;
+    make_key(src_addr, dst_addr, key);
+
+    for ( unsigned i = 0; i < SFS_TOP_MAX; ++i )
+    {
+        HeavyHitters::Entry* e;
+
+        // only session starts rank pairs by sessions
+        if ( i == SFS_TOP_SESSIONS and state != SFS_STATE_TCP_CLOSED )
+            e = top_map[i]->add(key, 1);
+        else
+            e = top_map[i]->find(key);
+
+        if ( e )
+            e->stats.state_changes[state]++;
+    }
+}
+
+void FlowIPTracker::process_top()
+{
+    std::vector<const HeavyHitters::Entry*> entries;
+
+    for ( unsigned i = 0; i < SFS_TOP_MAX; ++i )
+    {
+        top_map[i]->get_top(top, entries);
+        snprintf(top_by, sizeof(top_by), "%s", top_names[i]);
+        top_rank = 0;
+
+        for ( const auto* e : entries )
+        {
+            e->key.ipA.ntop(ip_a, sizeof(ip_a));
+            e->key.ipB.ntop(ip_b, sizeof(ip_b));
+            memcpy(&stats, &e->stats, sizeof(stats));
+
+            ++top_rank;
+            top_count = e->count;
+            top_error = e->error;
+
+            write();
+        }
+    }
+}
 
 void FlowIPTracker::update(Packet* p)
 {
@@ -164,29 +286,32 @@ void FlowIPTracker::update(Packet* p)
         else if (p->ptrs.udph)
             type = SFS_TYPE_UDP;
 
+        if ( top )
+        {
+            update_top(src_addr, dst_addr, type, len);
+            return;
+        }
+
         FlowStateValue* value = find_stats(src_addr, dst_addr, &swapped);
         if ( !value )
             return;
 
-        TrafficStats* tmp_stats = &value->traffic_stats[type];
-
-        if ( !swapped )
-        {
-            tmp_stats->packets_a_to_b++;
-            tmp_stats->bytes_a_to_b += len;
-        }
-        else
-        {
-            tmp_stats->packets_b_to_a++;
-            tmp_stats->bytes_b_to_a += len;
-        }
-        value->total_packets++;
-        value->total_bytes += len;
+        update_traffic(value, type, swapped, len);
     }
 }
 
 void FlowIPTracker::process(bool)
 {
+    if ( top )
+    {
+        process_top();
+
+        if ( !(perf_flags & PERF_SUMMARY) )
+            reset();
+
+        return;
+    }
+
     for (auto node = ip_map->find_first_node(); node; node = ip_map->find_next_node())
     {
         FlowStateKey* key = (FlowStateKey*)node->key;
@@ -207,6 +332,12 @@ int FlowIPTracker::update_state(const SfIp* src_addr, const SfIp* dst_addr, Flow
 {
     int swapped;
 
+    if ( top )
+    {
+        update_top_state(src_addr, dst_addr, state);
+        return 0;
+    }
+
     FlowStateValue* value = find_stats(src_addr, dst_addr, &swapped);
     if ( !value )
         return 1;
@@ -22,6 +22,7 @@
 #define FLOW_IP_TRACKER_H
 
 #include "hash/xhash.h"
+#include "sfip/sf_ip.h"
 
 #include "perf_tracker.h"
 
@@ -57,6 +58,23 @@ struct FlowStateValue
     PegCount state_changes[SFS_STATE_MAX];
 };
 
+struct FlowStateKey
+{
+    snort::SfIp ipA;
+    snort::SfIp ipB;
+};
+
+// rankings reported when flow_ip_top is set
+enum FlowTopType
+{
+    SFS_TOP_BYTES = 0,
+    SFS_TOP_PACKETS,
+    SFS_TOP_SESSIONS,
+    SFS_TOP_MAX
+};
+
+class HeavyHitters;
+
 class FlowIPTracker : public PerfTracker
 {
 public:
@@ -73,12 +91,21 @@ public:
 
 private:
     FlowStateValue stats;
-    snort::XHash* ip_map;
+    snort::XHash* ip_map = nullptr;
+    HeavyHitters* top_map[SFS_TOP_MAX] = { };
     char ip_a[41], ip_b[41];
+    char top_by[16];
+    PegCount top_rank;
+    PegCount top_count;
+    PegCount top_error;
     int perf_flags;
     PerfConfig* perf_conf;
     size_t memcap;
+    unsigned top;
     FlowStateValue* find_stats(const snort::SfIp* src_addr, const snort::SfIp* dst_addr, int* swapped);
+    void update_top(const snort::SfIp* src_addr, const snort::SfIp* dst_addr, FlowType, int len);
+    void update_top_state(const snort::SfIp* src_addr, const snort::SfIp* dst_addr, FlowState);
+    void process_top();
     void write_stats();
     void display_stats();
 
@@ -0,0 +1,286 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "heavy_hitters.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "hash/hash_key_operations.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+HeavyHitters::HeavyHitters(unsigned capacity)
+{
+    assert(capacity);
+
+    entries.resize(capacity);
+    heap.resize(capacity);
+    heap_pos.resize(capacity);
+
+    // keep the key table at most half full
+    unsigned slots = hash_nearest_power_of_2(2 * capacity);
+    index.assign(slots, -1);
+    mask = slots - 1;
+}
+
+size_t HeavyHitters::get_entry_size()
+{ return sizeof(Entry) + 2 * sizeof(unsigned) + 2 * sizeof(int); }
+
+void HeavyHitters::clear()
+{
+    used = 0;
+    std::fill(index.begin(), index.end(), -1);
+}
+
+int HeavyHitters::find_slot(const FlowStateKey& key, uint32_t hash) const
+{
+    for ( unsigned slot = hash & mask; index[slot] >= 0; slot = (slot + 1) & mask )
+    {
+        const Entry& e = entries[index[slot]];
+
+        if ( e.hash == hash and !memcmp(&e.key, &key, sizeof(key)) )
+            return slot;
+    }
+    return -1;
+}
+
+void HeavyHitters::insert_slot(unsigned entry)
+{
+    unsigned slot = entries[entry].hash & mask;
+
+    while ( index[slot] >= 0 )
+        slot = (slot + 1) & mask;
+
+    index[slot] = entry;
+}
+
+// backward shift deletion keeps probe sequences intact without tombstones
+void HeavyHitters::remove_slot(unsigned slot)
+{
+    unsigned next = slot;
+
+    while ( true )
+    {
+        index[slot] = -1;
+
+        while ( true )
+        {
+            next = (next + 1) & mask;
+
+            if ( index[next] < 0 )
+                return;
+
+            unsigned home = entries[index[next]].hash & mask;
+
+            // leave entries whose home is cyclically in (slot, next]
+            if ( slot <= next ? (slot < home and home <= next) : (slot < home or home <= next) )
+                continue;
+
+            index[slot] = index[next];
+            slot = next;
+            break;
+        }
+    }
+}
+
+void HeavyHitters::swap_heap(unsigned a, unsigned b)
+{
+    std::swap(heap[a], heap[b]);
+    heap_pos[heap[a]] = a;
+    heap_pos[heap[b]] = b;
+}
+
+void HeavyHitters::sift_up(unsigned pos)
+{
+    while ( pos )
+    {
+        unsigned parent = (pos - 1) / 2;
+
+        if ( entries[heap[parent]].count <= entries[heap[pos]].count )
+            break;
+
+        swap_heap(pos, parent);
+        pos = parent;
+    }
+}
+
+void HeavyHitters::sift_down(unsigned pos)
+{
+    while ( true )
+    {
+        unsigned child = 2 * pos + 1;
+
+        if ( child >= used )
+            break;
+
+        if ( child + 1 < used and entries[heap[child + 1]].count < entries[heap[child]].count )
+            ++child;
+
+        if ( entries[heap[pos]].count <= entries[heap[child]].count )
+            break;
+
+        swap_heap(pos, child);
+        pos = child;
+    }
+}
+
+HeavyHitters::Entry* HeavyHitters::find(const FlowStateKey& key)
+{
+    int slot = find_slot(key, str_to_hash((const uint8_t*)&key, sizeof(key)));
+    return slot < 0 ? nullptr : &entries[index[slot]];
+}
+
+HeavyHitters::Entry* HeavyHitters::add(const FlowStateKey& key, PegCount weight)
+{
+    uint32_t hash = str_to_hash((const uint8_t*)&key, sizeof(key));
+    int slot = find_slot(key, hash);
+
+    if ( slot >= 0 )
+    {
+        unsigned i = index[slot];
+        entries[i].count += weight;
+        sift_down(heap_pos[i]);
+        return &entries[i];
+    }
+
+    unsigned i;
+    bool appended = used < entries.size();
+
+    if ( appended )
+    {
+        i = used++;
+        entries[i].count = weight;
+        entries[i].error = 0;
+        heap[i] = i;
+        heap_pos[i] = i;
+    }
+    else
+    {
+        // replace the pair with the smallest count
+        i = heap[0];
+        remove_slot(find_slot(entries[i].key, entries[i].hash));
+        entries[i].error = entries[i].count;
+        entries[i].count += weight;
+    }
+
+    Entry& e = entries[i];
+    e.key = key;
+    e.hash = hash;
+    memset(&e.stats, 0, sizeof(e.stats));
+
+    insert_slot(i);
+
+    if ( appended )
+        sift_up(heap_pos[i]);
+    else
+        sift_down(heap_pos[i]);
+
+    return &e;
+}
+
+void HeavyHitters::get_top(unsigned k, std::vector<const Entry*>& top) const
+{
+    top.clear();
+
+    for ( unsigned i = 0; i < used; ++i )
+        top.emplace_back(&entries[i]);
+
+    if ( k > top.size() )
+        k = top.size();
+
+    std::partial_sort(top.begin(), top.begin() + k, top.end(),
+        [](const Entry* a, const Entry* b) { return a->count > b->count; });
+
+    top.resize(k);
+}
+
+#ifdef UNIT_TEST
+
+static FlowStateKey make_key(uint32_t a, uint32_t b)
+{
+    FlowStateKey key;
+    memset(&key, 0, sizeof(key));
+    key.ipA.set(&a, AF_INET);
+    key.ipB.set(&b, AF_INET);
+    return key;
+}
+
+TEST_CASE("heavy hitters", "[HeavyHitters]")
+{
+    HeavyHitters hh(4);
+    std::vector<const HeavyHitters::Entry*> top;
+
+    SECTION("exact below capacity")
+    {
+        for ( uint32_t i = 1; i <= 3; ++i )
+            for ( uint32_t n = 0; n < i * 10; ++n )
+                hh.add(make_key(i, 100), 1);
+
+        hh.get_top(2, top);
+        CHECK(top.size() == 2);
+        CHECK(top[0]->count == 30);
+        CHECK(top[0]->error == 0);
+        CHECK(top[1]->count == 20);
+        CHECK(hh.find(make_key(1, 100)) != nullptr);
+        CHECK(hh.find(make_key(9, 100)) == nullptr);
+    }
+
+    SECTION("heavy pairs survive churn")
+    {
+        for ( uint32_t n = 0; n < 1000; ++n )
+        {
+            hh.add(make_key(1, 100), 10);
+            hh.add(make_key(2, 100), 5);
+            hh.add(make_key(1000 + n, 100), 1);
+        }
+
+        hh.get_top(2, top);
+        CHECK(top.size() == 2);
+        CHECK(top[0]->key.ipA.equals(make_key(1, 100).ipA));
+        CHECK(top[0]->count - top[0]->error <= 10000);
+        CHECK(top[0]->count >= 10000);
+        CHECK(top[1]->key.ipA.equals(make_key(2, 100).ipA));
+        CHECK(top[1]->count >= 5000);
+
+        // every pair is still found through the key table after removals
+        for ( const auto* e : top )
+            CHECK(hh.find(e->key) == e);
+    }
+
+    SECTION("clear")
+    {
+        hh.add(make_key(1, 2), 1);
+        hh.clear();
+        hh.get_top(4, top);
+        CHECK(top.empty());
+        CHECK(hh.find(make_key(1, 2)) == nullptr);
+    }
+}
+
+#endif
+
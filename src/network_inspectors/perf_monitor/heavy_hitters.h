@@ -0,0 +1,81 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef HEAVY_HITTERS_H
+#define HEAVY_HITTERS_H
+
+// HeavyHitters implements the Space-Saving algorithm over host pairs. It
+// monitors a fixed number of pairs; a pair that isn't monitored replaces the
+// one with the smallest count and inherits that count as its error. Any pair
+// whose true weight exceeds total / capacity is guaranteed to be monitored,
+// and no count is over by more than its error.
+
+#include <cstdint>
+#include <vector>
+
+#include "flow_ip_tracker.h"
+
+class HeavyHitters
+{
+public:
+    struct Entry
+    {
+        FlowStateKey key;
+        PegCount count;         // estimated weight, never less than the true weight
+        PegCount error;         // maximum overestimate included in count
+        FlowStateValue stats;   // traffic seen since the pair was admitted
+        uint32_t hash;
+    };
+
+    HeavyHitters(unsigned capacity);
+
+    // add weight to the pair, admitting it if needed
+    Entry* add(const FlowStateKey&, PegCount weight);
+
+    // the pair if it is monitored, else nullptr
+    Entry* find(const FlowStateKey&);
+
+    // the k monitored pairs with the highest counts, highest first
+    void get_top(unsigned k, std::vector<const Entry*>&) const;
+
+    void clear();
+
+    unsigned get_capacity() const
+    { return entries.size(); }
+
+    static size_t get_entry_size();
+
+private:
+    int find_slot(const FlowStateKey&, uint32_t hash) const;
+    void insert_slot(unsigned entry);
+    void remove_slot(unsigned slot);
+
+    void sift_down(unsigned pos);
+    void sift_up(unsigned pos);
+    void swap_heap(unsigned a, unsigned b);
+
+    std::vector<Entry> entries;
+    std::vector<unsigned> heap;     // entry indices, min-heap on count
+    std::vector<unsigned> heap_pos; // heap position of each entry
+    std::vector<int> index;         // open addressed key to entry table
+    unsigned used = 0;
+    unsigned mask;
+};
+
+#endif
+
@@ -76,6 +76,10 @@ static const Parameter s_params[] =
     { "flow_ip_memcap", Parameter::PT_INT, "236:maxSZ", "52428800",
       "maximum memory in bytes for flow tracking" },
 
+    { "flow_ip_top", Parameter::PT_INT, "0:max32", "0",
+      "report only this many of the heaviest host pairs by bytes, packets, and sessions "
+      "(0 tracks all pairs)" },
+
     { "max_file_size", Parameter::PT_INT, "4096:max53", "1073741824",
       "files will be rolled over if they exceed this size" },
 
@@ -273,6 +277,10 @@ bool PerfMonModule::set(const char*, Value& v, SnortConfig*)
     {
         config->flowip_memcap = v.get_size();
     }
+    else if ( v.is("flow_ip_top") )
+    {
+        config->flowip_top = v.get_uint32();
+    }
     else if ( v.is("max_file_size") )
         config->max_file_size = v.get_uint64() - ROLLOVER_THRESH;
 
@@ -92,6 +92,7 @@ struct PerfConfig
     uint64_t max_file_size = 0;
     int flow_max_port_to_track = 0;
     size_t flowip_memcap = 0;
+    unsigned flowip_top = 0;
     PerfFormat format = PerfFormat::CSV;
     PerfOutput output = PerfOutput::TO_FILE;
     std::vector<ModuleConfig> modules;
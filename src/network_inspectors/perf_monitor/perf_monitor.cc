@@ -164,7 +164,10 @@ void PerfMonitor::show(const SnortConfig*) const
         ConfigLogger::log_value("flow_ports", config->flow_max_port_to_track);
 
     if ( ConfigLogger::log_flag("flow_ip", config->perf_flags & PERF_FLOWIP) )
+    {
         ConfigLogger::log_value("flow_ip_memcap", config->flowip_memcap);
+        ConfigLogger::log_value("flow_ip_top", config->flowip_top);
+    }
 
     ConfigLogger::log_value("packets", config->pkt_cnt);
     ConfigLogger::log_value("seconds", config->sample_interval);
@@ -247,7 +250,7 @@ bool PerfMonReloadTuner::tinit()
 
 bool PerfMonReloadTuner::tune_resources(unsigned work_limit)
 {
-    if (t_constraints->flow_ip_enabled)
+    if (t_constraints->flow_ip_enabled and flow_ip_tracker->get_ip_map())
     {
         unsigned num_freed = 0;
         int result = flow_ip_tracker->get_ip_map()->tune_memory_resources(work_limit, num_freed);
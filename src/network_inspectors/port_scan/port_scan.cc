@@ -385,6 +385,15 @@ static std::string to_string(const IPSET* list)
 static void portscan_config_show(const PortscanConfig* config)
 {
     ConfigLogger::log_value("memcap", config->memcap);
+    ConfigLogger::log_flag("sketch", config->sketch);
+
+    if ( config->sketch )
+    {
+        ConfigLogger::log_value("sketch_error", config->sketch_error);
+        ConfigLogger::log_value("sketch_failure", config->sketch_failure);
+        ConfigLogger::log_value("sketch_distinct_error", config->sketch_distinct_error);
+    }
+
     ConfigLogger::log_value("protos", get_protos(config->detect_scans).c_str());
     ConfigLogger::log_value("scan_types", get_types(config->detect_scan_type).c_str());
 
@@ -420,7 +429,13 @@ PortScan::~PortScan()
 }
 
 void PortScan::tinit()
-{ ps_init_hash(config->memcap); }
+{
+    if ( config->sketch )
+        ps_init_sketch(config->sketch_error, config->sketch_failure,
+            config->sketch_distinct_error);
+    else
+        ps_init_hash(config->memcap);
+}
 
 void PortScan::tterm()
 { ps_cleanup(); }
@@ -46,6 +46,7 @@
 
 #include "ps_inspect.h"
 #include "ps_pegs.h"
+#include "ps_sketch.h"
 
 using namespace snort;
 
@@ -87,6 +88,7 @@ public:
 };
 
 static THREAD_LOCAL PortScanCache* portscan_hash = nullptr;
+static THREAD_LOCAL PsSketch* portscan_sketch = nullptr;
 extern THREAD_LOCAL PsPegStats spstats;
 
 PS_PKT::PS_PKT(Packet* p)
@@ -120,6 +122,12 @@ void ps_cleanup()
         delete portscan_hash;
         portscan_hash = nullptr;
     }
+
+    if ( portscan_sketch )
+    {
+        delete portscan_sketch;
+        portscan_sketch = nullptr;
+    }
 }
 
 unsigned ps_node_size()
@@ -127,6 +135,12 @@ unsigned ps_node_size()
 
 bool ps_init_hash(unsigned long memcap)
 {
+    if ( portscan_sketch )
+    {
+        delete portscan_sketch;
+        portscan_sketch = nullptr;
+    }
+
     if ( portscan_hash )
     {
         bool need_pruning = (memcap < portscan_hash->get_mem_used());
@@ -141,6 +155,24 @@ bool ps_init_hash(unsigned long memcap)
     return false;
 }
 
+// the sketch has a fixed size so there is never anything to prune
+bool ps_init_sketch(double error, double failure, double distinct_error)
+{
+    if ( portscan_hash )
+    {
+        delete portscan_hash;
+        portscan_hash = nullptr;
+    }
+
+    if ( portscan_sketch and portscan_sketch->matches(error, failure, distinct_error) )
+        return false;
+
+    delete portscan_sketch;
+    portscan_sketch = new PsSketch(error, failure, distinct_error);
+
+    return false;
+}
+
 bool ps_prune_hash(unsigned work_limit)
 {
     if ( !portscan_hash )
@@ -156,12 +188,17 @@ void ps_reset()
 {
     if ( portscan_hash )
         portscan_hash->clear_hash();
+
+    if ( portscan_sketch )
+        portscan_sketch->clear();
 }
 
 void ps_update_memusage_peg()
 {
     if (portscan_hash)
         spstats.bytes_in_use = portscan_hash->get_mem_used();
+    else if (portscan_sketch)
+        spstats.bytes_in_use = portscan_sketch->get_mem_used();
     else
         spstats.bytes_in_use = 0;
 }
@@ -302,8 +339,11 @@ bool PortScan::ps_filter_ignore(PS_PKT* ps_pkt)
 **  Get a tracker node by either finding one or starting a new one.  We may
 **  return null, in which case we wait `til the next packet.
 */
-static PS_TRACKER* ps_tracker_get(PS_HASH_KEY* key)
+static PS_TRACKER* ps_tracker_get(PS_HASH_KEY* key, unsigned slot)
 {
+    if ( portscan_sketch )
+        return portscan_sketch->get(key, sizeof(*key), packet_time(), slot);
+
     PS_TRACKER* ht = (PS_TRACKER*)portscan_hash->get_user_data((void*)key);
 
     if ( ht )
@@ -359,7 +399,7 @@ bool PortScan::ps_tracker_lookup(
             key.group = p->get_egress_group();
         }
 
-        *scanned = ps_tracker_get(&key);
+        *scanned = ps_tracker_get(&key, PS_SKETCH_SCANNED);
     }
 
     //  Let's lookup the host that is scanning.
@@ -379,7 +419,7 @@ bool PortScan::ps_tracker_lookup(
             key.group = p->get_ingress_group();
         }
 
-        *scanner = ps_tracker_get(&key);
+        *scanner = ps_tracker_get(&key, PS_SKETCH_SCANNER);
     }
 
     return *scanner or *scanned;
@@ -1282,9 +1322,25 @@ int PortScan::ps_detect(PS_PKT* ps_pkt)
         if ( !ps_tracker_update(ps_pkt, scanner, scanned) )
             return 0;
 
+        if ( portscan_sketch )
+        {
+            if ( scanner )
+                portscan_sketch->update(PS_SKETCH_SCANNER);
+            if ( scanned )
+                portscan_sketch->update(PS_SKETCH_SCANNED);
+        }
+
         if ( !ps_tracker_alert(ps_pkt, scanner, scanned) )
             return 0;
 
+        if ( portscan_sketch )
+        {
+            if ( scanner )
+                portscan_sketch->set_alerts(PS_SKETCH_SCANNER);
+            if ( scanned )
+                portscan_sketch->set_alerts(PS_SKETCH_SCANNED);
+        }
+
         /* This is added to address the case of no
          * session and a RST packet going back from the Server. */
         if ( p->ptrs.tcph and (p->ptrs.tcph->th_flags & TH_RST) and !p->flow )
@@ -86,6 +86,11 @@ struct PortscanConfig
 
     bool alert_all;
     bool logfile;
+    bool sketch;
+
+    double sketch_error;
+    double sketch_failure;
+    double sketch_distinct_error;
 
     unsigned tcp_window;
     unsigned udp_window;
@@ -167,6 +172,7 @@ void ps_update_memusage_peg();
 unsigned ps_node_size();
 bool ps_init_hash(unsigned long);
 bool ps_prune_hash(unsigned);
+bool ps_init_sketch(double error, double failure, double distinct_error);
 int ps_detect(PS_PKT*);
 
 #endif
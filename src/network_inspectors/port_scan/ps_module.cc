@@ -23,6 +23,7 @@
 #endif
 
 #include "ps_module.h"
+#include "ps_sketch.h"
 #include "log/messages.h"
 #include "main/snort.h"
 #include "main/snort_config.h"
@@ -62,7 +63,19 @@ static const Parameter scan_params[] =
 static const Parameter ps_params[] =
 {
     { "memcap", Parameter::PT_INT, "1024:maxSZ", "10485760",
-      "maximum tracker memory in bytes" },
+      "maximum tracker or sketch memory in bytes per packet thread" },
+
+    { "sketch", Parameter::PT_BOOL, nullptr, "false",
+      "track scans with fixed size sketches instead of per host trackers limited by memcap" },
+
+    { "sketch_error", Parameter::PT_REAL, "0.001:0.1", "0.001",
+      "sketch count error bound as a fraction of all attempts in a window" },
+
+    { "sketch_failure", Parameter::PT_REAL, "0.01:0.5", "0.01",
+      "probability that a sketch count exceeds the error bound" },
+
+    { "sketch_distinct_error", Parameter::PT_REAL, "0.05:0.5", "0.1",
+      "relative standard error of sketch distinct host and port estimates" },
 
     { "protos", Parameter::PT_MULTI, protos, "all",
       "choose the protocols to monitor" },
@@ -243,6 +256,18 @@ bool PortScanModule::set(const char* fqn, Value& v, SnortConfig*)
     if ( v.is("memcap") )
         config->memcap = v.get_size();
 
+    else if ( v.is("sketch") )
+        config->sketch = v.get_bool();
+
+    else if ( v.is("sketch_error") )
+        config->sketch_error = v.get_real();
+
+    else if ( v.is("sketch_failure") )
+        config->sketch_failure = v.get_real();
+
+    else if ( v.is("sketch_distinct_error") )
+        config->sketch_distinct_error = v.get_real();
+
     else if ( v.is("protos") )
     {
         unsigned u = v.get_uint32();
@@ -329,8 +354,21 @@ bool PortScanModule::set(const char* fqn, Value& v, SnortConfig*)
 
 bool PortScanModule::end(const char* fqn, int, SnortConfig* sc)
 {
+    if ( config->sketch and !strcmp(fqn, "port_scan") )
+    {
+        size_t need = PsSketch::mem_needed(config->sketch_error, config->sketch_failure,
+            config->sketch_distinct_error);
+
+        if ( need > config->memcap )
+        {
+            ParseError("port_scan: sketch needs %zu bytes, more than memcap %zu; "
+                "raise memcap or the sketch error bounds", need, config->memcap);
+            return false;
+        }
+    }
+
     if ( Snort::is_reloading() && strcmp(fqn, "port_scan") == 0 )
-        sc->register_reload_handler(new PortScanReloadTuner(config->memcap));
+        sc->register_reload_handler(new PortScanReloadTuner(*config));
     return true;
 }
 
@@ -142,11 +142,18 @@ struct SnortConfig;
 class PortScanReloadTuner : public snort::ReloadResourceTuner
 {
 public:
-    explicit PortScanReloadTuner(size_t memcap) : memcap(memcap) { }
+    explicit PortScanReloadTuner(const PortscanConfig& pc) :
+        memcap(pc.memcap), sketch(pc.sketch), sketch_error(pc.sketch_error),
+        sketch_failure(pc.sketch_failure), sketch_distinct_error(pc.sketch_distinct_error)
+    { }
     ~PortScanReloadTuner() override = default;
 
     bool tinit() override
-    { return ps_init_hash(memcap); }
+    {
+        if ( sketch )
+            return ps_init_sketch(sketch_error, sketch_failure, sketch_distinct_error);
+        return ps_init_hash(memcap);
+    }
 
     bool tune_idle_context() override
     { return ps_prune_hash(max_work_idle); }
@@ -156,6 +163,10 @@ public:
 
 private:
     size_t memcap;
+    bool sketch;
+    double sketch_error;
+    double sketch_failure;
+    double sketch_distinct_error;
 };
 
 //-------------------------------------------------------------------------
@@ -0,0 +1,326 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ps_sketch.h"
+
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+struct PsSketch::Cell
+{
+    time_t window;
+    int connection_count;
+    int priority_count;
+
+    // running sum of 2^-register and number of empty registers, kept so an
+    // estimate doesn't have to scan the registers
+    float ip_sum;
+    float port_sum;
+    uint16_t ip_zeros;
+    uint16_t port_zeros;
+
+    unsigned short low_p;
+    unsigned short high_p;
+    unsigned char alerts;
+};
+
+// FNV-1a with a 64 bit finalizer so the low bits used for column and
+// register selection depend on the whole key
+static uint64_t hash_bytes(const void* data, size_t len, uint64_t seed)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+
+    for ( size_t i = 0; i < len; ++i )
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb93fe53ec88dULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+void PsSketch::size(double e, double f, double d,
+    unsigned& width, unsigned& depth, unsigned& register_bits)
+{
+    assert(e > 0.0 and f > 0.0 and f < 1.0 and d > 0.0);
+
+    // count-min sizing: w = e / error, d = ln(1 / failure)
+    width = (unsigned)ceil(M_E / e);
+    depth = (unsigned)ceil(log(1.0 / f));
+
+    if ( depth < 1 )
+        depth = 1;
+    else if ( depth > PS_SKETCH_MAX_DEPTH )
+        depth = PS_SKETCH_MAX_DEPTH;
+
+    // HyperLogLog standard error is 1.04 / sqrt(m)
+    double m = (1.04 / d) * (1.04 / d);
+    register_bits = 4;
+
+    while ( register_bits < 12 and (1u << register_bits) < m )
+        ++register_bits;
+}
+
+size_t PsSketch::mem_needed(double e, double f, double d)
+{
+    unsigned width, depth, register_bits;
+    size(e, f, d, width, depth, register_bits);
+
+    size_t num_cells = (size_t)width * depth;
+    return sizeof(PsSketch) + num_cells * (sizeof(Cell) + 2 * (1u << register_bits));
+}
+
+PsSketch::PsSketch(double e, double f, double d) :
+    error(e), failure(f), distinct_error(d)
+{
+    size(error, failure, distinct_error, width, depth, register_bits);
+    registers = 1u << register_bits;
+
+    switch ( registers )
+    {
+    case 16: alpha = 0.673; break;
+    case 32: alpha = 0.697; break;
+    case 64: alpha = 0.709; break;
+    default: alpha = 0.7213 / (1.0 + 1.079 / registers); break;
+    }
+
+    size_t num_cells = (size_t)width * depth;
+    cells = new Cell[num_cells];
+    regs = new uint8_t[num_cells * 2 * registers];
+    mem_used = mem_needed(error, failure, distinct_error);
+
+    clear();
+    memset(entries, 0, sizeof(entries));
+}
+
+PsSketch::~PsSketch()
+{
+    delete[] cells;
+    delete[] regs;
+}
+
+bool PsSketch::matches(double e, double f, double d) const
+{ return e == error and f == failure and d == distinct_error; }
+
+PsSketch::Cell* PsSketch::get_cell(unsigned row, unsigned col) const
+{ return cells + (size_t)row * width + col; }
+
+uint8_t* PsSketch::get_ip_regs(const Cell* c) const
+{ return regs + (size_t)(c - cells) * 2 * registers; }
+
+uint8_t* PsSketch::get_port_regs(const Cell* c) const
+{ return get_ip_regs(c) + registers; }
+
+void PsSketch::reset_cell(Cell* c)
+{
+    memset(c, 0, sizeof(*c));
+    c->ip_sum = c->port_sum = registers;
+    c->ip_zeros = c->port_zeros = registers;
+    memset(get_ip_regs(c), 0, 2 * registers);
+}
+
+void PsSketch::clear()
+{
+    for ( size_t i = 0; i < (size_t)width * depth; ++i )
+        reset_cell(cells + i);
+}
+
+void PsSketch::add(uint8_t* r, float& sum, uint16_t& zeros, uint64_t hash)
+{
+    unsigned idx = hash & (registers - 1);
+    uint64_t w = hash >> register_bits;
+
+    // position of the first set bit in the remaining hash bits
+    uint8_t rank = w ? __builtin_clzll(w) - register_bits + 1 : 64 - register_bits + 1;
+
+    if ( rank <= r[idx] )
+        return;
+
+    if ( !r[idx] )
+        --zeros;
+
+    sum -= ldexpf(1.0f, -r[idx]);
+    sum += ldexpf(1.0f, -rank);
+    r[idx] = rank;
+}
+
+unsigned PsSketch::estimate(float sum, uint16_t zeros) const
+{
+    double m = registers;
+    double est = alpha * m * m / sum;
+
+    // linear counting is more accurate for the small counts that matter here
+    if ( est <= 2.5 * m and zeros )
+        est = m * log(m / zeros);
+
+    return (unsigned)(est + 0.5);
+}
+
+void PsSketch::refresh(Entry& e)
+{
+    unsigned ips = UINT32_MAX;
+    unsigned ports = UINT32_MAX;
+
+    for ( unsigned row = 0; row < depth; ++row )
+    {
+        const Cell* c = get_cell(row, e.cols[row]);
+        unsigned n = estimate(c->ip_sum, c->ip_zeros);
+
+        if ( n < ips )
+            ips = n;
+
+        n = estimate(c->port_sum, c->port_zeros);
+
+        if ( n < ports )
+            ports = n;
+    }
+
+    e.tracker.proto.u_ip_count = ips;
+    e.tracker.proto.u_port_count = ports;
+}
+
+PS_TRACKER* PsSketch::get(const void* key, size_t len, time_t now, unsigned slot)
+{
+    assert(slot < 2);
+    Entry& e = entries[slot];
+    memset(&e.tracker, 0, sizeof(e.tracker));
+
+    // double hashing gives the depth independent columns
+    uint64_t h1 = hash_bytes(key, len, 0);
+    uint64_t h2 = hash_bytes(key, len, h1) | 1;
+
+    PS_PROTO& proto = e.tracker.proto;
+    const Cell* best = nullptr;
+    int pri = INT_MAX;
+    bool alerted = true;
+
+    for ( unsigned row = 0; row < depth; ++row )
+    {
+        e.cols[row] = (h1 + row * h2) % width;
+        Cell* c = get_cell(row, e.cols[row]);
+
+        if ( c->window and now > c->window )
+            reset_cell(c);
+
+        if ( !best or c->connection_count < best->connection_count )
+            best = c;
+
+        if ( c->priority_count < pri )
+            pri = c->priority_count;
+
+        if ( c->window > proto.window )
+            proto.window = c->window;
+
+        if ( !c->alerts )
+            alerted = false;
+    }
+
+    proto.connection_count = best->connection_count;
+    proto.priority_count = pri;
+    proto.low_p = best->low_p;
+    proto.high_p = best->high_p;
+
+    // the key alerted already only if every one of its cells did
+    if ( alerted )
+        proto.alerts = get_cell(0, e.cols[0])->alerts;
+
+    e.connection_count = proto.connection_count;
+    e.priority_count = proto.priority_count;
+    refresh(e);
+
+    return &e.tracker;
+}
+
+void PsSketch::update(unsigned slot)
+{
+    assert(slot < 2);
+    Entry& e = entries[slot];
+    PS_PROTO& proto = e.tracker.proto;
+
+    int conn = proto.connection_count - e.connection_count;
+    int pri = proto.priority_count - e.priority_count;
+
+    // ps_proto_update() records the peer and port of a connection attempt in
+    // u_ips and u_ports; a get() leaves u_ips unset
+    bool attempt = proto.u_ips.is_set();
+    uint64_t ip_hash = 0;
+    uint64_t port_hash = 0;
+
+    if ( attempt )
+    {
+        ip_hash = hash_bytes(proto.u_ips.get_ip6_ptr(), 16, 0);
+        port_hash = hash_bytes(&proto.u_ports, sizeof(proto.u_ports), 0);
+    }
+
+    for ( unsigned row = 0; row < depth; ++row )
+    {
+        Cell* c = get_cell(row, e.cols[row]);
+
+        c->connection_count += conn;
+        if ( c->connection_count < 0 )
+            c->connection_count = 0;
+
+        c->priority_count += pri;
+        if ( c->priority_count < 0 )
+            c->priority_count = 0;
+
+        if ( !c->window )
+            c->window = proto.window;
+
+        if ( !attempt )
+            continue;
+
+        add(get_ip_regs(c), c->ip_sum, c->ip_zeros, ip_hash);
+        add(get_port_regs(c), c->port_sum, c->port_zeros, port_hash);
+
+        if ( !c->low_p or c->low_p > proto.u_ports )
+            c->low_p = proto.u_ports;
+
+        if ( c->high_p < proto.u_ports )
+            c->high_p = proto.u_ports;
+    }
+
+    e.connection_count = proto.connection_count;
+    e.priority_count = proto.priority_count;
+    proto.u_ips.clear();
+
+    refresh(e);
+}
+
+void PsSketch::set_alerts(unsigned slot)
+{
+    assert(slot < 2);
+    Entry& e = entries[slot];
+
+    if ( !e.tracker.proto.alerts )
+        return;
+
+    for ( unsigned row = 0; row < depth; ++row )
+        get_cell(row, e.cols[row])->alerts = e.tracker.proto.alerts;
+}
+
@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef PS_SKETCH_H
+#define PS_SKETCH_H
+
+// Fixed size alternative to the port scan tracker hash. Trackers are kept
+// in a count-min sketch whose cells hold the connection and priority counts
+// plus HyperLogLog registers estimating the distinct hosts and ports seen in
+// the cell's window. A lookup hashes the tracker key to one cell per row and
+// builds a PS_TRACKER from the least inflated estimates, so collisions can
+// only make counts larger, never smaller.
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "ps_detect.h"
+
+#define PS_SKETCH_SCANNER 0
+#define PS_SKETCH_SCANNED 1
+
+#define PS_SKETCH_MAX_DEPTH 8
+
+class PsSketch
+{
+public:
+    // error is the count-min bound as a fraction of all attempts counted in a
+    // window, failure the probability of exceeding it, and distinct_error the
+    // relative standard error of the distinct host and port estimates.
+    PsSketch(double error, double failure, double distinct_error);
+    ~PsSketch();
+
+    PsSketch(const PsSketch&) = delete;
+    PsSketch& operator=(const PsSketch&) = delete;
+
+    // bytes a sketch with these bounds would allocate
+    static size_t mem_needed(double error, double failure, double distinct_error);
+
+    // Build the tracker for key in the given slot from the current estimates.
+    // The tracker remains valid until the next get() for that slot.
+    PS_TRACKER* get(const void* key, size_t len, time_t now, unsigned slot);
+
+    // Fold the counts and the peer recorded by ps_proto_update() into the
+    // sketch and refresh the distinct estimates of the slot's tracker.
+    void update(unsigned slot);
+
+    // Remember the alert state of the slot's tracker for the rest of the window.
+    void set_alerts(unsigned slot);
+
+    void clear();
+
+    bool matches(double error, double failure, double distinct_error) const;
+
+    size_t get_mem_used() const
+    { return mem_used; }
+
+    unsigned get_width() const
+    { return width; }
+
+    unsigned get_depth() const
+    { return depth; }
+
+    unsigned get_registers() const
+    { return registers; }
+
+private:
+    struct Cell;
+    struct Entry
+    {
+        PS_TRACKER tracker;
+        unsigned cols[PS_SKETCH_MAX_DEPTH];
+        int connection_count;
+        int priority_count;
+    };
+
+    static void size(double error, double failure, double distinct_error,
+        unsigned& width, unsigned& depth, unsigned& register_bits);
+
+    Cell* get_cell(unsigned row, unsigned col) const;
+    uint8_t* get_ip_regs(const Cell*) const;
+    uint8_t* get_port_regs(const Cell*) const;
+
+    void reset_cell(Cell*);
+    void add(uint8_t* regs, float& sum, uint16_t& zeros, uint64_t hash);
+    unsigned estimate(float sum, uint16_t zeros) const;
+    void refresh(Entry&);
+
+    double error;
+    double failure;
+    double distinct_error;
+
+    unsigned width;
+    unsigned depth;
+    unsigned registers;
+    unsigned register_bits;
+    double alpha;
+
+    Cell* cells;
+    uint8_t* regs;
+    size_t mem_used;
+
+    Entry entries[2];
+};
+
+#endif
+
@@ -0,0 +1,386 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ps_sketch_test.cc - count-min and distinct estimates of the port scan sketch
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/port_scan/ps_sketch.h"
+
+#include <sys/socket.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+namespace snort
+{
+char* snort_strdup(const char* s) { return strdup(s); }
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+#define WINDOW 60
+
+// what ps_proto_update() does to the tracker for a connection attempt
+static PS_TRACKER* attempt(
+    PsSketch& ps, uint32_t key, uint32_t peer, unsigned short port, time_t now,
+    int conns = 1, unsigned slot = PS_SKETCH_SCANNER)
+{
+    PS_TRACKER* t = ps.get(&key, sizeof(key), now, slot);
+    PS_PROTO& proto = t->proto;
+
+    if ( now > proto.window )
+    {
+        memset(&proto, 0, sizeof(proto));
+        proto.window = now + WINDOW;
+    }
+    proto.connection_count += conns;
+    proto.u_ips.set(&peer, AF_INET);
+    proto.u_ports = port;
+
+    ps.update(slot);
+    return t;
+}
+
+static PS_PROTO lookup(PsSketch& ps, uint32_t key, time_t now)
+{ return ps.get(&key, sizeof(key), now, PS_SKETCH_SCANNED)->proto; }
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(ps_sketch) { };
+
+TEST(ps_sketch, dimensions)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+
+    // e / 0.01, ln(1 / 0.01), and (1.04 / 0.1)^2 rounded up to a power of 2
+    CHECK_EQUAL(272u, ps.get_width());
+    CHECK_EQUAL(5u, ps.get_depth());
+    CHECK_EQUAL(128u, ps.get_registers());
+    CHECK(ps.matches(0.01, 0.01, 0.1));
+    CHECK(!ps.matches(0.02, 0.01, 0.1));
+
+    PsSketch tiny(1.0, 0.5, 1.0);
+    CHECK_EQUAL(3u, tiny.get_width());
+    CHECK_EQUAL(1u, tiny.get_depth());
+    CHECK_EQUAL(16u, tiny.get_registers());
+}
+
+TEST(ps_sketch, mem_needed)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+    CHECK_EQUAL(PsSketch::mem_needed(0.01, 0.01, 0.1), ps.get_mem_used());
+
+    // the defaults fit the default memcap and the tightest allowed bounds 16 MB
+    CHECK(PsSketch::mem_needed(0.001, 0.01, 0.1) < 10485760);
+    CHECK(PsSketch::mem_needed(0.001, 0.01, 0.05) < 16777216);
+}
+
+TEST(ps_sketch, insert_estimate)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+    time_t now = 1000;
+
+    PS_PROTO p = lookup(ps, 1, now);
+    CHECK_EQUAL(0, p.connection_count);
+    CHECK_EQUAL(0, p.u_ip_count);
+    CHECK_EQUAL(0, p.u_port_count);
+    CHECK_EQUAL(0, p.window);
+
+    for ( unsigned i = 0; i < 5; ++i )
+        attempt(ps, 1, 0x0a000001 + i, 100 + i, now);
+
+    // repeated peers and ports aren't distinct
+    attempt(ps, 1, 0x0a000001, 100, now);
+
+    p = lookup(ps, 1, now);
+    CHECK_EQUAL(6, p.connection_count);
+
+    // small distinct counts are nearly exact
+    CHECK(abs(p.u_ip_count - 5) <= 1);
+    CHECK(abs(p.u_port_count - 5) <= 1);
+    CHECK_EQUAL(100, p.low_p);
+    CHECK_EQUAL(104, p.high_p);
+    CHECK_EQUAL(now + WINDOW, p.window);
+
+    // priority and negative counts are folded in without an attempt
+    uint32_t key = 1;
+    PS_TRACKER* t = ps.get(&key, sizeof(key), now, PS_SKETCH_SCANNER);
+    t->proto.priority_count += 2;
+    t->proto.connection_count -= 10;
+    ps.update(PS_SKETCH_SCANNER);
+
+    p = lookup(ps, 1, now);
+    CHECK_EQUAL(0, p.connection_count);
+    CHECK_EQUAL(2, p.priority_count);
+    CHECK(abs(p.u_ip_count - 5) <= 1);
+
+    p = lookup(ps, 2, now);
+    CHECK_EQUAL(0, p.connection_count);
+    CHECK_EQUAL(0, p.u_ip_count);
+}
+
+TEST(ps_sketch, slots)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+    time_t now = 1000;
+
+    uint32_t a = 1, b = 2;
+    PS_TRACKER* ta = ps.get(&a, sizeof(a), now, PS_SKETCH_SCANNER);
+    PS_TRACKER* tb = ps.get(&b, sizeof(b), now, PS_SKETCH_SCANNED);
+    CHECK(ta != tb);
+
+    ta->proto.window = now + WINDOW;
+    ta->proto.connection_count = 3;
+    tb->proto.window = now + WINDOW;
+    tb->proto.connection_count = 7;
+
+    ps.update(PS_SKETCH_SCANNED);
+    ps.update(PS_SKETCH_SCANNER);
+
+    CHECK_EQUAL(3, lookup(ps, a, now).connection_count);
+    CHECK_EQUAL(7, lookup(ps, b, now).connection_count);
+}
+
+TEST(ps_sketch, collisions)
+{
+    // one row of three columns so most keys share a cell
+    PsSketch ps(1.0, 0.5, 0.1);
+    time_t now = 1000;
+
+    const unsigned keys = 30;
+    int sum = 0;
+
+    for ( unsigned k = 0; k < keys; ++k )
+    {
+        attempt(ps, k, k, k, now, k + 1);
+        sum += k + 1;
+    }
+
+    // collisions only inflate the counts, and each key gets the total of
+    // the keys sharing its cell
+    std::set<int> totals;
+    unsigned inflated = 0;
+
+    for ( unsigned k = 0; k < keys; ++k )
+    {
+        int est = lookup(ps, k, now).connection_count;
+        CHECK(est >= (int)k + 1);
+
+        if ( est > (int)k + 1 )
+            ++inflated;
+
+        totals.insert(est);
+    }
+    CHECK(inflated >= keys - 3);
+    CHECK(totals.size() <= 3);
+
+    int all = 0;
+    for ( auto t : totals )
+        all += t;
+
+    CHECK_EQUAL(sum, all);
+}
+
+TEST(ps_sketch, error_bound)
+{
+    const double error = 0.01;
+    const double failure = 0.01;
+    PsSketch ps(error, failure, 0.1);
+    time_t now = 1000;
+
+    // skewed counts like a few scanners among many quiet hosts
+    const unsigned keys = 2000;
+    std::vector<int> counts(keys);
+    int sum = 0;
+
+    for ( unsigned k = 0; k < keys; ++k )
+    {
+        counts[k] = (k % 100) ? 1 + k % 7 : 200;
+        attempt(ps, k, k, k, now, counts[k]);
+        sum += counts[k];
+    }
+
+    unsigned over = 0;
+
+    for ( unsigned k = 0; k < keys; ++k )
+    {
+        int est = lookup(ps, k, now).connection_count;
+        CHECK(est >= counts[k]);
+
+        if ( est - counts[k] > error * sum )
+            ++over;
+    }
+    CHECK(over <= failure * keys);
+}
+
+TEST(ps_sketch, distinct_error)
+{
+    const double distinct_error = 0.05;
+    PsSketch ps(0.01, 0.01, distinct_error);
+    time_t now = 1000;
+
+    const unsigned peers[] = { 10, 100, 1000, 5000 };
+    uint32_t key = 0;
+
+    for ( auto n : peers )
+    {
+        ++key;
+        for ( unsigned i = 0; i < n; ++i )
+            attempt(ps, key, 0x0a000000 + i, i, now);
+
+        PS_PROTO p = lookup(ps, key, now);
+        double ips = p.u_ip_count;
+        double ports = p.u_port_count;
+
+        // within 3 standard errors, give or take rounding
+        CHECK(fabs(ips - n) <= 3 * distinct_error * n + 1);
+        CHECK(fabs(ports - n) <= 3 * distinct_error * n + 1);
+        CHECK_EQUAL((int)n, p.connection_count);
+    }
+}
+
+TEST(ps_sketch, distinct_collisions)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+    time_t now = 1000;
+
+    const unsigned keys = 100;
+
+    for ( uint32_t k = 0; k < keys; ++k )
+    {
+        for ( unsigned i = 0; i <= k % 20; ++i )
+            attempt(ps, k, (k << 16) + i, (k << 8) + i, now);
+    }
+
+    // most keys have a row to themselves and that row gives the estimate
+    unsigned close = 0;
+
+    for ( uint32_t k = 0; k < keys; ++k )
+    {
+        PS_PROTO p = lookup(ps, k, now);
+        int n = k % 20 + 1;
+        CHECK(p.u_ip_count >= n - 2);
+
+        if ( abs(p.u_ip_count - n) <= 1 and abs(p.u_port_count - n) <= 1 )
+            ++close;
+    }
+    CHECK(close >= 0.8 * keys);
+}
+
+TEST(ps_sketch, aging)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+    time_t now = 1000;
+
+    attempt(ps, 1, 1, 1, now, 4);
+    attempt(ps, 1, 2, 2, now + WINDOW, 4);
+
+    PS_PROTO p = lookup(ps, 1, now + WINDOW);
+    CHECK_EQUAL(8, p.connection_count);
+    CHECK_EQUAL(2, p.u_ip_count);
+
+    // the cells reset once the window has passed
+    p = lookup(ps, 1, now + WINDOW + 1);
+    CHECK_EQUAL(0, p.connection_count);
+    CHECK_EQUAL(0, p.u_ip_count);
+    CHECK_EQUAL(0, p.u_port_count);
+    CHECK_EQUAL(0, p.window);
+
+    // and start a new one
+    attempt(ps, 1, 3, 3, now + 2 * WINDOW, 1);
+    p = lookup(ps, 1, now + 2 * WINDOW);
+    CHECK_EQUAL(1, p.connection_count);
+    CHECK_EQUAL(1, p.u_ip_count);
+    CHECK_EQUAL(now + 3 * WINDOW, p.window);
+}
+
+TEST(ps_sketch, clear)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+    time_t now = 1000;
+
+    for ( uint32_t k = 0; k < 100; ++k )
+        attempt(ps, k, k, k, now, 2);
+
+    ps.clear();
+
+    for ( uint32_t k = 0; k < 100; ++k )
+    {
+        PS_PROTO p = lookup(ps, k, now);
+        CHECK_EQUAL(0, p.connection_count);
+        CHECK_EQUAL(0, p.u_ip_count);
+        CHECK_EQUAL(0, p.window);
+    }
+}
+
+TEST(ps_sketch, alerts)
+{
+    PsSketch ps(0.01, 0.01, 0.1);
+    time_t now = 1000;
+
+    PS_TRACKER* t = attempt(ps, 1, 1, 1, now);
+    CHECK_EQUAL(0, t->proto.alerts);
+
+    t->proto.alerts = PS_ALERT_GENERATED;
+    ps.set_alerts(PS_SKETCH_SCANNER);
+
+    CHECK_EQUAL(PS_ALERT_GENERATED, lookup(ps, 1, now).alerts);
+    CHECK_EQUAL(0, lookup(ps, 2, now).alerts);
+
+    // other keys have alerted only if they share all the cells
+    PsSketch small(1.0, 0.1, 0.1);
+    t = attempt(small, 0, 0, 0, now);
+    t->proto.alerts = PS_ALERT_GENERATED;
+    small.set_alerts(PS_SKETCH_SCANNER);
+
+    unsigned alerted = 0;
+
+    for ( uint32_t k = 1; k < 100; ++k )
+    {
+        if ( lookup(small, k, now).alerts )
+            ++alerted;
+    }
+    CHECK(alerted < 15);
+
+    // cleared with the window
+    CHECK_EQUAL(0, lookup(ps, 1, now + WINDOW + 1).alerts);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
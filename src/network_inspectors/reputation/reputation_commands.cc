@@ -23,6 +23,8 @@
 
 #include "reputation_commands.h"
 
+#include <lua.hpp>
+
 #include "control/control.h"
 #include "log/messages.h"
 #include "main/analyzer_command.h"
@@ -30,6 +32,7 @@
 
 #include "reputation_common.h"
 #include "reputation_inspect.h"
+#include "reputation_table_file.h"
 
 using namespace snort;
 
@@ -37,6 +40,7 @@ class ReputationReload : public AnalyzerCommand
 {
 public:
     ReputationReload(ControlConn*, Reputation&);
+    ReputationReload(ControlConn*, Reputation&, ReputationData*);
     ~ReputationReload() override;
 
     bool execute(Analyzer&, void**) override;
@@ -59,6 +63,14 @@ ReputationReload::ReputationReload(ControlConn* conn, Reputation& ins)
     data = ins.load_data();
 }
 
+// publish data that has already been built, e.g. by applying a delta
+ReputationReload::ReputationReload(ControlConn* conn, Reputation& ins, ReputationData* data)
+    : AnalyzerCommand(conn), ins(ins), data(data)
+{
+    ins.add_global_ref();
+    log_message(".. reputation updating\n");
+}
+
 ReputationReload::~ReputationReload()
 {
     ins.swap_data(data);
@@ -83,8 +95,58 @@ static int reload(lua_State* L)
     return 0;
 }
 
+static int update(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    const char* list_file = luaL_optstring(L, 1, nullptr);
+    const char* delta_file = luaL_optstring(L, 2, nullptr);
+    Reputation* ins = static_cast<Reputation*>(InspectorManager::get_inspector(REPUTATION_NAME));
+
+    if (!ins)
+        AnalyzerCommand::log_message(ctrlcon, "No reputation instance configured to update\n");
+    else if (!list_file or !delta_file)
+        AnalyzerCommand::log_message(ctrlcon, "Usage: reputation.update(list_file, delta_file)\n");
+    else if (ReputationData* data = ins->load_delta(list_file, delta_file))
+        main_broadcast_command(new ReputationReload(ctrlcon, *ins, data), ctrlcon);
+    else
+        AnalyzerCommand::log_message(ctrlcon, "== Reputation update failed, see log\n");
+    return 0;
+}
+
+static const Parameter update_params[] =
+{
+    {"list_file", Parameter::PT_STRING, nullptr, nullptr, "list file as named in the configuration or manifest"},
+    {"delta_file", Parameter::PT_STRING, nullptr, nullptr, "file with +address and -address lines"},
+    {nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr}
+};
+
+static int save_table(lua_State* L)
+{
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    const char* file_name = luaL_optstring(L, 1, nullptr);
+    Reputation* ins = static_cast<Reputation*>(InspectorManager::get_inspector(REPUTATION_NAME));
+
+    if (!ins)
+        AnalyzerCommand::log_message(ctrlcon, "No reputation instance configured\n");
+    else if (!file_name)
+        AnalyzerCommand::log_message(ctrlcon, "Usage: reputation.save_table(file_name)\n");
+    else if (save_reputation_table(file_name, ins->get_data()))
+        AnalyzerCommand::log_message(ctrlcon, "== Reputation table saved\n");
+    else
+        AnalyzerCommand::log_message(ctrlcon, "== Reputation table not saved, see log\n");
+    return 0;
+}
+
+static const Parameter save_table_params[] =
+{
+    {"file_name", Parameter::PT_STRING, nullptr, nullptr, "file to write the table to"},
+    {nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr}
+};
+
 const Command reputation_cmds[] =
 {
     {"reload", reload, nullptr, "reload reputation data"},
+    {"update", update, update_params, "add and remove addresses of one list without a full reload"},
+    {"save_table", save_table, save_table_params, "save the current table for use as table_file"},
     {nullptr, nullptr, nullptr, nullptr}
 };
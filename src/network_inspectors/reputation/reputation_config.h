@@ -87,6 +87,7 @@ struct ReputationConfig
     std::string blocklist_path;
     std::string allowlist_path;
     std::string list_dir;
+    std::string table_file;
 };
 
 struct IPrepInfo
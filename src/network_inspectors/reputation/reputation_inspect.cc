@@ -25,6 +25,8 @@
 
 #include "reputation_inspect.h"
 
+#include <sys/mman.h>
+
 #include "detection/detect.h"
 #include "detection/detection_engine.h"
 #include "events/event_queue.h"
@@ -41,6 +43,7 @@
 #include "utils/util.h"
 
 #include "reputation_parse.h"
+#include "reputation_table_file.h"
 
 using namespace snort;
 
@@ -521,6 +524,9 @@ ReputationData::~ReputationData()
     if (reputation_segment)
         snort_free(reputation_segment);
 
+    if (mapped_table)
+        munmap(mapped_table, mapped_size);
+
     for (auto& file : list_files)
         delete file;
 }
@@ -534,6 +540,17 @@ Reputation::~Reputation()
 ReputationData* Reputation::load_data()
 {
     ReputationData* data = new ReputationData();
+
+    if (!config.table_file.empty())
+    {
+        if (map_reputation_table(config.table_file.c_str(), *data))
+        {
+            reputationstats.memory_allocated = data->usage;
+            return data;
+        }
+        ErrorMessage("reputation: falling back to parsing the IP lists\n");
+    }
+
     if (!config.list_dir.empty())
         ReputationParser::read_manifest(MANIFEST_FILENAME, config, *data);
 
@@ -548,9 +565,29 @@ ReputationData* Reputation::load_data()
     {
         ReputationParser parser;
         parser.ip_list_init(data->num_entries + 1, config, *data);
-        reputationstats.memory_allocated = parser.get_usage();
+        data->segment_size = parser.get_segment_used();
+        data->usage = parser.get_usage();
+        reputationstats.memory_allocated = data->usage;
+    }
+
+    return data;
+}
+
+ReputationData* Reputation::load_delta(const char* list_file, const char* delta_file)
+{
+    // apply on top of a previous update that is still being published
+    const ReputationData& cur = pending_data ? *pending_data : *rep_data;
+    ReputationData* data = new ReputationData();
+    ReputationParser parser;
+
+    if (!parser.apply_delta(list_file, delta_file, config, cur, *data))
+    {
+        delete data;
+        return nullptr;
     }
 
+    reputationstats.memory_allocated = data->usage;
+    pending_data = data;
     return data;
 }
 
@@ -559,6 +596,9 @@ void Reputation::swap_thread_data(ReputationData* data)
 
 void Reputation::swap_data(ReputationData* data)
 {
+    if (pending_data == data)
+        pending_data = nullptr;
+
     delete rep_data;
     rep_data = data;
 }
@@ -579,6 +619,7 @@ void Reputation::show(const SnortConfig*) const
     ConfigLogger::log_flag("scan_local", config.scanlocal);
     ConfigLogger::log_value("allow (action)", to_string(config.allow_action));
     ConfigLogger::log_value("allowlist", config.allowlist_path.c_str());
+    ConfigLogger::log_value("table_file", config.table_file.c_str());
 }
 
 bool Reputation::configure(SnortConfig*)
@@ -33,8 +33,14 @@ public:
     ListFiles list_files;
     uint8_t* reputation_segment = nullptr;
     table_flat_t* ip_list = nullptr;
+    size_t segment_size = 0;        // bytes of the segment in use, starting at ip_list
+    unsigned usage = 0;             // table memory usage as reported by sfrt
     int num_entries = 0;
     bool memcap_reached = false;
+
+    // set when ip_list is mapped from a prebuilt table file instead
+    void* mapped_table = nullptr;
+    size_t mapped_size = 0;
 };
 
 class Reputation : public snort::Inspector
@@ -57,6 +63,7 @@ public:
     const ReputationConfig& get_config()
     { return config; }
     ReputationData* load_data();
+    ReputationData* load_delta(const char* list_file, const char* delta_file);
 
     void swap_thread_data(ReputationData*);
     void swap_data(ReputationData*);
@@ -64,6 +71,7 @@ public:
 private:
     ReputationConfig config;
     ReputationData* rep_data;
+    ReputationData* pending_data = nullptr;  // built but not yet swapped in
 };
 
 #endif
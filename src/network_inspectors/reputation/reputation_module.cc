@@ -77,6 +77,9 @@ static const Parameter s_params[] =
     { "allowlist", Parameter::PT_STRING, nullptr, nullptr,
       "allowlist file name with IP lists" },
 
+    { "table_file", Parameter::PT_STRING, nullptr, nullptr,
+      "prebuilt table saved with reputation.save_table; mapped instead of parsing the lists" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -149,6 +152,9 @@ bool ReputationModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("allowlist") )
         conf->allowlist_path = v.get_string();
 
+    else if ( v.is("table_file") )
+        conf->table_file = v.get_string();
+
     return true;
 }
 
@@ -918,6 +918,208 @@ static bool process_line_in_manifest(ListFile* list_item, const char* manifest,
     return true;
 }
 
+// Drop list_index from the lists of a single entry, keeping the order of the rest
+static bool remove_list_index(IPrepInfo* rep_info, uint8_t* base, char list_index)
+{
+    IPrepInfo* dest_info = rep_info;
+    int dest = 0;
+    bool found = false;
+
+    while (rep_info)
+    {
+        for (int i = 0; i < NUM_INDEX_PER_ENTRY; i++)
+        {
+            char index = rep_info->list_indexes[i];
+            rep_info->list_indexes[i] = 0;
+
+            if (!index)
+                break;
+
+            if (index == list_index)
+            {
+                found = true;
+                continue;
+            }
+
+            if (dest == NUM_INDEX_PER_ENTRY)
+            {
+                dest_info = (IPrepInfo*)&base[dest_info->next];
+                dest = 0;
+            }
+            dest_info->list_indexes[dest++] = index;
+        }
+        rep_info = rep_info->next ? (IPrepInfo*)&base[rep_info->next] : nullptr;
+    }
+
+    return found;
+}
+
+bool ReputationParser::apply_delta(const char* list_file, const char* delta_file,
+    const ReputationConfig& config, const ReputationData& cur, ReputationData& data)
+{
+    char linebuf[MAX_ADDR_LINE_LENGTH];
+    char full_path_filename[PATH_MAX+1];
+    const ListFile* list_info = nullptr;
+
+    if (!cur.ip_list or !cur.segment_size)
+    {
+        ErrorMessage("reputation: no table to update\n");
+        return false;
+    }
+
+    for (const auto* file : cur.list_files)
+    {
+        if (file->file_name == list_file)
+        {
+            list_info = file;
+            break;
+        }
+    }
+
+    if (!list_info)
+    {
+        ErrorMessage("reputation: %s is not a configured list file\n", list_file);
+        return false;
+    }
+
+    update_path_to_file(full_path_filename, PATH_MAX, delta_file);
+    FILE* fp = fopen(full_path_filename, "r");
+
+    if (!fp)
+    {
+        ErrorMessage("Unable to open delta file %s, Error: %s\n", full_path_filename,
+            get_error(errno));
+        return false;
+    }
+
+    unsigned num_adds = 0;
+    while (fgets(linebuf, MAX_ADDR_LINE_LENGTH, fp))
+    {
+        if (linebuf[0] == '+')
+            num_adds++;
+    }
+    rewind(fp);
+
+    // work on a private copy; packet threads keep the current table until the swap.
+    // the headroom includes a larger data table for the new entries.
+    uint64_t mem_size = (uint64_t)cur.segment_size + estimate_size(num_adds, config.memcap) +
+        (uint64_t)sizeof(INFO) * (cur.ip_list->num_ent + num_adds);
+    if (mem_size > std::numeric_limits<uint32_t>::max())
+        mem_size = std::numeric_limits<uint32_t>::max();
+
+    data.reputation_segment = (uint8_t*)snort_alloc(mem_size);
+    memcpy(data.reputation_segment, cur.ip_list, cur.segment_size);
+    table.segment_attach(data.reputation_segment, cur.segment_size, mem_size);
+    data.ip_list = table.get_table();
+    data.num_entries = cur.num_entries;
+
+    if (!table.sfrt_flat_reserve(num_adds))
+    {
+        ErrorMessage("reputation: no room for %u more entries\n", num_adds);
+        fclose(fp);
+        return false;
+    }
+
+    for (const auto* file : cur.list_files)
+        data.list_files.emplace_back(new ListFile(*file));
+
+    uint8_t* base = data.reputation_segment;
+    MEM_OFFSET ip_info_ptr = table.segment_snort_calloc(1, sizeof(IPrepInfo));
+    if (!ip_info_ptr)
+    {
+        fclose(fp);
+        return false;
+    }
+    ((IPrepInfo*)&base[ip_info_ptr])->list_indexes[0] = list_info->list_index;
+
+    unsigned added = 0, removed = 0, invalid_count = 0, missing = 0;
+    int addrline = 0;
+    bool ok = true;
+
+    while (fgets(linebuf, MAX_ADDR_LINE_LENGTH, fp))
+    {
+        char* cmt;
+        addrline++;
+
+        if ((cmt = strchr(linebuf, '#')))
+            *cmt = '\0';
+
+        if ((cmt = strchr(linebuf, '\n')))
+            *cmt = '\0';
+
+        char* line = ignore_start_space(linebuf);
+
+        if (*line == '\0')
+            continue;
+
+        int ret = IP_INVALID;
+
+        if (*line == '+')
+        {
+            ret = process_line(line + 1, ip_info_ptr, config);
+
+            if (IP_INSERT_SUCCESS == ret or IP_INSERT_DUPLICATE == ret)
+                added++;
+        }
+        else if (*line == '-')
+        {
+            SfCidr address;
+
+            if (snort_pton(line + 1, &address) > 0)
+            {
+                IPrepInfo* rep_info = (IPrepInfo*)table.sfrt_flat_lookup_exact(&address);
+
+                if (rep_info and remove_list_index(rep_info, base, list_info->list_index))
+                    removed++;
+                else
+                    missing++;
+
+                ret = IP_INSERT_SUCCESS;
+            }
+        }
+
+        if (IP_INVALID == ret && invalid_count++ < MAX_MSGS_TO_PRINT)
+        {
+            ErrorMessage("      (%d) => Invalid delta: \'%s\'\n", addrline, linebuf);
+        }
+        else if (IP_INSERT_FAILURE == ret)
+        {
+            // a partial update would leave the list inconsistent with the feed
+            ErrorMessage("      (%d) => Failed to insert address: \'%s\'\n", addrline, linebuf);
+            ok = false;
+            break;
+        }
+        else if (IP_MEM_ALLOC_FAILURE == ret)
+        {
+            ErrorMessage(
+                "WARNING: %s(%d) => Memcap %u Mbytes reached when inserting IP Address: %s\n",
+                full_path_filename, addrline, config.memcap, linebuf);
+            ok = false;
+            break;
+        }
+    }
+
+    fclose(fp);
+
+    if (invalid_count > MAX_MSGS_TO_PRINT)
+        ErrorMessage("    Additional invalid entries were not listed.\n");
+
+    // the caller discards data, and with it everything added to the segment
+    if (!ok)
+    {
+        ErrorMessage("    Reputation delta %s for %s was not applied\n", full_path_filename, list_file);
+        return false;
+    }
+
+    LogMessage("    Reputation delta %s for %s: added %u, removed %u, not found %u, invalid %u\n",
+        full_path_filename, list_file, added, removed, missing, invalid_count);
+
+    data.segment_size = table.segment_usedmem();
+    data.usage = get_usage();
+
+    return true;
+}
+
 void ReputationParser::read_manifest(const char* manifest_file, const ReputationConfig& config, ReputationData& data)
 {
     char full_path_dir[PATH_MAX+1];
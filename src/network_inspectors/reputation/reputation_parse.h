@@ -40,9 +40,17 @@ public:
         ReputationData& data);
     void ip_list_init(uint32_t max_entries, const ReputationConfig&, ReputationData&);
 
+    // Build data from a copy of cur with the additions and removals in
+    // delta_file applied to the list loaded from list_file
+    bool apply_delta(const char* list_file, const char* delta_file,
+        const ReputationConfig&, const ReputationData& cur, ReputationData& data);
+
     unsigned get_usage() const
     { return table.sfrt_flat_usage(); }
 
+    size_t get_segment_used() const
+    { return table.segment_usedmem(); }
+
 protected:
     int duplicate_info(IPrepInfo* dest_info, IPrepInfo* current_info, uint8_t* base);
     int64_t update_entry_info_impl(INFO* current, INFO new_entry, SaveDest save_dest, uint8_t* base);
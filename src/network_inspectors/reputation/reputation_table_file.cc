@@ -0,0 +1,283 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "reputation_table_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "log/messages.h"
+#include "sfrt/sfrt_flat.h"
+#include "utils/util.h"
+
+#include "reputation_config.h"
+#include "reputation_inspect.h"
+
+using namespace snort;
+
+// File layout: header, list records, zero padding up to segment_offset,
+// then segment_size bytes of the sfrt_flat segment. Everything is in host
+// byte order; byte_order rejects files written on a different architecture.
+
+#define TABLE_FILE_MAGIC "SNRTBL01"
+#define TABLE_FILE_VERSION 1
+#define TABLE_FILE_BYTE_ORDER 0x01020304
+#define TABLE_FILE_ALIGN 4096
+
+struct TableFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t offset_size;       // sizeof(MEM_OFFSET) of the writer
+    uint32_t num_lists;
+    uint32_t usage;
+    int32_t num_entries;
+    uint64_t segment_offset;
+    uint64_t segment_size;
+};
+
+struct TableFileList
+{
+    uint32_t list_id;
+    int32_t file_type;
+    uint8_t list_index;
+    uint8_t list_type;
+    uint8_t all_intfs_enabled;
+    uint8_t reserved;
+    uint32_t num_intfs;
+    uint32_t name_len;
+    // followed by num_intfs uint32_t interfaces and name_len name bytes
+};
+
+static bool write_all(FILE* fp, const void* buf, size_t len)
+{ return fwrite(buf, 1, len, fp) == len; }
+
+bool save_reputation_table(const char* file_name, const ReputationData& data)
+{
+    if ( !data.ip_list or !data.segment_size )
+    {
+        ErrorMessage("reputation: no table to save\n");
+        return false;
+    }
+
+    // write to a temporary file and rename so readers never map a partial table
+    std::string tmp_name = std::string(file_name) + ".tmp";
+    FILE* fp = fopen(tmp_name.c_str(), "wb");
+
+    if ( !fp )
+    {
+        ErrorMessage("reputation: can't create %s: %s\n", tmp_name.c_str(), get_error(errno));
+        return false;
+    }
+
+    TableFileHeader hdr = {};
+    memcpy(hdr.magic, TABLE_FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version = TABLE_FILE_VERSION;
+    hdr.byte_order = TABLE_FILE_BYTE_ORDER;
+    hdr.offset_size = sizeof(MEM_OFFSET);
+    hdr.num_lists = data.list_files.size();
+    hdr.usage = data.usage;
+    hdr.num_entries = data.num_entries;
+    hdr.segment_size = data.segment_size;
+
+    uint64_t lists_size = 0;
+    for ( const auto* lf : data.list_files )
+        lists_size += sizeof(TableFileList) + lf->intfs.size() * sizeof(uint32_t)
+            + lf->file_name.size();
+
+    hdr.segment_offset = sizeof(hdr) + lists_size;
+    hdr.segment_offset = (hdr.segment_offset + TABLE_FILE_ALIGN - 1) & ~(uint64_t)(TABLE_FILE_ALIGN - 1);
+
+    bool ok = write_all(fp, &hdr, sizeof(hdr));
+
+    for ( auto it = data.list_files.cbegin(); ok and it != data.list_files.cend(); ++it )
+    {
+        const ListFile* lf = *it;
+        TableFileList rec = {};
+        rec.list_id = lf->list_id;
+        rec.file_type = lf->file_type;
+        rec.list_index = lf->list_index;
+        rec.list_type = lf->list_type;
+        rec.all_intfs_enabled = lf->all_intfs_enabled;
+        rec.num_intfs = lf->intfs.size();
+        rec.name_len = lf->file_name.size();
+
+        ok = write_all(fp, &rec, sizeof(rec));
+
+        for ( auto intf = lf->intfs.cbegin(); ok and intf != lf->intfs.cend(); ++intf )
+        {
+            uint32_t val = *intf;
+            ok = write_all(fp, &val, sizeof(val));
+        }
+        if ( ok )
+            ok = write_all(fp, lf->file_name.data(), lf->file_name.size());
+    }
+
+    if ( ok )
+    {
+        static const uint8_t zeros[TABLE_FILE_ALIGN] = { };
+        ok = write_all(fp, zeros, hdr.segment_offset - sizeof(hdr) - lists_size);
+    }
+
+    if ( ok )
+        ok = write_all(fp, data.ip_list, data.segment_size);
+
+    if ( fclose(fp) or !ok )
+    {
+        ErrorMessage("reputation: can't write %s: %s\n", tmp_name.c_str(), get_error(errno));
+        unlink(tmp_name.c_str());
+        return false;
+    }
+
+    if ( rename(tmp_name.c_str(), file_name) )
+    {
+        ErrorMessage("reputation: can't rename %s: %s\n", tmp_name.c_str(), get_error(errno));
+        unlink(tmp_name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static bool load_lists(const uint8_t* buf, const uint8_t* end, uint32_t num_lists,
+    ListFiles& lists)
+{
+    for ( uint32_t i = 0; i < num_lists; i++ )
+    {
+        TableFileList rec;
+
+        if ( (size_t)(end - buf) < sizeof(rec) )
+            return false;
+
+        memcpy(&rec, buf, sizeof(rec));
+        buf += sizeof(rec);
+
+        if ( (size_t)(end - buf) < rec.num_intfs * sizeof(uint32_t) + rec.name_len )
+            return false;
+
+        ListFile* lf = new ListFile;
+        lf->list_id = rec.list_id;
+        lf->file_type = rec.file_type;
+        lf->list_index = rec.list_index;
+        lf->list_type = rec.list_type;
+        lf->all_intfs_enabled = rec.all_intfs_enabled;
+
+        for ( uint32_t n = 0; n < rec.num_intfs; n++ )
+        {
+            uint32_t val;
+            memcpy(&val, buf, sizeof(val));
+            buf += sizeof(val);
+            lf->intfs.insert(val);
+        }
+
+        lf->file_name.assign((const char*)buf, rec.name_len);
+        buf += rec.name_len;
+
+        lists.emplace_back(lf);
+    }
+    return true;
+}
+
+// the table is trusted, as it is produced by snort itself; this only
+// catches files that are truncated, stale or from another build
+static bool check_table(const TableFileHeader& hdr, size_t file_size)
+{
+    if ( memcmp(hdr.magic, TABLE_FILE_MAGIC, sizeof(hdr.magic)) or
+        hdr.version != TABLE_FILE_VERSION or hdr.byte_order != TABLE_FILE_BYTE_ORDER or
+        hdr.offset_size != sizeof(MEM_OFFSET) )
+        return false;
+
+    if ( hdr.segment_offset > file_size or hdr.segment_size > file_size - hdr.segment_offset or
+        hdr.segment_size < sizeof(table_flat_t) or hdr.segment_offset % TABLE_FILE_ALIGN )
+        return false;
+
+    // the list index stored in the table is 8 bits wide
+    return hdr.num_lists <= UINT8_MAX;
+}
+
+bool map_reputation_table(const char* file_name, ReputationData& data)
+{
+    assert(!data.ip_list and data.list_files.empty());
+
+    int fd = open(file_name, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        ErrorMessage("reputation: can't open %s: %s\n", file_name, get_error(errno));
+        return false;
+    }
+
+    struct stat st;
+
+    if ( fstat(fd, &st) or (size_t)st.st_size < sizeof(TableFileHeader) )
+    {
+        ErrorMessage("reputation: %s is not a reputation table\n", file_name);
+        close(fd);
+        return false;
+    }
+
+    // a shared read-only mapping lets processes using the same table share its pages
+    size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if ( map == MAP_FAILED )
+    {
+        ErrorMessage("reputation: can't map %s: %s\n", file_name, get_error(errno));
+        return false;
+    }
+
+    const uint8_t* base = (const uint8_t*)map;
+    TableFileHeader hdr;
+    memcpy(&hdr, base, sizeof(hdr));
+
+    ListFiles lists;
+
+    if ( !check_table(hdr, size) or
+        !load_lists(base + sizeof(hdr), base + hdr.segment_offset, hdr.num_lists, lists) )
+    {
+        ErrorMessage("reputation: %s is not a valid reputation table\n", file_name);
+        for ( auto* lf : lists )
+            delete lf;
+        munmap(map, size);
+        return false;
+    }
+
+    data.list_files = std::move(lists);
+    data.ip_list = (table_flat_t*)(base + hdr.segment_offset);
+    data.segment_size = hdr.segment_size;
+    data.usage = hdr.usage;
+    data.num_entries = hdr.num_entries;
+    data.mapped_table = map;
+    data.mapped_size = size;
+
+    return true;
+}
@@ -0,0 +1,36 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef REPUTATION_TABLE_FILE_H
+#define REPUTATION_TABLE_FILE_H
+
+// Prebuilt reputation tables. The sfrt_flat segment only holds offsets
+// relative to its base, so a finished table can be written to a file as is
+// and later mapped read-only in place of parsing the IP lists. The file
+// also carries the list metadata needed to interpret lookup results.
+
+class ReputationData;
+
+// Write the table and list metadata of data to file_name.
+bool save_reputation_table(const char* file_name, const ReputationData&);
+
+// Map a table written by save_reputation_table() into data, which must be
+// empty. On failure, data is left unchanged.
+bool map_reputation_table(const char* file_name, ReputationData&);
+
+#endif
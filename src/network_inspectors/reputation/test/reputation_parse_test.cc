@@ -0,0 +1,184 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// reputation_parse_test.cc - tests for applying delta updates to reputation lists
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "network_inspectors/reputation/reputation_config.h"
+#include "network_inspectors/reputation/reputation_inspect.h"
+#include "network_inspectors/reputation/reputation_parse.h"
+#include "main/snort_config.h"
+#include "sfip/sf_ip.h"
+#include "utils/util.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+namespace snort
+{
+uint32_t SnortConfig::logging_flags = 0;
+
+void ErrorMessage(const char*, ...) { }
+void LogMessage(const char*, ...) { }
+void ParseError(const char*, ...) { }
+const char* get_error(int) { return ""; }
+char* snort_strdup(const char* s)
+{
+    char* d = new char[strlen(s) + 1];
+    return strcpy(d, s);
+}
+}
+
+const char* get_snort_conf_dir() { return "/"; }
+
+ReputationData::~ReputationData()
+{
+    snort_free(reputation_segment);
+
+    for (auto& file : list_files)
+        delete file;
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+static void write_file(const std::string& path, const char* text)
+{
+    FILE* fp = fopen(path.c_str(), "w");
+    CHECK(fp);
+    fputs(text, fp);
+    fclose(fp);
+}
+
+// the list index of the first list that matches addr or 0 if none
+static int lookup(const ReputationData& data, const char* addr)
+{
+    SfIp ip;
+    ip.set(addr);
+
+    const IPrepInfo* info = (const IPrepInfo*)sfrt_flat_dir8x_lookup(&ip, data.ip_list);
+    return info ? info->list_indexes[0] : 0;
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(reputation_delta)
+{
+    char dir[32] = "/tmp/rep_delta_XXXXXX";
+    std::string block, delta;
+    ReputationConfig config;
+    ReputationData* cur = nullptr;
+
+    void setup() override
+    {
+        CHECK(mkdtemp(dir));
+        block = std::string(dir) + "/block.txt";
+        delta = std::string(dir) + "/delta.txt";
+
+        write_file(block, "10.1.2.0/24\n10.9.9.9\n");
+        config.blocklist_path = block;
+
+        // sized as the inspector does, with no room to spare
+        cur = new ReputationData;
+        ReputationParser::add_block_allow_List(config, *cur);
+        ReputationParser::estimate_num_entries(*cur);
+
+        ReputationParser parser;
+        parser.ip_list_init(cur->num_entries + 1, config, *cur);
+        cur->segment_size = parser.get_segment_used();
+    }
+
+    void teardown() override
+    {
+        delete cur;
+        unlink(block.c_str());
+        unlink(delta.c_str());
+        rmdir(dir);
+    }
+};
+
+TEST(reputation_delta, add_and_remove)
+{
+    write_file(delta, "# update\n+10.7.7.7\n+2001:db8::/32\n-10.9.9.9\n");
+
+    ReputationData data;
+    ReputationParser parser;
+    CHECK(parser.apply_delta(block.c_str(), delta.c_str(), config, *cur, data));
+
+    CHECK(lookup(data, "10.1.2.3") == 1);
+    CHECK(lookup(data, "10.7.7.7") == 1);
+    CHECK(lookup(data, "2001:db8::1") == 1);
+    CHECK(lookup(data, "10.9.9.9") == 0);
+    CHECK(lookup(data, "10.7.7.8") == 0);
+
+    // the current table is untouched
+    CHECK(lookup(*cur, "10.9.9.9") == 1);
+    CHECK(lookup(*cur, "10.7.7.7") == 0);
+}
+
+TEST(reputation_delta, adds_beyond_capacity)
+{
+    std::string text;
+
+    for (unsigned i = 1; i <= 200; ++i)
+        text += "+172.16." + std::to_string(i) + ".1\n";
+
+    write_file(delta.c_str(), text.c_str());
+
+    ReputationData data;
+    ReputationParser parser;
+    CHECK(parser.apply_delta(block.c_str(), delta.c_str(), config, *cur, data));
+
+    CHECK(lookup(data, "172.16.1.1") == 1);
+    CHECK(lookup(data, "172.16.200.1") == 1);
+    CHECK(lookup(data, "10.9.9.9") == 1);
+    CHECK(lookup(data, "172.16.201.1") == 0);
+}
+
+TEST(reputation_delta, unknown_list)
+{
+    write_file(delta, "+10.7.7.7\n");
+
+    ReputationData data;
+    ReputationParser parser;
+    CHECK(!parser.apply_delta("nothing.txt", delta.c_str(), config, *cur, data));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
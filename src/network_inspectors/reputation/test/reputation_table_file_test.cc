@@ -0,0 +1,361 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// reputation_table_file_test.cc - tests for saving and mapping prebuilt tables
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/reputation/reputation_table_file.cc"
+
+#include <fstream>
+#include <iterator>
+
+#include "main/snort_config.h"
+#include "network_inspectors/reputation/reputation_parse.h"
+#include "sfip/sf_ip.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//--------------------------------------------------------------------------
+// stubs
+//--------------------------------------------------------------------------
+
+namespace snort
+{
+uint32_t SnortConfig::logging_flags = 0;
+
+void ErrorMessage(const char*, ...) { }
+void LogMessage(const char*, ...) { }
+void ParseError(const char*, ...) { }
+const char* get_error(int) { return ""; }
+char* snort_strdup(const char* s)
+{
+    char* d = new char[strlen(s) + 1];
+    return strcpy(d, s);
+}
+}
+
+const char* get_snort_conf_dir() { return "/"; }
+
+ReputationData::~ReputationData()
+{
+    snort_free(reputation_segment);
+
+    if (mapped_table)
+        munmap(mapped_table, mapped_size);
+
+    for (auto& file : list_files)
+        delete file;
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+static void write_file(const std::string& path, const std::string& text)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+    CHECK(out.good());
+}
+
+static std::string read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// the list index of the first list that matches addr or 0 if none
+static int lookup(const ReputationData& data, const char* addr)
+{
+    SfIp ip;
+    ip.set(addr);
+
+    const IPrepInfo* info = (const IPrepInfo*)sfrt_flat_dir8x_lookup(&ip, data.ip_list);
+    return info ? info->list_indexes[0] : 0;
+}
+
+static TableFileHeader get_header(const std::string& file)
+{
+    TableFileHeader hdr;
+    memcpy(&hdr, file.data(), sizeof(hdr));
+    return hdr;
+}
+
+static void set_header(std::string& file, const TableFileHeader& hdr)
+{ file.replace(0, sizeof(hdr), (const char*)&hdr, sizeof(hdr)); }
+
+static const char* const addrs[] =
+{ "10.1.2.3", "10.9.9.9", "10.9.9.8", "192.168.5.5", "2001:db8::1", "2001:db9::1", "8.8.8.8" };
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(reputation_table_file)
+{
+    char dir[32] = "/tmp/rep_table_XXXXXX";
+    std::string block, allow, table;
+    ReputationConfig config;
+    ReputationData* built = nullptr;
+
+    void setup() override
+    {
+        CHECK(mkdtemp(dir));
+        block = std::string(dir) + "/block.txt";
+        allow = std::string(dir) + "/allow.txt";
+        table = std::string(dir) + "/table.rep";
+
+        write_file(block, "10.1.2.0/24\n10.9.9.9\n2001:db8::/32\n");
+        write_file(allow, "192.168.5.0/24\n10.9.9.8\n");
+        config.blocklist_path = block;
+        config.allowlist_path = allow;
+
+        built = new ReputationData;
+        ReputationParser::add_block_allow_List(config, *built);
+        ReputationParser::estimate_num_entries(*built);
+
+        ReputationParser parser;
+        parser.ip_list_init(built->num_entries + 1, config, *built);
+        built->segment_size = parser.get_segment_used();
+        built->usage = parser.get_usage();
+
+        // metadata that add_block_allow_List doesn't set, as from a manifest
+        ListFile* lf = built->list_files.back();
+        lf->list_id = 7;
+        lf->all_intfs_enabled = false;
+        lf->intfs = { 1, 5, 300 };
+    }
+
+    void teardown() override
+    {
+        delete built;
+        unlink(block.c_str());
+        unlink(allow.c_str());
+        unlink(table.c_str());
+        rmdir(dir);
+    }
+
+    // save the built table, let the caller damage it, and try to map it
+    template<typename Damage>
+    bool map_damaged(Damage damage)
+    {
+        CHECK(save_reputation_table(table.c_str(), *built));
+
+        std::string file = read_file(table);
+        damage(file);
+        write_file(table, file);
+
+        ReputationData data;
+        bool ok = map_reputation_table(table.c_str(), data);
+
+        // a rejected table leaves data as it was
+        if ( !ok )
+        {
+            CHECK(!data.ip_list);
+            CHECK(!data.mapped_table);
+            CHECK(data.list_files.empty());
+        }
+        return ok;
+    }
+};
+
+TEST(reputation_table_file, round_trip)
+{
+    CHECK(save_reputation_table(table.c_str(), *built));
+
+    ReputationData data;
+    CHECK(map_reputation_table(table.c_str(), data));
+
+    CHECK(data.mapped_table);
+    CHECK(!data.reputation_segment);
+    CHECK_EQUAL(built->segment_size, data.segment_size);
+    CHECK_EQUAL(built->usage, data.usage);
+    CHECK_EQUAL(built->num_entries, data.num_entries);
+    CHECK_EQUAL(0, memcmp(built->ip_list, data.ip_list, built->segment_size));
+
+    // the segment is page aligned in the file
+    CHECK_EQUAL(0u, ((const uint8_t*)data.ip_list - (const uint8_t*)data.mapped_table) %
+        TABLE_FILE_ALIGN);
+
+    for ( auto addr : addrs )
+        CHECK_EQUAL(lookup(*built, addr), lookup(data, addr));
+
+    CHECK_EQUAL(1, lookup(data, "10.1.2.3"));
+    CHECK_EQUAL(2, lookup(data, "192.168.5.5"));
+    CHECK_EQUAL(0, lookup(data, "8.8.8.8"));
+
+    CHECK_EQUAL(built->list_files.size(), data.list_files.size());
+
+    for ( unsigned i = 0; i < data.list_files.size(); ++i )
+    {
+        const ListFile* a = built->list_files[i];
+        const ListFile* b = data.list_files[i];
+
+        CHECK(a->file_name == b->file_name);
+        CHECK_EQUAL(a->file_type, b->file_type);
+        CHECK_EQUAL(a->list_id, b->list_id);
+        CHECK_EQUAL(a->all_intfs_enabled, b->all_intfs_enabled);
+        CHECK(a->intfs == b->intfs);
+        CHECK_EQUAL(a->list_index, b->list_index);
+        CHECK_EQUAL(a->list_type, b->list_type);
+    }
+
+    CHECK_EQUAL(7u, data.list_files[1]->list_id);
+    CHECK_EQUAL(3u, data.list_files[1]->intfs.size());
+}
+
+TEST(reputation_table_file, no_partial_file)
+{
+    CHECK(save_reputation_table(table.c_str(), *built));
+    CHECK(access((table + ".tmp").c_str(), F_OK));
+
+    ReputationData empty;
+    CHECK(!save_reputation_table(table.c_str(), empty));
+}
+
+TEST(reputation_table_file, missing_file)
+{
+    ReputationData data;
+    CHECK(!map_reputation_table(table.c_str(), data));
+    CHECK(!data.ip_list);
+}
+
+TEST(reputation_table_file, undamaged)
+{
+    CHECK(map_damaged([](std::string&) { }));
+}
+
+TEST(reputation_table_file, truncated)
+{
+    CHECK(!map_damaged([](std::string& f) { f.resize(f.size() - 1); }));
+    CHECK(!map_damaged([](std::string& f) { f.resize(TABLE_FILE_ALIGN); }));
+    CHECK(!map_damaged([](std::string& f) { f.resize(sizeof(TableFileHeader) - 1); }));
+    CHECK(!map_damaged([](std::string& f) { f.clear(); }));
+}
+
+TEST(reputation_table_file, bad_magic)
+{
+    CHECK(!map_damaged([](std::string& f) { f[7] = '2'; }));
+}
+
+TEST(reputation_table_file, bad_version)
+{
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileHeader hdr = get_header(f);
+        hdr.version++;
+        set_header(f, hdr);
+    }));
+}
+
+TEST(reputation_table_file, bad_byte_order)
+{
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileHeader hdr = get_header(f);
+        hdr.byte_order = 0x04030201;
+        set_header(f, hdr);
+    }));
+}
+
+TEST(reputation_table_file, bad_offset_size)
+{
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileHeader hdr = get_header(f);
+        hdr.offset_size = sizeof(MEM_OFFSET) == 4 ? 8 : 4;
+        set_header(f, hdr);
+    }));
+}
+
+TEST(reputation_table_file, segment_not_aligned)
+{
+    // still inside the file, with the segment size adjusted to fit
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileHeader hdr = get_header(f);
+        hdr.segment_offset -= 8;
+        hdr.segment_size += 8;
+        set_header(f, hdr);
+    }));
+}
+
+TEST(reputation_table_file, segment_too_small)
+{
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileHeader hdr = get_header(f);
+        hdr.segment_size = sizeof(table_flat_t) - 1;
+        set_header(f, hdr);
+    }));
+}
+
+TEST(reputation_table_file, too_many_lists)
+{
+    // with enough padding for the extra (empty) records to fit
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileHeader hdr = get_header(f);
+        f.insert(hdr.segment_offset, 2 * TABLE_FILE_ALIGN, '\0');
+        hdr.segment_offset += 2 * TABLE_FILE_ALIGN;
+        hdr.num_lists = UINT8_MAX + 1;
+        set_header(f, hdr);
+    }));
+}
+
+TEST(reputation_table_file, lists_past_segment)
+{
+    // the zero padding reads as empty records until the segment is reached
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileHeader hdr = get_header(f);
+        hdr.num_lists = UINT8_MAX;
+        set_header(f, hdr);
+    }));
+}
+
+TEST(reputation_table_file, list_name_past_segment)
+{
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileList rec;
+        memcpy(&rec, f.data() + sizeof(TableFileHeader), sizeof(rec));
+        rec.name_len = TABLE_FILE_ALIGN;
+        f.replace(sizeof(TableFileHeader), sizeof(rec), (const char*)&rec, sizeof(rec));
+    }));
+}
+
+TEST(reputation_table_file, list_intfs_past_segment)
+{
+    CHECK(!map_damaged([](std::string& f)
+    {
+        TableFileList rec;
+        memcpy(&rec, f.data() + sizeof(TableFileHeader), sizeof(rec));
+        rec.num_intfs = TABLE_FILE_ALIGN / sizeof(uint32_t);
+        f.replace(sizeof(TableFileHeader), sizeof(rec), (const char*)&rec, sizeof(rec));
+    }));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "batch_sizer.h"
+
+#include <algorithm>
+
+BatchSizer::BatchSizer(unsigned max, uint64_t target) :
+    target_ns(target), max_size(max ? max : 1), size(max_size)
+{ }
+
+void BatchSizer::update(unsigned asked, unsigned received, uint64_t ns)
+{
+    if ( !received )
+        return;
+
+    uint64_t per_msg = ns / received;
+
+    if ( avg_ns8 )
+        avg_ns8 = avg_ns8 - (avg_ns8 >> 3) + per_msg;
+    else
+        avg_ns8 = per_msg << 3;
+
+    uint64_t avg_ns = avg_ns8 >> 3;
+    uint64_t limit = avg_ns ? target_ns / avg_ns : max_size;
+
+    if ( limit > max_size )
+        limit = max_size;
+    else if ( !limit )
+        limit = 1;
+
+    // a full batch means more is waiting
+    if ( received >= asked )
+        size *= 2;
+
+    else if ( received * 4 <= asked )
+        size /= 2;
+
+    size = std::max(std::min(size, (unsigned)limit), 1u);
+}
+
+unsigned BatchSizer::get_bin(unsigned n)
+{
+    unsigned bin = 0;
+
+    while ( n > 1 and bin < NUM_BINS - 1 )
+    {
+        n >>= 1;
+        ++bin;
+    }
+    return bin;
+}
@@ -0,0 +1,56 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// batch_sizer.h - chooses how many messages to receive from the DAQ at once
+
+#ifndef BATCH_SIZER_H
+#define BATCH_SIZER_H
+
+#include <cstdint>
+
+// Larger batches amortize the cost of each receive but every message waits
+// for those ahead of it in its batch.  BatchSizer grows the batch while the
+// DAQ has a backlog and shrinks it when traffic is light or when the measured
+// processing time per message would keep the last message of a full batch
+// waiting longer than the target.
+
+class BatchSizer
+{
+public:
+    // sizes are counted in bins of powers of 2, the last bin takes the rest
+    static constexpr unsigned NUM_BINS = 9;
+
+    BatchSizer(unsigned max_size, uint64_t target_ns);
+
+    unsigned get_size() const
+    { return size; }
+
+    // asked is the number of messages requested, which may be less than the
+    // size, received is the number returned, and ns is the time taken to
+    // process them
+    void update(unsigned asked, unsigned received, uint64_t ns);
+
+    static unsigned get_bin(unsigned size);
+
+private:
+    uint64_t target_ns;
+    uint64_t avg_ns8 = 0;    // moving average per message, scaled by 8
+    unsigned max_size;
+    unsigned size;
+};
+
+#endif
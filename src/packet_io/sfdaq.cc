@@ -84,6 +84,18 @@ void SFDAQ::unload()
     loaded = false;
 }
 
+// loads the modules if needed so that a stack can be checked before init;
+// unknown modules have no type
+uint32_t SFDAQ::get_module_type(const SFDAQConfig* cfg, const char* name)
+{
+    if (!loaded)
+        load(cfg);
+
+    DAQ_Module_h module = daq_find_module(name);
+
+    return module ? daq_module_get_type(module) : 0;
+}
+
 void SFDAQ::print_types(ostream& ostr)
 {
     DAQ_Module_h mod = daq_modules_first();
@@ -41,6 +41,7 @@ public:
     static void unload();
 
     static void print_types(std::ostream&);
+    static uint32_t get_module_type(const SFDAQConfig*, const char* name);
     static const char* verdict_to_string(DAQ_Verdict verdict);
     static bool init(const SFDAQConfig*, unsigned total_instances);
     static void term();
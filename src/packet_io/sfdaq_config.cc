@@ -65,6 +65,7 @@ void SFDAQModuleConfig::set_variable(const char* varkvp)
 SFDAQConfig::SFDAQConfig()
 {
     batch_size = BATCH_SIZE_UNSET;
+    batch_latency = 0;
     mru_size = SNAPLEN_UNSET;
     timeout = TIMEOUT_DEFAULT;
 }
@@ -100,6 +101,11 @@ void SFDAQConfig::set_batch_size(uint32_t batch_size_value)
     batch_size = batch_size_value;
 }
 
+void SFDAQConfig::set_batch_latency(uint32_t usecs)
+{
+    batch_latency = usecs;
+}
+
 void SFDAQConfig::set_mru_size(int mru_size_value)
 {
     mru_size = mru_size_value;
@@ -125,6 +131,8 @@ void SFDAQConfig::overlay(const SFDAQConfig* other)
 
     if (other->batch_size != BATCH_SIZE_UNSET)
         batch_size = other->batch_size;
+    if (other->batch_latency)
+        batch_latency = other->batch_latency;
     if (other->mru_size != SNAPLEN_UNSET)
         mru_size = other->mru_size;
     timeout = other->timeout;
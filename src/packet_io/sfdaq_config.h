@@ -58,6 +58,7 @@ struct SFDAQConfig
     SFDAQModuleConfig* add_module_config(const char* module_name);
     void add_module_dir(const char*);
     void set_batch_size(uint32_t);
+    void set_batch_latency(uint32_t);
     void set_mru_size(int);
 
     uint32_t get_batch_size() const { return (batch_size == BATCH_SIZE_UNSET) ? BATCH_SIZE_DEFAULT : batch_size; }
@@ -70,6 +71,7 @@ struct SFDAQConfig
     /* Instance configuration */
     std::vector<std::string> inputs;
     uint32_t batch_size;
+    uint32_t batch_latency;     // usecs, 0 for a fixed batch size
     int mru_size;
     unsigned int timeout;
     std::vector<SFDAQModuleConfig*> module_configs;
@@ -31,6 +31,7 @@
 #include "protocols/packet.h"
 #include "protocols/vlan.h"
 
+#include "batch_sizer.h"
 #include "sfdaq_config.h"
 #include "sfdaq_module.h"
 
@@ -44,10 +45,14 @@ SFDAQInstance::SFDAQInstance(const char* input, unsigned id, const SFDAQConfig*
     instance_id = id + 1;
     batch_size = cfg->get_batch_size();
     daq_msgs = new DAQ_Msg_h[batch_size];
+
+    if (cfg->batch_latency)
+        batch_sizer = new BatchSizer(batch_size, (uint64_t)cfg->batch_latency * 1000);
 }
 
 SFDAQInstance::~SFDAQInstance()
 {
+    delete batch_sizer;
     delete[] daq_msgs;
     if (instance)
         daq_instance_destroy(instance);
@@ -195,9 +200,36 @@ DAQ_RecvStatus SFDAQInstance::receive_messages(unsigned max_recv)
     pool_available -= curr_batch_size;
     curr_batch_idx = 0;
 
+    if (batch_sizer)
+    {
+        batch_asked = max_recv;
+        batch_received = std::chrono::steady_clock::now();
+    }
+
     return rstat;
 }
 
+uint32_t SFDAQInstance::get_recv_size() const
+{
+    return batch_sizer ? batch_sizer->get_size() : batch_size;
+}
+
+// The time from receipt to here is what the batch took to process.
+void SFDAQInstance::batch_processed()
+{
+    if (!batch_sizer or !batch_asked)
+        return;
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - batch_received).count();
+
+    batch_sizer->update(batch_asked, curr_batch_size, ns);
+
+    daq_stats.batches[BatchSizer::get_bin(batch_asked)]++;
+    daq_stats.batch_size = batch_sizer->get_size();
+    batch_asked = 0;
+}
+
 int SFDAQInstance::finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict)
 {
     int rval = daq_instance_msg_finalize(instance, msg, verdict);
@@ -24,11 +24,13 @@
 
 #include <daq_common.h>
 
+#include <chrono>
 #include <string>
 
 #include "main/snort_types.h"
 #include "protocols/protocol_ids.h"
 
+class BatchSizer;
 struct SFDAQConfig;
 
 namespace snort
@@ -50,6 +52,7 @@ public:
     void reload();
 
     DAQ_RecvStatus receive_messages(unsigned max_recv);
+    void batch_processed();
     DAQ_Msg_h next_message()
     {
         if (curr_batch_idx < curr_batch_size)
@@ -61,6 +64,7 @@ public:
 
     int get_base_protocol() const;
     uint32_t get_batch_size() const { return batch_size; }
+    uint32_t get_recv_size() const;
     uint32_t get_pool_available() const { return pool_available; }
     const char* get_input_spec() const;
     const DAQ_Stats_t* get_stats();
@@ -93,6 +97,9 @@ private:
     unsigned curr_batch_size = 0;
     unsigned curr_batch_idx = 0;
     uint32_t batch_size;
+    BatchSizer* batch_sizer = nullptr;
+    unsigned batch_asked = 0;
+    std::chrono::steady_clock::time_point batch_received;
     uint32_t pool_size = 0;
     uint32_t pool_available = 0;
     int dlt = -1;
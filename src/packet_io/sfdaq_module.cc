@@ -26,12 +26,14 @@
 
 #include <cassert>
 
+#include "daqs/daq_balance.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 
 #include "active.h"
 #include "sfdaq.h"
 #include "sfdaq_config.h"
+#include "sfdaq_instance.h"
 #include "trough.h"
 
 using namespace snort;
@@ -78,6 +80,7 @@ static const Parameter s_params[] =
     { "inputs", Parameter::PT_LIST, input_list_param, nullptr, "input sources" },
     { "snaplen", Parameter::PT_INT, "0:65535", "1518", "set snap length (same as -s)" },
     { "batch_size", Parameter::PT_INT, "1:", "64", "set receive batch size (same as --daq-batch-size)" },
+    { "batch_latency", Parameter::PT_INT, "0:max32", "0", "adapt the receive batch size up to batch_size so that packets wait no more than this many usecs for those ahead of them; 0 keeps the size fixed (same as --daq-batch-latency)" },
     { "modules", Parameter::PT_LIST, daq_module_param, nullptr, "DAQ modules to use" },
 
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
@@ -122,6 +125,10 @@ bool SFDAQModule::set(const char* fqn, Value& v, SnortConfig*)
     {
         config->set_batch_size(v.get_uint32());
     }
+    else if (!strcmp(fqn, "daq.batch_latency"))
+    {
+        config->set_batch_latency(v.get_uint32());
+    }
     else if (!strcmp(fqn, "daq.modules.name"))
     {
         module_config->name = v.get_string();
@@ -171,6 +178,7 @@ bool SFDAQModule::end(const char* fqn, int idx, SnortConfig* sc)
 }
 
 static_assert(MAX_DAQ_VERDICT == 6, "Verdict peg counts must align with MAX_DAQ_VERDICT");
+static_assert(BatchSizer::NUM_BINS == 9, "Batch peg counts must align with BatchSizer::NUM_BINS");
 const PegInfo daq_names[] =
 {
     { CountType::MAX, "pcaps", "total files and interfaces processed" },
@@ -206,11 +214,33 @@ const PegInfo daq_names[] =
     { CountType::SUM, "sof_messages", "start of flow messages received from DAQ" },
     { CountType::SUM, "eof_messages", "end of flow messages received from DAQ" },
     { CountType::SUM, "other_messages", "messages received from DAQ with unrecognized message type" },
+
+    // Must align with BatchSizer::NUM_BINS (one for each, in order)
+    { CountType::NOW, "batch_size", "current adaptive receive batch size" },
+    { CountType::SUM, "batches_1", "adaptive receives of 1 message" },
+    { CountType::SUM, "batches_2", "adaptive receives of 2 to 3 messages" },
+    { CountType::SUM, "batches_4", "adaptive receives of 4 to 7 messages" },
+    { CountType::SUM, "batches_8", "adaptive receives of 8 to 15 messages" },
+    { CountType::SUM, "batches_16", "adaptive receives of 16 to 31 messages" },
+    { CountType::SUM, "batches_32", "adaptive receives of 32 to 63 messages" },
+    { CountType::SUM, "batches_64", "adaptive receives of 64 to 127 messages" },
+    { CountType::SUM, "batches_128", "adaptive receives of 128 to 255 messages" },
+    { CountType::SUM, "batches_256", "adaptive receives of 256 or more messages" },
+
+    // from the balance DAQ when it is in the stack
+    { CountType::NOW, "balance_load", "messages queued for, held by, or last received by each thread; summed over threads in the totals" },
+    { CountType::SUM, "balance_forwarded", "packets handed to other threads" },
+    { CountType::SUM, "balance_adopted", "packets handed to this thread by others" },
+    { CountType::SUM, "balance_assigned", "flow buckets given an owner by this thread" },
+    { CountType::SUM, "balance_moved", "flow buckets given to a less loaded thread" },
+    { CountType::SUM, "balance_reassigned", "flow buckets given a new owner after going idle" },
+    { CountType::SUM, "balance_unsteered", "messages kept by the receiving thread because they couldn't be hashed" },
     { CountType::END, nullptr, nullptr }
 };
 
 THREAD_LOCAL DAQStats daq_stats;
 static THREAD_LOCAL DAQ_Stats_t prev_daq_stats;
+static THREAD_LOCAL DIOCTL_GetBalanceStats prev_balance_stats;
 
 const PegInfo* SFDAQModule::get_pegs() const
 {
@@ -238,6 +268,26 @@ static DAQ_Stats_t operator-(const DAQ_Stats_t& left, const DAQ_Stats_t& right)
     return ret;
 }
 
+// the balance stats are cumulative too; other stacks don't support the query
+static void prep_balance_counts(bool dump_stats)
+{
+    DIOCTL_GetBalanceStats gbs;
+
+    if ( SFDAQ::get_local_instance()->ioctl(DIOCTL_GET_BALANCE_STATS, &gbs, sizeof(gbs)) != DAQ_SUCCESS )
+        return;
+
+    daq_stats.balance_load = gbs.load;
+    daq_stats.balance_forwarded = gbs.forwarded - prev_balance_stats.forwarded;
+    daq_stats.balance_adopted = gbs.adopted - prev_balance_stats.adopted;
+    daq_stats.balance_assigned = gbs.assigned - prev_balance_stats.assigned;
+    daq_stats.balance_moved = gbs.moved - prev_balance_stats.moved;
+    daq_stats.balance_reassigned = gbs.reassigned - prev_balance_stats.reassigned;
+    daq_stats.balance_unsteered = gbs.unsteered - prev_balance_stats.unsteered;
+
+    if ( !dump_stats )
+        prev_balance_stats = gbs;
+}
+
 void SFDAQModule::prep_counts(bool dump_stats)
 {
 
@@ -277,6 +327,8 @@ void SFDAQModule::prep_counts(bool dump_stats)
 
     if ( !dump_stats )
         prev_daq_stats = new_daq_stats;
+
+    prep_balance_counts(dump_stats);
 }
 
 void SFDAQModule::reset_stats()
@@ -285,6 +337,10 @@ void SFDAQModule::reset_stats()
     {
         DAQ_Stats_t new_daq_stats = *SFDAQ::get_stats();
         prev_daq_stats = new_daq_stats;
+
+        DIOCTL_GetBalanceStats gbs;
+        if ( SFDAQ::get_local_instance()->ioctl(DIOCTL_GET_BALANCE_STATS, &gbs, sizeof(gbs)) == DAQ_SUCCESS )
+            prev_balance_stats = gbs;
     }
     Trough::clear_file_count();
     Module::reset_stats();
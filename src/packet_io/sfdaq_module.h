@@ -23,6 +23,8 @@
 
 #include "framework/module.h"
 
+#include "batch_sizer.h"
+
 namespace snort
 {
 struct SnortConfig;
@@ -79,6 +81,15 @@ struct DAQStats
     PegCount sof_messages;
     PegCount eof_messages;
     PegCount other_messages;
+    PegCount batch_size;
+    PegCount batches[BatchSizer::NUM_BINS];
+    PegCount balance_load;
+    PegCount balance_forwarded;
+    PegCount balance_adopted;
+    PegCount balance_assigned;
+    PegCount balance_moved;
+    PegCount balance_reassigned;
+    PegCount balance_unsteered;
 };
 
 extern THREAD_LOCAL DAQStats daq_stats;
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+// unit tests
+// -----------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/snort_catch.h"
+#include "packet_io/batch_sizer.h"
+
+TEST_CASE("batch sizer grows with backlog", "[BatchSizer]")
+{
+    BatchSizer bs(256, 1000000);
+    CHECK(bs.get_size() == 256);
+
+    // 1 usec per message allows 1000 messages
+    bs.update(256, 256, 256000);
+    CHECK(bs.get_size() == 256);
+
+    // light load
+    bs.update(256, 10, 10000);
+    CHECK(bs.get_size() == 128);
+
+    bs.update(128, 20, 20000);
+    CHECK(bs.get_size() == 64);
+
+    // moderate load holds the size
+    bs.update(64, 40, 40000);
+    CHECK(bs.get_size() == 64);
+
+    // backlog
+    bs.update(64, 64, 64000);
+    CHECK(bs.get_size() == 128);
+
+    bs.update(128, 128, 128000);
+    CHECK(bs.get_size() == 256);
+
+    bs.update(256, 256, 256000);
+    CHECK(bs.get_size() == 256);
+}
+
+TEST_CASE("batch sizer meets target", "[BatchSizer]")
+{
+    BatchSizer bs(256, 100000);
+
+    // 10 usecs per message allows 10 messages
+    bs.update(256, 256, 2560000);
+    CHECK(bs.get_size() == 10);
+
+    // backlog can't grow past the target
+    bs.update(10, 10, 100000);
+    CHECK(bs.get_size() == 10);
+
+    // faster processing allows more as the average moves an eighth of the way
+    for ( int i = 0; i < 64; ++i )
+        bs.update(bs.get_size(), bs.get_size(), bs.get_size() * 1000);
+
+    unsigned size = bs.get_size();
+    CHECK(size > 90);
+    CHECK(size <= 100);
+
+    // no messages says nothing
+    bs.update(size, 0, 0);
+    CHECK(bs.get_size() == size);
+
+    // much slower processing still receives one
+    bs.update(size, 1, 10000000);
+    CHECK(bs.get_size() == 1);
+}
+
+TEST_CASE("batch sizer bins", "[BatchSizer]")
+{
+    CHECK(BatchSizer::get_bin(0) == 0);
+    CHECK(BatchSizer::get_bin(1) == 0);
+    CHECK(BatchSizer::get_bin(2) == 1);
+    CHECK(BatchSizer::get_bin(3) == 1);
+    CHECK(BatchSizer::get_bin(4) == 2);
+    CHECK(BatchSizer::get_bin(64) == 6);
+    CHECK(BatchSizer::get_bin(255) == 7);
+    CHECK(BatchSizer::get_bin(256) == 8);
+    CHECK(BatchSizer::get_bin(100000) == BatchSizer::NUM_BINS - 1);
+}
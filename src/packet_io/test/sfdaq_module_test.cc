@@ -63,6 +63,9 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
     Value batch_size(static_cast<double>(10));
     CHECK(true == sfdm.set("daq.batch_size", batch_size, &sc));
 
+    Value batch_latency(static_cast<double>(200));
+    CHECK(true == sfdm.set("daq.batch_latency", batch_latency, &sc));
+
     CHECK(true == sfdm.begin("daq.modules", 0, &sc));
 
     SECTION("empty module config")
@@ -107,6 +110,7 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
 
         CHECK((6666 == cfg->mru_size));
         CHECK((10 == cfg->batch_size));
+        CHECK((200 == cfg->batch_latency));
 
         REQUIRE(1 == cfg->module_configs.size());
         for (auto it : cfg->module_configs)
@@ -131,6 +135,7 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
         overlay_cfg.add_input("cli_input");
         overlay_cfg.set_mru_size(3333);
         overlay_cfg.set_batch_size(12);
+        overlay_cfg.set_batch_latency(300);
 
         SFDAQModuleConfig* cli_module_cfg = overlay_cfg.add_module_config("cli_module_name");
 
@@ -155,6 +160,7 @@ TEST_CASE("parse sfdaq config", "[SFDAQModule]")
 
         CHECK((3333 == cfg->mru_size));
         CHECK((12 == cfg->batch_size));
+        CHECK((300 == cfg->batch_latency));
 
         REQUIRE(2 == cfg->module_configs.size());
         for (auto it : cfg->module_configs)
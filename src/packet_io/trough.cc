@@ -32,8 +32,12 @@
 #include "helpers/directory.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 #include "utils/util.h"
 
+#include "sfdaq.h"
+#include "sfdaq_config.h"
+
 using namespace snort;
 
 std::vector<struct Trough::PcapReadObject> Trough::pcap_object_list;
@@ -42,6 +46,8 @@ std::string Trough::pcap_filter = "*.*cap*";
 std::vector<std::string>::const_iterator Trough::pcap_queue_iter;
 
 unsigned Trough::pcap_loop_count = 0;
+bool Trough::hot_loop = false;
+bool Trough::hot_loop_rewrite = false;
 std::atomic<unsigned> Trough::file_count{0};
 
 bool Trough::add_pcaps_dir(const std::string& dirname, const std::string& filter)
@@ -213,7 +219,67 @@ void Trough::set_filter(const char* f)
         pcap_filter.erase();
 }
 
-void Trough::setup()
+/* In hot loop mode every packet thread gets all of the pcaps at once.  The
+    replay DAQ loads them into memory when the thread's instance is created
+    and does the looping, so the queue holds one list per thread. */
+void Trough::setup_hot_loop(SFDAQConfig* daq_config)
+{
+    std::string list;
+
+    for (const std::string& pcap : pcap_queue)
+    {
+        if (pcap == "-" || pcap.find(' ') != std::string::npos)
+            FatalError("Can't hot loop pcap: %s\n", pcap.c_str());
+
+        if (!list.empty())
+            list += ' ';
+        list += pcap;
+    }
+    pcap_queue.assign(ThreadConfig::get_instance_max(), list);
+
+    /* replay is a terminal module so it must be at the bottom of the stack,
+        where it takes the place of a module that reads files */
+    auto& mcs = daq_config->module_configs;
+    auto it = std::find_if(mcs.begin(), mcs.end(),
+        [](const SFDAQModuleConfig* dmc){ return dmc->name == "replay"; });
+
+    SFDAQModuleConfig* dmc;
+
+    if (it != mcs.end())
+    {
+        if (it != mcs.begin())
+            FatalError("--pcap-hot-loop needs the replay DAQ at the bottom of the stack\n");
+        dmc = *it;
+    }
+    else
+    {
+        uint32_t type = mcs.empty() ? DAQ_TYPE_WRAPPER :
+            SFDAQ::get_module_type(daq_config, mcs.front()->name.c_str());
+
+        if (!(type & DAQ_TYPE_WRAPPER))
+        {
+            if (!(type & DAQ_TYPE_FILE_CAPABLE))
+                FatalError("--pcap-hot-loop can't replay pcaps with the %s DAQ\n",
+                    mcs.front()->name.c_str());
+
+            LogMessage("--pcap-hot-loop replaces the %s DAQ with replay\n",
+                mcs.front()->name.c_str());
+            delete mcs.front();
+            mcs.erase(mcs.begin());
+        }
+        dmc = new SFDAQModuleConfig;
+        dmc->name = "replay";
+        mcs.insert(mcs.begin(), dmc);
+    }
+    dmc->variables.emplace_back("loop", std::to_string(pcap_loop_count));
+
+    if (hot_loop_rewrite)
+        dmc->variables.emplace_back("rewrite", "");
+
+    pcap_loop_count = 0;
+}
+
+void Trough::setup(SFDAQConfig* daq_config)
 {
     if (!pcap_object_list.empty())
     {
@@ -226,6 +292,9 @@ void Trough::setup()
         /* free pcap list used to get params */
         pcap_object_list.clear();
 
+        if (hot_loop)
+            setup_hot_loop(daq_config);
+
         pcap_queue_iter = pcap_queue.cbegin();
     }
     pcap_filter.clear();
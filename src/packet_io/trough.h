@@ -24,6 +24,8 @@
 #include <string>
 #include <vector>
 
+struct SFDAQConfig;
+
 // Trough provides access to sources (interface, file, etc.).
 
 class Trough
@@ -40,9 +42,18 @@ public:
     {
         pcap_loop_count = c;
     }
+    static void set_hot_loop(bool rewrite)
+    {
+        hot_loop = true;
+        hot_loop_rewrite = hot_loop_rewrite || rewrite;
+    }
+    static bool get_hot_loop()
+    {
+        return hot_loop;
+    }
     static void set_filter(const char *f);
     static void add_source(SourceType type, const char *list);
-    static void setup();
+    static void setup(SFDAQConfig*);
     static bool has_next();
     static const char *get_next();
     static unsigned get_file_count()
@@ -74,6 +85,7 @@ private:
     static bool add_pcaps_list_file(const std::string& list_filename, const std::string& filter);
     static bool add_pcaps_list(const std::string& list);
     static bool get_pcaps(const std::vector<struct PcapReadObject> &pol);
+    static void setup_hot_loop(SFDAQConfig*);
 
     static std::vector<struct PcapReadObject> pcap_object_list;
     static std::vector<std::string> pcap_queue;
@@ -81,6 +93,8 @@ private:
     static std::string pcap_filter;
 
     static unsigned pcap_loop_count;
+    static bool hot_loop;
+    static bool hot_loop_rewrite;
     static std::atomic<unsigned> file_count;
 };
 
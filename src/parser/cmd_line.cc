@@ -51,6 +51,12 @@ static void check_flags(SnortConfig* sc)
         ParseError("--pcap-loop can only be used in combination with pcaps "
             "on the command line.\n");
     }
+
+    if (Trough::get_hot_loop() && !(sc->run_flags & RUN_FLAG__READ))
+    {
+        ParseError("--pcap-hot-loop can only be used in combination with pcaps "
+            "on the command line.\n");
+    }
 }
 
 //-------------------------------------------------------------------------
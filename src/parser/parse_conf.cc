@@ -326,7 +326,7 @@ void parse_rules_file(SnortConfig* sc, const char* fname)
         return;
     }
     ++rules_file_depth;
-    parse_stream(fs, sc);
+    parse_stream(fs, sc, sc->parallel_rule_lexing);
     --rules_file_depth;
 }
 
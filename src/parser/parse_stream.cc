@@ -23,7 +23,13 @@
 
 #include "parse_stream.h"
 
+#include <cstdarg>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include "log/messages.h"
 #include "managers/ips_manager.h"
@@ -35,11 +41,6 @@
 using namespace snort;
 using namespace std;
 
-static unsigned chars = 0, tokens = 0;
-static unsigned lines = 1, comments = 0;
-static unsigned keys = 0, rules = 0;
-static unsigned lists = 0, strings = 0;
-
 enum TokenType
 {
     TT_NONE,
@@ -83,14 +84,54 @@ static uint8_t to_hex(char c)
         return 10 + c - 'a';
 }
 
-static TokenType get_token(
-    istream& is, string& s, const char* punct, int esc)
+//-------------------------------------------------------------------------
+// lexer
+//-------------------------------------------------------------------------
+// the lexer runs the fsm because the punctuation and escaping of the next
+// token depend on the current state.  when deferred, parse position
+// updates and warnings are recorded with each token instead of applied so
+// the lexer can run ahead of rule construction on another thread.
+
+struct RuleToken;
+
+class RuleLexer
+{
+public:
+    RuleLexer(istream& is, bool defer) : is(is), defer(defer) { }
+
+    bool next(RuleToken&);
+
+    bool incomplete() const
+    { return num != 0; }
+
+private:
+    TokenType get_token(string&, const char* punct, int esc);
+    void new_line();
+    void warning(const char*, ...) __attribute__((format (printf, 2, 3)));
+
+    istream& is;
+    RuleToken* cur = nullptr;
+    const char* delims = nullptr;
+    string key;
+
+    int num = 0;
+    int prev = EOF;
+    int pos = 0;
+
+    bool defer;
+    bool done = false;
+
+    unsigned chars = 0, tokens = 0;
+    unsigned lines = 1, comments = 0;
+    unsigned keys = 0;
+    unsigned lists = 0, strings = 0;
+};
+
+TokenType RuleLexer::get_token(string& s, const char* punct, int esc)
 {
-    static int prev = EOF;
     int c, list = 0, state = 0;
     s.clear();
     bool inc = true;
-    static int pos = 0;
     uint8_t hex = 0;
 
     if ( prev != EOF )
@@ -117,7 +158,7 @@ static TokenType get_token(
             pos = 0;
 
             if ( inc )
-                inc_parse_position();
+                new_line();
             else
                 inc = true;
         }
@@ -208,7 +249,7 @@ static TokenType get_token(
             else if ( c == '\\' )
                 state = (esc > 0) ? 4 : 16;
             else if ( c == '\n' )
-                ParseWarning(WARN_RULES, "line break in string on line %u\n", lines-1);
+                warning("line break in string on line %u\n", lines-1);
             else
                 s += c;
             break;
@@ -223,7 +264,7 @@ static TokenType get_token(
             break;
         case 5:  // unquoted escape
             if ( c != '\n' && c != '\r' )
-                ParseWarning(WARN_RULES, "invalid escape on line %u\n", lines);
+                warning("invalid escape on line %u\n", lines);
             state = 0;
             break;
         case 6:  // token
@@ -315,7 +356,7 @@ static TokenType get_token(
                 state = 11;
             else if ( c == '\n' )
             {
-                ParseWarning(WARN_RULES, "line break in commented string on line %u\n", lines-1);
+                warning("line break in commented string on line %u\n", lines-1);
                 state = 11;
             }
             break;
@@ -327,8 +368,7 @@ static TokenType get_token(
             }
             else
             {
-                ParseWarning(WARN_RULES, "\\x used with no following hex digits on line %u\n",
-                        lines-1);
+                warning("\\x used with no following hex digits on line %u\n", lines-1);
                 s += c;
                 state = 3;
             }
@@ -466,10 +506,114 @@ static const State* get_state(int num, TokenType type, const string& tok)
             return s;
         }
     }
-    ParseError("syntax error");
-    return fsm;
+    return nullptr;
 }
 
+// FIXIT-L escaping should not be by option name
+// probably should remove content escaping except for \" so
+// that individual rule options can do whatever
+static int get_escape(const string& s)
+{
+    if ( s == "pcre" )
+        return 0;  // no escape, option goes to ;
+
+    else if ( s == "regex" || s == "sd_pattern" )
+        return -1; // no escape, option goes to "
+
+    return 1;      // escape, option goes to "
+}
+
+struct RuleToken
+{
+    string tok;
+    vector<pair<unsigned, string>> warnings;  // lines advanced before each
+    FsmAction action = FSM_NOP;
+    unsigned lines = 0;  // parse positions to advance before acting
+    bool error = false;  // no transition for this token
+};
+
+void RuleLexer::new_line()
+{
+    if ( defer )
+        ++cur->lines;
+    else
+        inc_parse_position();
+}
+
+void RuleLexer::warning(const char* format, ...)
+{
+    char buf[STD_BUF];
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+
+    if ( defer )
+        cur->warnings.emplace_back(cur->lines, buf);
+    else
+        ParseWarning(WARN_RULES, "%s", buf);
+}
+
+bool RuleLexer::next(RuleToken& t)
+{
+    cur = &t;
+    t.warnings.clear();
+    t.action = FSM_NOP;
+    t.lines = 0;
+    t.error = false;
+
+    if ( done )
+        return false;
+
+    if ( !delims )
+        delims = fsm[0].punct;
+
+    TokenType type = get_token(t.tok, delims, get_escape(key));
+
+    if ( !type )
+    {
+        done = true;
+        return false;
+    }
+
+    ++tokens;
+    const State* s = get_state(num, type, t.tok);
+
+    if ( !s )
+    {
+        t.error = true;
+        s = fsm;
+    }
+
+#ifdef TRACER
+    printf("%d: %s = '%s' -> %s\n",
+        num, toks[type], t.tok.c_str(), acts[s->action]);
+#endif
+
+    t.action = s->action;
+
+    // FIXIT-L if non-rule tok != "END", parsing goes bad
+    // (need ctl-D to terminate)
+    if ( t.action == FSM_ACT and t.tok == "END" )
+    {
+        done = true;
+        return true;
+    }
+
+    if ( t.action == FSM_KEY )
+        key = t.tok;
+
+    num = s->next;
+
+    if ( s->punct )
+        delims = s->punct;
+
+    return true;
+}
+
+static unsigned rules = 0;
+
 struct RuleParseState
 {
     RuleTreeNode rtn;
@@ -489,8 +633,6 @@ static bool exec(
     switch ( act )
     {
     case FSM_ACT:
-        // FIXIT-L if non-rule tok != "END", parsing goes bad
-        // (need ctl-D to terminate)
         if ( tok == "END" )
             return true;
         parse_rule_type(sc, tok.c_str(), rps.rtn);
@@ -598,55 +740,167 @@ static bool exec(
     return false;
 }
 
-// FIXIT-L escaping should not be by option name
-// probably should remove content escaping except for \" so
-// that individual rule options can do whatever
-static int get_escape(const string& s)
+//-------------------------------------------------------------------------
+// parsing
+//-------------------------------------------------------------------------
+
+static bool apply(RuleToken& t, RuleParseState& rps, SnortConfig* sc)
 {
-    if ( s == "pcre" )
-        return 0;  // no escape, option goes to ;
+    unsigned i = 0;
 
-    else if ( s == "regex" || s == "sd_pattern" )
-        return -1; // no escape, option goes to "
+    for ( const auto& w : t.warnings )
+    {
+        for ( ; i < w.first; ++i )
+            inc_parse_position();
 
-    return 1;      // escape, option goes to "
+        ParseWarning(WARN_RULES, "%s", w.second.c_str());
+    }
+
+    for ( ; i < t.lines; ++i )
+        inc_parse_position();
+
+    if ( t.error )
+        ParseError("syntax error");
+
+    return exec(t.action, t.tok, rps, sc);
 }
 
-void parse_stream(istream& is, SnortConfig* sc)
+// tokens are handed over in batches to keep locking out of the way; the
+// queue is bounded so a large file isn't tokenized far ahead of the rules
+#define RULE_TOKEN_BATCH 1024
+#define RULE_TOKEN_QUEUE 64
+
+class RuleLexerThread
 {
-    string tok;
-    TokenType type;
-    int esc = 1;
+public:
+    RuleLexerThread(istream& is) : lexer(is, true)
+    { worker = thread(&RuleLexerThread::run, this); }
 
-    int num = 0;
-    const char* punct = fsm[0].punct;
-    RuleParseState rps;
+    ~RuleLexerThread();
+
+    bool get(vector<RuleToken>&);
+
+    // valid once get() returns false
+    bool incomplete() const
+    { return lexer.incomplete(); }
+
+private:
+    void run();
+
+    RuleLexer lexer;
+    thread worker;
+
+    mutex lock;
+    condition_variable cond;
+    deque<vector<RuleToken>> batches;
+
+    bool done = false;
+    bool stop = false;
+};
 
-    while ( (type = get_token(is, tok, punct, esc)) )
+RuleLexerThread::~RuleLexerThread()
+{
     {
-        ++tokens;
-        const State* s = get_state(num, type, tok);
+        lock_guard<mutex> hold(lock);
+        stop = true;
+    }
+    cond.notify_all();
+    worker.join();
+}
 
-#ifdef TRACER
-        printf("%d: %s = '%s' -> %s\n",
-            num, toks[type], tok.c_str(), acts[s->action]);
-#endif
+void RuleLexerThread::run()
+{
+    vector<RuleToken> batch;
+    RuleToken t;
+    bool more;
 
-        if ( exec(s->action, tok, rps, sc) )
-            break;
+    batch.reserve(RULE_TOKEN_BATCH);
+
+    do
+    {
+        more = lexer.next(t);
+
+        // the last one may only carry trailing lines and warnings
+        if ( more or t.lines or !t.warnings.empty() )
+            batch.emplace_back(std::move(t));
+
+        if ( more and batch.size() < RULE_TOKEN_BATCH )
+            continue;
+
+        unique_lock<mutex> hold(lock);
+        cond.wait(hold, [this]() { return stop or batches.size() < RULE_TOKEN_QUEUE; });
+
+        if ( stop )
+            return;
 
-        num = s->next;
-        esc = get_escape(rps.key);
+        if ( !batch.empty() )
+            batches.emplace_back(std::move(batch));
 
-        if ( s->punct )
-            punct = s->punct;
+        done = !more;
+        hold.unlock();
+        cond.notify_all();
+
+        batch.clear();
+        batch.reserve(RULE_TOKEN_BATCH);
     }
-    if ( num )
-        ParseError("incomplete rule");
+    while ( more );
+}
+
+bool RuleLexerThread::get(vector<RuleToken>& batch)
+{
+    unique_lock<mutex> hold(lock);
+    cond.wait(hold, [this]() { return done or !batches.empty(); });
+
+    if ( batches.empty() )
+        return false;
+
+    batch = std::move(batches.front());
+    batches.pop_front();
+
+    hold.unlock();
+    cond.notify_all();
+
+    return true;
+}
+
+// rules are still built on the calling thread in file order, so option
+// dedup, sid conflicts, and error locations are the same either way
+static void parse_pipelined(istream& is, SnortConfig* sc)
+{
+    RuleLexerThread lexer(is);
+    RuleParseState rps;
+    vector<RuleToken> batch;
+    bool end = false;
 
-    //printf("chars = %d, tokens = %d\n", chars, tokens);
-    //printf("lines = %d, comments = %d\n", lines, comments);
-    //printf("rules = %d, keys = %d\n", rules, keys);
-    //printf("lists = %d, strings = %d\n", lists, strings);
+    while ( lexer.get(batch) )
+    {
+        for ( auto& t : batch )
+        {
+            if ( !end and apply(t, rps, sc) )
+                end = true;
+        }
+    }
+    if ( lexer.incomplete() )
+        ParseError("incomplete rule");
 }
 
+void parse_stream(istream& is, SnortConfig* sc, bool pipeline)
+{
+    if ( pipeline )
+    {
+        parse_pipelined(is, sc);
+        return;
+    }
+
+    RuleLexer lexer(is, false);
+    RuleParseState rps;
+    RuleToken t;
+
+    while ( lexer.next(t) )
+    {
+        if ( apply(t, rps, sc) )
+            break;
+    }
+    if ( lexer.incomplete() )
+        ParseError("incomplete rule");
+}
@@ -27,7 +27,8 @@ struct SnortConfig;
 
 #include <istream>
 
-void parse_stream(std::istream&, snort::SnortConfig*);
+// pipeline tokenizes on a separate thread while rules are built
+void parse_stream(std::istream&, snort::SnortConfig*, bool pipeline = false);
 
 #endif
 
@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// parse_stream_benchmark.cc - rules file parsing with and without lexer thread
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "parser/parse_stream.cc"
+
+#include "catch/catch.hpp"
+
+//--------------------------------------------------------------------------
+// rule construction is stubbed so this times the stream parser alone
+//--------------------------------------------------------------------------
+
+static unsigned rules_closed = 0;
+static unsigned opts = 0;
+static OptTreeNode* const dummy_otn = reinterpret_cast<OptTreeNode*>(&opts);
+
+void inc_parse_position() { }
+void parse_include(SnortConfig*, const char*) { }
+
+void parse_rule_type(SnortConfig*, const char*, RuleTreeNode&) { }
+void parse_rule_proto(SnortConfig*, const char*, RuleTreeNode&, bool) { }
+void parse_rule_nets(SnortConfig*, const char*, bool, RuleTreeNode&, bool) { }
+void parse_rule_ports(SnortConfig*, const char*, bool, RuleTreeNode&, bool) { }
+void parse_rule_dir(SnortConfig*, const char*, RuleTreeNode&, bool) { }
+
+void parse_rule_opt_begin(SnortConfig*, const char*) { }
+
+void parse_rule_opt_set(SnortConfig*, const char*, const char*, const char*)
+{ ++opts; }
+
+void parse_rule_opt_end(SnortConfig*, const char*, OptTreeNode*) { }
+
+OptTreeNode* parse_rule_open(SnortConfig*, RuleTreeNode&, bool)
+{ return dummy_otn; }
+
+void parse_rule_close(SnortConfig*, RuleTreeNode&, OptTreeNode*)
+{ ++rules_closed; }
+
+namespace snort
+{
+void ParseWarning(WarningGroup, const char*, ...) { }
+void ParseError(const char*, ...) { }
+}
+
+// about the size and shape of community rules
+#define NUM_RULES 60000
+
+static string make_rules()
+{
+    string s;
+
+    for ( unsigned i = 0; i < NUM_RULES; ++i )
+    {
+        string n = to_string(i);
+
+        s += "alert http $EXTERNAL_NET any -> $HOME_NET $HTTP_PORTS ( ";
+        s += "msg:\"SERVER-WEBAPP example request " + n + "\"; ";
+        s += "flow:to_server,established; ";
+        s += "http_uri; content:\"/cgi-bin/" + n + ".cgi\",fast_pattern,nocase; ";
+        s += "content:\"cmd=\",distance 0; ";
+        s += "pcre:\"/cmd=[^&]*?(%3b|%0a)/i\"; ";
+        s += "metadata:policy balanced-ips drop,policy security-ips drop; ";
+        s += "service:http; reference:url,www.example.com/" + n + "; ";
+        s += "classtype:web-application-attack; sid:" + to_string(100000 + i) + "; rev:1; )\n";
+    }
+    return s;
+}
+
+static unsigned parse(const string& text, bool pipeline)
+{
+    rules_closed = opts = 0;
+    istringstream is(text);
+    parse_stream(is, nullptr, pipeline);
+    return rules_closed;
+}
+
+TEST_CASE("parse stream", "[parse_stream]")
+{
+    const string text = make_rules();
+
+    CHECK(parse(text, false) == NUM_RULES);
+    CHECK(parse(text, true) == NUM_RULES);
+
+    BENCHMARK("sequential")
+    {
+        return parse(text, false);
+    };
+
+    BENCHMARK("lexer thread")
+    {
+        return parse(text, true);
+    };
+}
+
+#endif
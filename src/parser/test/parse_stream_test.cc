@@ -0,0 +1,271 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// parse_stream_test.cc - rules lexed on a thread match rules lexed inline
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "parser/parse_stream.cc"
+
+#include <algorithm>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+//--------------------------------------------------------------------------
+// stubs record each call with the parse position it was made at
+//--------------------------------------------------------------------------
+
+static vector<string> calls;
+static unsigned line = 1;
+static OptTreeNode* const test_otn = reinterpret_cast<OptTreeNode*>(&line);
+
+static void call(const string& s)
+{ calls.emplace_back(to_string(line) + ": " + s); }
+
+static string str(const char* s)
+{ return s ? s : "(null)"; }
+
+void inc_parse_position()
+{ ++line; }
+
+void parse_include(SnortConfig*, const char* arg)
+{ call("include " + str(arg)); }
+
+void parse_rule_type(SnortConfig*, const char* s, RuleTreeNode&)
+{ call("type " + str(s)); }
+
+void parse_rule_proto(SnortConfig*, const char* s, RuleTreeNode&, bool elided)
+{ call("proto " + str(s) + (elided ? " elided" : "")); }
+
+void parse_rule_nets(SnortConfig*, const char* s, bool src, RuleTreeNode&, bool elided)
+{ call((src ? "src " : "dst ") + str(s) + (elided ? " elided" : "")); }
+
+void parse_rule_ports(SnortConfig*, const char* s, bool src, RuleTreeNode&, bool elided)
+{ call((src ? "sp " : "dp ") + str(s) + (elided ? " elided" : "")); }
+
+void parse_rule_dir(SnortConfig*, const char* s, RuleTreeNode&, bool elided)
+{ call("dir " + str(s) + (elided ? " elided" : "")); }
+
+void parse_rule_opt_begin(SnortConfig*, const char* key)
+{ call("begin " + str(key)); }
+
+void parse_rule_opt_set(SnortConfig*, const char* key, const char* opt, const char* val)
+{ call("set " + str(key) + " [" + str(opt) + "] [" + str(val) + "]"); }
+
+void parse_rule_opt_end(SnortConfig*, const char* key, OptTreeNode* otn)
+{ call("end " + str(key) + (otn == test_otn ? "" : " no otn")); }
+
+OptTreeNode* parse_rule_open(SnortConfig*, RuleTreeNode&, bool stub)
+{
+    call(stub ? "open stub" : "open");
+    return test_otn;
+}
+
+void parse_rule_close(SnortConfig*, RuleTreeNode&, OptTreeNode* otn)
+{ call(string("close") + (otn == test_otn ? "" : " no otn")); }
+
+namespace snort
+{
+void ParseWarning(WarningGroup, const char* format, ...)
+{
+    char buf[STD_BUF];
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+
+    call(string("warning ") + buf);
+}
+
+void ParseError(const char* format, ...)
+{
+    char buf[STD_BUF];
+    va_list ap;
+
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+
+    call(string("error ") + buf);
+}
+}
+
+//--------------------------------------------------------------------------
+// helpers
+//--------------------------------------------------------------------------
+
+static const char* const rules_text =
+    "# a comment with \"quotes\" and ( parens\n"
+    "/* a block comment\n"
+    "   with \"a string\" inside */\n"
+    "#begin\n"
+    "alert tcp any any -> any any ( sid:99; )\n"
+    "#end\n"
+    "\n"
+    "alert tcp $HOME_NET any -> $EXTERNAL_NET [80,8080] ( msg:\"say \\\"hi\\\"\\; ok\"; "
+    "content:\"a|3b|b\\x41\\tz\"; pcre:\"/x\\;y/i\"; sid:1; rev:2; )\n"
+    "alert udp [10.0.0.0/8,!10.1.0.0/16] 53 <> any any \\\n"
+    "    ( msg:\"continued\";\n"
+    "      content:\"one\", nocase,\n"
+    "          within 8;\n"
+    "      metadata: policy balanced-ips drop, service dns;\n"
+    "      reference:url,example.com/a;\n"
+    "      sid:2; )\n"
+    "alert ( gid:1; sid:3; msg:\"stub\"; )\n"
+    "alert http ( msg:\"\\xq\"; sid:4; )\n"
+    "alert tcp any any\n"
+    "    -> any any\n"
+    "(\n"
+    "    msg:\"line\n"
+    "break\";\n"
+    "    sid:5;\n"
+    ")\n";
+
+static string make_rules(unsigned n)
+{
+    string s = rules_text;
+
+    // enough tokens for several lexer batches
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        s += "# rule " + to_string(i) + "\n";
+        s += "drop tcp any any -> any " + to_string(i) + " ( msg:\"r\\\\" + to_string(i) +
+            "\"; flow:established,to_server; content:\"x\"; sid:" + to_string(1000 + i) + "; )\n";
+    }
+    return s;
+}
+
+static vector<string> parse(const string& text, bool pipeline)
+{
+    calls.clear();
+    line = 1;
+
+    istringstream is(text);
+    parse_stream(is, nullptr, pipeline);
+
+    return calls;
+}
+
+static bool has(const vector<string>& v, const string& s)
+{ return find(v.begin(), v.end(), s) != v.end(); }
+
+static unsigned count(const vector<string>& v, const string& suffix)
+{
+    return count_if(v.begin(), v.end(), [&suffix](const string& s)
+        { return s.size() >= suffix.size() and !s.compare(s.size() - suffix.size(), suffix.size(), suffix); });
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+
+TEST_GROUP(parse_stream) { };
+
+TEST(parse_stream, rules_file)
+{
+    const unsigned n = 200;
+    string text = make_rules(n);
+
+    vector<string> seq = parse(text, false);
+    vector<string> pipe = parse(text, true);
+
+    CHECK_EQUAL(seq.size(), pipe.size());
+
+    for ( unsigned i = 0; i < seq.size() and i < pipe.size(); ++i )
+        CHECK_EQUAL(seq[i], pipe[i]);
+
+    // spot check what both saw
+    CHECK_EQUAL(n + 5, count(seq, ": close"));
+    CHECK_EQUAL(0u, count(seq, " no otn"));
+    CHECK_EQUAL(0u, count(seq, ": set sid [99] []"));
+
+    CHECK(has(seq, "8: set msg [\"say \"hi\"; ok\"] []"));
+    CHECK(has(seq, "8: set content [\"a|3b|bA\tz\"] []"));
+    CHECK(has(seq, "8: set pcre [\"/x\\;y/i\"] []"));
+    CHECK(has(seq, "8: dp [80,8080]"));
+
+    CHECK(has(seq, "9: src [10.0.0.0/8,!10.1.0.0/16]"));
+    CHECK(has(seq, "9: dir <>"));
+    CHECK(has(seq, "11: set content [\"one\"] []"));
+    CHECK(has(seq, "11: set content [nocase] []"));
+    CHECK(has(seq, "12: set content [within] [8]"));
+    CHECK(has(seq, "13: set metadata [policy] [balanced-ips drop]"));
+    CHECK(has(seq, "13: set metadata [service] [dns]"));
+    CHECK(has(seq, "14: set reference [url,example.com/a] []"));
+
+    CHECK(has(seq, "16: open stub"));
+    CHECK(has(seq, "17: sp any elided"));
+    CHECK(has(seq, "17: warning \\x used with no following hex digits on line 16\n"));
+    CHECK(has(seq, "17: set msg [\"q\"] []"));
+
+    // warnings are reported where they occur in a multi-line token
+    CHECK(has(seq, "21: begin msg"));
+    CHECK(has(seq, "22: warning line break in string on line 23\n"));
+    CHECK(has(seq, "22: set msg [\"linebreak\"] []"));
+    CHECK(has(seq, "23: set sid [5] []"));
+    CHECK(has(seq, "24: close"));
+
+    string last = to_string(24 + 2 * n) + ": set sid [" + to_string(1000 + n - 1) + "] []";
+    CHECK(has(seq, last));
+    CHECK(has(seq, to_string(24 + 2 * n) + ": set msg [\"r\\" + to_string(n - 1) + "\"] []"));
+}
+
+TEST(parse_stream, end_of_rules)
+{
+    string text = make_rules(100) + "END\nthis is not a rule (\n";
+
+    vector<string> seq = parse(text, false);
+    vector<string> pipe = parse(text, true);
+
+    CHECK(seq == pipe);
+    CHECK_EQUAL(105u, count(seq, ": close"));
+    CHECK_EQUAL(0u, count(seq, "error incomplete rule"));
+    CHECK_EQUAL(0u, count(seq, "type this"));
+}
+
+TEST(parse_stream, incomplete_rule)
+{
+    string text = make_rules(100) + "alert tcp any any -> any any ( sid:1;\n";
+
+    vector<string> seq = parse(text, false);
+    vector<string> pipe = parse(text, true);
+
+    CHECK(seq == pipe);
+    CHECK_EQUAL(105u, count(seq, ": close"));
+    CHECK_EQUAL(1u, count(seq, ": error incomplete rule"));
+}
+
+TEST(parse_stream, syntax_error)
+{
+    string text = make_rules(100) + "alert tcp any any -> any any ( sid:1; ; )\n";
+
+    vector<string> seq = parse(text, false);
+    vector<string> pipe = parse(text, true);
+
+    CHECK(seq == pipe);
+    CHECK_EQUAL(1u, count(seq, ": error syntax error"));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -24,22 +24,30 @@
 #include "packet_manager.h"
 
 #include <daq.h>
+#include <cstring>
 #include <mutex>
 
 #include "codecs/codec_module.h"
 #include "codecs/ip/checksum.h"
 #include "detection/detection_engine.h"
 #include "log/text_log.h"
+#include "main/policy.h"
 #include "main/snort_config.h"
 #include "packet_io/active.h"
 #include "packet_io/sfdaq.h"
 #include "profiler/profiler_defs.h"
 #include "stream/stream.h"
 #include "trace/trace_api.h"
+#include "utils/util.h"
 
 #include "eth.h"
 #include "icmp4.h"
 #include "icmp6.h"
+#include "ipv4.h"
+#include "ipv6.h"
+#include "tcp.h"
+#include "tcp_options.h"
+#include "vlan.h"
 
 using namespace snort;
 
@@ -71,9 +79,39 @@ const std::array<const char*, PacketManager::stat_offset> PacketManager::stat_na
 // Encoder Foo
 static THREAD_LOCAL std::array<uint8_t, Codec::PKT_MAX>* s_pkt;
 
+// codecs whose headers fast_decode() decodes inline, 0 if not loaded
+struct FastCodecs
+{
+    ProtocolIndex eth = 0;
+    ProtocolIndex vlan = 0;
+    ProtocolIndex ip4 = 0;
+    ProtocolIndex ip6 = 0;
+    ProtocolIndex tcp = 0;
+};
+
+static THREAD_LOCAL FastCodecs s_fast;
+
+static inline bool is_fast(ProtocolIndex idx, ProtocolIndex fast)
+{ return fast and idx == fast; }
+
 void PacketManager::thread_init()
 {
     s_pkt = new std::array<uint8_t, Codec::PKT_MAX>{ {0} };
+
+    // only the built in codecs are known to decode as fast_decode() does
+    auto find = [](ProtocolIndex idx, const char* name) -> ProtocolIndex
+    {
+        const Codec* cd = CodecManager::s_protocols[idx];
+        return (idx and cd and !strcmp(cd->get_name(), name)) ? idx : 0;
+    };
+
+    if ( CodecManager::grinder_id == ProtocolId::ETHERNET_802_3 )
+        s_fast.eth = find(CodecManager::grinder, "eth");
+
+    s_fast.vlan = find(proto_idx(ProtocolId::ETHERTYPE_8021Q), "vlan");
+    s_fast.ip4 = find(proto_idx(ProtocolId::ETHERTYPE_IPV4), "ipv4");
+    s_fast.ip6 = find(proto_idx(ProtocolId::ETHERTYPE_IPV6), "ipv6");
+    s_fast.tcp = find(proto_idx(ProtocolId::TCP), "tcp");
 }
 
 void PacketManager::thread_term()
@@ -208,6 +246,384 @@ static_assert(CODEC_ENCAP_LAYER == (CODEC_UNSURE_ENCAP | CODEC_SAVE_LAYER),
     "If this is an encapsulated layer, you must also set UNSURE_ENCAP"
     " and SAVE_LAYER");
 
+//-------------------------------------------------------------------------
+// Fast path
+//-------------------------------------------------------------------------
+
+// Ethernet, VLAN tags, IPv4 or IPv6, and TCP make up most traffic, and most
+// of their headers need none of what the codecs check for.  The functions
+// below recognize those headers so they can be decoded inline.  Anything
+// that would raise an event or set state the fast path doesn't is left to
+// the codecs, so these must stay in step with the eth, vlan, ipv4, ipv6,
+// and tcp codecs.
+
+// the naptha and shaft synflood signatures of the tcp codec
+static constexpr uint32_t NAPTHA_SEQ = 0x005c7b2a;
+static constexpr uint16_t NAPTHA_ID = 0x019d;
+static constexpr uint32_t SHAFT_SEQ = 674711609;
+
+// reserved ids are left to the codec
+static inline bool clean_vlan(const vlan::VlanTagHdr* vh)
+{
+    const uint16_t vid = vh->vid();
+    return vid != 0 and vid != 4095;
+}
+
+// an outer header with no options, fragmentation, or suspect addresses
+static inline bool clean_ip4(const ip::IP4Hdr* iph, uint32_t len)
+{
+    if ( len < ip::IP4_HEADER_LEN or iph->ver() != 4 or iph->hlen() != ip::IP4_HEADER_LEN )
+        return false;
+
+    const uint16_t ip_len = iph->len();
+
+    if ( ip_len > len or ip_len < ip::IP4_HEADER_LEN )
+        return false;
+
+    if ( iph->get_src() == iph->get_dst() or iph->is_src_broadcast() or iph->is_dst_broadcast() )
+        return false;
+
+    const uint8_t msb_src = ntohl(iph->get_src()) >> 24;
+    const uint8_t msb_dst = ntohl(iph->get_dst()) >> 24;
+
+    if ( msb_src == ip::IP4_LOOPBACK or msb_dst == ip::IP4_LOOPBACK or
+        msb_src == ip::IP4_THIS_NET or msb_dst == ip::IP4_THIS_NET or
+        (msb_src >> 4) == ip::IP4_MULTICAST )
+        return false;
+
+    // anything but DF
+    if ( iph->off_w_flags() & ~0x4000 )
+        return false;
+
+    if ( to_utype(iph->proto()) >= to_utype(ProtocolId::MIN_UNASSIGNED_IP_PROTO) )
+        return false;
+
+    if ( get_network_policy()->ip_checksums() and
+        checksum::ip_cksum((const uint16_t*)iph, ip::IP4_HEADER_LEN) )
+        return false;
+
+    return true;
+}
+
+// an outer header with no multicast or suspect addresses; sets api
+static inline bool clean_ip6(const ip::IP6Hdr* ip6h, uint32_t len, ip::IpApi& api)
+{
+    if ( len < ip::IP6_HEADER_LEN or ip6h->ver() != 6 or
+        (uint32_t)ip6h->len() + ip::IP6_HEADER_LEN > len )
+        return false;
+
+    if ( ip6h->is_src_multicast() or ip6h->is_dst_multicast() or !ip6h->is_valid_next_header() )
+        return false;
+
+    api.set(ip6h);
+
+    const SfIp* src = api.get_src();
+    const SfIp* dst = api.get_dst();
+
+    return !src->fast_eq6(*dst) and !src->is_loopback() and !dst->is_loopback() and dst->is_set();
+}
+
+static inline bool fits(const tcp::TcpOption* opt, const uint8_t* end, uint8_t len)
+{ return (const uint8_t*)opt + len <= end and opt->len == len; }
+
+// the options of nearly all segments; sets the decode flags and the
+// invalid bytes after an EOL as the tcp codec does
+static inline bool clean_tcp_options(const tcp::TCPHdr* tcph, uint16_t& flags, uint16_t& invalid)
+{
+    const uint8_t* const start = (const uint8_t*)tcph + tcp::TCP_MIN_HEADER_LEN;
+    const uint16_t o_len = tcph->hlen() - tcp::TCP_MIN_HEADER_LEN;
+    const uint8_t* const end = start + o_len;
+    uint16_t tot_len = 0;
+
+    while ( tot_len < o_len )
+    {
+        const tcp::TcpOption* opt = (const tcp::TcpOption*)(start + tot_len);
+
+        switch ( opt->code )
+        {
+        case tcp::TcpOptCode::EOL:
+            invalid = o_len - tot_len;
+            return true;
+
+        case tcp::TcpOptCode::NOP:
+            break;
+
+        case tcp::TcpOptCode::MAXSEG:
+            if ( !fits(opt, end, tcp::TCPOLEN_MAXSEG) )
+                return false;
+            flags |= DECODE_TCP_MSS;
+            break;
+
+        case tcp::TcpOptCode::SACKOK:
+            if ( !fits(opt, end, tcp::TCPOLEN_SACKOK) )
+                return false;
+            break;
+
+        case tcp::TcpOptCode::WSCALE:
+            if ( !fits(opt, end, tcp::TCPOLEN_WSCALE) or opt->data[0] > 14 )
+                return false;
+            flags |= DECODE_TCP_WS;
+            break;
+
+        case tcp::TcpOptCode::TIMESTAMP:
+            if ( !fits(opt, end, tcp::TCPOLEN_TIMESTAMP) )
+                return false;
+            flags |= DECODE_TCP_TS;
+            break;
+
+        case tcp::TcpOptCode::SACK:
+            if ( (const uint8_t*)opt + 2 > end or (const uint8_t*)opt + opt->len > end or opt->len < 2 )
+                return false;
+            break;
+
+        default:
+            return false;
+        }
+        tot_len += opt->get_len();
+    }
+    return true;
+}
+
+// a segment with no suspect flags, ports, or options
+static inline bool clean_tcp(const tcp::TCPHdr* tcph, uint32_t len, const ip::IpApi& api,
+    uint16_t& flags, uint16_t& invalid)
+{
+    if ( len < tcp::TCP_MIN_HEADER_LEN or tcph->hlen() < tcp::TCP_MIN_HEADER_LEN or tcph->hlen() > len )
+        return false;
+
+    const uint8_t th_flags = tcph->th_flags;
+
+    if ( th_flags & TH_URG )
+        return false;
+
+    if ( th_flags & TH_SYN )
+    {
+        if ( th_flags & (TH_RST | TH_FIN) )
+            return false;
+
+        if ( (th_flags & TH_NORESERVED) == TH_SYN and tcph->seq() == SHAFT_SEQ )
+            return false;
+
+        if ( th_flags == TH_SYN and tcph->seq() == NAPTHA_SEQ and api.is_ip4() and
+            api.get_ip4h()->id() == NAPTHA_ID )
+            return false;
+    }
+    else if ( !(th_flags & (TH_ACK | TH_RST)) )
+        return false;
+
+    if ( (th_flags & (TH_FIN | TH_PUSH)) and !(th_flags & TH_ACK) )
+        return false;
+
+    if ( !tcph->src_port() or !tcph->dst_port() )
+        return false;
+
+    if ( tcph->has_options() and !clean_tcp_options(tcph, flags, invalid) )
+        return false;
+
+    if ( get_network_policy()->tcp_checksums() )
+    {
+        uint16_t csum;
+
+        if ( api.is_ip4() )
+        {
+            const ip::IP4Hdr* ip4h = api.get_ip4h();
+            checksum::Pseudoheader ph;
+            ph.hdr.sip = ip4h->get_src();
+            ph.hdr.dip = ip4h->get_dst();
+            ph.hdr.zero = 0;
+            ph.hdr.protocol = IpProtocol::TCP;
+            ph.hdr.len = htons((uint16_t)len);
+            csum = checksum::tcp_cksum((const uint16_t*)tcph, len, ph);
+        }
+        else
+        {
+            const ip::IP6Hdr* ip6h = api.get_ip6h();
+            checksum::Pseudoheader6 ph6;
+            COPY4(ph6.hdr.sip, ip6h->get_src()->u6_addr32);
+            COPY4(ph6.hdr.dip, ip6h->get_dst()->u6_addr32);
+            ph6.hdr.zero = 0;
+            ph6.hdr.protocol = IpProtocol::TCP;
+            ph6.hdr.len = htons((uint16_t)len);
+            csum = checksum::tcp_cksum((const uint16_t*)tcph, len, ph6);
+        }
+        if ( csum )
+            return false;
+    }
+    return true;
+}
+
+// the generic loop's handling of a layer that needs none of its special cases
+inline void PacketManager::fast_layer(Packet* p, RawData& raw, CodecData& codec_data,
+    ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    debug_logf(decode_trace, nullptr,
+        "Codec %s (0x%0*hx) starts at %u, length is %hu\n",
+        CodecManager::s_protocols[mapped_prot]->get_name(),
+        (static_cast<uint16_t>(prev_prot_id) < 0xFF) ? 2 : 4,
+        static_cast<uint16_t>(prev_prot_id),
+        p->pktlen - raw.len, codec_data.lyr_len);
+
+    if ( push_layer(p, codec_data, prev_prot_id, raw.data, codec_data.lyr_len) and
+        codec_data.proto_bits == PROTO_BIT__VLAN )
+        p->vlan_idx = p->num_layers - 1;
+
+    s_stats[mapped_prot + stat_offset]++;
+    mapped_prot = CodecManager::s_proto_map[to_utype(codec_data.next_prot_id)];
+    prev_prot_id = codec_data.next_prot_id;
+
+    const uint16_t curr_lyr_len = codec_data.lyr_len + codec_data.invalid_bytes;
+    assert(curr_lyr_len <= raw.len);
+    raw.len -= curr_lyr_len;
+    raw.data += curr_lyr_len;
+
+    p->proto_bits |= codec_data.proto_bits;
+
+    codec_data.next_prot_id = ProtocolId::FINISHED_DECODE;
+    codec_data.lyr_len = 0;
+    codec_data.invalid_bytes = 0;
+    codec_data.proto_bits = 0;
+}
+
+// Decodes Ethernet, any VLAN tags, IPv4 or IPv6, and TCP without the codecs
+// when all of those headers are clean.  Up to the IP layer, everything is
+// checked before anything is set, so a packet that isn't clean is left as
+// it was for the generic loop.  A transport layer other than clean TCP is
+// left to its codec, and the generic loop continues from there with the
+// state the codecs would have left.  Returns true if the packet is decoded.
+bool PacketManager::fast_decode(Packet* p, RawData& raw, CodecData& codec_data,
+    ProtocolIndex& mapped_prot, ProtocolId& prev_prot_id)
+{
+    // addresses and ports from the DAQ are left to the codecs
+    if ( codec_data.conf->is_address_anomaly_check_enabled() or
+        daq_msg_get_meta(raw.daq_msg, DAQ_PKT_META_NAPT_INFO) or
+        daq_msg_get_meta(raw.daq_msg, DAQ_PKT_META_DECODE_DATA) )
+        return false;
+
+    if ( raw.len < eth::ETH_HEADER_LEN )
+        return false;
+
+    const eth::EtherHdr* const eh = reinterpret_cast<const eth::EtherHdr*>(raw.data);
+    uint32_t off = eth::ETH_HEADER_LEN;
+    uint16_t type = ntohs(eh->ether_type);
+
+    if ( is_fast(CodecManager::s_proto_map[type], s_fast.vlan) )
+    {
+        if ( daq_msg_get_pkthdr(raw.daq_msg)->flags & DAQ_PKT_FLAG_IGNORE_VLAN )
+            return false;
+
+        do
+        {
+            if ( raw.len - off < sizeof(vlan::VlanTagHdr) )
+                return false;
+
+            const vlan::VlanTagHdr* const vh = reinterpret_cast<const vlan::VlanTagHdr*>(raw.data + off);
+
+            if ( !clean_vlan(vh) )
+                return false;
+
+            type = vh->proto();
+            off += sizeof(vlan::VlanTagHdr);
+        }
+        while ( is_fast(CodecManager::s_proto_map[type], s_fast.vlan) );
+    }
+
+    const uint8_t* const ip_start = raw.data + off;
+    const ProtocolIndex ip_idx = CodecManager::s_proto_map[type];
+    ip::IpApi ip6_api;
+
+    if ( type == to_utype(ProtocolId::ETHERTYPE_IPV4) and is_fast(ip_idx, s_fast.ip4) )
+    {
+        if ( !clean_ip4(reinterpret_cast<const ip::IP4Hdr*>(ip_start), raw.len - off) )
+            return false;
+    }
+    else if ( type == to_utype(ProtocolId::ETHERTYPE_IPV6) and is_fast(ip_idx, s_fast.ip6) )
+    {
+        if ( !clean_ip6(reinterpret_cast<const ip::IP6Hdr*>(ip_start), raw.len - off, ip6_api) )
+            return false;
+    }
+    else
+        return false;
+
+    // the link and network layers are clean so commit them
+    codec_data.next_prot_id = eh->ethertype();
+    codec_data.lyr_len = eth::ETH_HEADER_LEN;
+    codec_data.proto_bits |= PROTO_BIT__ETH;
+    fast_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+
+    while ( raw.data < ip_start )
+    {
+        const vlan::VlanTagHdr* const vh = reinterpret_cast<const vlan::VlanTagHdr*>(raw.data);
+
+        codec_data.next_prot_id = (ProtocolId)vh->proto();
+        codec_data.lyr_len = sizeof(vlan::VlanTagHdr);
+        codec_data.proto_bits |= PROTO_BIT__VLAN;
+        fast_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+    }
+
+    DecodeData& snort = p->ptrs;
+
+    if ( ip_idx == s_fast.ip4 )
+    {
+        const ip::IP4Hdr* const iph = reinterpret_cast<const ip::IP4Hdr*>(raw.data);
+
+        snort.ip_api.set(iph);
+
+        if ( iph->df() )
+        {
+            codec_data.codec_flags |= CODEC_DF;
+            snort.decode_flags |= DECODE_DF;
+        }
+        codec_data.codec_flags &= ~CODEC_IPOPT_FLAGS;
+        raw.len = iph->len();
+        codec_data.next_prot_id = (ProtocolId)iph->proto();
+        codec_data.lyr_len = ip::IP4_HEADER_LEN;
+    }
+    else
+    {
+        const ip::IP6Hdr* const ip6h = reinterpret_cast<const ip::IP6Hdr*>(raw.data);
+
+        snort.ip_api = ip6_api;
+        codec_data.codec_flags &= ~CODEC_ROUTING_SEEN;
+        codec_data.ip6_csum_proto = ip6h->next();
+        raw.len = ip6h->len() + ip::IP6_HEADER_LEN;
+        codec_data.next_prot_id = (ProtocolId)ip6h->next();
+        codec_data.lyr_len = ip::IP6_HEADER_LEN;
+    }
+
+    snort.set_pkt_type(PktType::IP);
+    codec_data.ip_layer_cnt++;
+    codec_data.curr_ip6_extension = 0;
+    codec_data.ip6_extension_count = 0;
+    codec_data.proto_bits |= PROTO_BIT__IP;
+
+    p->ip_proto_next = convert_protocolid_to_ipprotocol(codec_data.next_prot_id);
+    fast_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+
+    // then TCP or leave the rest to the generic loop
+    if ( !is_fast(mapped_prot, s_fast.tcp) )
+        return false;
+
+    const tcp::TCPHdr* const tcph = reinterpret_cast<const tcp::TCPHdr*>(raw.data);
+    uint16_t flags = 0;
+    uint16_t invalid = 0;
+
+    if ( !clean_tcp(tcph, raw.len, snort.ip_api, flags, invalid) )
+        return false;
+
+    snort.decode_flags |= flags;
+    snort.set_pkt_type(PktType::TCP);
+    snort.tcph = tcph;
+    snort.sp = tcph->src_port();
+    snort.dp = tcph->dst_port();
+
+    codec_data.invalid_bytes = invalid;
+    codec_data.lyr_len = tcph->hlen() - invalid;
+    codec_data.proto_bits |= PROTO_BIT__TCP;
+    fast_layer(p, raw, codec_data, mapped_prot, prev_prot_id);
+
+    return true;
+}
+
 //-------------------------------------------------------------------------
 // Encode/Decode functions
 //-------------------------------------------------------------------------
@@ -238,8 +654,11 @@ void PacketManager::decode(
 
     s_stats[total_processed]++;
 
+    bool done = codec_data.conf->fast_decode and is_fast(mapped_prot, s_fast.eth) and
+        fast_decode(p, raw, codec_data, mapped_prot, prev_prot_id);
+
     // loop until the protocol id is no longer valid
-    while (CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs))
+    while (!done and CodecManager::s_protocols[mapped_prot]->decode(raw, codec_data, p->ptrs))
     {
         debug_logf(decode_trace, nullptr,
             "Codec %s (0x%0*hx) starts at %u, length is %hu\n",
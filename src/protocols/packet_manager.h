@@ -139,6 +139,9 @@ private:
     static void pop_teredo(Packet*, RawData&);
     static void handle_decode_failure(Packet*, RawData&, const CodecData&, const DecodeData&, ProtocolId);
 
+    static bool fast_decode(Packet*, RawData&, CodecData&, ProtocolIndex&, ProtocolId&);
+    static void fast_layer(Packet*, RawData&, CodecData&, ProtocolIndex&, ProtocolId&);
+
     static bool encode(const Packet*, EncodeFlags,
         uint8_t lyr_start, IpProtocol next_prot, Buffer& buf);
 
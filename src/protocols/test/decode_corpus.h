@@ -0,0 +1,532 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// decode_corpus.h - synthetic Ethernet frames covering the decoder fast
+// path, its fallbacks, and the anomalies the codecs check for
+
+#include <arpa/inet.h>
+#include <daq_common.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// DAQ metadata to attach to a frame
+enum class DecodeMeta { NONE, NAPT, DECODE_DATA };
+
+struct DecodeFrame
+{
+    const char* name;
+    std::vector<uint8_t> data;
+    uint32_t daq_flags = 0;
+    DecodeMeta meta = DecodeMeta::NONE;
+};
+
+class FrameBuilder
+{
+public:
+    FrameBuilder& eth(uint16_t type)
+    {
+        static const uint8_t macs[] =
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x00, 0x66, 0x77, 0x88, 0x99, 0xaa };
+        bytes(macs, sizeof(macs));
+        u16(type);
+        return *this;
+    }
+
+    FrameBuilder& vlan(uint16_t vid, uint16_t type)
+    {
+        u16(vid);
+        u16(type);
+        return *this;
+    }
+
+    // addresses, ports and so on for the layers that follow
+    FrameBuilder& addrs4(uint32_t src, uint32_t dst)
+    { src4 = src; dst4 = dst; return *this; }
+
+    // the first and last words of each address, the rest are zero
+    FrameBuilder& addrs6(uint32_t src_hi, uint32_t src_lo, uint32_t dst_hi, uint32_t dst_lo)
+    { src6 = { src_hi, src_lo }; dst6 = { dst_hi, dst_lo }; return *this; }
+
+    FrameBuilder& id(uint16_t v)
+    { ip_id = v; return *this; }
+
+    FrameBuilder& ports(uint16_t src, uint16_t dst)
+    { sport = src; dport = dst; return *this; }
+
+    FrameBuilder& seq(uint32_t v)
+    { tcp_seq = v; return *this; }
+
+    FrameBuilder& ip4(uint8_t proto, uint16_t frag = 0, unsigned opt_words = 0)
+    {
+        add(IP4);
+        u8(0x45 + opt_words);
+        u8(0);
+        u16(0);                 // length
+        u16(ip_id);
+        u16(frag);
+        u8(64);
+        u8(proto);
+        u16(0);                 // checksum
+        u32(src4);
+        u32(dst4);
+
+        for ( unsigned i = 0; i < opt_words; ++i )
+            u32(0x01010101);    // nops
+
+        return *this;
+    }
+
+    FrameBuilder& ip6(uint8_t next)
+    {
+        add(IP6);
+        u32(0x60000000);
+        u16(0);                 // length
+        u8(next);
+        u8(64);
+
+        for ( const auto& a : { src6, dst6 } )
+        {
+            u32(a.first);
+            u32(0);
+            u32(0);
+            u32(a.second);
+        }
+        return *this;
+    }
+
+    FrameBuilder& hop_opts(uint8_t next)
+    {
+        static const uint8_t pad[] = { 0x01, 0x04, 0x00, 0x00, 0x00, 0x00 };
+        u8(next);
+        u8(0);
+        bytes(pad, sizeof(pad));
+        return *this;
+    }
+
+    // options are padded with EOLs to a multiple of 4 bytes
+    FrameBuilder& tcp(uint8_t flags, std::vector<uint8_t> opts = {}, uint16_t urp = 0)
+    {
+        while ( opts.size() % 4 )
+            opts.push_back(0);
+
+        add(TCP);
+        u16(sport);
+        u16(dport);
+        u32(tcp_seq);
+        u32(flags & 0x10 ? 2000 : 0);
+        u8((5 + opts.size() / 4) << 4);
+        u8(flags);
+        u16(8192);
+        u16(0);                 // checksum
+        u16(urp);
+        bytes(opts.data(), opts.size());
+        return *this;
+    }
+
+    FrameBuilder& udp()
+    {
+        add(UDP);
+        u16(sport);
+        u16(dport == 80 ? 53 : dport);
+        u16(0);                 // length
+        u16(0);                 // checksum
+        return *this;
+    }
+
+    FrameBuilder& payload(unsigned len)
+    {
+        for ( unsigned i = 0; i < len; ++i )
+            u8('a' + i % 26);
+        return *this;
+    }
+
+    // set lengths and checksums from the innermost layer out
+    std::vector<uint8_t> build()
+    {
+        for ( auto it = layers.rbegin(); it != layers.rend(); ++it )
+        {
+            unsigned off = it->off;
+            unsigned len = buf.size() - off;
+
+            switch ( it->kind )
+            {
+            case IP4:
+                put16(off + 2, len);
+                put16(off + 10, checksum(0, off, (buf[off] & 0x0f) * 4));
+                break;
+
+            case IP6:
+                put16(off + 4, len - 40);
+                break;
+
+            case UDP:
+                put16(off + 4, len);
+                put16(off + 6, l4_checksum(it, 17, off, len));
+                break;
+
+            case TCP:
+                put16(off + 16, l4_checksum(it, 6, off, len));
+                break;
+            }
+        }
+        return buf;
+    }
+
+private:
+    enum Kind { IP4, IP6, TCP, UDP };
+
+    struct Layer
+    {
+        Kind kind;
+        unsigned off;
+    };
+
+    void add(Kind k)
+    { layers.push_back({ k, (unsigned)buf.size() }); }
+
+    void u8(uint8_t v)
+    { buf.push_back(v); }
+
+    void u16(uint16_t v)
+    { u8(v >> 8); u8(v & 0xff); }
+
+    void u32(uint32_t v)
+    { u16(v >> 16); u16(v & 0xffff); }
+
+    void bytes(const uint8_t* b, unsigned n)
+    { buf.insert(buf.end(), b, b + n); }
+
+    void put16(unsigned off, uint16_t v)
+    {
+        buf[off] = v >> 8;
+        buf[off + 1] = v & 0xff;
+    }
+
+    uint32_t sum(uint32_t s, unsigned off, unsigned len) const
+    {
+        for ( unsigned i = 0; i + 1 < len; i += 2 )
+            s += (buf[off + i] << 8) | buf[off + i + 1];
+
+        if ( len & 1 )
+            s += buf[off + len - 1] << 8;
+
+        return s;
+    }
+
+    uint16_t checksum(uint32_t s, unsigned off, unsigned len) const
+    {
+        s = sum(s, off, len);
+
+        while ( s >> 16 )
+            s = (s & 0xffff) + (s >> 16);
+
+        uint16_t c = ~s & 0xffff;
+        return c ? c : 0xffff;
+    }
+
+    // pseudo header from the enclosing IP layer
+    uint16_t l4_checksum(std::vector<Layer>::reverse_iterator it, uint8_t proto,
+        unsigned off, unsigned len) const
+    {
+        while ( ++it != layers.rend() and it->kind != IP4 and it->kind != IP6 );
+
+        uint32_t s = proto + len;
+
+        if ( it == layers.rend() )
+            return checksum(s, off, len);
+
+        if ( it->kind == IP4 )
+            s = sum(s, it->off + 12, 8);
+        else
+            s = sum(s, it->off + 8, 32);
+
+        return checksum(s, off, len);
+    }
+
+    std::vector<uint8_t> buf;
+    std::vector<Layer> layers;
+
+    uint32_t src4 = 0x0a000001;
+    uint32_t dst4 = 0x0a000002;
+    std::pair<uint32_t, uint32_t> src6 { 0x2a001450, 1 };
+    std::pair<uint32_t, uint32_t> dst6 { 0x2a001450, 2 };
+    uint16_t ip_id = 0x1234;
+    uint16_t sport = 40000;
+    uint16_t dport = 80;
+    uint32_t tcp_seq = 1000;
+};
+
+#define ETH_IP4 0x0800
+#define ETH_IP6 0x86dd
+#define ETH_ARP 0x0806
+#define ETH_8021Q 0x8100
+#define ETH_8021AD 0x88a8
+
+#define TH_SYN 0x02
+#define TH_FIN 0x01
+#define TH_ACK 0x10
+#define TH_PSH 0x08
+#define TH_RST 0x04
+#define TH_URG 0x20
+
+// tcp options
+#define MSS 0x02, 0x04, 0x05, 0xb4
+#define SACKOK 0x04, 0x02
+#define TS 0x08, 0x0a, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00
+#define NOP 0x01
+#define WS(n) 0x03, 0x03, (n)
+#define SACK 0x05, 0x0a, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02
+
+static inline DecodeFrame make_frame(
+    const char* name, std::vector<uint8_t> data, uint32_t daq_flags = 0, DecodeMeta meta = DecodeMeta::NONE)
+{ return { name, std::move(data), daq_flags, meta }; }
+
+static std::vector<uint8_t> truncate(std::vector<uint8_t> v, unsigned len)
+{
+    v.resize(len);
+    return v;
+}
+
+static std::vector<uint8_t> corrupt(std::vector<uint8_t> v, unsigned off)
+{
+    v[off] ^= 0x5a;
+    return v;
+}
+
+static std::vector<DecodeFrame> make_corpus()
+{
+    std::vector<DecodeFrame> c;
+
+    // fast path
+    c.emplace_back(make_frame("tcp4",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK | TH_PSH).payload(512).build()));
+    c.emplace_back(make_frame("tcp4 syn", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_SYN).build()));
+    c.emplace_back(make_frame("udp4", FrameBuilder().eth(ETH_IP4).ip4(17).udp().payload(64).build()));
+    c.emplace_back(make_frame("tcp6",
+        FrameBuilder().eth(ETH_IP6).ip6(6).tcp(TH_ACK).payload(1200).build()));
+    c.emplace_back(make_frame("udp6", FrameBuilder().eth(ETH_IP6).ip6(17).udp().payload(100).build()));
+    c.emplace_back(make_frame("vlan tcp4",
+        FrameBuilder().eth(ETH_8021Q).vlan(100, ETH_IP4).ip4(6).tcp(TH_ACK).payload(300).build()));
+    c.emplace_back(make_frame("qinq udp6",
+        FrameBuilder().eth(ETH_8021AD).vlan(10, ETH_8021Q).vlan(20, ETH_IP6).ip6(17).udp()
+        .payload(40).build()));
+    c.emplace_back(make_frame("tcp4 df",
+        FrameBuilder().eth(ETH_IP4).ip4(6, 0x4000).tcp(TH_ACK).payload(10).build()));
+    c.emplace_back(make_frame("tcp4 syn options",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_SYN, { MSS, SACKOK, TS, NOP, WS(7) }).build()));
+    c.emplace_back(make_frame("tcp6 syn ack options",
+        FrameBuilder().eth(ETH_IP6).ip6(6).tcp(TH_SYN | TH_ACK, { MSS, NOP, NOP, SACKOK, NOP, WS(14) })
+        .build()));
+    c.emplace_back(make_frame("tcp4 timestamps",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK | TH_PSH, { NOP, NOP, TS }).payload(100).build()));
+    c.emplace_back(make_frame("tcp4 sack",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { NOP, NOP, SACK }).build()));
+    c.emplace_back(make_frame("tcp4 eol", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { MSS, 0, NOP })
+        .payload(8).build()));
+    c.emplace_back(make_frame("tcp4 rst", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_RST).build()));
+    c.emplace_back(make_frame("tcp4 fin ack", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_FIN | TH_ACK).build()));
+    c.emplace_back(make_frame("ip4 options",
+        FrameBuilder().eth(ETH_IP4).ip4(6, 0, 2).tcp(TH_ACK).payload(10).build()));
+
+    // fallbacks
+    c.emplace_back(make_frame("udp6 hop opts",
+        FrameBuilder().eth(ETH_IP6).ip6(0).hop_opts(17).udp().payload(10).build()));
+    c.emplace_back(make_frame("arp", FrameBuilder().eth(ETH_ARP).payload(28).build()));
+    c.emplace_back(make_frame("llc", FrameBuilder().eth(0x0040).payload(64).build()));
+    c.emplace_back(make_frame("icmp4", FrameBuilder().eth(ETH_IP4).ip4(1).payload(16).build()));
+    c.emplace_back(make_frame("ip4 frag", FrameBuilder().eth(ETH_IP4).ip4(17, 0x2000).udp()
+        .payload(64).build()));
+    c.emplace_back(make_frame("ip4 in ip4",
+        FrameBuilder().eth(ETH_IP4).ip4(4).ip4(6).tcp(TH_ACK).payload(20).build()));
+    c.emplace_back(make_frame("ip6 in ip4",
+        FrameBuilder().eth(ETH_IP4).ip4(41).ip6(17).udp().payload(20).build()));
+    c.emplace_back(make_frame("vlan id 0",
+        FrameBuilder().eth(ETH_8021Q).vlan(0, ETH_IP4).ip4(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("vlan llc", FrameBuilder().eth(ETH_8021Q).vlan(5, 0x0040).payload(64).build()));
+    c.emplace_back(make_frame("vlan arp", FrameBuilder().eth(ETH_8021Q).vlan(5, ETH_ARP).payload(28).build()));
+    c.emplace_back(make_frame("ignored vlan",
+        FrameBuilder().eth(ETH_8021Q).vlan(7, ETH_IP4).ip4(17).udp().build(), DAQ_PKT_FLAG_IGNORE_VLAN));
+
+    // anomalies
+    std::vector<uint8_t> tcp4 = FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK).payload(20).build();
+    std::vector<uint8_t> udp4 = FrameBuilder().eth(ETH_IP4).ip4(17).udp().payload(20).build();
+
+    c.emplace_back(make_frame("bad ip4 checksum", corrupt(tcp4, 24)));
+    c.emplace_back(make_frame("bad tcp checksum", corrupt(tcp4, 50)));
+    c.emplace_back(make_frame("bad udp checksum", corrupt(udp4, 40)));
+    c.emplace_back(make_frame("bad ip4 version", corrupt(tcp4, 14)));
+    c.emplace_back(make_frame("syn fin", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_SYN | TH_FIN).build()));
+    c.emplace_back(make_frame("short eth", truncate(tcp4, 10)));
+    c.emplace_back(make_frame("short vlan",
+        truncate(FrameBuilder().eth(ETH_8021Q).vlan(100, ETH_IP4).build(), 16)));
+    c.emplace_back(make_frame("short ip4", truncate(tcp4, 30)));
+    c.emplace_back(make_frame("short tcp", truncate(tcp4, 44)));
+    c.emplace_back(make_frame("short udp", truncate(udp4, 38)));
+    c.emplace_back(make_frame("trailing bytes", [&]()
+        { std::vector<uint8_t> v = udp4; v.resize(v.size() + 8); return v; }()));
+    c.emplace_back(make_frame("ip6 trailing bytes", [&]()
+        { std::vector<uint8_t> v = FrameBuilder().eth(ETH_IP6).ip6(6).tcp(TH_ACK).payload(20).build();
+          v.resize(v.size() + 6); return v; }()));
+    c.emplace_back(make_frame("tcp trailing bytes", [&]()
+        { std::vector<uint8_t> v = tcp4; v.resize(v.size() + 6); return v; }()));
+
+    // addresses
+    c.emplace_back(make_frame("ip4 same addrs", FrameBuilder().eth(ETH_IP4).addrs4(0x0a000001, 0x0a000001)
+        .ip4(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("ip4 broadcast", FrameBuilder().eth(ETH_IP4).addrs4(0x0a000001, 0xffffffff)
+        .ip4(17).udp().build()));
+    c.emplace_back(make_frame("ip4 loopback", FrameBuilder().eth(ETH_IP4).addrs4(0x7f000001, 0x0a000002)
+        .ip4(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("ip4 this net", FrameBuilder().eth(ETH_IP4).addrs4(0x0a000001, 0x00000005)
+        .ip4(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("ip4 multicast src", FrameBuilder().eth(ETH_IP4).addrs4(0xe0000001, 0x0a000002)
+        .ip4(17).udp().build()));
+    c.emplace_back(make_frame("ip4 multicast dst", FrameBuilder().eth(ETH_IP4).addrs4(0x0a000001, 0xe0000001)
+        .ip4(17).udp().build()));
+    c.emplace_back(make_frame("ip6 same addrs", FrameBuilder().eth(ETH_IP6).addrs6(0x2a001450, 1, 0x2a001450, 1)
+        .ip6(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("ip6 loopback", FrameBuilder().eth(ETH_IP6).addrs6(0, 1, 0x2a001450, 2)
+        .ip6(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("ip6 unspecified dst", FrameBuilder().eth(ETH_IP6).addrs6(0x2a001450, 1, 0, 0)
+        .ip6(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("ip6 multicast src", FrameBuilder().eth(ETH_IP6).addrs6(0xff020000, 1, 0x2a001450, 2)
+        .ip6(17).udp().build()));
+    c.emplace_back(make_frame("ip6 multicast dst", FrameBuilder().eth(ETH_IP6).addrs6(0x2a001450, 1, 0xff030000, 2)
+        .ip6(17).udp().build()));
+
+    // ip headers
+    c.emplace_back(make_frame("ip4 reserved bit", FrameBuilder().eth(ETH_IP4).ip4(6, 0x8000).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("ip4 frag offset", FrameBuilder().eth(ETH_IP4).ip4(6, 0x0010).payload(20).build()));
+    c.emplace_back(make_frame("ip4 unassigned", FrameBuilder().eth(ETH_IP4).ip4(200).payload(20).build()));
+    c.emplace_back(make_frame("ip4 len gt caplen", truncate(tcp4, tcp4.size() - 4)));
+    c.emplace_back(make_frame("ip4 len lt hlen", [&]()
+        { std::vector<uint8_t> v = tcp4; v[16] = 0; v[17] = 16; return v; }()));
+    c.emplace_back(make_frame("ip6 bad next", FrameBuilder().eth(ETH_IP6).ip6(200).payload(20).build()));
+    c.emplace_back(make_frame("ip6 len gt caplen",
+        truncate(FrameBuilder().eth(ETH_IP6).ip6(6).tcp(TH_ACK).payload(20).build(), 90)));
+
+    // tcp headers
+    c.emplace_back(make_frame("tcp urg", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK | TH_URG, {}, 4)
+        .payload(10).build()));
+    c.emplace_back(make_frame("tcp bad urp", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK | TH_URG, {}, 20)
+        .payload(10).build()));
+    c.emplace_back(make_frame("tcp xmas ack",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_FIN | TH_PSH | TH_URG | TH_ACK).build()));
+    c.emplace_back(make_frame("tcp xmas",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_FIN | TH_PSH | TH_URG).build()));
+    c.emplace_back(make_frame("tcp null", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(0).build()));
+    c.emplace_back(make_frame("tcp fin", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_FIN).build()));
+    c.emplace_back(make_frame("tcp psh", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_PSH | TH_RST).build()));
+    c.emplace_back(make_frame("tcp syn rst", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_SYN | TH_RST).build()));
+    c.emplace_back(make_frame("tcp syn fin ack",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_SYN | TH_FIN | TH_ACK).build()));
+    c.emplace_back(make_frame("tcp syn to multicast", FrameBuilder().eth(ETH_IP4).addrs4(0x0a000001, 0xe0000001)
+        .ip4(6).tcp(TH_SYN).build()));
+    c.emplace_back(make_frame("tcp naptha",
+        FrameBuilder().eth(ETH_IP4).id(0x019d).seq(0x005c7b2a).ip4(6).tcp(TH_SYN).build()));
+    c.emplace_back(make_frame("tcp naptha ip6",
+        FrameBuilder().eth(ETH_IP6).seq(0x005c7b2a).ip6(6).tcp(TH_SYN).build()));
+    c.emplace_back(make_frame("tcp shaft",
+        FrameBuilder().eth(ETH_IP4).seq(674711609).ip4(6).tcp(TH_SYN | 0x40).build()));
+    c.emplace_back(make_frame("tcp src port 0",
+        FrameBuilder().eth(ETH_IP4).ports(0, 80).ip4(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("tcp dst port 0",
+        FrameBuilder().eth(ETH_IP6).ports(40000, 0).ip6(6).tcp(TH_ACK).build()));
+    c.emplace_back(make_frame("tcp short offset", [&]()
+        { std::vector<uint8_t> v = tcp4; v[46] = 0x40; return v; }()));
+    c.emplace_back(make_frame("tcp long offset",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { NOP, NOP, NOP, NOP }).build()));
+    c.emplace_back(make_frame("bad tcp6 checksum",
+        corrupt(FrameBuilder().eth(ETH_IP6).ip6(6).tcp(TH_ACK).payload(20).build(), 80)));
+
+    // tcp options
+    c.emplace_back(make_frame("wscale 15", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_SYN, { WS(15) }).build()));
+    c.emplace_back(make_frame("mss bad len",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_SYN, { 0x02, 0x03, 0x05, NOP }).build()));
+    c.emplace_back(make_frame("ts truncated", FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { NOP, NOP, TS })
+        .build()));
+    c.emplace_back(make_frame("sack bad len",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { 0x05, 0x01, NOP, NOP }).build()));
+    c.emplace_back(make_frame("sack truncated",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { 0x05, 0x0a, 0, 0 }).build()));
+    c.emplace_back(make_frame("echo option",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { 0x06, 0x06, 0, 0, 0, 0 }).build()));
+    c.emplace_back(make_frame("experimental option",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK, { 0x1e, 0x04, 0, 0 }).build()));
+
+    // DAQ metadata
+    c.emplace_back(make_frame("napt", tcp4, 0, DecodeMeta::NAPT));
+    c.emplace_back(make_frame("decode data", tcp4, 0, DecodeMeta::DECODE_DATA));
+
+    return c;
+}
+
+// DAQ message wrapping a frame for PacketManager::decode()
+struct DecodeMsg
+{
+    DAQ_PktHdr_t hdr;
+    DAQ_Msg_t msg;
+
+    // metadata for frames that have it
+    DAQ_NAPTInfo_t napt;
+    DAQ_PktDecodeData_t decode_data;
+
+    DecodeMsg(const DecodeFrame& f)
+    {
+        memset(&hdr, 0, sizeof(hdr));
+        memset(&msg, 0, sizeof(msg));
+        memset(&napt, 0, sizeof(napt));
+        memset(&decode_data, 0, sizeof(decode_data));
+
+        if ( f.meta == DecodeMeta::NAPT )
+        {
+            napt.src_port = htons(1234);
+            napt.dst_port = htons(4321);
+            napt.ip_layer = 1;
+            const uint32_t src = htonl(0xc0a80001);
+            const uint32_t dst = htonl(0xc0a80002);
+            memcpy(&napt.src_addr, &src, sizeof(src));
+            memcpy(&napt.dst_addr, &dst, sizeof(dst));
+            msg.meta[DAQ_PKT_META_NAPT_INFO] = &napt;
+        }
+        else if ( f.meta == DecodeMeta::DECODE_DATA )
+        {
+            decode_data.flags.bits.l3 = 1;
+            decode_data.flags.bits.ipv4 = 1;
+            decode_data.flags.bits.l3_checksum = 1;
+            decode_data.flags.bits.l4 = 1;
+            decode_data.flags.bits.tcp = 1;
+            decode_data.flags.bits.l4_checksum = 1;
+            decode_data.l3_offset = DAQ_PKT_DECODE_OFFSET_INVALID;
+            decode_data.l4_offset = DAQ_PKT_DECODE_OFFSET_INVALID;
+            decode_data.payload_offset = DAQ_PKT_DECODE_OFFSET_INVALID;
+            msg.meta[DAQ_PKT_META_DECODE_DATA] = &decode_data;
+        }
+
+        hdr.pktlen = f.data.size();
+        hdr.flags = f.daq_flags;
+
+        msg.type = DAQ_MSG_TYPE_PACKET;
+        msg.hdr_len = sizeof(hdr);
+        msg.hdr = &hdr;
+        msg.data_len = f.data.size();
+        msg.data = const_cast<uint8_t*>(f.data.data());
+    }
+};
@@ -0,0 +1,180 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// decode_stubs.h - stubs for decoding with the real Ethernet, VLAN, IP,
+// TCP, and UDP codecs
+
+#include <daq_dlt.h>
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "detection/detection_engine.h"
+#include "detection/ips_context.h"
+#include "flow/expect_cache.h"
+#include "framework/codec.h"
+#include "framework/data_bus.h"
+#include "framework/module.h"
+#include "log/log.h"
+#include "log/messages.h"
+#include "log/text_log.h"
+#include "main/policy.h"
+#include "main/snort_config.h"
+#include "managers/codec_manager.h"
+#include "packet_io/sfdaq.h"
+#include "profiler/time_profiler_defs.h"
+#include "sfip/sf_ipvar.h"
+#include "stream/stream.h"
+#include "utils/stats.h"
+#include "utils/util.h"
+
+// events queued by the codecs since the last clear
+static std::vector<std::pair<unsigned, unsigned>> s_events;
+
+static snort::SnortConfig* s_conf = nullptr;
+static NetworkPolicy* s_policy = nullptr;
+
+unsigned int get_random_seed() { return 0; }
+static sfip_var_t s_ip_var;
+sfip_var_t* sfip_var_from_string(const char*, const char*) { return &s_ip_var; }
+void sfvar_free(sfip_var_t*) { }
+// multicast and above is reserved for the address anomaly checks
+bool sfvar_ip_in(sfip_var_t*, const snort::SfIp* ip)
+{ return ip->is_ip4() and (ntohl(ip->get_ip4_value()) >> 28) >= 0xe; }
+// the nonzero codec stats last shown
+static std::string s_stats;
+
+void show_percent_stats(PegCount* counts, const char* names[], unsigned n, const char*)
+{
+    s_stats.clear();
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        if ( counts[i] )
+            s_stats += std::string(names[i]) + " " + std::to_string(counts[i]) + "\n";
+    }
+}
+
+void sum_stats(PegCount* sums, PegCount* counts, unsigned n, bool)
+{
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        sums[i] += counts[i];
+        counts[i] = 0;
+    }
+}
+
+NetworkPolicy::NetworkPolicy(PolicyId, PolicyId) { }
+NetworkPolicy::~NetworkPolicy() = default;
+
+namespace snort
+{
+THREAD_LOCAL bool TimeProfilerStats::enabled = false;
+
+char* snort_strdup(const char* s) { return strdup(s); }
+
+void ParseAbort(const char*, ...) { abort(); }
+void ParseError(const char*, ...) { }
+void WarningMessage(const char*, ...) { }
+void LogMessage(const char*, ...) { }
+
+bool TextLog_Print(TextLog* const, const char*, ...) { return true; }
+bool TextLog_Putc(TextLog* const, char) { return true; }
+bool TextLog_Write(TextLog* const, const char*, int) { return true; }
+void LogEthAddrs(TextLog*, const eth::EtherHdr*) { }
+void LogIpOptions(TextLog*, const ip::IP4Hdr*, uint16_t) { }
+void LogTcpOptions(TextLog*, const tcp::TCPHdr*, uint16_t) { }
+void CreateTCPFlagString(const tcp::TCPHdr*, char*) { }
+
+int DetectionEngine::queue_event(unsigned gid, unsigned sid)
+{
+    s_events.emplace_back(gid, sid);
+    return 0;
+}
+Packet* DetectionEngine::get_encode_packet() { return nullptr; }
+
+void ExpectFlow::reset_expect_flows() { }
+
+DataBus::DataBus() { }
+DataBus::~DataBus() { }
+
+IpsContext::IpsContext(unsigned) { }
+IpsContext::~IpsContext() = default;
+
+Module::Module(const char* s, const char* h) : name(s), help(h), params(nullptr), list(false)
+{ }
+Module::Module(const char* s, const char* h, const Parameter* p, bool l) :
+    name(s), help(h), params(p), list(l)
+{ }
+PegCount Module::get_global_count(const char*) const { return 0; }
+void Module::sum_stats(bool) { }
+void Module::show_interval_stats(IndexVec&, FILE*) { }
+void Module::show_stats() { }
+void Module::reset_stats() { }
+
+void Value::get_bits(PortBitSet&) const { }
+
+SnortConfig::SnortConfig(const SnortConfig* const, const char*) { }
+SnortConfig::~SnortConfig() = default;
+const SnortConfig* SnortConfig::get_conf() { return s_conf; }
+bool SnortConfig::tunnel_bypass_enabled(uint16_t) const { return false; }
+
+NetworkPolicy* get_network_policy() { return s_policy; }
+
+int SFDAQ::get_base_protocol() { return DLT_EN10MB; }
+bool SFDAQ::forwarding_packet(const DAQ_PktHdr_t*) { return false; }
+
+uint8_t Stream::get_flow_ttl(Flow*, char, bool) { return 0; }
+bool Stream::get_held_pkt_seq(Flow*, uint32_t&) { return false; }
+}
+
+extern const snort::BaseApi* cd_eth[];
+extern const snort::BaseApi* cd_vlan[];
+extern const snort::BaseApi* cd_ipv4[];
+extern const snort::BaseApi* cd_ipv6[];
+extern const snort::BaseApi* cd_tcp[];
+extern const snort::BaseApi* cd_udp[];
+
+// codecs can only be instantiated once per process
+static void decode_init(snort::SnortConfig* sc)
+{
+    const snort::BaseApi** const apis[] = { cd_eth, cd_vlan, cd_ipv4, cd_ipv6, cd_tcp, cd_udp };
+
+    for ( auto api : apis )
+        CodecManager::add_plugin((const snort::CodecApi*)api[0]);
+
+    sc->num_layers = 40;
+    s_conf = sc;
+
+    s_policy = new NetworkPolicy;
+
+    CodecManager::instantiate();
+    CodecManager::thread_init(sc);
+    snort::PacketManager::thread_init();
+}
+
+static void decode_term()
+{
+    snort::PacketManager::thread_term();
+    CodecManager::release_plugins();
+
+    delete s_policy;
+    s_policy = nullptr;
+    s_conf = nullptr;
+}
@@ -0,0 +1,97 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include "protocols/packet.h"
+#include "protocols/packet_manager.h"
+
+#include "decode_corpus.h"
+#include "decode_stubs.h"
+
+using namespace snort;
+
+static void decode_all(Packet& p, const std::vector<DecodeFrame>& frames, std::vector<DecodeMsg>& msgs)
+{
+    for ( unsigned i = 0; i < frames.size(); ++i )
+    {
+        p.daq_msg = &msgs[i].msg;
+        PacketManager::decode(&p, &msgs[i].hdr, frames[i].data.data(), frames[i].data.size());
+    }
+}
+
+TEST_CASE("decode rate", "[PacketManager]")
+{
+    SnortConfig* sc = new SnortConfig;
+    decode_init(sc);
+
+    IpsContext context;
+    context.conf = sc;
+
+    Packet* p = new Packet(false);
+    p->context = &context;
+
+    // checksums are commonly offloaded and would otherwise dwarf the rest
+    s_policy->checksum_eval = 0;
+
+    // the common stacks plus a share of everything else
+    std::vector<DecodeFrame> common;
+    common.emplace_back(make_frame("tcp4",
+        FrameBuilder().eth(ETH_IP4).ip4(6).tcp(TH_ACK).payload(64).build()));
+    common.emplace_back(make_frame("vlan tcp4",
+        FrameBuilder().eth(ETH_8021Q).vlan(100, ETH_IP4).ip4(6).tcp(TH_ACK).payload(64).build()));
+    common.emplace_back(make_frame("udp4",
+        FrameBuilder().eth(ETH_IP4).ip4(17).udp().payload(64).build()));
+    common.emplace_back(make_frame("tcp6",
+        FrameBuilder().eth(ETH_IP6).ip6(6).tcp(TH_ACK).payload(64).build()));
+
+    std::vector<DecodeFrame> corpus = make_corpus();
+
+    std::vector<DecodeMsg> common_msgs(common.begin(), common.end());
+    std::vector<DecodeMsg> corpus_msgs(corpus.begin(), corpus.end());
+
+    for ( bool fast : { false, true } )
+    {
+        sc->fast_decode = fast;
+        std::string path = fast ? "fast " : "generic ";
+
+        BENCHMARK((path + "common").c_str())
+        {
+            decode_all(*p, common, common_msgs);
+            return p->dsize;
+        };
+
+        BENCHMARK((path + "corpus").c_str())
+        {
+            decode_all(*p, corpus, corpus_msgs);
+            return p->dsize;
+        };
+    }
+
+    delete p;
+    decode_term();
+    delete sc;
+}
+
+#endif
@@ -0,0 +1,222 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// fast_decode_test.cc - the fast path must decode exactly like the generic loop
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+
+#include "protocols/packet.h"
+#include "protocols/packet_manager.h"
+
+#include "decode_corpus.h"
+#include "decode_stubs.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+// everything decode() sets, as text so a mismatch shows what differs
+static std::string snapshot(const Packet& p)
+{
+    std::string s;
+    char buf[128];
+
+    auto off = [&p](const void* ptr)
+    { return ptr ? (long)((const uint8_t*)ptr - p.pkt) : -1L; };
+
+    for ( const auto& e : s_events )
+    {
+        snprintf(buf, sizeof(buf), "event %u:%u\n", e.first, e.second);
+        s += buf;
+    }
+
+    for ( unsigned i = 0; i < p.num_layers; ++i )
+    {
+        snprintf(buf, sizeof(buf), "layer 0x%04x at %ld length %u\n",
+            (unsigned)p.layers[i].prot_id, off(p.layers[i].start), p.layers[i].length);
+        s += buf;
+    }
+
+    snprintf(buf, sizeof(buf), "proto_bits 0x%x packet_flags 0x%x ip_proto_next %u vlan_idx %u\n",
+        p.proto_bits, p.packet_flags, (unsigned)p.ip_proto_next, p.vlan_idx);
+    s += buf;
+
+    snprintf(buf, sizeof(buf), "data at %ld size %u\n", off(p.data), p.dsize);
+    s += buf;
+
+    const DecodeData& d = p.ptrs;
+    const void* iph = nullptr;
+
+    if ( d.ip_api.is_ip4() )
+        iph = d.ip_api.get_ip4h();
+    else if ( d.ip_api.is_ip6() )
+        iph = d.ip_api.get_ip6h();
+
+    snprintf(buf, sizeof(buf), "type %u decode_flags 0x%x ports %u %u ip at %ld tcp at %ld udp at %ld\n",
+        (unsigned)d.type, d.decode_flags, d.sp, d.dp, off(iph), off(d.tcph), off(d.udph));
+    s += buf;
+
+    return s;
+}
+
+static std::string decode(Packet& p, const DecodeFrame& f, bool fast)
+{
+    s_conf->fast_decode = fast;
+    s_events.clear();
+    PacketManager::reset_stats();
+
+    DecodeMsg m(f);
+    p.daq_msg = &m.msg;
+    PacketManager::decode(&p, &m.hdr, f.data.data(), f.data.size());
+
+    PacketManager::accumulate();
+    PacketManager::dump_stats();
+
+    return snapshot(p) + s_stats;
+}
+
+static void check_corpus(Packet& p)
+{
+    for ( const auto& f : make_corpus() )
+    {
+        std::string generic = decode(p, f, false);
+        std::string fast = decode(p, f, true);
+
+        std::string msg = std::string(f.name) + ":\n" + generic + "vs\n" + fast;
+        CHECK_TEXT(generic == fast, msg.c_str());
+    }
+}
+
+static SnortConfig* s_snort_conf = nullptr;
+
+TEST_GROUP(fast_decode_tests)
+{
+    IpsContext* context = nullptr;
+    Packet* p = nullptr;
+
+    void setup() override
+    {
+        context = new IpsContext;
+        context->conf = s_snort_conf;
+
+        p = new Packet(false);
+        p->context = context;
+    }
+
+    void teardown() override
+    {
+        delete p;
+        delete context;
+        s_conf->fast_decode = false;
+    }
+};
+
+TEST(fast_decode_tests, same_as_generic)
+{
+    check_corpus(*p);
+}
+
+TEST(fast_decode_tests, same_without_checksums)
+{
+    const uint32_t checksum_eval = s_policy->checksum_eval;
+    s_policy->checksum_eval = 0;
+    check_corpus(*p);
+    s_policy->checksum_eval = checksum_eval;
+}
+
+TEST(fast_decode_tests, same_with_address_checks)
+{
+    s_conf->address_anomaly_check_enabled = true;
+    check_corpus(*p);
+    s_conf->address_anomaly_check_enabled = false;
+}
+
+TEST(fast_decode_tests, same_with_one_ip_layer)
+{
+    s_conf->max_ip_layers = 1;
+    check_corpus(*p);
+    s_conf->max_ip_layers = 0;
+}
+
+TEST(fast_decode_tests, same_with_few_layers)
+{
+    for ( uint8_t n : { 1, 2, 3, 4 } )
+    {
+        s_conf->num_layers = n;
+        CodecManager::thread_init(s_conf);
+        check_corpus(*p);
+    }
+    s_conf->num_layers = 40;
+    CodecManager::thread_init(s_conf);
+}
+
+TEST(fast_decode_tests, decodes_stack)
+{
+    DecodeFrame f = make_frame("qinq tcp6",
+        FrameBuilder().eth(ETH_8021AD).vlan(10, ETH_8021Q).vlan(20, ETH_IP6).ip6(6)
+        .tcp(TH_ACK, { NOP, NOP, TS }).payload(40).build());
+
+    decode(*p, f, true);
+
+    CHECK(s_events.empty());
+    CHECK(p->num_layers == 5);
+    CHECK(p->vlan_idx == 2);
+    CHECK(p->ptrs.tcph);
+    CHECK(p->ptrs.dp == 80);
+    CHECK(p->ptrs.decode_flags & DECODE_TCP_TS);
+    CHECK(p->layers[4].length == 32);
+    CHECK(p->dsize == 40);
+    CHECK(p->ip_proto_next == IpProtocol::TCP);
+    CHECK((p->proto_bits & (PROTO_BIT__ETH | PROTO_BIT__VLAN | PROTO_BIT__IP | PROTO_BIT__TCP)) ==
+        (PROTO_BIT__ETH | PROTO_BIT__VLAN | PROTO_BIT__IP | PROTO_BIT__TCP));
+}
+
+TEST(fast_decode_tests, continues_with_udp)
+{
+    DecodeFrame f = make_frame("udp4",
+        FrameBuilder().eth(ETH_8021Q).vlan(10, ETH_IP4).ip4(17).udp().payload(20).build());
+
+    decode(*p, f, true);
+
+    CHECK(s_events.empty());
+    CHECK(p->num_layers == 4);
+    CHECK(p->ptrs.udph);
+    CHECK(p->ptrs.dp == 53);
+    CHECK(p->dsize == 20);
+    CHECK(p->ip_proto_next == IpProtocol::UDP);
+}
+
+//-------------------------------------------------------------------------
+// main
+//-------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    s_snort_conf = new SnortConfig;
+    decode_init(s_snort_conf);
+
+    int ret = CommandLineTestRunner::RunAllTests(argc, argv);
+
+    decode_term();
+    delete s_snort_conf;
+
+    return ret;
+}
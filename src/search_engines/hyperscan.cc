@@ -39,6 +39,7 @@
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "main/thread.h"
+#include "main/thread_config.h"
 #include "utils/stats.h"
 
 using namespace snort;
@@ -118,6 +119,9 @@ static hs_scratch_t* s_scratch = nullptr;
 static unsigned int scratch_index;
 static ScratchAllocator* scratcher = nullptr;
 
+// node of this packet thread's database replica, if any
+static THREAD_LOCAL int s_node = -1;
+
 struct ScanContext
 {
     class HyperscanMpse* mpse;
@@ -137,10 +141,11 @@ struct ScanContext
 class HyperscanMpse : public Mpse
 {
 public:
-    HyperscanMpse(const MpseAgent* a)
+    HyperscanMpse(const MpseAgent* a, bool r)
         : Mpse("hyperscan")
     {
         agent = a;
+        numa_replicas = r;
         ++instances;
     }
 
@@ -149,6 +154,12 @@ public:
         if ( hs_db )
             hs_free_database(hs_db);
 
+        for ( auto* db : node_dbs )
+        {
+            if ( db )
+                hs_free_database(db);
+        }
+
         if ( agent )
             user_dtor();
     }
@@ -184,19 +195,29 @@ public:
 private:
     void user_ctor(SnortConfig*);
     void user_dtor();
+    void replicate(const SnortConfig*);
 
     const MpseAgent* agent;
     PatternVector pvector;
+    bool numa_replicas;
 
     hs_database_t* hs_db = nullptr;
 
+    // read only copies of hs_db local to each node with packet threads
+    // except the node holding hs_db, which is null and uses hs_db
+    std::vector<hs_database_t*> node_dbs;
+
 public:
     static uint64_t instances;
     static uint64_t patterns;
+    static uint64_t replicas;
+    static uint64_t replica_bytes;
 };
 
 uint64_t HyperscanMpse::instances = 0;
 uint64_t HyperscanMpse::patterns = 0;
+uint64_t HyperscanMpse::replicas = 0;
+uint64_t HyperscanMpse::replica_bytes = 0;
 
 bool HyperscanMpse::serialize(uint8_t*& buf, size_t& sz) const
 { return hs_db and (hs_serialize_database(hs_db, (char**)&buf, &sz) == HS_SUCCESS) and buf; }
@@ -239,6 +260,52 @@ void HyperscanMpse::user_ctor(SnortConfig* sc)
     }
 }
 
+// with numa_replicas the database is deserialized into memory preferred
+// on each other node so that packet threads on every socket scan from
+// local memory.  this costs one more copy of the database per extra node.
+void HyperscanMpse::replicate(const SnortConfig* sc)
+{
+    if ( !numa_replicas or !node_dbs.empty() )
+        return;
+
+    unsigned nodes = sc->thread_config ? sc->thread_config->get_numa_node_count() : 1;
+
+    if ( nodes < 2 )
+        return;
+
+    // if unknown, every node gets a replica and hs_db is only a fallback
+    int home = ThreadConfig::get_memory_node(hs_db);
+
+    char* buf = nullptr;
+    size_t sz = 0;
+
+    if ( hs_serialize_database(hs_db, &buf, &sz) != HS_SUCCESS or !buf )
+        return;
+
+    node_dbs.resize(nodes, nullptr);
+
+    for ( unsigned n = 0; n < nodes; ++n )
+    {
+        if ( (int)n == home )
+            continue;
+
+        // a replica not placed on its node is no better than the original
+        if ( !ThreadConfig::prefer_numa_node(n) or
+            hs_deserialize_database(buf, sz, &node_dbs[n]) != HS_SUCCESS )
+            continue;
+
+        size_t db_size = 0;
+
+        if ( hs_database_size(node_dbs[n], &db_size) == HS_SUCCESS )
+            replica_bytes += db_size;
+
+        ++replicas;
+    }
+
+    ThreadConfig::prefer_numa_node(-1);
+    free(buf);
+}
+
 void HyperscanMpse::user_dtor()
 {
     for ( auto& p : pvector )
@@ -261,6 +328,7 @@ int HyperscanMpse::prep_patterns(SnortConfig* sc)
         if ( agent )
             user_ctor(sc);
 
+        replicate(sc);
         return 0;
     }
 
@@ -310,6 +378,8 @@ int HyperscanMpse::prep_patterns(SnortConfig* sc)
     if ( agent )
         user_ctor(sc);
 
+    replicate(sc);
+
     std::lock_guard<std::mutex> lock(s_mutex);
 
     if ( hs_error_t err = hs_alloc_scratch(hs_db, &s_scratch) )
@@ -375,7 +445,12 @@ int HyperscanMpse::_search(
     // scratch is null for the degenerate case w/o patterns
     assert(!hs_db or ss);
 
-    hs_scan(hs_db, (const char*)buf, n, 0, ss, HyperscanMpse::match, &scan);
+    hs_database_t* db = hs_db;
+
+    if ( s_node >= 0 and (unsigned)s_node < node_dbs.size() and node_dbs[s_node] )
+        db = node_dbs[s_node];
+
+    hs_scan(db, (const char*)buf, n, 0, ss, HyperscanMpse::match, &scan);
 
     return scan.nfound;
 }
@@ -414,12 +489,34 @@ static void scratch_update(SnortConfig* sc)
     hs_clone_scratch(s_scratch, ss);
 }
 
+static void scratch_localize(const SnortConfig* sc)
+{
+    hs_scratch_t** ss = (hs_scratch_t**) &sc->state[get_instance_id()][scratch_index];
+    hs_scratch_t* local = nullptr;
+
+    if ( *ss and hs_clone_scratch(*ss, &local) == HS_SUCCESS )
+    {
+        hs_free_scratch(*ss);
+        *ss = local;
+    }
+    s_node = ThreadConfig::get_numa_node();
+}
+
+static const Parameter s_params[] =
+{
+    { "numa_replicas", Parameter::PT_BOOL, nullptr, "false",
+      "copy each database to every NUMA node with pinned packet threads" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 class HyperscanModule : public Module
 {
 public:
-    HyperscanModule() : Module(s_name, s_help)
+    HyperscanModule() : Module(s_name, s_help, s_params)
     {
-        scratcher = new SimpleScratchAllocator(scratch_setup, scratch_cleanup, scratch_update);
+        scratcher = new SimpleScratchAllocator(
+            scratch_setup, scratch_cleanup, scratch_update, scratch_localize);
         scratch_index = scratcher->get_id();
     }
 
@@ -429,6 +526,19 @@ public:
         hs_free_scratch(s_scratch);
         s_scratch = nullptr;
     }
+
+    bool set(const char*, Value& v, SnortConfig*) override
+    {
+        if ( v.is("numa_replicas") )
+            numa_replicas = v.get_bool();
+
+        return true;
+    }
+
+    Usage get_usage() const override
+    { return GLOBAL; }
+
+    bool numa_replicas = false;
 };
 
 //-------------------------------------------------------------------------
@@ -441,9 +551,10 @@ static Module* mod_ctor()
 static void mod_dtor(Module* p)
 { delete p; }
 
-static Mpse* hs_ctor(const SnortConfig*, class Module*, const MpseAgent* a)
+static Mpse* hs_ctor(const SnortConfig*, class Module* m, const MpseAgent* a)
 {
-    return new HyperscanMpse(a);
+    HyperscanModule* mod = (HyperscanModule*)m;
+    return new HyperscanMpse(a, mod and mod->numa_replicas);
 }
 
 static void hs_dtor(Mpse* p)
@@ -455,12 +566,16 @@ static void hs_init()
 {
     HyperscanMpse::instances = 0;
     HyperscanMpse::patterns = 0;
+    HyperscanMpse::replicas = 0;
+    HyperscanMpse::replica_bytes = 0;
 }
 
 static void hs_print()
 {
     LogCount("instances", HyperscanMpse::instances);
     LogCount("patterns", HyperscanMpse::patterns);
+    LogCount("numa replicas", HyperscanMpse::replicas);
+    LogCount("replica bytes", HyperscanMpse::replica_bytes);
 }
 
 static const MpseApi hs_api =
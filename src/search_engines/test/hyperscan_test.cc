@@ -28,8 +28,10 @@
 #include "framework/base_api.h"
 #include "framework/counts.h"
 #include "framework/mpse.h"
+#include "framework/module.h"
 #include "framework/mpse_batch.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 
 #include "mpse_test_stubs.h"
 
@@ -351,6 +353,119 @@ TEST(mpse_hs_scratch, scratch_update)
     CHECK(instance_sz2 > instance_sz1);
 }
 
+//-------------------------------------------------------------------------
+// numa replica tests
+//-------------------------------------------------------------------------
+
+TEST_GROUP(mpse_hs_numa)
+{
+    Module* mod = nullptr;
+    ThreadConfig tc;
+    const MpseApi* mpse_api = (const MpseApi*)se_hyperscan;
+
+    void setup() override
+    {
+        CHECK(se_hyperscan);
+        mod = mpse_api->base.mod_ctor();
+        snort_conf->thread_config = &tc;
+        numa_nodes = 3;
+        numa_memory_node = 0;
+        mpse_api->init();
+        hits = 0;
+    }
+    void teardown() override
+    {
+        ThreadConfig::prefer_numa_node(-1);
+        numa_nodes = 1;
+        numa_memory_node = -1;
+        snort_conf->thread_config = nullptr;
+        scratcher->cleanup(snort_conf);
+        mpse_api->base.mod_dtor(mod);
+    }
+    void set_replicas(bool b)
+    {
+        Value v(b);
+        v.set(mod->get_parameters());
+        CHECK(mod->set(nullptr, v, nullptr));
+    }
+    Mpse* make()
+    {
+        Mpse* hs = mpse_api->ctor(snort_conf, mod, &s_agent);
+        Mpse::PatternDescriptor desc;
+        CHECK(hs->add_pattern((const uint8_t*)"foo", 3, desc, s_user) == 0);
+        CHECK(hs->prep_patterns(snort_conf) == 0);
+        scratcher->setup(snort_conf);
+        return hs;
+    }
+};
+
+TEST(mpse_hs_numa, off_by_default)
+{
+    Mpse* hs = make();
+
+    // the packet thread on another node still scans the original
+    scratcher->localize(snort_conf);
+    CHECK(ThreadConfig::prefer_numa_node(2));
+    scratcher->localize(snort_conf);
+
+    int state = 0;
+    CHECK(hs->search((const uint8_t*)"foo", 3, match, nullptr, &state) == 1);
+    CHECK(hits == 1);
+
+    mpse_api->print();
+    CHECK(log_counts["numa replicas"] == 0);
+    CHECK(log_counts["replica bytes"] == 0);
+
+    mpse_api->dtor(hs);
+}
+
+TEST(mpse_hs_numa, original_is_reused)
+{
+    set_replicas(true);
+    Mpse* hs = make();
+
+    // node 0 already holds the original so only nodes 1 and 2 get a copy
+    mpse_api->print();
+    CHECK(log_counts["numa replicas"] == 2);
+    CHECK(log_counts["replica bytes"] > 0);
+
+    int state = 0;
+
+    for ( int n = 0; n < 3; ++n )
+    {
+        CHECK(ThreadConfig::prefer_numa_node(n));
+        scratcher->localize(snort_conf);
+        CHECK(hs->search((const uint8_t*)"foo foo", 7, match, nullptr, &state) == 2);
+    }
+    CHECK(hits == 6);
+
+    mpse_api->dtor(hs);
+}
+
+TEST(mpse_hs_numa, unknown_home)
+{
+    set_replicas(true);
+    numa_memory_node = -1;
+    Mpse* hs = make();
+
+    mpse_api->print();
+    CHECK(log_counts["numa replicas"] == 3);
+
+    mpse_api->dtor(hs);
+}
+
+TEST(mpse_hs_numa, single_node)
+{
+    set_replicas(true);
+    numa_nodes = 1;
+    Mpse* hs = make();
+
+    mpse_api->print();
+    CHECK(log_counts["numa replicas"] == 0);
+
+    mpse_api->dtor(hs);
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
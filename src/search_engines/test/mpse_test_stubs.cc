@@ -32,6 +32,7 @@
 #include "framework/mpse_batch.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 #include "managers/mpse_manager.h"
 #include "search_engines/pat_stats.h"
 #include "utils/stats.h"
@@ -92,11 +93,31 @@ void ParseWarning(WarningGroup, const char*, ...) { }
 
 [[noreturn]] void FatalError(const char*,...) { exit(1); }
 
-void LogCount(char const*, uint64_t, FILE*) { }
+std::map<std::string, uint64_t> log_counts;
+void LogCount(char const* s, uint64_t n, FILE*) { log_counts[s] = n; }
 void LogStat(const char*, double, FILE*) { }
 
 void md5(const unsigned char*, size_t, unsigned char*) { }
 
+unsigned numa_nodes = 1;
+int numa_memory_node = -1;
+static THREAD_LOCAL int numa_node = -1;
+
+ThreadConfig::~ThreadConfig() = default;
+
+bool ThreadConfig::prefer_numa_node(int node)
+{
+    if ( numa_nodes < 2 or node >= (int)numa_nodes )
+        return false;
+
+    numa_node = node;
+    return true;
+}
+
+int ThreadConfig::get_numa_node() { return numa_node; }
+int ThreadConfig::get_memory_node(const void*) { return numa_memory_node; }
+unsigned ThreadConfig::get_numa_node_count() const { return numa_nodes; }
+
 } // namespace snort
 
 FastPatternConfig::FastPatternConfig()
@@ -22,6 +22,8 @@
 #define TEST_STUBS_H
 
 #include <cassert>
+#include <map>
+#include <string>
 
 #include "detection/fp_config.h"
 #include "framework/base_api.h"
@@ -44,6 +46,13 @@ extern THREAD_LOCAL SnortConfig* snort_conf;
 extern THREAD_LOCAL PatMatQStat pmqs;
 
 extern unsigned parse_errors;
+
+// the last value printed for each count
+extern std::map<std::string, uint64_t> log_counts;
+
+// nodes reported by ThreadConfig and the node holding any database
+extern unsigned numa_nodes;
+extern int numa_memory_node;
 } // namespace snort
 
 extern snort::Mpse* mpse;
@@ -24,6 +24,9 @@
 
 #include "sfrt/sfrt_flat.h"
 
+#include <cstring>
+#include <limits>
+
 #include "sfip/sf_cidr.h"
 
 using namespace snort;
@@ -199,6 +202,47 @@ GENERIC RtTable::sfrt_flat_lookup(const SfIp* ip)
         return nullptr;
 }
 
+GENERIC RtTable::sfrt_flat_lookup_exact(const SfCidr* cidr)
+{
+    if (!cidr || !table)
+        return nullptr;
+
+    const SfIp* ip = cidr->get_addr();
+    const uint32_t* addr;
+    int numAddrDwords;
+    int len = cidr->get_bits();
+    TABLE_PTR rt;
+
+    if (ip->is_ip4())
+    {
+        addr = ip->get_ip4_ptr();
+        numAddrDwords = 1;
+        rt = table->rt;
+        len -= 96;
+    }
+    else if (ip->is_ip6())
+    {
+        addr = ip->get_ip6_ptr();
+        numAddrDwords = 4;
+        rt = table->rt6;
+    }
+    else
+        return nullptr;
+
+    tuple_flat_t tuple = sfrt_dir_flat_lookup(addr, numAddrDwords, rt);
+
+    if (tuple.index >= table->num_ent || tuple.length != len)
+        return nullptr;
+
+    uint8_t* base = (uint8_t*)segment_basePtr();
+    INFO* data = (INFO*)(&base[table->data]);
+
+    if (data[tuple.index])
+        return (GENERIC)&base[data[tuple.index]];
+    else
+        return nullptr;
+}
+
 /* Insert "ip", of length "len", into "table", and have it point to "ptr" */
 return_codes RtTable::sfrt_flat_insert(SfCidr* cidr, unsigned char len, INFO ptr,
     int behavior, updateEntryInfoFunc updateEntry, void* update_entry_info_data)
@@ -271,7 +315,11 @@ return_codes RtTable::sfrt_flat_insert(SfCidr* cidr, unsigned char len, INFO ptr
     if (bytesAllocated < 0)
     {
         if (tuple.length != len)
+        {
+            segment_free(data[index]);
+            data[index] = 0;
             table->num_ent--;
+        }
         return MEM_ALLOC_FAILURE;
     }
 
@@ -291,12 +339,46 @@ return_codes RtTable::sfrt_flat_insert(SfCidr* cidr, unsigned char len, INFO ptr
          * time it will be incremented above is when we are potentially
          * mallocing one or more new entries (It's not incremented when we
          * overwrite an existing entry). */
+        if (tuple.length != len)
+        {
+            segment_free(data[index]);
+            data[index] = 0;
+        }
         table->num_ent--;
     }
 
     return res;
 }
 
+bool RtTable::sfrt_flat_reserve(unsigned count)
+{
+    if (!table || !table->data)
+        return false;
+
+    if (count <= table->max_size - table->num_ent)
+        return true;
+
+    uint64_t max_size = (uint64_t)table->num_ent + count;
+
+    if (max_size > std::numeric_limits<unsigned>::max() / sizeof(INFO))
+        return false;
+
+    MEM_OFFSET data = segment_snort_calloc(sizeof(INFO) * max_size, 1);
+
+    if (!data)
+        return false;
+
+    // the old array stays in the segment; segment memory isn't reused
+    uint8_t* base = (uint8_t*)segment_basePtr();
+    memcpy(&base[data], &base[table->data], sizeof(INFO) * table->num_ent);
+
+    table->allocated += sizeof(INFO) * (max_size - table->max_size);
+    table->max_size = (unsigned)max_size;
+    table->data = data;
+
+    return true;
+}
+
 uint32_t RtTable::sfrt_flat_num_entries() const
 {
     if (!table)
@@ -75,8 +75,15 @@ struct RtTable
     void sfrt_flat_new(char table_flat_type, char ip_type, long data_size, uint32_t mem_cap);
     GENERIC sfrt_flat_lookup(const snort::SfIp*);
 
+    // Like sfrt_flat_lookup() but only returns data inserted for exactly this cidr
+    GENERIC sfrt_flat_lookup_exact(const snort::SfCidr*);
+
     return_codes sfrt_flat_insert(snort::SfCidr* cidr, unsigned char len, INFO ptr, int behavior,
         updateEntryInfoFunc, void* update_entry_info_data);
+
+    // Make room in the data table for count more entries. The table's
+    // capacity is fixed by sfrt_flat_new() so a larger copy is made.
+    bool sfrt_flat_reserve(unsigned count);
     unsigned sfrt_flat_usage() const;
     unsigned sfrt_flat_num_entries() const;
     table_flat_t* get_table() const
@@ -88,8 +95,23 @@ struct RtTable
         unused_ptr = 0;
         unused_mem = mem_cap;
     }
+    // Continue allocating from a copy of a finished segment. The first used
+    // bytes of buff must hold a table built by sfrt_flat_new().
+    void segment_attach(uint8_t* buff, size_t used, size_t mem_cap)
+    {
+        base_ptr = buff;
+        unused_ptr = used;
+        unused_mem = mem_cap - used;
+        table = (table_flat_t*)buff;
+    }
+
     MEM_OFFSET segment_snort_calloc(size_t num, size_t size);
 
+    // Bytes handed out from the segment so far. Everything the table refers
+    // to lies within this prefix, so it can be copied or saved as is.
+    size_t segment_usedmem() const
+    { return unused_ptr; }
+
 protected:
     TABLE_PTR sfrt_dir_flat_new(uint32_t mem_cap, int count, ...);
     tuple_flat_t sfrt_dir_flat_lookup(const uint32_t* addr, int numAddrDwords, TABLE_PTR table_ptr);
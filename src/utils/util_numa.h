@@ -48,6 +48,13 @@ public:
     {
         return set_mempolicy(mode, nodemask, maxnode);
     }
+    virtual int node_of(void* addr)
+    {
+        int node = -1;
+        if ( get_mempolicy(&node, nullptr, 0, addr, MPOL_F_NODE | MPOL_F_ADDR) )
+            return -1;
+        return node;
+    }
 };
 class HwlocWrapper
 {
@@ -0,0 +1,318 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// columnar_dump prints alert_columnar files as csv, one header line per
+// distinct schema followed by the rows.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <zlib.h>
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "log/columnar.h"
+
+struct Column
+{
+    std::string name;
+    uint8_t type;
+    std::vector<std::string> dict;
+    const uint8_t* values;
+};
+
+class Reader
+{
+public:
+    Reader(const uint8_t* p, size_t n) : pos(p), end(p + n) { }
+
+    bool get(void* v, size_t n)
+    {
+        if ( (size_t)(end - pos) < n )
+            return false;
+
+        memcpy(v, pos, n);
+        pos += n;
+        return true;
+    }
+
+    const uint8_t* skip(size_t n)
+    {
+        if ( (size_t)(end - pos) < n )
+            return nullptr;
+
+        const uint8_t* p = pos;
+        pos += n;
+        return p;
+    }
+
+private:
+    const uint8_t* pos;
+    const uint8_t* end;
+};
+
+static bool parse_block(const std::vector<uint8_t>& body, uint32_t rows, std::vector<Column>& cols)
+{
+    Reader r(body.data(), body.size());
+    uint32_t num;
+
+    if ( !r.get(&num, sizeof(num)) )
+        return false;
+
+    cols.resize(num);
+
+    for ( auto& c : cols )
+    {
+        uint8_t hdr[2];
+        const uint8_t* name;
+
+        if ( !r.get(hdr, sizeof(hdr)) or !(name = r.skip(hdr[1])) or hdr[0] >= COL_MAX )
+            return false;
+
+        c.type = hdr[0];
+        c.name.assign((const char*)name, hdr[1]);
+    }
+
+    for ( auto& c : cols )
+    {
+        uint32_t len;
+        const uint8_t* sect;
+
+        if ( !r.get(&len, sizeof(len)) or !(sect = r.skip(len)) )
+            return false;
+
+        Reader s(sect, len);
+        c.dict.clear();
+
+        if ( c.type == COL_DICT )
+        {
+            uint32_t count;
+
+            if ( !s.get(&count, sizeof(count)) )
+                return false;
+
+            for ( uint32_t i = 0; i < count; ++i )
+            {
+                uint32_t n;
+                const uint8_t* str;
+
+                if ( !s.get(&n, sizeof(n)) or !(str = s.skip(n)) )
+                    return false;
+
+                c.dict.emplace_back((const char*)str, n);
+            }
+        }
+
+        if ( !(c.values = s.skip((size_t)rows * columnar_width(c.type))) )
+            return false;
+    }
+    return true;
+}
+
+static void print_quoted(const std::string& s, FILE* out)
+{
+    fputc('"', out);
+
+    for ( char c : s )
+    {
+        if ( c == '"' )
+            fputc('"', out);
+        fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static void print_value(const Column& c, uint32_t row, FILE* out)
+{
+    const uint8_t* p = c.values + (size_t)row * columnar_width(c.type);
+
+    switch ( c.type )
+    {
+    case COL_U8:
+        fprintf(out, "%u", *p);
+        break;
+
+    case COL_U16:
+    {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        fprintf(out, "%u", v);
+        break;
+    }
+    case COL_U32:
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        fprintf(out, "%u", v);
+        break;
+    }
+    case COL_U64:
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        fprintf(out, "%" PRIu64, v);
+        break;
+    }
+    case COL_IP:
+    {
+        static const uint8_t mapped[12] = { 0,0,0,0, 0,0,0,0, 0,0,0xff,0xff };
+        static const uint8_t none[16] = { };
+        char buf[INET6_ADDRSTRLEN];
+
+        if ( !memcmp(p, none, sizeof(none)) )
+            break;
+
+        if ( !memcmp(p, mapped, sizeof(mapped)) )
+            inet_ntop(AF_INET, p + 12, buf, sizeof(buf));
+        else
+            inet_ntop(AF_INET6, p, buf, sizeof(buf));
+
+        fputs(buf, out);
+        break;
+    }
+    case COL_DICT:
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+
+        if ( v < c.dict.size() )
+            print_quoted(c.dict[v], out);
+        break;
+    }
+    }
+}
+
+static int dump(const char* file, bool summary, FILE* out)
+{
+    FILE* f = fopen(file, "rb");
+
+    if ( !f )
+    {
+        fprintf(out, "ERROR: Failed to open file: %s\n\tErrno: %s\n", file, strerror(errno));
+        return -1;
+    }
+
+    ColumnarFileHeader fh;
+
+    if ( fread(&fh, sizeof(fh), 1, f) != 1 or memcmp(fh.magic, COLUMNAR_MAGIC, sizeof(fh.magic)) or
+        fh.version != COLUMNAR_VERSION or fh.byte_order != COLUMNAR_BYTE_ORDER )
+    {
+        fprintf(out, "ERROR: %s is not a columnar alert file from this architecture\n", file);
+        fclose(f);
+        return -1;
+    }
+
+    std::vector<uint8_t> comp, body;
+    std::vector<Column> cols;
+    std::string schema;
+    unsigned blocks = 0;
+    uint64_t events = 0;
+    int ret = 0;
+    ColumnarBlockHeader bh;
+
+    while ( fread(&bh, sizeof(bh), 1, f) == 1 )
+    {
+        if ( bh.magic != COLUMNAR_BLOCK_MAGIC )
+        {
+            fprintf(out, "ERROR: bad block %u in %s\n", blocks, file);
+            ret = -1;
+            break;
+        }
+
+        comp.resize(bh.comp_size);
+        body.resize(bh.raw_size);
+        uLongf raw_size = bh.raw_size;
+
+        if ( fread(comp.data(), bh.comp_size, 1, f) != 1 or
+            uncompress(body.data(), &raw_size, comp.data(), bh.comp_size) != Z_OK or
+            raw_size != bh.raw_size or crc32(0, body.data(), body.size()) != bh.crc or
+            !parse_block(body, bh.rows, cols) )
+        {
+            fprintf(out, "ERROR: corrupt block %u in %s\n", blocks, file);
+            ret = -1;
+            break;
+        }
+
+        ++blocks;
+        events += bh.rows;
+
+        if ( summary )
+        {
+            fprintf(out, "block %u: %u events, %u bytes, %u compressed\n",
+                blocks, bh.rows, bh.raw_size, bh.comp_size);
+            continue;
+        }
+
+        std::string names;
+
+        for ( const auto& c : cols )
+            names += (names.empty() ? "" : ",") + c.name;
+
+        if ( names != schema )
+        {
+            fprintf(out, "%s\n", names.c_str());
+            schema = names;
+        }
+
+        for ( uint32_t row = 0; row < bh.rows; ++row )
+        {
+            for ( size_t i = 0; i < cols.size(); ++i )
+            {
+                if ( i )
+                    fputc(',', out);
+                print_value(cols[i], row, out);
+            }
+            fputc('\n', out);
+        }
+    }
+
+    if ( summary )
+        fprintf(out, "%s: %u blocks, %" PRIu64 " events\n", file, blocks, events);
+
+    fclose(f);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    bool summary = argc > 1 and !strcmp(argv[1], "-s");
+    int first = summary ? 2 : 1;
+
+    if ( first >= argc )
+    {
+        puts("usage: columnar_dump [-s] <file> ...");
+        return 1;
+    }
+
+    int ret = 0;
+
+    for ( int i = first; i < argc; ++i )
+    {
+        if ( dump(argv[i], summary, stdout) )
+            ret = 1;
+    }
+    return ret;
+}
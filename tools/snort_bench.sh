@@ -0,0 +1,97 @@
+#!/bin/sh
+#--------------------------------------------------------------------------
+# Copyright (C) 2024-2024 Cisco and/or its affiliates. All rights reserved.
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the GNU General Public License Version 2 as published
+# by the Free Software Foundation.  You may not use, modify or distribute
+# this program under any other version of the GNU General Public License.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+#--------------------------------------------------------------------------
+# snort_bench.sh - run snort on traffic from the gen DAQ and report the
+# per thread results and their totals as JSON
+
+usage()
+{
+    cat <<EOF
+usage: $0 [options] [-- snort args]
+    -c <conf>       snort configuration (default none)
+    -d <dir>        directory containing daq_gen.so
+    -e <num>        requests and responses per flow
+    -f <num>        concurrent flows per thread
+    -m <mix>        weighted protocols, eg http:4,tls:3,dns:2,smb:1
+    -n <num>        packets per thread
+    -o <percent>    out of order data segments
+    -s <bytes>      bytes in each TCP response
+    -S <snort>      snort binary (default snort)
+    -z <num>        packet threads (default 1)
+EOF
+    exit 1
+}
+
+snort=snort
+threads=1
+conf=
+daq_dir=
+vars=
+
+while getopts "c:d:e:f:m:n:o:s:S:z:h" opt; do
+    case $opt in
+        c) conf=$OPTARG ;;
+        d) daq_dir=$OPTARG ;;
+        e) vars="$vars --daq-var exchanges=$OPTARG" ;;
+        f) vars="$vars --daq-var flows=$OPTARG" ;;
+        m) vars="$vars --daq-var mix=$OPTARG" ;;
+        n) vars="$vars --daq-var packets=$OPTARG" ;;
+        o) vars="$vars --daq-var ooo=$OPTARG" ;;
+        s) vars="$vars --daq-var size=$OPTARG" ;;
+        S) snort=$OPTARG ;;
+        z) threads=$OPTARG ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+report=$(mktemp) || exit 1
+trap 'rm -f "$report"' EXIT
+
+$snort ${conf:+-c "$conf"} ${daq_dir:+--daq-dir "$daq_dir"} --daq gen -i gen -z "$threads" \
+    $vars --daq-var report="$report" -q "$@" >&2 || exit $?
+
+# the thread reports are single lines of flat JSON apart from latency
+awk '
+function field(line, name,    s)
+{
+    s = line
+    sub(".*\"" name "\": ", "", s)
+    sub("[,} ].*", "", s)
+    return s + 0
+}
+{
+    lines[NR] = $0
+    packets += field($0, "packets")
+    bytes += field($0, "bytes")
+    flows += field($0, "flows")
+    pps += field($0, "pps")
+    gbps += field($0, "gbps")
+    if ( field($0, "seconds") > secs )
+        secs = field($0, "seconds")
+}
+END {
+    printf("{\n  \"threads\": [\n")
+    for ( i = 1; i <= NR; ++i )
+        printf("    %s%s\n", lines[i], i < NR ? "," : "")
+    printf("  ],\n")
+    printf("  \"total\": { \"packets\": %.0f, \"bytes\": %.0f, \"flows\": %.0f, \"seconds\": %.6f, ",
+        packets, bytes, flows, secs)
+    printf("\"pps\": %.0f, \"gbps\": %.3f }\n}\n", pps, gbps)
+}
+' "$report"